@@ -0,0 +1,151 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <numeric>
+#include "Fluent/Fluent.hpp"
+#include "BenchmarkRunner.hpp"
+
+namespace Fluent
+{
+    static std::string EscapeJson(const std::string& value)
+    {
+        std::string result;
+        result.reserve(value.size());
+        for (char c : value)
+        {
+            switch (c)
+            {
+                case '"': result += "\\\""; break;
+                case '\\': result += "\\\\"; break;
+                case '\b': result += "\\b"; break;
+                case '\f': result += "\\f"; break;
+                case '\n': result += "\\n"; break;
+                case '\r': result += "\\r"; break;
+                case '\t': result += "\\t"; break;
+                default:
+                {
+                    /// Remaining control characters have no short escape
+                    if (static_cast<unsigned char>(c) < 0x20)
+                    {
+                        char escaped[7];
+                        std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned char>(c));
+                        result += escaped;
+                    }
+                    else
+                    {
+                        result.push_back(c);
+                    }
+                    break;
+                }
+            }
+        }
+        return result;
+    }
+
+    BenchmarkRunner::BenchmarkRunner(std::string filter)
+        : mFilter(std::move(filter))
+    {}
+
+    bool BenchmarkRunner::IsEnabled(const std::string& name) const
+    {
+        return mFilter.empty() || name.find(mFilter) != std::string::npos;
+    }
+
+    void BenchmarkRunner::SetAfterBenchmark(Body&& afterBenchmark)
+    {
+        mAfterBenchmark = std::move(afterBenchmark);
+    }
+
+    void BenchmarkRunner::Run(const std::string& name, uint32_t iterations, const Body& body, const Body& afterIteration)
+    {
+        if (!IsEnabled(name) || iterations == 0)
+            return;
+
+        for (uint32_t i = 0; i < WARMUP_ITERATIONS; ++i)
+        {
+            body();
+            if (afterIteration)
+                afterIteration();
+        }
+
+        /// Timer keeps float seconds, which loses sub microsecond precision on short bodies
+        std::vector<double> timings(iterations);
+        for (uint32_t i = 0; i < iterations; ++i)
+        {
+            auto begin = std::chrono::steady_clock::now();
+            body();
+            auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin);
+            timings[i] = static_cast<double>(elapsed.count()) / 1000.0;
+
+            if (afterIteration)
+                afterIteration();
+        }
+
+        if (mAfterBenchmark)
+            mAfterBenchmark();
+
+        std::sort(timings.begin(), timings.end());
+
+        auto& result = mResults.emplace_back();
+        result.name = name;
+        result.iterations = iterations;
+        result.min = timings.front();
+        result.max = timings.back();
+        result.median = timings[timings.size() / 2];
+        result.p95 = timings[std::min<size_t>(timings.size() - 1, timings.size() * 95 / 100)];
+        result.mean = std::accumulate(timings.begin(), timings.end(), 0.0) / timings.size();
+
+        LOG_INFO("{:<40} median {:>12.2f} us  p95 {:>12.2f} us  ({} iterations)", name, result.median, result.p95, iterations);
+    }
+
+    void BenchmarkRunner::Skip(const std::string& name, const std::string& reason)
+    {
+        if (!IsEnabled(name))
+            return;
+
+        auto& result = mResults.emplace_back();
+        result.name = name;
+        result.skipReason = reason;
+
+        LOG_WARN("{:<40} skipped: {}", name, reason);
+    }
+
+    bool BenchmarkRunner::WriteJson(const std::string& path, const std::vector<std::pair<std::string, std::string>>& environment) const
+    {
+        std::ofstream file(path);
+        if (!file.is_open())
+        {
+            LOG_ERROR("Failed to open file {}", path);
+            return false;
+        }
+
+        file << "{\n  \"environment\": {";
+        for (size_t i = 0; i < environment.size(); ++i)
+        {
+            file << (i ? ",\n" : "\n") << "    \"" << EscapeJson(environment[i].first) << "\": \"" << EscapeJson(environment[i].second) << "\"";
+        }
+        file << "\n  },\n  \"unit\": \"us\",\n  \"benchmarks\": [";
+
+        for (size_t i = 0; i < mResults.size(); ++i)
+        {
+            auto& result = mResults[i];
+            file << (i ? ",\n" : "\n") << "    { \"name\": \"" << EscapeJson(result.name) << "\"";
+            if (!result.skipReason.empty())
+            {
+                file << ", \"skipped\": \"" << EscapeJson(result.skipReason) << "\" }";
+                continue;
+            }
+
+            file << ", \"iterations\": " << result.iterations
+                 << ", \"min\": " << result.min
+                 << ", \"median\": " << result.median
+                 << ", \"mean\": " << result.mean
+                 << ", \"p95\": " << result.p95
+                 << ", \"max\": " << result.max << " }";
+        }
+        file << "\n  ]\n}\n";
+
+        return true;
+    }
+} // namespace Fluent
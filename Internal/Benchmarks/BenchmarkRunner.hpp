@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace Fluent
+{
+    /// Timings are in microseconds
+    struct BenchmarkResult
+    {
+        std::string name;
+        uint32_t    iterations = 0;
+        double      min = 0.0;
+        double      median = 0.0;
+        double      mean = 0.0;
+        double      p95 = 0.0;
+        double      max = 0.0;
+        /// Reason why benchmark didn't run, empty when it did
+        std::string skipReason;
+    };
+
+    class BenchmarkRunner
+    {
+    public:
+        using Body = std::function<void()>;
+    private:
+        static constexpr uint32_t WARMUP_ITERATIONS = 2;
+
+        std::string                     mFilter;
+        std::vector<BenchmarkResult>    mResults;
+        Body                            mAfterBenchmark;
+    public:
+        /// Only benchmarks which name contains filter are run, empty filter runs all
+        explicit BenchmarkRunner(std::string filter);
+
+        bool IsEnabled(const std::string& name) const;
+        /// Called after every benchmark, e.g. to release deferred gpu objects
+        void SetAfterBenchmark(Body&& afterBenchmark);
+
+        /// Every iteration of body is timed separately, afterIteration isn't measured
+        void Run(const std::string& name, uint32_t iterations, const Body& body, const Body& afterIteration = {});
+        void Skip(const std::string& name, const std::string& reason);
+
+        const std::vector<BenchmarkResult>& GetResults() const { return mResults; }
+        /// Properties are written as strings into "environment" object
+        bool WriteJson(const std::string& path, const std::vector<std::pair<std::string, std::string>>& environment) const;
+    };
+} // namespace Fluent
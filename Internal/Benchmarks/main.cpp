@@ -0,0 +1,451 @@
+/// Headless micro benchmarks of renderer hot paths, results are written to json.
+/// Usage: Benchmarks [--out=benchmarks.json] [--filter=Buffer] [--trace=trace.json]
+/// --trace needs FluentProfiling build
+/// For numbers comparable between machines run on lavapipe:
+/// VK_ICD_FILENAMES=/usr/share/vulkan/icd.d/lvp_icd.x86_64.json ./Benchmarks
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "Fluent/Fluent.hpp"
+#include "BenchmarkRunner.hpp"
+
+using namespace Fluent;
+
+static constexpr uint32_t TARGET_WIDTH = 512;
+static constexpr uint32_t TARGET_HEIGHT = 512;
+static constexpr uint32_t BUFFER_SIZE = 1024 * 1024;
+static constexpr uint32_t STAGING_SUBMIT_SIZE = 64 * 1024;
+static constexpr uint32_t DESCRIPTOR_IMAGE_COUNT = 16;
+/// More than frames in flight, so every deletion queue is flushed
+static constexpr uint32_t FLUSH_FRAME_COUNT = 3;
+
+struct PushConstantBlock
+{
+    Matrix4 model = Matrix4(1.0f);
+    Vector4 viewPosition = Vector4(0.0f);
+    Vector4 lightPosition = Vector4(0.0f);
+};
+
+class RendererBenchmarks
+{
+private:
+    Scope<GraphicContext>       mContext;
+    BenchmarkRunner&            mRunner;
+
+    Ref<Shader>                 mVertexShader;
+    Ref<Shader>                 mFragmentShader;
+    Ref<DescriptorSetLayout>    mDescriptorSetLayout;
+    Ref<RenderPass>             mRenderPass;
+    Ref<Image>                  mRenderImage;
+    Ref<Framebuffer>            mFramebuffer;
+    Ref<Image>                  mTexture;
+    Ref<Sampler>                mSampler;
+    Ref<Buffer>                 mUniformBuffer;
+    Ref<Buffer>                 mVertexBuffer;
+
+    static bool ReadFile(const std::string& path, std::vector<uint32_t>& result)
+    {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file.is_open())
+            return false;
+
+        result.resize(static_cast<size_t>(file.tellg()) / sizeof(uint32_t));
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(result.data()), result.size() * sizeof(uint32_t));
+        return true;
+    }
+
+    /// Deferred destructors run once their frame fence is waited
+    void FlushFrames()
+    {
+        for (uint32_t i = 0; i < FLUSH_FRAME_COUNT; ++i)
+        {
+            mContext->BeginFrame();
+            mContext->EndFrame();
+        }
+        mContext->WaitIdle();
+    }
+
+    void ResetStaging()
+    {
+        mContext->GetStagingBuffer()->Reset();
+    }
+
+    PipelineDescription GetPipelineDescription() const
+    {
+        RasterizerStateDescription rasterizerState{};
+        rasterizerState.cullMode = CullMode::eNone;
+        rasterizerState.frontFace = FrontFace::eClockwise;
+
+        PipelineDescription pipelineDesc{};
+        pipelineDesc.type = PipelineType::eGraphics;
+        pipelineDesc.descriptorSetLayout = mDescriptorSetLayout;
+        pipelineDesc.rasterizerDescription = rasterizerState;
+        pipelineDesc.depthStateDescription = {};
+        pipelineDesc.renderPass = mRenderPass;
+        /// Attributes are generated from vertex shader reflection
+        return pipelineDesc;
+    }
+
+    void CreateResources()
+    {
+        ShaderDescription vertexShaderDesc{};
+        vertexShaderDesc.stage = ShaderStage::eVertex;
+        vertexShaderDesc.filename = "08_ModelLoading/main.vert.glsl";
+
+        ShaderDescription fragmentShaderDesc{};
+        fragmentShaderDesc.stage = ShaderStage::eFragment;
+        fragmentShaderDesc.filename = "08_ModelLoading/main.frag.glsl";
+
+        mVertexShader = Shader::Create(vertexShaderDesc);
+        mFragmentShader = Shader::Create(fragmentShaderDesc);
+
+        DescriptorSetLayoutDescription descriptorSetLayoutDesc{};
+        descriptorSetLayoutDesc.shaders = { mVertexShader, mFragmentShader };
+        mDescriptorSetLayout = DescriptorSetLayout::Create(descriptorSetLayoutDesc);
+
+        ClearValue clearValue{};
+        clearValue.color = Vector4(0.0, 0.0, 0.0, 1.0);
+
+        RenderPassDescription renderPassDesc{};
+        renderPassDesc.width = TARGET_WIDTH;
+        renderPassDesc.height = TARGET_HEIGHT;
+        renderPassDesc.clearValues = { clearValue };
+        renderPassDesc.colorFormats = { Format::eR8G8B8A8Unorm };
+        renderPassDesc.initialUsages = { ImageUsage::eUndefined };
+        renderPassDesc.finalUsages = { ImageUsage::eSampled };
+        renderPassDesc.attachmentLoadOps = { AttachmentLoadOp::eClear };
+        renderPassDesc.sampleCount = SampleCount::e1;
+        mRenderPass = RenderPass::Create(renderPassDesc);
+
+        ImageDescription imageDesc{};
+        imageDesc.arraySize = 1;
+        imageDesc.mipLevels = 1;
+        imageDesc.depth = 1;
+        imageDesc.format = Format::eR8G8B8A8Unorm;
+        imageDesc.width = TARGET_WIDTH;
+        imageDesc.height = TARGET_HEIGHT;
+        imageDesc.initialUsage = ImageUsage::eSampled;
+        mRenderImage = Image::Create(imageDesc);
+
+        FramebufferDescription framebufferDesc{};
+        framebufferDesc.width = TARGET_WIDTH;
+        framebufferDesc.height = TARGET_HEIGHT;
+        framebufferDesc.renderPass = mRenderPass;
+        framebufferDesc.targets = {{ mRenderImage }};
+        mFramebuffer = Framebuffer::Create(framebufferDesc);
+
+        mRenderPass->SetRenderArea(TARGET_WIDTH, TARGET_HEIGHT);
+
+        ImageDescription textureDesc{};
+        textureDesc.initialUsage = ImageUsage::eSampled;
+        textureDesc.filename = "05_ParallaxMapping/normal.ktx";
+        mTexture = Image::Create(textureDesc);
+        ResetStaging();
+
+        SamplerDescription samplerDesc{};
+        samplerDesc.mipmapMode = SamplerMipmapMode::eLinear;
+        samplerDesc.minLod = 0;
+        samplerDesc.maxLod = 1000;
+        mSampler = Sampler::Create(samplerDesc);
+
+        BufferDescription uniformBufferDesc{};
+        uniformBufferDesc.bufferUsage = BufferUsage::eUniformBuffer;
+        uniformBufferDesc.memoryUsage = MemoryUsage::eCpuToGpu;
+        uniformBufferDesc.size = 2 * sizeof(Matrix4);
+        mUniformBuffer = Buffer::Create(uniformBufferDesc);
+
+        BufferDescription vertexBufferDesc{};
+        vertexBufferDesc.bufferUsage = BufferUsage::eVertexBuffer;
+        vertexBufferDesc.memoryUsage = MemoryUsage::eCpuToGpu;
+        vertexBufferDesc.size = BUFFER_SIZE;
+        mVertexBuffer = Buffer::Create(vertexBufferDesc);
+    }
+
+    void BenchmarkBuffers()
+    {
+        std::vector<uint8_t> data(BUFFER_SIZE, 0xAB);
+
+        mRunner.Run("Buffer/CreateHostVisible", 200, [&data]()
+        {
+            BufferDescription bufferDesc{};
+            bufferDesc.bufferUsage = BufferUsage::eVertexBuffer;
+            bufferDesc.memoryUsage = MemoryUsage::eCpuToGpu;
+            bufferDesc.size = BUFFER_SIZE;
+            auto buffer = Buffer::Create(bufferDesc);
+            buffer->WriteData(data.data(), BUFFER_SIZE, 0);
+        });
+
+        mRunner.Run("Buffer/CreateStaged", 200, [&data]()
+        {
+            BufferDescription bufferDesc{};
+            bufferDesc.bufferUsage = BufferUsage::eVertexBuffer;
+            bufferDesc.memoryUsage = MemoryUsage::eGpu;
+            bufferDesc.size = BUFFER_SIZE;
+            bufferDesc.data = data.data();
+            auto buffer = Buffer::Create(bufferDesc);
+        }, [this]() { ResetStaging(); });
+
+        auto& stagingBuffer = mContext->GetStagingBuffer();
+        mRunner.Run("StagingBuffer/Submit64KiB", 2000, [&stagingBuffer, &data]()
+        {
+            stagingBuffer->Submit(data.data(), STAGING_SUBMIT_SIZE);
+        }, [&stagingBuffer]()
+        {
+            if (stagingBuffer->GetCurrentOffset() + STAGING_SUBMIT_SIZE > stagingBuffer->GetBuffer()->GetSize())
+                stagingBuffer->Reset();
+        });
+        ResetStaging();
+    }
+
+    void BenchmarkAssets()
+    {
+        mRunner.Run("Image/CreateFromKtx", 50, []()
+        {
+            ImageDescription imageDesc{};
+            imageDesc.initialUsage = ImageUsage::eSampled;
+            imageDesc.filename = "05_ParallaxMapping/normal.ktx";
+            auto image = Image::Create(imageDesc);
+        }, [this]() { ResetStaging(); });
+
+        const std::string modelName = "ModelLoader/LoadBackpack";
+        if (!std::filesystem::exists(FileSystem::GetModelsDirectory() + "/backpack/backpack.obj"))
+        {
+            mRunner.Skip(modelName, "backpack/backpack.obj not found in models directory");
+        }
+        else
+        {
+            mRunner.Run(modelName, 3, [this]()
+            {
+                LoadModelDescription loadModelDescription{};
+                loadModelDescription.filename = "backpack/backpack.obj";
+                loadModelDescription.vertexShader = mVertexShader;
+
+                /// Without async file reader textures are read before Load returns
+                Model model;
+                ModelLoader modelLoader;
+                modelLoader.Load(loadModelDescription, [&model](Model& loaded) { model = std::move(loaded); });
+            }, [this]() { ResetStaging(); });
+        }
+
+        ShaderDescription reflectedDesc{};
+        reflectedDesc.stage = ShaderStage::eVertex;
+        if (!ReadFile(FileSystem::GetShadersDirectory() + "08_ModelLoading/main.vert.glsl.spv", reflectedDesc.byteCode))
+        {
+            mRunner.Skip("Shader/Reflect", "08_ModelLoading/main.vert.glsl.spv not found");
+            return;
+        }
+
+        mRunner.Run("Shader/Reflect", 500, [&reflectedDesc]()
+        {
+            auto description = reflectedDesc;
+            Reflect(description);
+        });
+    }
+
+    void BenchmarkPipelines()
+    {
+        auto pipelineDesc = GetPipelineDescription();
+
+        /// Previous pipeline is released every iteration, so cache never returns it
+        mRunner.Run("Pipeline/Create", 50, [&pipelineDesc]()
+        {
+            auto pipeline = Pipeline::Create(pipelineDesc);
+        });
+
+        /// Layout is created again as every example does on attach, cache still returns held pipeline
+        auto heldPipeline = Pipeline::Create(pipelineDesc);
+        mRunner.Run("Pipeline/CreateCached", 2000, [this, &pipelineDesc]()
+        {
+            DescriptorSetLayoutDescription descriptorSetLayoutDesc{};
+            descriptorSetLayoutDesc.shaders = { mVertexShader, mFragmentShader };
+            auto description = pipelineDesc;
+            description.descriptorSetLayout = DescriptorSetLayout::Create(descriptorSetLayoutDesc);
+            auto pipeline = Pipeline::Create(description);
+        });
+        heldPipeline = nullptr;
+
+        std::vector<PipelineDescription> batch(8, pipelineDesc);
+        /// Every description differs, so all 8 pipelines are compiled in one call
+        for (uint32_t i = 0; i < batch.size(); ++i)
+        {
+            batch[i].rasterizerDescription.cullMode = i % 2 ? CullMode::eBack : CullMode::eFront;
+            batch[i].rasterizerDescription.frontFace = (i / 2) % 2 ? FrontFace::eCounterClockwise : FrontFace::eClockwise;
+            batch[i].depthStateDescription.depthTest = i / 4 != 0;
+        }
+        mRunner.Run("Pipeline/CreateBatch8", 20, [&batch]()
+        {
+            auto pipelines = Pipeline::CreateBatch(batch);
+        });
+
+        DescriptorSetDescription descriptorSetDesc{};
+        descriptorSetDesc.descriptorSetLayout = mDescriptorSetLayout;
+        auto descriptorSet = DescriptorSet::Create(descriptorSetDesc);
+
+        std::vector<DescriptorSetUpdateDesc> updateDescriptions(3);
+        updateDescriptions[0].binding = 0;
+        updateDescriptions[0].bufferUpdates = {{ mUniformBuffer, 0, static_cast<uint32_t>(2 * sizeof(Matrix4)) }};
+        updateDescriptions[0].descriptorType = DescriptorType::eUniformBuffer;
+
+        ImageUpdateDesc samplerUpdate{};
+        samplerUpdate.sampler = mSampler;
+        updateDescriptions[1].binding = 1;
+        updateDescriptions[1].imageUpdates = { samplerUpdate };
+        updateDescriptions[1].descriptorType = DescriptorType::eSampler;
+
+        ImageUpdateDesc imageUpdate{};
+        imageUpdate.image = mTexture;
+        imageUpdate.usage = ImageUsage::eSampled;
+        updateDescriptions[2].binding = 2;
+        updateDescriptions[2].imageUpdates = std::vector<ImageUpdateDesc>(DESCRIPTOR_IMAGE_COUNT, imageUpdate);
+        updateDescriptions[2].descriptorType = DescriptorType::eSampledImage;
+
+        mRunner.Run("DescriptorSet/Update", 2000, [&descriptorSet, &updateDescriptions]()
+        {
+            descriptorSet->UpdateDescriptorSet(updateDescriptions);
+        });
+    }
+
+    void BenchmarkRecording(uint32_t drawCount)
+    {
+        auto pipeline = Pipeline::Create(GetPipelineDescription());
+
+        DescriptorSetDescription descriptorSetDesc{};
+        descriptorSetDesc.descriptorSetLayout = mDescriptorSetLayout;
+        auto descriptorSet = DescriptorSet::Create(descriptorSetDesc);
+
+        CommandBufferDescription cmdDesc{};
+        cmdDesc.device = mContext->GetDevice();
+        cmdDesc.commandPool = mContext->GetCommandPool();
+        auto cmd = CommandBuffer::Create(cmdDesc);
+
+        PushConstantBlock pcb{};
+        TextureIndices textureIndices{};
+
+        /// Only recording is measured, command buffer is never submitted
+        mRunner.Run("CommandBuffer/Record" + std::to_string(drawCount) + "Draws", 100, [&]()
+        {
+            cmd->Begin();
+            cmd->BeginRenderPass(mRenderPass, mFramebuffer);
+            cmd->SetViewport(TARGET_WIDTH, TARGET_HEIGHT, 0.0f, 1.0f, 0, 0);
+            cmd->SetScissor(TARGET_WIDTH, TARGET_HEIGHT, 0, 0);
+            cmd->BindPipeline(pipeline);
+            cmd->BindDescriptorSet(pipeline, descriptorSet, DescriptorSetFrequency::ePerFrame);
+            cmd->BindVertexBuffer(mVertexBuffer, 0);
+            for (uint32_t i = 0; i < drawCount; ++i)
+            {
+                pcb.model[3][0] = static_cast<float>(i);
+                cmd->PushConstants(pipeline, 0, sizeof(PushConstantBlock), &pcb);
+                cmd->PushConstants(pipeline, sizeof(PushConstantBlock), sizeof(TextureIndices), &textureIndices);
+                cmd->Draw(3, 1, 0, 0);
+            }
+            cmd->EndRenderPass();
+            cmd->End();
+        });
+    }
+public:
+    RendererBenchmarks(BenchmarkRunner& runner)
+        : mRunner(runner)
+    {
+        GraphicContextDescription contextDesc{};
+        contextDesc.requestValidation = false;
+        contextDesc.window = nullptr;
+
+        mContext = GraphicContext::Create(contextDesc);
+        SetGraphicContext(*mContext);
+        mContext->OnResize(TARGET_WIDTH, TARGET_HEIGHT);
+        /// Keep defragmentation moves out of measurements
+        mContext->SetDefragmentationBudget(0);
+
+        mRunner.SetAfterBenchmark([this]() { FlushFrames(); });
+    }
+
+    ~RendererBenchmarks()
+    {
+        mContext->WaitIdle();
+        mVertexBuffer = nullptr;
+        mUniformBuffer = nullptr;
+        mSampler = nullptr;
+        mTexture = nullptr;
+        mFramebuffer = nullptr;
+        mRenderImage = nullptr;
+        mRenderPass = nullptr;
+        mDescriptorSetLayout = nullptr;
+        mFragmentShader = nullptr;
+        mVertexShader = nullptr;
+    }
+
+    void Run()
+    {
+        CreateResources();
+        BenchmarkBuffers();
+        BenchmarkAssets();
+        BenchmarkPipelines();
+        BenchmarkRecording(1000);
+        BenchmarkRecording(10000);
+    }
+
+    std::vector<std::pair<std::string, std::string>> GetEnvironment()
+    {
+        VkPhysicalDeviceProperties properties{};
+        vkGetPhysicalDeviceProperties((VkPhysicalDevice)mContext->GetPhysicalDevice(), &properties);
+
+        return
+        {
+            { "device", properties.deviceName },
+            { "driverVersion", std::to_string(properties.driverVersion) },
+            { "apiVersion", std::to_string(VK_VERSION_MAJOR(properties.apiVersion)) + "." +
+                            std::to_string(VK_VERSION_MINOR(properties.apiVersion)) + "." +
+                            std::to_string(VK_VERSION_PATCH(properties.apiVersion)) }
+        };
+    }
+};
+
+int main(int argc, char** argv)
+{
+    /// Library stays quiet, results are reported through core category
+    Log::SetLogLevel(Log::LogLevel::eWarn);
+    Log::SetLogLevel(Log::Category::eCore, Log::LogLevel::eInfo);
+
+    std::string outputPath = "benchmarks.json";
+    std::string filter;
+    std::string tracePath;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strncmp(argv[i], "--out=", 6) == 0)
+            outputPath = argv[i] + 6;
+        else if (std::strncmp(argv[i], "--filter=", 9) == 0)
+            filter = argv[i] + 9;
+        else if (std::strncmp(argv[i], "--trace=", 8) == 0)
+            tracePath = argv[i] + 8;
+    }
+
+    /// Output paths are relative to working directory, they are reported as absolute ones
+    outputPath = std::filesystem::absolute(outputPath).string();
+    if (!tracePath.empty())
+        tracePath = std::filesystem::absolute(tracePath).string();
+
+    FileSystem::Init(argv);
+    FileSystem::SetShadersDirectory("../../Internal/Examples/Shaders/");
+    FileSystem::SetTexturesDirectory("../../Internal/Examples/Textures/");
+    FileSystem::SetModelsDirectory("../../Internal/Examples/Models");
+
+    BenchmarkRunner runner(filter);
+    std::vector<std::pair<std::string, std::string>> environment;
+    {
+        RendererBenchmarks benchmarks(runner);
+        benchmarks.Run();
+        environment = benchmarks.GetEnvironment();
+    }
+
+    if (!tracePath.empty())
+        Profiler::WriteChromeTrace(tracePath);
+
+    if (!runner.WriteJson(outputPath, environment))
+        return 1;
+
+    LOG_INFO("Results written to {}", outputPath);
+    return 0;
+}
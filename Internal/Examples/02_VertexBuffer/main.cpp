@@ -199,6 +199,8 @@ int main(int argc, char** argv)
     appDesc.argv = argv;
     appDesc.windowDescription = windowDescription;
     appDesc.askGraphicValidation = true;
+    appDesc.shaderHotReload = true;
+    appDesc.asyncLogging = true;
     
     Application app(appDesc);
     VertexBufferLayer layer;
@@ -325,7 +325,7 @@ public:
         cmd->SetViewport(window->GetWidth(), window->GetHeight(), 0.0f, 1.0f, 0, 0);
         cmd->SetScissor(window->GetWidth(), window->GetHeight(), 0, 0);
         cmd->BindPipeline(mPipeline);
-        cmd->BindDescriptorSet(mPipeline, mDescriptorSet);
+        cmd->BindDescriptorSet(mPipeline, mDescriptorSet, DescriptorSetFrequency::ePerFrame);
         cmd->BindVertexBuffer(mVertexBuffer, 0);
         cmd->BindIndexBuffer(mIndexBuffer, 0, IndexType::eUint32);
         cmd->DrawIndexed(indices.size(), 1, 0, 0, 0);
@@ -349,6 +349,8 @@ int main(int argc, char** argv)
     appDesc.argv = argv;
     appDesc.windowDescription = windowDescription;
     appDesc.askGraphicValidation = true;
+    appDesc.shaderHotReload = true;
+    appDesc.asyncLogging = true;
     
     Application app(appDesc);
     TextureLayer layer;
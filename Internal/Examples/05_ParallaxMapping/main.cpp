@@ -375,7 +375,7 @@ public:
         cmd->BeginRenderPass(mRenderPass, mFramebuffer);
         cmd->SetViewport(window->GetWidth(), window->GetHeight(), 0.0f, 1.0f, 0, 0);
         cmd->SetScissor(window->GetWidth(), window->GetHeight(), 0, 0);
-        cmd->BindDescriptorSet(mPipeline, mDescriptorSet);
+        cmd->BindDescriptorSet(mPipeline, mDescriptorSet, DescriptorSetFrequency::ePerFrame);
         cmd->BindPipeline(mPipeline);
         cmd->PushConstants(mPipeline, 0, sizeof(ParallaxMappingSettings), &mParallaxSettings);
         cmd->BindVertexBuffer(mVertexBuffer, 0);
@@ -401,6 +401,8 @@ int main(int argc, char** argv)
     appDesc.argv = argv;
     appDesc.windowDescription = windowDescription;
     appDesc.askGraphicValidation = true;
+    appDesc.shaderHotReload = true;
+    appDesc.asyncLogging = true;
     
     Application app(appDesc);
     ParallaxMappingLayer layer;
@@ -110,7 +110,7 @@ public:
     {
         auto& context = Application::Get().GetGraphicContext();
         auto cmd = context->GetCurrentCommandBuffer();
-        cmd->BindDescriptorSet(mPipeline, mDescriptorSet);
+        cmd->BindDescriptorSet(mPipeline, mDescriptorSet, DescriptorSetFrequency::ePerFrame);
         cmd->BindPipeline(mPipeline);
         PushConstantBlock pcb;
         pcb.time = mTimer.Elapsed();
@@ -138,6 +138,8 @@ int main(int argc, char** argv)
     appDesc.argv = argv;
     appDesc.windowDescription = windowDescription;
     appDesc.askGraphicValidation = true;
+    appDesc.shaderHotReload = true;
+    appDesc.asyncLogging = true;
     
     Application app(appDesc);
     ComputeLayer layer;
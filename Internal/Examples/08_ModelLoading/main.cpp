@@ -20,6 +20,9 @@ struct PushConstantBlock
 class ParallaxMappingLayer : public Layer
 {
 private:
+    static constexpr float      NEAR_PLANE = 0.1f;
+    static constexpr float      FAR_PLANE = 100.0f;
+
     Ref<Image>                  mRenderImage;
     Ref<Image>                  mDepthImage;
     Ref<RenderPass>             mRenderPass;
@@ -30,7 +33,19 @@ private:
     Ref<DescriptorSet>          mDescriptorSet;
     Ref<Sampler>                mSampler;
 
+    ModelLoader                 mModelLoader;
     Model                       mModel;
+    RenderQueue                 mRenderQueue;
+    /// Sorted draws are recorded as POD packets and translated in one pass
+    CommandStream               mCommandStream;
+    CommandStreamExecutor       mCommandStreamExecutor;
+    /// One draw item per lod of every mesh, sort keys are built per frame from view depth
+    std::vector<std::vector<DrawItem>> mDrawItems;
+    std::vector<uint32_t>       mMeshLods;
+    /// Streamed texture versions written to descriptor set
+    std::vector<uint32_t>       mTextureVersions;
+    float                       mCameraDistance = 2.0f;
+    float                       mMaxPixelError = 1.0f;
 
     Timer                       mTimer;
 
@@ -44,7 +59,7 @@ public:
     {
         auto& window = Application::Get().GetWindow();
 
-        mCameraUBO.projection   = CreatePerspectiveMatrix(Radians(45.0f), window->GetAspect(), 0, 100.f);
+        mCameraUBO.projection   = CreatePerspectiveMatrix(Radians(45.0f), window->GetAspect(), NEAR_PLANE, FAR_PLANE);
         mCameraUBO.view         = CreateLookAtMatrix(Vector3(0.0f, 0.0, 2.0f), Vector3(0.0, 0.0, -1.0), Vector3(0.0, 1.0, 0.0));
 
         BufferDescription bufferDesc{};
@@ -97,16 +112,6 @@ public:
         uiDesc.renderPass = mRenderPass;
         mUIContext = UIContext::Create(uiDesc);
 
-        LoadModelDescription loadModelDescription{};
-        loadModelDescription.filename = "backpack/backpack.obj";
-        loadModelDescription.loadNormals = true;
-        loadModelDescription.loadTexCoords = true;
-        loadModelDescription.loadTangents = true;
-        loadModelDescription.loadBitangents = true;
-
-        ModelLoader modelLoader;
-        mModel = modelLoader.Load(loadModelDescription);
-
         ShaderDescription vertexShaderDesc{};
         vertexShaderDesc.stage = ShaderStage::eVertex;
         vertexShaderDesc.filename = "08_ModelLoading/main.vert.glsl";
@@ -115,9 +120,37 @@ public:
         fragmentShaderDesc.stage = ShaderStage::eFragment;
         fragmentShaderDesc.filename = "08_ModelLoading/main.frag.glsl";
 
-        auto vertexShader = Shader::Create(vertexShaderDesc);
-        auto fragmentShader = Shader::Create(fragmentShaderDesc);
-        
+        CreateUniformBuffer();
+        CreateSampler();
+
+        /// Spirv of both stages is read in one batch, model is loaded once shaders exist
+        Shader::CreateBatch({ vertexShaderDesc, fragmentShaderDesc }, [this](std::vector<Ref<Shader>>& shaders)
+        {
+            LoadModel(shaders[0], shaders[1]);
+        });
+    }
+
+    void LoadModel(const Ref<Shader>& vertexShader, const Ref<Shader>& fragmentShader)
+    {
+        /// Streams which vertex shader doesn't read, like bitangents, are not loaded
+        LoadModelDescription loadModelDescription{};
+        loadModelDescription.filename = "backpack/backpack.obj";
+        loadModelDescription.vertexShader = vertexShader;
+        loadModelDescription.lodCount = 4;
+        /// Base mips are resident, finer ones are streamed by screen size of meshes
+        loadModelDescription.textureStreamer = Application::Get().GetTextureStreamer().get();
+
+        /// Nothing is drawn until textures are read and pipeline is created
+        mModelLoader.Load(loadModelDescription, [this, vertexShader, fragmentShader](Model& model)
+        {
+            mModel = std::move(model);
+            CreatePipeline(vertexShader, fragmentShader);
+            CreateDrawItems();
+        });
+    }
+
+    void CreatePipeline(const Ref<Shader>& vertexShader, const Ref<Shader>& fragmentShader)
+    {
         DescriptorSetLayoutDescription descriptorSetLayoutDesc{};
         descriptorSetLayoutDesc.shaders = { vertexShader, fragmentShader };
 
@@ -134,8 +167,8 @@ public:
 
         PipelineDescription pipelineDesc{};
         pipelineDesc.type = PipelineType::eGraphics;
-        pipelineDesc.bindingDescriptions = modelLoader.GetVertexBindingDescription();
-        pipelineDesc.attributeDescriptions = modelLoader.GetVertexAttributeDescription();
+        pipelineDesc.bindingDescriptions = mModelLoader.GetVertexBindingDescription();
+        pipelineDesc.attributeDescriptions = mModelLoader.GetVertexAttributeDescription();
 
         pipelineDesc.descriptorSetLayout = mDescriptorSetLayout;
         pipelineDesc.rasterizerDescription = rasterizerState;
@@ -143,18 +176,42 @@ public:
         pipelineDesc.renderPass = mRenderPass;
 
         mPipeline = Pipeline::Create(pipelineDesc);
+    }
 
-        CreateUniformBuffer();
-        CreateSampler();
+    /// Descriptor set is rebuilt when streamer replaces image. Textures which failed to load
+    /// are replaced by first loaded one, so indices of materials stay valid
+    void UpdateDescriptorSet()
+    {
+        Ref<Image> fallback;
+        bool changed = mTextureVersions.size() != mModel.streamedTextures.size();
+        mTextureVersions.resize(mModel.streamedTextures.size(), 0);
+        for (uint32_t i = 0; i < mModel.streamedTextures.size(); ++i)
+        {
+            const auto& texture = mModel.streamedTextures[i];
+            if (!texture)
+                continue;
+            /// Base mips are not uploaded yet
+            if (!texture->GetImage())
+                return;
+
+            if (!fallback)
+                fallback = texture->GetImage();
+            changed |= mTextureVersions[i] != texture->GetVersion();
+            mTextureVersions[i] = texture->GetVersion();
+        }
+
+        if (!fallback || (mDescriptorSet && !changed))
+            return;
 
         DescriptorSetDescription descriptorSetDesc{};
         descriptorSetDesc.descriptorSetLayout = mDescriptorSetLayout;
         mDescriptorSet = DescriptorSet::Create(descriptorSetDesc);
 
-        std::vector<ImageUpdateDesc> imageUpdates(mModel.textures.size());
+        std::vector<ImageUpdateDesc> imageUpdates(mModel.streamedTextures.size());
         for (uint32_t i = 0; i < imageUpdates.size(); ++i)
         {
-            imageUpdates[i].image = mModel.textures[i];
+            const auto& texture = mModel.streamedTextures[i];
+            imageUpdates[i].image = texture ? texture->GetImage() : fallback;
             imageUpdates[i].usage = ImageUsage::eSampled;
         }
 
@@ -181,11 +238,61 @@ public:
         mDescriptorSet->UpdateDescriptorSet(updateDescriptions);
     }
 
+    void CreateDrawItems()
+    {
+        uint32_t pipeline = mRenderQueue.AddPipeline(mPipeline);
+        for (auto& mesh : mModel.meshes)
+        {
+            RenderMaterial material{};
+            auto* textureIndices = reinterpret_cast<const uint8_t*>(&mesh.material.textureIndices);
+            material.pushConstants.assign(textureIndices, textureIndices + sizeof(TextureIndices));
+            material.pushConstantOffset = sizeof(PushConstantBlock);
+
+            uint32_t materialIndex = mRenderQueue.AddMaterial(material);
+
+            auto& lodItems = mDrawItems.emplace_back();
+            for (const auto& lod : mesh.lods)
+            {
+                RenderMesh renderMesh{};
+                renderMesh.vertexBuffer = mesh.vertexBuffer;
+                renderMesh.indexBuffer = mesh.indexBuffer;
+                renderMesh.firstIndex = lod.firstIndex;
+                renderMesh.indexCount = lod.indexCount;
+                renderMesh.indexType = IndexType::eUint32;
+
+                DrawItem item{};
+                item.pipeline = pipeline;
+                item.material = materialIndex;
+                item.mesh = mRenderQueue.AddMesh(renderMesh);
+                lodItems.push_back(item);
+            }
+        }
+        mMeshLods.assign(mModel.meshes.size(), 0);
+    }
+
+    /// Texture is assumed to span whole mesh once
+    void RequestTextureMips(const Mesh& mesh, float lodScale)
+    {
+        Vector3 extent = mesh.boundsMax - mesh.boundsMin;
+        float screenSize = lodScale * std::max(extent.x, std::max(extent.y, extent.z));
+        const auto& indices = mesh.material.textureIndices;
+        for (int index : { indices.diffuse, indices.specular, indices.normal, indices.height })
+        {
+            if (index >= 0 && index < (int)mModel.streamedTextures.size() && mModel.streamedTextures[index])
+                mModel.streamedTextures[index]->RequestScreenSize(screenSize);
+        }
+    }
+
     void OnDetach() override
     {
         mUniformBuffer = nullptr;
         mUIContext = nullptr;
         mRenderPass = nullptr;
+        mRenderQueue.Reset();
+        mDrawItems.clear();
+        mMeshLods.clear();
+        mTextureVersions.clear();
+        mDescriptorSet = nullptr;
         mPipeline = nullptr;
         mFramebuffer = nullptr;
         mRenderImage = nullptr;
@@ -222,7 +329,7 @@ public:
 
         mRenderPass->SetRenderArea(window->GetWidth(), window->GetHeight());
 
-        mCameraUBO.projection = CreatePerspectiveMatrix(Radians(45.0f), window->GetAspect(), 0.1f, 100.0f);
+        mCameraUBO.projection = CreatePerspectiveMatrix(Radians(45.0f), window->GetAspect(), NEAR_PLANE, FAR_PLANE);
     }
 
     void OnUnload() override
@@ -234,6 +341,9 @@ public:
 
     void OnUpdate(float deltaTime) override
     {
+        Vector3 cameraPosition(0.0f, 0.0f, mCameraDistance);
+        mCameraUBO.view = CreateLookAtMatrix(cameraPosition, Vector3(0.0, 0.0, -1.0), Vector3(0.0, 1.0, 0.0));
+        mPcb.viewPosition = Vector4(cameraPosition, 0.0f);
         mUniformBuffer->WriteData(&mCameraUBO, sizeof(CameraUBO), 0);
 
         auto& context = Application::Get().GetGraphicContext();
@@ -243,22 +353,50 @@ public:
         cmd->BeginRenderPass(mRenderPass, mFramebuffer);
         cmd->SetViewport(window->GetWidth(), window->GetHeight(), 0.0f, 1.0f, 0, 0);
         cmd->SetScissor(window->GetWidth(), window->GetHeight(), 0, 0);
-        cmd->BindDescriptorSet(mPipeline, mDescriptorSet);
-        cmd->BindPipeline(mPipeline);
-        mPcb.model = Matrix4(1.0);
-        mPcb.model = glm::translate(mPcb.model, Vector3(0.0, 0.0, 0.0));
-        mPcb.model = glm::scale(mPcb.model, Vector3(0.3));
-        mPcb.model = Rotate(mPcb.model, Radians(mTimer.Elapsed() * 10), Vector3(0.0, 1.0, 0.0));
-        for (auto& mesh : mModel.meshes)
+        uint32_t triangleCount = 0;
+        /// Shaders and model are loaded asynchronously, draws start once base mips of textures are uploaded
+        if (!mDrawItems.empty())
+            UpdateDescriptorSet();
+
+        if (mDescriptorSet)
         {
-            cmd->PushConstants(mPipeline, 0, sizeof(PushConstantBlock), &mPcb);
-            cmd->PushConstants(mPipeline, sizeof(PushConstantBlock), sizeof(TextureIndices), &mesh.material.textureIndices);
-            cmd->BindVertexBuffer(mesh.vertexBuffer, 0);
-            cmd->BindIndexBuffer(mesh.indexBuffer, 0, IndexType::eUint32);
-            cmd->DrawIndexed(mesh.indices.size(), 1, 0, 0, 0);
+            cmd->BindDescriptorSet(mPipeline, mDescriptorSet, DescriptorSetFrequency::ePerFrame);
+            mPcb.model = Matrix4(1.0);
+            mPcb.model = glm::translate(mPcb.model, Vector3(0.0, 0.0, 0.0));
+            mPcb.model = glm::scale(mPcb.model, Vector3(0.3));
+            mPcb.model = Rotate(mPcb.model, Radians(mTimer.Elapsed() * 10), Vector3(0.0, 1.0, 0.0));
+            for (uint32_t i = 0; i < mModel.meshes.size(); ++i)
+            {
+                const auto& mesh = mModel.meshes[i];
+                Vector3 center(mPcb.model * Vector4((mesh.boundsMin + mesh.boundsMax) * 0.5f, 1.0f));
+                /// Model is scaled by 0.3, so is its simplification error
+                float lodScale = 0.3f * GetLodScale(Radians(45.0f), window->GetHeight(), glm::length(cameraPosition - center));
+                mMeshLods[i] = mesh.SelectLod(lodScale, mMeshLods[i], mMaxPixelError);
+                RequestTextureMips(mesh, lodScale);
+
+                /// Meshes with same state are drawn front to back by view space depth of their centers
+                DrawItem item = mDrawItems[i][mMeshLods[i]];
+                float viewDepth = -(mCameraUBO.view * Vector4(center, 1.0f)).z;
+                float depth = (viewDepth - NEAR_PLANE) / (FAR_PLANE - NEAR_PLANE);
+                item.sortKey = RenderQueue::MakeSortKey(0, item.pipeline, item.material, item.mesh, depth);
+                mRenderQueue.Submit(item, &mPcb, sizeof(PushConstantBlock), 0);
+                triangleCount += mesh.lods[mMeshLods[i]].indexCount / 3;
+            }
+            mRenderQueue.Execute(mCommandStream);
+            mCommandStreamExecutor.Merge(mCommandStream);
+            mCommandStreamExecutor.Execute(cmd, false);
+            mCommandStream.Reset();
         }
+
+        auto queueStats = mRenderQueue.GetStats();
+        mRenderQueue.Clear();
         mUIContext->BeginFrame();
         ImGui::SliderFloat3("Light position", &mPcb.lightPosition.x, -10.0, 10.0);
+        ImGui::Text("Draws %u, pipeline binds %u, material binds %u, mesh binds %u", queueStats.drawCount,
+                    queueStats.pipelineBindCount, queueStats.materialBindCount, queueStats.meshBindCount);
+        ImGui::SliderFloat("Camera distance", &mCameraDistance, 1.0f, 50.0f);
+        ImGui::SliderFloat("Max lod pixel error", &mMaxPixelError, 0.1f, 10.0f);
+        ImGui::Text("Triangles %u", triangleCount);
         mUIContext->EndFrame();
         cmd->EndRenderPass();
         uint32_t activeImage = context->GetActiveImageIndex();
@@ -280,6 +418,8 @@ int main(int argc, char** argv)
     appDesc.argv = argv;
     appDesc.windowDescription = windowDescription;
     appDesc.askGraphicValidation = true;
+    appDesc.shaderHotReload = true;
+    appDesc.asyncLogging = true;
     
     Application app(appDesc);
     ParallaxMappingLayer layer;
@@ -1,7 +1,11 @@
+#include "Core/AsyncFileReader.hpp"
 #include "Core/FileSystem.hpp"
-#include "Core/Event.hpp"
 #include "Core/Input.hpp"
+#include "Core/Profiler.hpp"
 #include "Renderer/GraphicContext.hpp"
+#include "Renderer/PipelineCompiler.hpp"
+#include "Renderer/ShaderHotReload.hpp"
+#include "Renderer/TextureStreamer.hpp"
 #include "Core/Application.hpp"
 
 namespace Fluent
@@ -13,10 +17,18 @@ namespace Fluent
         if (!mApplication)
         {
             mApplication = this;
+            PROFILE_THREAD("Main");
+            Log::SetAsync(description.asyncLogging);
             FileSystem::Init(description.argv);
+            mFileReader = AsyncFileReader::Create({});
+            FileSystem::SetAsyncFileReader(mFileReader.get());
             mWindow = Window::Create(description.windowDescription);
-            mWindow->SetEventCallback([this](const Event &event) { OnEvent(event); });
+            mEventBus = CreateScope<EventBus>(EventBusDescription{});
+            mWindow->SetEventCallback([this](const Event& event) { mEventBus->Push(event); });
+            mEventBus->Subscribe<WindowCloseEvent>([this](const WindowCloseEvent&) { mRunning = false; });
+            mEventBus->Subscribe<WindowResizeEvent>([this](const WindowResizeEvent&) { mResizeRequested = true; });
             mRunning = true;
+            mProfilerTrace = description.profilerTrace;
 
             GraphicContextDescription gcontextDescription{};
             gcontextDescription.requestValidation = description.askGraphicValidation;
@@ -26,7 +38,16 @@ namespace Fluent
             /// Very important! You should do it right after creation
             SetGraphicContext(*mGraphicContext);
             mGraphicContext->OnResize(mWindow->GetWidth(), mWindow->GetHeight());
-            Input::Init();
+            mPipelineCompiler = PipelineCompiler::Create({});
+            /// Created before layers are attached, so pipelines they build are registered
+            if (description.shaderHotReload)
+            {
+                ShaderHotReloadDescription shaderHotReloadDescription{};
+                shaderHotReloadDescription.pipelineCompiler = mPipelineCompiler.get();
+                mShaderHotReload = ShaderHotReload::Create(shaderHotReloadDescription);
+            }
+            mTextureStreamer = TextureStreamer::Create({});
+            Input::Init(*mEventBus);
         }
     }
 
@@ -34,11 +55,13 @@ namespace Fluent
     {
         if (mApplication)
         {
+            Log::Flush();
         }
     }
 
     void Application::PushLayer(Layer &layer)
     {
+        layer.mUpdateScopeName = Profiler::InternName(layer.GetName() + "::OnUpdate");
         mLayerStack.PushLayer(std::addressof(layer));
         layer.OnAttach();
         layer.OnLoad();
@@ -46,6 +69,7 @@ namespace Fluent
 
     void Application::PushOverlay(Layer& layer)
     {
+        layer.mUpdateScopeName = Profiler::InternName(layer.GetName() + "::OnUpdate");
         mLayerStack.PushOverlay(std::addressof(layer));
         layer.OnAttach();
         layer.OnLoad();
@@ -53,59 +77,81 @@ namespace Fluent
 
     void Application::Run()
     {
+        /// Shaders directory is known only after layers are attached
+        if (mShaderHotReload)
+            mShaderHotReload->Watch(FileSystem::GetShadersDirectory());
+
         while (mRunning)
         {
+            PROFILE_SCOPE("Application::Frame");
             float deltaTime = mDeltaTimer.Elapsed();
             mDeltaTimer.Reset();
 
+            if (mShaderHotReload)
+                mShaderHotReload->Update();
+
+            mFileReader->Update();
+
+            mPipelineCompiler->Update();
+            mTextureStreamer->Update();
+
             if (mGraphicContext->CanRender())
             {
                 mGraphicContext->BeginFrame();
                 for (auto layer : mLayerStack)
+                {
+                    PROFILE_SCOPE(layer->GetUpdateScopeName());
                     layer->OnUpdate(deltaTime);
+                }
                 mGraphicContext->EndFrame();
             }
 
             Input::OnUpdate();
             mWindow->OnUpdate();
+            mEventBus->Dispatch();
+
+            if (mResizeRequested)
+            {
+                mResizeRequested = false;
+                OnResize();
+            }
         }
         
         mGraphicContext->WaitIdle();
+        mShaderHotReload = nullptr;
+        mPipelineCompiler = nullptr;
+        mTextureStreamer = nullptr;
 
         for (auto layer : mLayerStack)
         {
             layer->OnUnload();
             layer->OnDetach();
         }
+
+        FileSystem::SetAsyncFileReader(nullptr);
+        mFileReader = nullptr;
+
+#if FLUENT_PROFILING
+        if (!mProfilerTrace.empty())
+            Profiler::WriteChromeTrace(mProfilerTrace);
+#endif
     }
 
-    void Application::OnEvent(const Event &event)
+    void Application::OnResize()
     {
-        switch (event.GetType())
+        mGraphicContext->OnResize(mWindow->GetWidth(), mWindow->GetHeight());
+        for (auto& layer : mLayerStack)
         {
-            case EventType::eWindowCloseEvent:
-            {
-                mRunning = false;
-                break;
-            }
-            case EventType::eWindowResizeEvent:
-            {
-                mGraphicContext->OnResize(mWindow->GetWidth(), mWindow->GetHeight());
-                for (auto& layer : mLayerStack)
-                {
-                    layer->OnUnload();
-                    layer->OnLoad();
-                }
-                break;
-            }
-            default:
-                break;
+            layer->OnUnload();
+            layer->OnLoad();
         }
-
-        Input::OnEvent(event);
     }
 
     Scope<GraphicContext>& Application::GetGraphicContext() { return mGraphicContext; }
+    Scope<PipelineCompiler>& Application::GetPipelineCompiler() { return mPipelineCompiler; }
+    Scope<TextureStreamer>& Application::GetTextureStreamer() { return mTextureStreamer; }
+    Scope<AsyncFileReader>& Application::GetFileReader() { return mFileReader; }
+    EventBus& Application::GetEventBus() { return *mEventBus; }
     const Scope<Window>& Application::GetWindow() const { return mWindow; }
     Application& Application::Get() { return *mApplication; }
 }
\ No newline at end of file
@@ -1,34 +1,54 @@
 
 #pragma once
 
+#include <string>
 #include "Core/Base.hpp"
+#include "Core/EventBus.hpp"
 #include "Core/LayerStack.hpp"
 #include "Core/Timer.hpp"
 #include "Core/Window.hpp"
 
 namespace Fluent
 {
+    class AsyncFileReader;
     class GraphicContext;
+    class PipelineCompiler;
+    class ShaderHotReload;
+    class TextureStreamer;
     
     struct ApplicationDescription
     {
         char** argv;
         WindowDescription windowDescription;
         bool askGraphicValidation;
+        /// Watch shaders directory and rebuild pipelines when spirv changes
+        bool shaderHotReload;
+        /// Write log messages from background thread
+        bool asyncLogging;
+        /// Chrome trace written here on shutdown, needs FLUENT_PROFILING build
+        std::string profilerTrace;
     };
 
     class Application
     {
     private:
         static Application*     mApplication;
+        Scope<EventBus>         mEventBus;
         Scope<Window>           mWindow;
+        Scope<AsyncFileReader>  mFileReader;
         Scope<GraphicContext>   mGraphicContext;
+        Scope<PipelineCompiler> mPipelineCompiler;
+        Scope<ShaderHotReload>  mShaderHotReload;
+        Scope<TextureStreamer>  mTextureStreamer;
         LayerStack              mLayerStack;
         Timer                   mDeltaTimer;
 
         bool                    mRunning = false;
+        /// Several resize events in one frame cause single swapchain recreation
+        bool                    mResizeRequested = false;
+        std::string             mProfilerTrace;
 
-        void OnEvent(const Event& event);
+        void OnResize();
     public:
         explicit Application(const ApplicationDescription& description);
         ~Application();
@@ -38,6 +58,10 @@ namespace Fluent
         void Run();
 
         Scope<GraphicContext>& GetGraphicContext();
+        Scope<PipelineCompiler>& GetPipelineCompiler();
+        Scope<TextureStreamer>& GetTextureStreamer();
+        Scope<AsyncFileReader>& GetFileReader();
+        EventBus& GetEventBus();
         const Scope<Window>& GetWindow() const;
         static Application& Get();
     };
@@ -0,0 +1,499 @@
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+#if defined(__linux__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define FLUENT_ARCHIVE_MMAP 1
+#endif
+#include "Core/Profiler.hpp"
+#include "Core/Archive.hpp"
+
+namespace Fluent
+{
+    static constexpr char       ARCHIVE_MAGIC[4] = { 'F', 'P', 'A', 'K' };
+    static constexpr uint32_t   ARCHIVE_VERSION = 1;
+    static constexpr uint32_t   ARCHIVE_ENTRY_COMPRESSED = 1 << 0;
+    /// Set in block size when block is stored without compression
+    static constexpr uint32_t   ARCHIVE_BLOCK_RAW = 1u << 31;
+
+    struct ArchiveHeader
+    {
+        char        magic[4];
+        uint32_t    version;
+        uint32_t    entryCount;
+        uint32_t    reserved;
+        uint64_t    tocOffset;
+        uint64_t    tocSize;
+    };
+
+    /// Followed by path bytes, padded to 8 bytes
+    struct ArchiveTocEntry
+    {
+        uint64_t    offset;
+        uint64_t    storedSize;
+        uint64_t    size;
+        uint32_t    flags;
+        uint32_t    pathLength;
+    };
+
+    /// Blocks use LZ4 block format
+    static constexpr uint32_t LZ4_MIN_MATCH = 4;
+    static constexpr uint32_t LZ4_LAST_LITERALS = 5;
+    /// Last match starts at least this far from block end
+    static constexpr uint32_t LZ4_MATCH_LIMIT = 12;
+    static constexpr uint32_t LZ4_MAX_OFFSET = 65535;
+    static constexpr uint32_t LZ4_HASH_BITS = 12;
+
+    static uint32_t Load32(const uint8_t* data)
+    {
+        uint32_t value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    static uint32_t Lz4Hash(uint32_t sequence)
+    {
+        return (sequence * 2654435761u) >> (32 - LZ4_HASH_BITS);
+    }
+
+    static bool Lz4WriteLength(uint8_t*& out, const uint8_t* outEnd, uint32_t length)
+    {
+        for (; length >= 255; length -= 255)
+        {
+            if (out == outEnd)
+                return false;
+            *out++ = 255;
+        }
+
+        if (out == outEnd)
+            return false;
+        *out++ = static_cast<uint8_t>(length);
+        return true;
+    }
+
+    static bool Lz4WriteSequence(uint8_t*& out, const uint8_t* outEnd, const uint8_t* literals, uint32_t literalLength)
+    {
+        if (out == outEnd)
+            return false;
+
+        *out++ = static_cast<uint8_t>(std::min(literalLength, 15u) << 4);
+        if (literalLength >= 15 && !Lz4WriteLength(out, outEnd, literalLength - 15))
+            return false;
+        if (static_cast<uint32_t>(outEnd - out) < literalLength)
+            return false;
+
+        std::memcpy(out, literals, literalLength);
+        out += literalLength;
+        return true;
+    }
+
+    /// Greedy single hash compressor, returns 0 when result does not fit capacity
+    static uint32_t Lz4CompressBlock(const uint8_t* src, uint32_t size, uint8_t* dst, uint32_t capacity)
+    {
+        std::array<uint32_t, 1 << LZ4_HASH_BITS> table{};
+        uint8_t* out = dst;
+        const uint8_t* outEnd = dst + capacity;
+        uint32_t anchor = 0;
+        uint32_t position = 0;
+
+        while (position + LZ4_MATCH_LIMIT <= size)
+        {
+            uint32_t sequence = Load32(src + position);
+            uint32_t hash = Lz4Hash(sequence);
+            uint32_t candidate = table[hash];
+            table[hash] = position;
+            if (candidate >= position || position - candidate > LZ4_MAX_OFFSET || Load32(src + candidate) != sequence)
+            {
+                position++;
+                continue;
+            }
+
+            uint32_t matchEnd = position + LZ4_MIN_MATCH;
+            while (matchEnd < size - LZ4_LAST_LITERALS && src[matchEnd] == src[candidate + matchEnd - position])
+                matchEnd++;
+
+            uint8_t* token = out;
+            if (!Lz4WriteSequence(out, outEnd, src + anchor, position - anchor) || outEnd - out < 2)
+                return 0;
+
+            uint32_t offset = position - candidate;
+            *out++ = static_cast<uint8_t>(offset);
+            *out++ = static_cast<uint8_t>(offset >> 8);
+
+            uint32_t matchLength = matchEnd - position - LZ4_MIN_MATCH;
+            *token |= static_cast<uint8_t>(std::min(matchLength, 15u));
+            if (matchLength >= 15 && !Lz4WriteLength(out, outEnd, matchLength - 15))
+                return 0;
+
+            position = anchor = matchEnd;
+        }
+
+        if (!Lz4WriteSequence(out, outEnd, src + anchor, size - anchor))
+            return 0;
+
+        return static_cast<uint32_t>(out - dst);
+    }
+
+    static bool Lz4ReadLength(const uint8_t*& in, const uint8_t* inEnd, size_t& length)
+    {
+        uint8_t value;
+        do
+        {
+            if (in == inEnd)
+                return false;
+            value = *in++;
+            length += value;
+        } while (value == 255);
+
+        return true;
+    }
+
+    /// Fails on malformed input instead of reading or writing out of bounds
+    static bool Lz4DecompressBlock(const uint8_t* src, uint32_t size, uint8_t* dst, uint32_t dstSize)
+    {
+        const uint8_t* in = src;
+        const uint8_t* inEnd = src + size;
+        uint8_t* out = dst;
+        const uint8_t* outEnd = dst + dstSize;
+
+        while (in < inEnd)
+        {
+            uint8_t token = *in++;
+            size_t literalLength = token >> 4;
+            if (literalLength == 15 && !Lz4ReadLength(in, inEnd, literalLength))
+                return false;
+            if (literalLength > size_t(inEnd - in) || literalLength > size_t(outEnd - out))
+                return false;
+
+            std::memcpy(out, in, literalLength);
+            in += literalLength;
+            out += literalLength;
+
+            /// Last sequence has literals only
+            if (in == inEnd)
+                break;
+            if (inEnd - in < 2)
+                return false;
+
+            size_t offset = in[0] | (size_t(in[1]) << 8);
+            in += 2;
+            if (offset == 0 || offset > size_t(out - dst))
+                return false;
+
+            size_t matchLength = token & 15;
+            if (matchLength == 15 && !Lz4ReadLength(in, inEnd, matchLength))
+                return false;
+            matchLength += LZ4_MIN_MATCH;
+            if (matchLength > size_t(outEnd - out))
+                return false;
+
+            /// Match could overlap output, so it is copied byte by byte
+            const uint8_t* match = out - offset;
+            for (size_t i = 0; i < matchLength; ++i)
+                out[i] = match[i];
+            out += matchLength;
+        }
+
+        return out == outEnd;
+    }
+
+    static uint32_t GetBlockCount(uint64_t size)
+    {
+        return static_cast<uint32_t>((size + ARCHIVE_BLOCK_SIZE - 1) / ARCHIVE_BLOCK_SIZE);
+    }
+
+    class MappedArchive : public Archive
+    {
+    private:
+        const uint8_t*                              mData = nullptr;
+        uint64_t                                    mSize = 0;
+#ifndef FLUENT_ARCHIVE_MMAP
+        std::vector<uint8_t>                        mStorage;
+#endif
+        std::vector<ArchiveEntry>                   mEntries;
+        std::unordered_map<std::string, uint32_t>   mLookup;
+        bool                                        mValid = false;
+
+        bool MapFile(const std::string& filename)
+        {
+#ifdef FLUENT_ARCHIVE_MMAP
+            int handle = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+            if (handle < 0)
+                return false;
+
+            struct stat status{};
+            if (fstat(handle, &status) != 0 || status.st_size <= 0)
+            {
+                close(handle);
+                return false;
+            }
+
+            /// Mapping stays valid after descriptor is closed
+            void* data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, handle, 0);
+            close(handle);
+            if (data == MAP_FAILED)
+                return false;
+
+            mData = static_cast<const uint8_t*>(data);
+            mSize = static_cast<uint64_t>(status.st_size);
+#else
+            std::ifstream file(filename, std::ios::binary);
+            if (!file)
+                return false;
+
+            mStorage.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            mData = mStorage.data();
+            mSize = mStorage.size();
+#endif
+            return true;
+        }
+
+        bool ReadTableOfContents()
+        {
+            ArchiveHeader header;
+            if (mSize < sizeof(header))
+                return false;
+
+            std::memcpy(&header, mData, sizeof(header));
+            if (std::memcmp(header.magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC)) != 0 || header.version != ARCHIVE_VERSION)
+                return false;
+            if (header.tocOffset > mSize || header.tocSize > mSize - header.tocOffset)
+                return false;
+
+            const uint8_t* toc = mData + header.tocOffset;
+            const uint8_t* tocEnd = toc + header.tocSize;
+            mEntries.reserve(header.entryCount);
+            for (uint32_t i = 0; i < header.entryCount; ++i)
+            {
+                ArchiveTocEntry tocEntry;
+                if (size_t(tocEnd - toc) < sizeof(tocEntry))
+                    return false;
+
+                std::memcpy(&tocEntry, toc, sizeof(tocEntry));
+                toc += sizeof(tocEntry);
+                if (size_t(tocEnd - toc) < tocEntry.pathLength)
+                    return false;
+                if (tocEntry.offset > mSize || tocEntry.storedSize > mSize - tocEntry.offset)
+                    return false;
+                /// Uncompressed entries are mapped and copied with their size, so it must be what's stored
+                if (!(tocEntry.flags & ARCHIVE_ENTRY_COMPRESSED) && tocEntry.size != tocEntry.storedSize)
+                    return false;
+
+                auto& entry = mEntries.emplace_back();
+                entry.path.assign(reinterpret_cast<const char*>(toc), tocEntry.pathLength);
+                entry.offset = tocEntry.offset;
+                entry.storedSize = tocEntry.storedSize;
+                entry.size = tocEntry.size;
+                entry.compressed = tocEntry.flags & ARCHIVE_ENTRY_COMPRESSED;
+                toc += std::min<size_t>((tocEntry.pathLength + 7) & ~7u, tocEnd - toc);
+
+                mLookup[entry.path] = i;
+            }
+
+            return true;
+        }
+    public:
+        explicit MappedArchive(const ArchiveDescription& description)
+        {
+            if (!MapFile(description.filename))
+            {
+                LOG_CATEGORY_WARN(eCore, "Failed to open archive {}", description.filename);
+                return;
+            }
+
+            mValid = ReadTableOfContents();
+            if (!mValid)
+                LOG_CATEGORY_WARN(eCore, "Archive {} is corrupted", description.filename);
+        }
+
+        ~MappedArchive() override
+        {
+#ifdef FLUENT_ARCHIVE_MMAP
+            if (mData)
+                munmap(const_cast<uint8_t*>(mData), static_cast<size_t>(mSize));
+#endif
+        }
+
+        bool IsValid() const { return mValid; }
+
+        const ArchiveEntry* Find(const std::string& path) const override
+        {
+            auto it = mLookup.find(path);
+            return it == mLookup.end() ? nullptr : &mEntries[it->second];
+        }
+
+        const void* Map(const ArchiveEntry& entry) const override
+        {
+            return entry.compressed ? nullptr : mData + entry.offset;
+        }
+
+        bool Read(const ArchiveEntry& entry, void* dst) const override
+        {
+            PROFILE_SCOPE("Archive::Read");
+            if (!entry.compressed)
+            {
+                if (entry.size > 0)
+                    std::memcpy(dst, mData + entry.offset, static_cast<size_t>(entry.size));
+                return true;
+            }
+
+            uint32_t blockCount = GetBlockCount(entry.size);
+            uint64_t tableSize = uint64_t(blockCount) * sizeof(uint32_t);
+            if (tableSize > entry.storedSize)
+                return false;
+
+            const uint8_t* blockSizes = mData + entry.offset;
+            const uint8_t* block = blockSizes + tableSize;
+            const uint8_t* end = mData + entry.offset + entry.storedSize;
+            auto out = static_cast<uint8_t*>(dst);
+            for (uint32_t i = 0; i < blockCount; ++i)
+            {
+                uint32_t blockSize = Load32(blockSizes + i * sizeof(uint32_t));
+                bool raw = blockSize & ARCHIVE_BLOCK_RAW;
+                blockSize &= ~ARCHIVE_BLOCK_RAW;
+
+                auto decompressedSize = static_cast<uint32_t>(std::min<uint64_t>(ARCHIVE_BLOCK_SIZE, entry.size - uint64_t(i) * ARCHIVE_BLOCK_SIZE));
+                if (blockSize > size_t(end - block) || (raw && blockSize != decompressedSize))
+                    return false;
+
+                if (raw)
+                    std::memcpy(out, block, blockSize);
+                else if (!Lz4DecompressBlock(block, blockSize, out, decompressedSize))
+                    return false;
+
+                block += blockSize;
+                out += decompressedSize;
+            }
+
+            return true;
+        }
+
+        const std::vector<ArchiveEntry>& GetEntries() const override { return mEntries; }
+    };
+
+    void ArchiveWriter::AddFile(const std::string& path, const void* data, size_t size, bool compress)
+    {
+        PendingEntry entry;
+        entry.path = std::filesystem::path(path).lexically_normal().generic_string();
+        entry.size = size;
+        entry.compressed = false;
+
+        auto src = static_cast<const uint8_t*>(data);
+        if (compress && size > 0)
+        {
+            uint32_t blockCount = GetBlockCount(size);
+            entry.data.resize(blockCount * sizeof(uint32_t) + size);
+            size_t offset = blockCount * sizeof(uint32_t);
+            for (uint32_t i = 0; i < blockCount; ++i)
+            {
+                auto blockSize = static_cast<uint32_t>(std::min<size_t>(ARCHIVE_BLOCK_SIZE, size - size_t(i) * ARCHIVE_BLOCK_SIZE));
+                const uint8_t* block = src + size_t(i) * ARCHIVE_BLOCK_SIZE;
+
+                /// Compressed block must be smaller than source, else it is stored raw
+                uint32_t storedSize = Lz4CompressBlock(block, blockSize, entry.data.data() + offset, blockSize - 1);
+                uint32_t sizeField = storedSize;
+                if (storedSize == 0)
+                {
+                    std::memcpy(entry.data.data() + offset, block, blockSize);
+                    storedSize = blockSize;
+                    sizeField = blockSize | ARCHIVE_BLOCK_RAW;
+                }
+
+                std::memcpy(entry.data.data() + i * sizeof(uint32_t), &sizeField, sizeof(sizeField));
+                offset += storedSize;
+            }
+
+            entry.data.resize(offset);
+            entry.compressed = offset < size;
+        }
+
+        if (!entry.compressed)
+            entry.data.assign(src, src + size);
+
+        mEntries.emplace_back(std::move(entry));
+    }
+
+    bool ArchiveWriter::AddDirectory(const std::string& directory, bool compress)
+    {
+        std::error_code error;
+        std::filesystem::recursive_directory_iterator it(directory, error);
+        if (error)
+            return false;
+
+        for (const auto& file : it)
+        {
+            if (!file.is_regular_file())
+                continue;
+
+            std::ifstream stream(file.path(), std::ios::binary);
+            std::vector<char> data = { std::istreambuf_iterator(stream), std::istreambuf_iterator<char>() };
+            AddFile(std::filesystem::relative(file.path(), directory).generic_string(), data.data(), data.size(), compress);
+        }
+
+        return true;
+    }
+
+    bool ArchiveWriter::Write(const std::string& filename) const
+    {
+        std::ofstream file(filename, std::ios::binary);
+        if (!file)
+            return false;
+
+        ArchiveHeader header{};
+        std::memcpy(header.magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC));
+        header.version = ARCHIVE_VERSION;
+        header.entryCount = static_cast<uint32_t>(mEntries.size());
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        static constexpr char padding[ARCHIVE_ALIGNMENT] = {};
+        auto pad = [&file](uint64_t alignment)
+        {
+            auto position = static_cast<uint64_t>(file.tellp());
+            file.write(padding, static_cast<std::streamsize>((alignment - position % alignment) % alignment));
+        };
+
+        std::vector<uint8_t> toc;
+        for (const auto& entry : mEntries)
+        {
+            pad(ARCHIVE_ALIGNMENT);
+
+            ArchiveTocEntry tocEntry{};
+            tocEntry.offset = static_cast<uint64_t>(file.tellp());
+            tocEntry.storedSize = entry.data.size();
+            tocEntry.size = entry.size;
+            tocEntry.flags = entry.compressed ? ARCHIVE_ENTRY_COMPRESSED : 0;
+            tocEntry.pathLength = static_cast<uint32_t>(entry.path.size());
+            file.write(reinterpret_cast<const char*>(entry.data.data()), static_cast<std::streamsize>(entry.data.size()));
+
+            auto tocOffset = toc.size();
+            toc.resize(tocOffset + sizeof(tocEntry) + ((entry.path.size() + 7) & ~size_t(7)));
+            std::memcpy(toc.data() + tocOffset, &tocEntry, sizeof(tocEntry));
+            std::memcpy(toc.data() + tocOffset + sizeof(tocEntry), entry.path.data(), entry.path.size());
+        }
+
+        pad(8);
+        header.tocOffset = static_cast<uint64_t>(file.tellp());
+        header.tocSize = toc.size();
+        file.write(reinterpret_cast<const char*>(toc.data()), static_cast<std::streamsize>(toc.size()));
+
+        file.seekp(0);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        return static_cast<bool>(file);
+    }
+
+    /// Interface
+
+    Scope<Archive> Archive::Create(const ArchiveDescription& description)
+    {
+        auto archive = CreateScope<MappedArchive>(description);
+        if (!archive->IsValid())
+            return nullptr;
+        return archive;
+    }
+} // namespace Fluent
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Core/Base.hpp"
+
+namespace Fluent
+{
+    /// Payload offsets are aligned to it, so uncompressed entries could be copied to staging memory as is
+    static constexpr uint32_t ARCHIVE_ALIGNMENT = 256;
+    /// Compressed entries are split into independent blocks of this size
+    static constexpr uint32_t ARCHIVE_BLOCK_SIZE = 64 * 1024;
+
+    struct ArchiveEntry
+    {
+        /// Relative path with '/' separators
+        std::string path;
+        uint64_t    offset = 0;
+        uint64_t    storedSize = 0;
+        /// Size after decompression
+        uint64_t    size = 0;
+        bool        compressed = false;
+    };
+
+    struct ArchiveDescription
+    {
+        std::string filename;
+    };
+
+    /// Packed files with table of contents, file is memory mapped once and entries are read without
+    /// opening files. Reads are thread safe
+    class Archive
+    {
+    protected:
+        Archive() = default;
+    public:
+        virtual ~Archive() = default;
+
+        virtual const ArchiveEntry* Find(const std::string& path) const = 0;
+        /// Zero copy view of uncompressed entry, nullptr for compressed ones
+        virtual const void* Map(const ArchiveEntry& entry) const = 0;
+        /// Copies or decompresses entry into dst which has entry size bytes
+        virtual bool Read(const ArchiveEntry& entry, void* dst) const = 0;
+
+        virtual const std::vector<ArchiveEntry>& GetEntries() const = 0;
+
+        /// Returns nullptr when file could not be opened or is not an archive
+        static Scope<Archive> Create(const ArchiveDescription& description);
+    };
+
+    /// Builds archive in memory, entries are compressed when added
+    class ArchiveWriter
+    {
+        struct PendingEntry
+        {
+            std::string             path;
+            std::vector<uint8_t>    data;
+            uint64_t                size;
+            bool                    compressed;
+        };
+    private:
+        std::vector<PendingEntry>   mEntries;
+    public:
+        /// Compression is dropped for entries which do not get smaller
+        void AddFile(const std::string& path, const void* data, size_t size, bool compress = false);
+        /// Adds every file below directory with paths relative to it
+        bool AddDirectory(const std::string& directory, bool compress = false);
+        bool Write(const std::string& filename) const;
+
+        uint32_t GetEntryCount() const { return static_cast<uint32_t>(mEntries.size()); }
+    };
+} // namespace Fluent
@@ -0,0 +1,529 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#ifdef __linux__
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#include "Core/FileSystem.hpp"
+#include "Core/Profiler.hpp"
+#include "Core/AsyncFileReader.hpp"
+
+namespace Fluent
+{
+    class AsyncFileReadBatch : public FileReadBatch
+    {
+    private:
+        friend class AsyncFileReaderBase;
+
+        std::vector<FileReadResult> mResults;
+        FileReadCallback            mCallback;
+        std::atomic<uint32_t>       mRemaining;
+        std::mutex                  mMutex;
+        std::condition_variable     mCondition;
+        bool                        mCallbackCalled = false;
+
+        void CallCallback()
+        {
+            if (mCallbackCalled)
+                return;
+
+            mCallbackCalled = true;
+            if (mCallback)
+                mCallback(mResults);
+        }
+    public:
+        AsyncFileReadBatch(const std::vector<std::string>& paths, FileReadCallback callback)
+            : mCallback(std::move(callback))
+            , mRemaining(static_cast<uint32_t>(paths.size()))
+        {
+            mResults.resize(paths.size());
+            for (size_t i = 0; i < paths.size(); ++i)
+                mResults[i].path = paths[i];
+        }
+
+        /// Called by backend thread after result is written
+        void Complete(uint32_t index, bool success)
+        {
+            mResults[index].success = success;
+            if (!success)
+                mResults[index].data.clear();
+
+            std::scoped_lock lock(mMutex);
+            if (--mRemaining == 0)
+                mCondition.notify_all();
+        }
+
+        bool IsReady() const override { return mRemaining == 0; }
+
+        void Wait() override
+        {
+            {
+                std::unique_lock lock(mMutex);
+                mCondition.wait(lock, [this]() { return mRemaining == 0; });
+            }
+
+            CallCallback();
+        }
+
+        std::vector<FileReadResult>& GetResults() override { return mResults; }
+    };
+
+    struct FileReadItem
+    {
+        Ref<AsyncFileReadBatch> batch;
+        uint32_t                index;
+
+        FileReadResult& GetResult() const { return batch->GetResults()[index]; }
+    };
+
+    /// Batch bookkeeping shared by backends
+    class AsyncFileReaderBase : public AsyncFileReader
+    {
+    private:
+        std::vector<Ref<AsyncFileReadBatch>> mPending;
+    protected:
+        virtual void Enqueue(std::vector<FileReadItem>&& items) = 0;
+
+        /// Items which were never started on shutdown, so nobody waits for them forever
+        static void FailQueued(std::deque<FileReadItem>& queue)
+        {
+            for (auto& item : queue)
+                item.batch->Complete(item.index, false);
+            queue.clear();
+        }
+    public:
+        Ref<FileReadBatch> Read(const std::vector<std::string>& paths, FileReadCallback callback) override
+        {
+            auto batch = CreateRef<AsyncFileReadBatch>(paths, std::move(callback));
+            /// Empty batch is ready at once, its callback is still called from Update
+            if (batch->mCallback)
+                mPending.push_back(batch);
+            if (paths.empty())
+                return batch;
+
+            std::vector<FileReadItem> items;
+            items.reserve(paths.size());
+            for (uint32_t i = 0; i < paths.size(); ++i)
+                items.push_back({ batch, i });
+
+            Enqueue(std::move(items));
+            return batch;
+        }
+
+        void Update() override
+        {
+            PROFILE_SCOPE("AsyncFileReader::Update");
+            /// Callback could submit new batches, so finished ones are taken out first
+            std::vector<Ref<AsyncFileReadBatch>> finished;
+            auto it = std::stable_partition(mPending.begin(), mPending.end(), [](const Ref<AsyncFileReadBatch>& batch)
+            {
+                return !batch->IsReady();
+            });
+
+            std::move(it, mPending.end(), std::back_inserter(finished));
+            mPending.erase(it, mPending.end());
+            for (auto& batch : finished)
+                batch->CallCallback();
+        }
+    };
+
+    class ThreadPoolFileReader : public AsyncFileReaderBase
+    {
+    private:
+        std::vector<std::thread>    mWorkers;
+        std::mutex                  mMutex;
+        std::condition_variable     mCondition;
+        std::deque<FileReadItem>    mQueue;
+        bool                        mStopping = false;
+
+        void WorkerLoop()
+        {
+            PROFILE_THREAD("FileReader");
+            while (true)
+            {
+                FileReadItem item;
+                {
+                    std::unique_lock lock(mMutex);
+                    mCondition.wait(lock, [this]() { return mStopping || !mQueue.empty(); });
+                    if (mStopping)
+                        return;
+
+                    item = std::move(mQueue.front());
+                    mQueue.pop_front();
+                }
+
+                PROFILE_SCOPE("FileReader::Read");
+                auto& result = item.GetResult();
+                result.data.resize(FileSystem::GetFileSize(result.path));
+                item.batch->Complete(item.index, FileSystem::ReadFile(result.path, result.data.data()));
+            }
+        }
+    protected:
+        void Enqueue(std::vector<FileReadItem>&& items) override
+        {
+            {
+                std::scoped_lock lock(mMutex);
+                for (auto& item : items)
+                    mQueue.push_back(std::move(item));
+            }
+
+            mCondition.notify_all();
+        }
+    public:
+        explicit ThreadPoolFileReader(const AsyncFileReaderDescription& description)
+        {
+            uint32_t workerCount = std::max(description.workerCount, 1u);
+            for (uint32_t i = 0; i < workerCount; ++i)
+                mWorkers.emplace_back(&ThreadPoolFileReader::WorkerLoop, this);
+        }
+
+        ~ThreadPoolFileReader() override
+        {
+            {
+                std::scoped_lock lock(mMutex);
+                mStopping = true;
+            }
+
+            mCondition.notify_all();
+            for (auto& worker : mWorkers)
+                worker.join();
+
+            FailQueued(mQueue);
+        }
+
+        const char* GetBackendName() const override { return "Thread pool"; }
+    };
+
+#ifdef __linux__
+    /// Raw syscalls, so no liburing is needed
+    static int IoUringSetup(uint32_t entries, io_uring_params* params)
+    {
+        return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+    }
+
+    static int IoUringEnter(int ring, uint32_t submitCount, uint32_t waitCount, uint32_t flags)
+    {
+        return static_cast<int>(syscall(__NR_io_uring_enter, ring, submitCount, waitCount, flags, nullptr, 0));
+    }
+
+    /// One service thread opens files and keeps up to queue depth reads in flight. Archived files
+    /// are copied from mapped archive on same thread
+    class IoUringFileReader : public AsyncFileReaderBase
+    {
+        struct InFlightRead
+        {
+            FileReadItem    item;
+            int             file = -1;
+            uint64_t        offset = 0;
+        };
+    private:
+        int                         mRing = -1;
+        void*                       mSqRing = nullptr;
+        size_t                      mSqRingSize = 0;
+        void*                       mCqRing = nullptr;
+        size_t                      mCqRingSize = 0;
+        io_uring_sqe*               mSqes = nullptr;
+        size_t                      mSqesSize = 0;
+        uint32_t*                   mSqHead = nullptr;
+        uint32_t*                   mSqTail = nullptr;
+        uint32_t*                   mSqMask = nullptr;
+        uint32_t*                   mSqArray = nullptr;
+        uint32_t*                   mCqHead = nullptr;
+        uint32_t*                   mCqTail = nullptr;
+        uint32_t*                   mCqMask = nullptr;
+        io_uring_cqe*               mCqes = nullptr;
+
+        std::thread                 mThread;
+        std::mutex                  mMutex;
+        std::condition_variable     mCondition;
+        std::deque<FileReadItem>    mQueue;
+        bool                        mStopping = false;
+
+        /// Service thread state
+        std::vector<InFlightRead>   mSlots;
+        std::vector<uint32_t>       mFreeSlots;
+        uint32_t                    mPendingSubmitCount = 0;
+
+        bool InitRing(uint32_t queueDepth)
+        {
+            io_uring_params params{};
+            mRing = IoUringSetup(queueDepth, &params);
+            if (mRing < 0)
+                return false;
+
+            mSqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+            mCqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+            bool singleMap = params.features & IORING_FEAT_SINGLE_MMAP;
+            if (singleMap)
+                mSqRingSize = mCqRingSize = std::max(mSqRingSize, mCqRingSize);
+
+            mSqRing = mmap(nullptr, mSqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRing, IORING_OFF_SQ_RING);
+            if (mSqRing == MAP_FAILED)
+            {
+                mSqRing = nullptr;
+                return false;
+            }
+
+            mCqRing = singleMap ? mSqRing : mmap(nullptr, mCqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRing, IORING_OFF_CQ_RING);
+            if (mCqRing == MAP_FAILED)
+            {
+                mCqRing = nullptr;
+                return false;
+            }
+
+            mSqesSize = params.sq_entries * sizeof(io_uring_sqe);
+            void* sqes = mmap(nullptr, mSqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRing, IORING_OFF_SQES);
+            if (sqes == MAP_FAILED)
+                return false;
+
+            auto sqRing = static_cast<uint8_t*>(mSqRing);
+            auto cqRing = static_cast<uint8_t*>(mCqRing);
+            mSqes = static_cast<io_uring_sqe*>(sqes);
+            mSqHead = reinterpret_cast<uint32_t*>(sqRing + params.sq_off.head);
+            mSqTail = reinterpret_cast<uint32_t*>(sqRing + params.sq_off.tail);
+            mSqMask = reinterpret_cast<uint32_t*>(sqRing + params.sq_off.ring_mask);
+            mSqArray = reinterpret_cast<uint32_t*>(sqRing + params.sq_off.array);
+            mCqHead = reinterpret_cast<uint32_t*>(cqRing + params.cq_off.head);
+            mCqTail = reinterpret_cast<uint32_t*>(cqRing + params.cq_off.tail);
+            mCqMask = reinterpret_cast<uint32_t*>(cqRing + params.cq_off.ring_mask);
+            mCqes = reinterpret_cast<io_uring_cqe*>(cqRing + params.cq_off.cqes);
+
+            /// Completion ring is at least as large, so it never overflows
+            mSlots.resize(params.sq_entries);
+            for (uint32_t i = 0; i < params.sq_entries; ++i)
+                mFreeSlots.push_back(params.sq_entries - 1 - i);
+
+            return true;
+        }
+
+        void PrepareRead(uint32_t slot)
+        {
+            auto& read = mSlots[slot];
+            auto& data = read.item.GetResult().data;
+
+            uint32_t tail = *mSqTail;
+            uint32_t index = tail & *mSqMask;
+            auto& sqe = mSqes[index];
+            std::memset(&sqe, 0, sizeof(sqe));
+            sqe.opcode = IORING_OP_READ;
+            sqe.fd = read.file;
+            sqe.addr = reinterpret_cast<uint64_t>(data.data() + read.offset);
+            /// Reads larger than 2 GB are split by kernel anyway
+            sqe.len = static_cast<uint32_t>(std::min<uint64_t>(data.size() - read.offset, 1u << 30));
+            sqe.off = read.offset;
+            sqe.user_data = slot;
+
+            mSqArray[index] = index;
+            __atomic_store_n(mSqTail, tail + 1, __ATOMIC_RELEASE);
+            mPendingSubmitCount++;
+        }
+
+        void Finish(uint32_t slot, bool success)
+        {
+            auto& read = mSlots[slot];
+            close(read.file);
+            read.item.batch->Complete(read.item.index, success);
+            read = {};
+            mFreeSlots.push_back(slot);
+        }
+
+        /// Kernels before 5.6 have no IORING_OP_READ, those reads are finished with pread
+        bool ReadBlocking(InFlightRead& read)
+        {
+            auto& data = read.item.GetResult().data;
+            while (read.offset < data.size())
+            {
+                auto count = pread(read.file, data.data() + read.offset, data.size() - read.offset, static_cast<off_t>(read.offset));
+                if (count <= 0)
+                    return false;
+                read.offset += static_cast<uint64_t>(count);
+            }
+
+            return true;
+        }
+
+        void Start(FileReadItem&& item)
+        {
+            auto& result = item.GetResult();
+            if (FileSystem::IsArchived(result.path))
+            {
+                result.data.resize(FileSystem::GetFileSize(result.path));
+                item.batch->Complete(item.index, FileSystem::ReadFile(result.path, result.data.data()));
+                return;
+            }
+
+            int file = open(result.path.c_str(), O_RDONLY | O_CLOEXEC);
+            struct stat status{};
+            if (file < 0 || fstat(file, &status) != 0)
+            {
+                if (file >= 0)
+                    close(file);
+                item.batch->Complete(item.index, false);
+                return;
+            }
+
+            result.data.resize(static_cast<size_t>(status.st_size));
+            uint32_t slot = mFreeSlots.back();
+            mFreeSlots.pop_back();
+            mSlots[slot].item = std::move(item);
+            mSlots[slot].file = file;
+            if (result.data.empty())
+            {
+                Finish(slot, true);
+                return;
+            }
+
+            PrepareRead(slot);
+        }
+
+        void ReapCompletions()
+        {
+            uint32_t head = *mCqHead;
+            uint32_t tail = __atomic_load_n(mCqTail, __ATOMIC_ACQUIRE);
+            for (; head != tail; ++head)
+            {
+                const auto& cqe = mCqes[head & *mCqMask];
+                auto slot = static_cast<uint32_t>(cqe.user_data);
+                auto& read = mSlots[slot];
+                if (cqe.res == -EINVAL || cqe.res == -EOPNOTSUPP)
+                {
+                    Finish(slot, ReadBlocking(read));
+                    continue;
+                }
+
+                if (cqe.res == -EINTR || cqe.res == -EAGAIN)
+                {
+                    PrepareRead(slot);
+                    continue;
+                }
+
+                /// File became shorter since fstat
+                if (cqe.res <= 0)
+                {
+                    Finish(slot, false);
+                    continue;
+                }
+
+                read.offset += static_cast<uint64_t>(cqe.res);
+                if (read.offset < read.item.GetResult().data.size())
+                    PrepareRead(slot);
+                else
+                    Finish(slot, true);
+            }
+
+            __atomic_store_n(mCqHead, head, __ATOMIC_RELEASE);
+        }
+
+        void ServiceLoop()
+        {
+            PROFILE_THREAD("FileReader");
+            while (true)
+            {
+                std::vector<FileReadItem> started;
+                {
+                    std::unique_lock lock(mMutex);
+                    bool idle = mFreeSlots.size() == mSlots.size();
+                    if (idle)
+                        mCondition.wait(lock, [this]() { return mStopping || !mQueue.empty(); });
+                    if (mStopping && idle)
+                        return;
+
+                    while (!mStopping && !mQueue.empty() && started.size() < mFreeSlots.size())
+                    {
+                        started.push_back(std::move(mQueue.front()));
+                        mQueue.pop_front();
+                    }
+                }
+
+                for (auto& item : started)
+                    Start(std::move(item));
+
+                if (mFreeSlots.size() == mSlots.size())
+                    continue;
+
+                /// Waits for at least one completion, new requests are taken after it
+                int result = IoUringEnter(mRing, mPendingSubmitCount, 1, IORING_ENTER_GETEVENTS);
+                if (result >= 0)
+                    mPendingSubmitCount -= std::min(static_cast<uint32_t>(result), mPendingSubmitCount);
+                else if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+                    LOG_CATEGORY_ERROR(eCore, "io_uring_enter failed with {}", strerror(errno));
+
+                ReapCompletions();
+            }
+        }
+    protected:
+        void Enqueue(std::vector<FileReadItem>&& items) override
+        {
+            {
+                std::scoped_lock lock(mMutex);
+                for (auto& item : items)
+                    mQueue.push_back(std::move(item));
+            }
+
+            mCondition.notify_one();
+        }
+    public:
+        explicit IoUringFileReader(const AsyncFileReaderDescription& description)
+        {
+            if (InitRing(std::max(description.queueDepth, 1u)))
+                mThread = std::thread(&IoUringFileReader::ServiceLoop, this);
+        }
+
+        ~IoUringFileReader() override
+        {
+            if (mThread.joinable())
+            {
+                {
+                    std::scoped_lock lock(mMutex);
+                    mStopping = true;
+                }
+
+                mCondition.notify_one();
+                mThread.join();
+            }
+
+            FailQueued(mQueue);
+
+            if (mSqes)
+                munmap(mSqes, mSqesSize);
+            if (mCqRing && mCqRing != mSqRing)
+                munmap(mCqRing, mCqRingSize);
+            if (mSqRing)
+                munmap(mSqRing, mSqRingSize);
+            if (mRing >= 0)
+                close(mRing);
+        }
+
+        bool IsValid() const { return mThread.joinable(); }
+
+        const char* GetBackendName() const override { return "io_uring"; }
+    };
+#endif
+
+    /// Interface
+
+    Scope<AsyncFileReader> AsyncFileReader::Create(const AsyncFileReaderDescription& description)
+    {
+#ifdef __linux__
+        if (description.preferIoUring)
+        {
+            auto reader = CreateScope<IoUringFileReader>(description);
+            if (reader->IsValid())
+                return reader;
+
+            LOG_CATEGORY_WARN(eCore, "io_uring is not available, falling back to thread pool file reader");
+        }
+#endif
+        return CreateScope<ThreadPoolFileReader>(description);
+    }
+} // namespace Fluent
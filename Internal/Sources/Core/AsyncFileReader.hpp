@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "Core/Base.hpp"
+
+namespace Fluent
+{
+    struct AsyncFileReaderDescription
+    {
+        /// Max reads submitted to kernel at once
+        uint32_t    queueDepth = 64;
+        /// Threads of fallback backend
+        uint32_t    workerCount = 4;
+        bool        preferIoUring = true;
+    };
+
+    struct FileReadResult
+    {
+        std::string         path;
+        /// Empty on failure
+        std::vector<char>   data;
+        bool                success = false;
+    };
+
+    using FileReadCallback = std::function<void(std::vector<FileReadResult>& results)>;
+
+    /// Files submitted together, results are in submission order
+    class FileReadBatch
+    {
+    protected:
+        FileReadBatch() = default;
+    public:
+        virtual ~FileReadBatch() = default;
+
+        virtual bool IsReady() const = 0;
+        /// Blocks until every file is read, callback is called here unless Update already did
+        virtual void Wait() = 0;
+        virtual std::vector<FileReadResult>& GetResults() = 0;
+    };
+
+    /// Reads files without blocking calling thread. Paths are full paths as for FileSystem,
+    /// mounted archives are read too. Read, Update and Wait should be called from one thread
+    class AsyncFileReader
+    {
+    protected:
+        AsyncFileReader() = default;
+    public:
+        virtual ~AsyncFileReader() = default;
+
+        /// Reads left in queue when reader is destroyed fail, so waiting for them doesn't hang
+        virtual Ref<FileReadBatch> Read(const std::vector<std::string>& paths, FileReadCallback callback = nullptr) = 0;
+        /// Calls callbacks of finished batches
+        virtual void Update() = 0;
+
+        virtual const char* GetBackendName() const = 0;
+
+        /// io_uring on Linux when kernel allows it, thread pool otherwise
+        static Scope<AsyncFileReader> Create(const AsyncFileReaderDescription& description);
+    };
+} // namespace Fluent
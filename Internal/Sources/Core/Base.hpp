@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <functional>
 #include "Core/Log.hpp"
 
 namespace Fluent 
@@ -24,4 +25,10 @@ namespace Fluent
     {
         return std::make_shared<T>(args...);
     }
+
+    template<typename T>
+    void HashCombine(size_t& seed, const T& value)
+    {
+        seed ^= std::hash<T>{}(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    }
 }
\ No newline at end of file
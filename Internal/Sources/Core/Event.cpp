@@ -1,6 +0,0 @@
-#include "Core/Event.hpp"
-
-namespace Fluent
-{
-    Event::~Event() noexcept = default;
-} // namespace Fluent
\ No newline at end of file
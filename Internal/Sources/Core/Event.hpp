@@ -1,5 +1,9 @@
 #pragma once
 
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
 namespace Fluent
 {
     enum class EventType
@@ -27,127 +31,75 @@ namespace Fluent
         eDown
     };
 
-    class Event
+    struct KeyEvent
     {
-    public:
-        virtual ~Event() noexcept = 0;
-
-        virtual EventType GetType() const noexcept = 0;
+        static constexpr EventType TYPE = EventType::eKeyEvent;
+        int         key;
+        PressState  state;
     };
 
-    class KeyEvent : public Event
+    struct KeyTypedEvent
     {
-    public:
-        KeyEvent(int key, PressState state)
-            : mKey({ key, state }) {}
-        ~KeyEvent() noexcept override = default;
-
-        auto GetKey() const noexcept { return mKey; }
-        
-        EventType GetType() const noexcept override { return EventType::eKeyEvent; }
-    private:
-        struct Key
-        {
-            int         key;
-            PressState  state;
-        };
-
-        Key mKey;
+        static constexpr EventType TYPE = EventType::eKeyTypedEvent;
+        int codepoint;
     };
 
-    class KeyTypedEvent : public Event
+    struct MouseButtonEvent
     {
-    public:
-        explicit KeyTypedEvent(int codepoint) noexcept
-            : mCodepoint(codepoint) {}
-        ~KeyTypedEvent() noexcept override = default;
-
-        int GetKey() const noexcept { return mCodepoint; }
-
-        EventType GetType() const noexcept override { return EventType::eKeyTypedEvent; }
-    private:
-        int mCodepoint;
+        static constexpr EventType TYPE = EventType::eMouseButtonEvent;
+        int         button;
+        PressState  state;
     };
 
-    class MouseButtonEvent : public Event
+    struct MouseMoveEvent
     {
-    public:
-        MouseButtonEvent(int button, PressState state) noexcept
-            : mButton({ button, state }) {}
-        ~MouseButtonEvent() noexcept override = default;
-
-        auto GetButton() const noexcept { return mButton; }
-
-        EventType GetType() const noexcept override { return EventType::eMouseButtonEvent; }
-    private:
-        struct Button
-        {
-            int         button;
-            PressState  state;
-        };
-
-        Button mButton;
+        static constexpr EventType TYPE = EventType::eMouseMoveEvent;
+        int x, y;
     };
 
-    class MouseMoveEvent : public Event
+    struct MouseScrollEvent
     {
-    public:
-        MouseMoveEvent(int x, int y) noexcept
-            : mPosition({ x, y }) {}
-        ~MouseMoveEvent() override = default;
-
-        auto GetPosition() const noexcept { return mPosition; }
-
-        EventType GetType() const noexcept override { return EventType::eMouseMoveEvent; }
-    private:
-        struct MousePosition
-        {
-            int x, y;
-        };
-
-        MousePosition mPosition;
+        static constexpr EventType TYPE = EventType::eMouseScrollEvent;
+        ScrollDirection direction;
     };
 
-    class MouseScrollEvent : public Event
+    struct WindowResizeEvent
     {
-    public:
-        explicit MouseScrollEvent(ScrollDirection direction) noexcept
-            : mDirection(direction) {};
-        ~MouseScrollEvent() noexcept override = default;
+        static constexpr EventType TYPE = EventType::eWindowResizeEvent;
+        int width, height;
+    };
 
-        ScrollDirection GetDirection() const noexcept { return mDirection; }
-        
-        EventType GetType() const noexcept override { return EventType::eMouseScrollEvent; }
-    private:
-        ScrollDirection mDirection;
+    struct WindowCloseEvent
+    {
+        static constexpr EventType TYPE = EventType::eWindowCloseEvent;
     };
 
-    class WindowResizeEvent : public Event
+    /// Tagged storage for any event above, trivially copyable so it can live in lock free queue
+    class Event
     {
-    public:
-        WindowResizeEvent(int width, int height) noexcept
-            : mSize({ width, height }) {}
-        ~WindowResizeEvent() noexcept override = default;
+    private:
+        static constexpr size_t MAX_EVENT_SIZE = 8;
 
-        auto GetSize() const noexcept { return mSize; }
+        EventType                               mType = EventType::eMaxEvent;
+        alignas(alignof(int)) unsigned char     mData[MAX_EVENT_SIZE]{};
+    public:
+        Event() noexcept = default;
 
-        EventType GetType() const noexcept override { return EventType::eWindowResizeEvent; }
-    private:
-        struct WindowSize
+        template<typename T>
+        Event(const T& event) noexcept
+            : mType(T::TYPE)
         {
-            int width, height;
-        };
+            static_assert(std::is_trivially_copyable_v<T> && sizeof(T) <= MAX_EVENT_SIZE && alignof(T) <= alignof(int));
+            new (mData) T(event);
+        }
 
-        WindowSize mSize;
-    };
+        EventType GetType() const noexcept { return mType; }
 
-    class WindowCloseEvent : public Event
-    {
-    public:
-        WindowCloseEvent() noexcept = default;
-        ~WindowCloseEvent() noexcept override = default;
-        
-        EventType GetType() const noexcept override { return EventType::eWindowCloseEvent; }
-    };
+        template<typename T>
+        bool Is() const noexcept { return mType == T::TYPE; }
 
-} // namespace Fluent
\ No newline at end of file
+        /// Caller must check type first
+        template<typename T>
+        const T& Get() const noexcept { return *std::launder(reinterpret_cast<const T*>(mData)); }
+    };
+} // namespace Fluent
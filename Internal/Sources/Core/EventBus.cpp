@@ -0,0 +1,136 @@
+#include <algorithm>
+#include "Core/Log.hpp"
+#include "Core/EventBus.hpp"
+
+namespace Fluent
+{
+    EventBus::EventBus(const EventBusDescription& description)
+    {
+        uint64_t capacity = 2;
+        while (capacity < description.capacity)
+            capacity <<= 1;
+
+        mCells = std::make_unique<Cell[]>(capacity);
+        mMask = capacity - 1;
+        for (uint64_t i = 0; i < capacity; ++i)
+            mCells[i].sequence.store(i, std::memory_order_relaxed);
+
+        mDispatchQueue.reserve(capacity);
+    }
+
+    /// Bounded queue with per cell sequence numbers, producers only contend on enqueue position
+    bool EventBus::Push(const Event& event)
+    {
+        Cell* cell;
+        uint64_t position = mEnqueuePosition.load(std::memory_order_relaxed);
+        while (true)
+        {
+            cell = &mCells[position & mMask];
+            uint64_t sequence = cell->sequence.load(std::memory_order_acquire);
+            auto difference = static_cast<int64_t>(sequence - position);
+            if (difference == 0)
+            {
+                if (mEnqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (difference < 0)
+            {
+                mDroppedCount.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            else
+            {
+                position = mEnqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->event = event;
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool EventBus::Pop(Event& event)
+    {
+        auto& cell = mCells[mDequeuePosition & mMask];
+        uint64_t sequence = cell.sequence.load(std::memory_order_acquire);
+        if (static_cast<int64_t>(sequence - (mDequeuePosition + 1)) < 0)
+            return false;
+
+        event = cell.event;
+        cell.sequence.store(mDequeuePosition + mMask + 1, std::memory_order_release);
+        ++mDequeuePosition;
+        return true;
+    }
+
+    void EventBus::Dispatch()
+    {
+        uint64_t end = mEnqueuePosition.load(std::memory_order_acquire);
+        Event event;
+        while (mDequeuePosition < end && Pop(event))
+            mDispatchQueue.push_back(event);
+
+        mDispatching = true;
+        for (const auto& queued : mDispatchQueue)
+        {
+            for (auto& subscriber : mSubscribers[static_cast<size_t>(queued.GetType())])
+            {
+                if (subscriber.active)
+                    subscriber.callback(queued);
+            }
+        }
+        mDispatching = false;
+        mDispatchQueue.clear();
+
+        for (auto& subscriber : mPendingSubscribers)
+        {
+            if (subscriber.active)
+                mSubscribers[static_cast<size_t>(subscriber.type)].push_back(std::move(subscriber));
+        }
+        mPendingSubscribers.clear();
+
+        if (mHasRemovedSubscribers)
+        {
+            for (auto& subscribers : mSubscribers)
+            {
+                subscribers.erase(std::remove_if(subscribers.begin(), subscribers.end(),
+                    [](const Subscriber& subscriber) { return !subscriber.active; }), subscribers.end());
+            }
+            mHasRemovedSubscribers = false;
+        }
+
+        if (auto dropped = mDroppedCount.exchange(0, std::memory_order_relaxed))
+            LOG_WARN("Event queue overflow, {} events dropped", dropped);
+    }
+
+    EventBus::SubscriptionId EventBus::SubscribeToType(EventType type, std::function<void(const Event&)>&& callback)
+    {
+        Subscriber subscriber{ ++mLastSubscriptionId, type, std::move(callback), true };
+        if (mDispatching)
+            mPendingSubscribers.push_back(std::move(subscriber));
+        else
+            mSubscribers[static_cast<size_t>(type)].push_back(std::move(subscriber));
+        return mLastSubscriptionId;
+    }
+
+    void EventBus::Unsubscribe(SubscriptionId id)
+    {
+        /// Removed after dispatch, because it can be called from callback
+        for (auto& subscribers : mSubscribers)
+        {
+            for (auto& subscriber : subscribers)
+            {
+                if (subscriber.id == id)
+                {
+                    subscriber.active = false;
+                    mHasRemovedSubscribers = true;
+                }
+            }
+        }
+
+        for (auto& subscriber : mPendingSubscribers)
+        {
+            if (subscriber.id == id)
+                subscriber.active = false;
+        }
+    }
+} // namespace Fluent
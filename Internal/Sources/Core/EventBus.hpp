@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "Core/Event.hpp"
+
+namespace Fluent
+{
+    struct EventBusDescription
+    {
+        /// Rounded up to power of two, events pushed into full queue are dropped
+        uint32_t capacity = 4096;
+    };
+
+    /// Events are pushed from any thread and dispatched in one batch per frame on main thread.
+    /// Subscribe and Unsubscribe are main thread only
+    class EventBus
+    {
+    public:
+        using SubscriptionId = uint32_t;
+    private:
+        struct Cell
+        {
+            std::atomic<uint64_t>   sequence;
+            Event                   event;
+        };
+
+        struct Subscriber
+        {
+            SubscriptionId                      id;
+            EventType                           type;
+            std::function<void(const Event&)>   callback;
+            /// Callback isn't destroyed on unsubscribe, it may be running
+            bool                                active = true;
+        };
+
+        using SubscriberList = std::vector<Subscriber>;
+
+        std::unique_ptr<Cell[]>                                                 mCells;
+        uint64_t                                                                mMask;
+        std::atomic<uint64_t>                                                   mEnqueuePosition = 0;
+        uint64_t                                                                mDequeuePosition = 0;
+        std::atomic<uint32_t>                                                   mDroppedCount = 0;
+        std::array<SubscriberList, static_cast<size_t>(EventType::eMaxEvent)>   mSubscribers;
+        std::vector<Event>                                                      mDispatchQueue;
+        /// Subscribed from callbacks, lists can't grow while they are iterated
+        std::vector<Subscriber>                                                 mPendingSubscribers;
+        SubscriptionId                                                          mLastSubscriptionId = 0;
+        bool                                                                    mDispatching = false;
+        bool                                                                    mHasRemovedSubscribers = false;
+
+        SubscriptionId SubscribeToType(EventType type, std::function<void(const Event&)>&& callback);
+        bool Pop(Event& event);
+    public:
+        explicit EventBus(const EventBusDescription& description);
+
+        EventBus(const EventBus&) = delete;
+        EventBus& operator=(const EventBus&) = delete;
+
+        /// Lock free, safe to call from any thread
+        bool Push(const Event& event);
+        /// Delivers events pushed before the call, events pushed by callbacks wait for next dispatch
+        void Dispatch();
+
+        template<typename T>
+        SubscriptionId Subscribe(std::function<void(const T&)> callback)
+        {
+            return SubscribeToType(T::TYPE, [callback = std::move(callback)](const Event& event) { callback(event.Get<T>()); });
+        }
+
+        void Unsubscribe(SubscriptionId id);
+    };
+} // namespace Fluent
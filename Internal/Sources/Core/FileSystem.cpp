@@ -1,13 +1,51 @@
 #include <filesystem>
+#include <fstream>
 #include "Core/Base.hpp"
+#include "Core/Archive.hpp"
+#include "Core/AsyncFileReader.hpp"
 #include "Core/FileSystem.hpp"
 
 namespace Fluent::FileSystem
 {
+    struct MountedArchive
+    {
+        /// Normalized with trailing separator
+        std::string     directory;
+        Scope<Archive>  archive;
+    };
+
     static std::string absoluteExecutablePath;
     static std::string shadersDirectory;
     static std::string texturesDirectory;
     static std::string modelsDirectory;
+    static std::vector<MountedArchive> mountedArchives;
+    static AsyncFileReader* asyncFileReader = nullptr;
+
+    static std::string NormalizePath(const std::string& path)
+    {
+        return std::filesystem::path(path).lexically_normal().generic_string();
+    }
+
+    static const ArchiveEntry* FindEntry(const std::string& path, const Archive** archive)
+    {
+        if (mountedArchives.empty())
+            return nullptr;
+
+        auto normalizedPath = NormalizePath(path);
+        for (auto it = mountedArchives.rbegin(); it != mountedArchives.rend(); ++it)
+        {
+            if (normalizedPath.compare(0, it->directory.size(), it->directory) != 0)
+                continue;
+
+            if (auto entry = it->archive->Find(normalizedPath.substr(it->directory.size())))
+            {
+                *archive = it->archive.get();
+                return entry;
+            }
+        }
+
+        return nullptr;
+    }
 
     void Init(char** argv)
     {
@@ -43,4 +81,105 @@ namespace Fluent::FileSystem
     {
         return modelsDirectory;
     }
+
+    bool Mount(const std::string& archivePath, const std::string& mountDirectory)
+    {
+        ArchiveDescription archiveDesc{};
+        archiveDesc.filename = absoluteExecutablePath + archivePath;
+        auto archive = Archive::Create(archiveDesc);
+        if (!archive)
+            return false;
+
+        auto directory = NormalizePath(absoluteExecutablePath + mountDirectory + "/");
+        LOG_CATEGORY_INFO(eCore, "Mounted archive {} with {} files at {}", archivePath, archive->GetEntries().size(), directory);
+        mountedArchives.push_back({ std::move(directory), std::move(archive) });
+        return true;
+    }
+
+    void UnmountAll()
+    {
+        mountedArchives.clear();
+    }
+
+    bool Exists(const std::string& path)
+    {
+        return IsArchived(path) || std::filesystem::is_regular_file(path);
+    }
+
+    bool IsArchived(const std::string& path)
+    {
+        const Archive* archive = nullptr;
+        return FindEntry(path, &archive) != nullptr;
+    }
+
+    uint64_t GetFileSize(const std::string& path)
+    {
+        const Archive* archive = nullptr;
+        if (auto entry = FindEntry(path, &archive))
+            return entry->size;
+
+        std::error_code error;
+        auto size = std::filesystem::file_size(path, error);
+        return error ? 0 : static_cast<uint64_t>(size);
+    }
+
+    const void* MapFile(const std::string& path)
+    {
+        const Archive* archive = nullptr;
+        auto entry = FindEntry(path, &archive);
+        return entry ? archive->Map(*entry) : nullptr;
+    }
+
+    bool ReadFile(const std::string& path, void* dst)
+    {
+        const Archive* archive = nullptr;
+        if (auto entry = FindEntry(path, &archive))
+            return archive->Read(*entry, dst);
+
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+            return false;
+
+        auto size = GetFileSize(path);
+        file.read(static_cast<char*>(dst), static_cast<std::streamsize>(size));
+        return static_cast<uint64_t>(file.gcount()) == size;
+    }
+
+    std::vector<char> ReadFile(const std::string& path)
+    {
+        std::vector<char> data(GetFileSize(path));
+        if (!ReadFile(path, data.data()))
+            data.clear();
+        return data;
+    }
+
+    void SetAsyncFileReader(AsyncFileReader* reader)
+    {
+        asyncFileReader = reader;
+    }
+
+    AsyncFileReader* GetAsyncFileReader()
+    {
+        return asyncFileReader;
+    }
+
+    void ReadFiles(const std::vector<std::string>& paths, ReadFilesCallback callback)
+    {
+        if (!asyncFileReader)
+        {
+            std::vector<std::vector<char>> files(paths.size());
+            for (size_t i = 0; i < paths.size(); ++i)
+                files[i] = ReadFile(paths[i]);
+            callback(files);
+            return;
+        }
+
+        asyncFileReader->Read(paths, [callback = std::move(callback)](std::vector<FileReadResult>& results)
+        {
+            std::vector<std::vector<char>> files(results.size());
+            for (size_t i = 0; i < results.size(); ++i)
+                files[i] = std::move(results[i].data);
+            callback(files);
+        });
+    }
 } // namespace Fluent::FileSystem
@@ -1,6 +1,14 @@
 #pragma once
 
+#include <cstdint>
+#include <functional>
 #include <string>
+#include <vector>
+
+namespace Fluent
+{
+    class AsyncFileReader;
+} // namespace Fluent
 
 namespace Fluent::FileSystem
 {
@@ -12,4 +20,30 @@ namespace Fluent::FileSystem
     const std::string& GetShadersDirectory();
     const std::string& GetTexturesDirectory();
     const std::string& GetModelsDirectory();
+
+    /// Archive entries become files below mount directory, both paths are relative to executable
+    /// like other directories. Later mounts take priority. Mount before loading, lookups are not
+    /// synchronized with mounting
+    bool Mount(const std::string& archivePath, const std::string& mountDirectory);
+    void UnmountAll();
+
+    /// Paths below are full paths, as built from Get*Directory. Mounted archives are searched
+    /// before loose files
+    bool Exists(const std::string& path);
+    bool IsArchived(const std::string& path);
+    uint64_t GetFileSize(const std::string& path);
+    /// Zero copy view of uncompressed archive entry, nullptr for loose and compressed files
+    const void* MapFile(const std::string& path);
+    /// Reads whole file into dst of GetFileSize bytes, dst could be mapped staging memory
+    bool ReadFile(const std::string& path, void* dst);
+    /// Empty on failure
+    std::vector<char> ReadFile(const std::string& path);
+
+    /// Reader used by loaders, nullptr makes reads blocking one by one
+    void SetAsyncFileReader(AsyncFileReader* reader);
+    AsyncFileReader* GetAsyncFileReader();
+    using ReadFilesCallback = std::function<void(std::vector<std::vector<char>>& files)>;
+    /// Keeps all reads in flight at once, files are in paths order and empty on failure. Callback
+    /// is called from AsyncFileReader::Update on main thread, or before return without reader
+    void ReadFiles(const std::vector<std::string>& paths, ReadFilesCallback callback);
 } // namespace Fluent
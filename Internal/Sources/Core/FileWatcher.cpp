@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <filesystem>
+#include <unordered_map>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+#include "Core/FileWatcher.hpp"
+
+namespace Fluent
+{
+#ifdef __linux__
+    class InotifyFileWatcher : public FileWatcher
+    {
+    private:
+        int                                         mHandle = -1;
+        std::string                                 mDirectory;
+        bool                                        mRecursive = true;
+        std::unordered_map<int, std::string>        mWatchedDirectories;
+
+        void AddWatch(const std::string& path, const std::string& relativePath)
+        {
+            /// Directories are reported with IN_ISDIR, created and moved in ones are watched too
+            uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO;
+            if (mRecursive)
+                mask |= IN_CREATE;
+
+            int watch = inotify_add_watch(mHandle, path.c_str(), mask);
+            if (watch < 0)
+            {
+                LOG_CATEGORY_WARN(eCore, "Failed to watch directory {}", path);
+                return;
+            }
+
+            mWatchedDirectories[watch] = relativePath;
+        }
+
+        /// Files could be written into new directory before its watch was added, they are reported as changed
+        void AddWatchRecursive(const std::string& relativePath, std::vector<std::string>* existingFiles)
+        {
+            auto root = std::filesystem::path(mDirectory) / relativePath;
+            AddWatch(root.string(), relativePath);
+
+            std::error_code error;
+            for (auto& entry : std::filesystem::recursive_directory_iterator(root, error))
+            {
+                auto entryPath = std::filesystem::relative(entry.path(), mDirectory).generic_string();
+                if (entry.is_directory())
+                    AddWatch(entry.path().string(), entryPath + "/");
+                else if (existingFiles)
+                    existingFiles->emplace_back(std::move(entryPath));
+            }
+        }
+    public:
+        explicit InotifyFileWatcher(const FileWatcherDescription& description)
+            : mDirectory(description.directory)
+            , mRecursive(description.recursive)
+        {
+            mHandle = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+            if (mHandle < 0)
+            {
+                LOG_CATEGORY_WARN(eCore, "Failed to initialize inotify");
+                return;
+            }
+
+            if (mRecursive)
+                AddWatchRecursive("", nullptr);
+            else
+                AddWatch(mDirectory, "");
+        }
+
+        ~InotifyFileWatcher() override
+        {
+            if (mHandle >= 0)
+                close(mHandle);
+        }
+
+        std::vector<std::string> PollChanges() override
+        {
+            std::vector<std::string> result;
+            if (mHandle < 0)
+                return result;
+
+            alignas(inotify_event) char buffer[4096];
+            ssize_t length;
+            while ((length = read(mHandle, buffer, sizeof(buffer))) > 0)
+            {
+                for (char* ptr = buffer; ptr < buffer + length;)
+                {
+                    auto* event = reinterpret_cast<inotify_event*>(ptr);
+                    ptr += sizeof(inotify_event) + event->len;
+
+                    /// Watch is removed by kernel when directory is deleted
+                    if (event->mask & IN_IGNORED)
+                    {
+                        mWatchedDirectories.erase(event->wd);
+                        continue;
+                    }
+
+                    if (event->len == 0)
+                        continue;
+
+                    auto it = mWatchedDirectories.find(event->wd);
+                    if (it == mWatchedDirectories.end())
+                        continue;
+
+                    auto path = it->second + event->name;
+                    if (event->mask & IN_ISDIR)
+                    {
+                        if (mRecursive && (event->mask & (IN_CREATE | IN_MOVED_TO)))
+                            AddWatchRecursive(path + "/", &result);
+                        continue;
+                    }
+
+                    /// File creation is followed by IN_CLOSE_WRITE, which reports it
+                    if (!(event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)))
+                        continue;
+
+                    result.emplace_back(std::move(path));
+                }
+            }
+
+            /// Editors and compilers often produce several events for one save
+            std::sort(result.begin(), result.end());
+            result.erase(std::unique(result.begin(), result.end()), result.end());
+            return result;
+        }
+    };
+#endif
+
+    /// Interface
+
+    Scope<FileWatcher> FileWatcher::Create(const FileWatcherDescription& description)
+    {
+#ifdef __linux__
+        return CreateScope<InotifyFileWatcher>(description);
+#else
+        LOG_CATEGORY_WARN(eCore, "File watching is not supported on this platform");
+        return nullptr;
+#endif
+    }
+} // namespace Fluent
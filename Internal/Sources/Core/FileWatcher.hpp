@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "Core/Base.hpp"
+
+namespace Fluent
+{
+    struct FileWatcherDescription
+    {
+        std::string directory;
+        bool        recursive = true;
+    };
+
+    class FileWatcher
+    {
+    protected:
+        FileWatcher() = default;
+    public:
+        virtual ~FileWatcher() = default;
+
+        /// Non blocking, returns paths relative to watched directory written since last call
+        virtual std::vector<std::string> PollChanges() = 0;
+
+        static Scope<FileWatcher> Create(const FileWatcherDescription& description);
+    };
+} // namespace Fluent
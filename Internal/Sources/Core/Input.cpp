@@ -1,7 +1,7 @@
 #include <array>
-#include <set>
+#include <vector>
 #include "Core/Window.hpp"
-#include "Core/Event.hpp"
+#include "Core/EventBus.hpp"
 #include "Math/Math.hpp"
 #include "Core/Input.hpp"
 
@@ -9,64 +9,65 @@ namespace Fluent
 {
     using MousePosition = VectorInt2;
 
-    static std::array<PressState, 349> keys;
-    static std::array<PressState, 5> buttons;
-    static std::set<std::pair<KeyCode, PressState>> keysChanged;
+    static constexpr uint32_t KEY_COUNT = 349;
+    static constexpr uint32_t BUTTON_COUNT = 5;
+
+    static std::array<PressState, KEY_COUNT> keys;
+    static std::array<PressState, BUTTON_COUNT> buttons;
+    /// Keys changed since last update, each key listed once
+    static std::array<bool, KEY_COUNT> keysChangedMask;
+    static std::vector<KeyCode> keysChanged;
     static MousePosition mousePosition(0, 0);
 
-    void Input::Init() noexcept
+    void Input::Init(EventBus& eventBus)
     {
         keys.fill(PressState::eUndefined);
         buttons.fill(PressState::eUndefined);
+        keysChangedMask.fill(false);
+        keysChanged.reserve(KEY_COUNT);
+
+        eventBus.Subscribe<KeyEvent>([](const KeyEvent& event)
+        {
+            if (event.key < 0 || event.key >= static_cast<int>(KEY_COUNT))
+                return;
+
+            keys[event.key] = event.state;
+            if (!keysChangedMask[event.key])
+            {
+                keysChangedMask[event.key] = true;
+                keysChanged.push_back(static_cast<KeyCode>(event.key));
+            }
+        });
+
+        eventBus.Subscribe<MouseButtonEvent>([](const MouseButtonEvent& event)
+        {
+            if (event.button >= 0 && event.button < static_cast<int>(BUTTON_COUNT))
+                buttons[event.button] = event.state;
+        });
+
+        eventBus.Subscribe<MouseMoveEvent>([](const MouseMoveEvent& event)
+        {
+            mousePosition = { event.x, event.y };
+        });
     }
 
     void Input::OnUpdate() noexcept
     {
-        for (auto& [keyCode, state] : keysChanged)
+        /// Press becomes hold and release becomes undefined one frame after event
+        for (auto keyCode : keysChanged)
         {
-            if (state == PressState::eRelease && keys[keyCode] == PressState::eRelease)
+            if (keys[keyCode] == PressState::eRelease)
                 keys[keyCode] = PressState::eUndefined;
             else
-            if (state == PressState::ePress && keys[keyCode] == PressState::ePress)
+            if (keys[keyCode] == PressState::ePress)
                 keys[keyCode] = PressState::eHold;
-            else
-                keys[keyCode] = state;
+
+            keysChangedMask[keyCode] = false;
         }
 
         keysChanged.clear();
     }
 
-    void Input::OnEvent(const Event& event) noexcept
-    {
-        switch (event.GetType())
-        {
-            case EventType::eKeyEvent:
-            {
-                auto key = dynamic_cast<const KeyEvent&>(event).GetKey();
-                if (key.key >= 0 && key.key < 349) // TODO: Rewrite
-                {
-                    keys[key.key] = static_cast<PressState>(key.state);
-                    keysChanged.insert(std::make_pair(key.key, key.state));
-                }
-                break;
-            }
-            case EventType::eMouseButtonEvent:
-            {
-                auto button = dynamic_cast<const MouseButtonEvent&>(event).GetButton();
-                buttons[button.button] = static_cast<PressState>(button.state);
-                break;
-            }
-            case EventType::eMouseMoveEvent:
-            {
-                auto position = dynamic_cast<const MouseMoveEvent&>(event).GetPosition();
-                mousePosition = { position.x, position.y };
-                break;
-            }
-            default:
-                break;
-        }
-    }
-
     bool Input::GetKeyDown(KeyCode keycode) noexcept
     {
         return keys[keycode] == PressState::ePress;
@@ -7,13 +7,14 @@
 
 namespace Fluent
 {
+    class EventBus;
+
     class Input
     {
     public:
-        static void Init() noexcept;
+        /// Subscribes to key and mouse events
+        static void Init(EventBus& eventBus);
         static void OnUpdate() noexcept;
-
-        static void OnEvent(const Event& event) noexcept;
         
         static bool GetKeyDown(KeyCode keycode) noexcept;
         static bool GetKey(KeyCode keycode) noexcept;
@@ -6,11 +6,16 @@
 namespace Fluent
 {
     class Event;
+    class Application;
     
     class Layer
     {
     private:
+        friend class Application;
+
         std::string mName;
+        /// Profile scope of OnUpdate, interned once when layer is pushed
+        const char* mUpdateScopeName = "Layer::OnUpdate";
     public:
         explicit Layer(std::string name) noexcept : mName(std::move(name)) {};
         virtual ~Layer() noexcept = default;
@@ -22,5 +27,6 @@ namespace Fluent
         virtual void OnUpdate(float deltaTime) = 0;
         
         const std::string& GetName() const noexcept { return mName; };
+        const char* GetUpdateScopeName() const noexcept { return mUpdateScopeName; }
     };
 }
\ No newline at end of file
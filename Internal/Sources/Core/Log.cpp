@@ -1,25 +1,200 @@
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <spdlog/async.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
 #include "Core/Log.hpp"
 
 namespace Fluent::Log
 {
-    void SetLogLevel(LogLevel level)
+    static constexpr uint32_t CATEGORY_COUNT = static_cast<uint32_t>(Category::eLast);
+    static constexpr const char* CATEGORY_NAMES[CATEGORY_COUNT] = { "Core", "Renderer", "Shader", "Scene", "UI" };
+    static constexpr const char* LOG_PATTERN = "[%H:%M:%S.%e] [%n] [%^%l%$] %v";
+
+    /// Request overrun by newer messages is never completed, waiting for it is bounded
+    static constexpr auto FLUSH_TIMEOUT = std::chrono::seconds(1);
+
+    /// Flush of marker logger is queued behind every message logged before it, so
+    /// its sink tells when worker has written them
+    class FlushMarkerSink : public spdlog::sinks::sink
+    {
+    private:
+        std::mutex              mMutex;
+        std::condition_variable mCondition;
+        uint64_t                mCompletedCount = 0;
+    public:
+        void log(const spdlog::details::log_msg&) override {}
+
+        void flush() override
+        {
+            {
+                std::scoped_lock lock(mMutex);
+                mCompletedCount++;
+            }
+
+            mCondition.notify_all();
+        }
+
+        void set_pattern(const std::string&) override {}
+        void set_formatter(std::unique_ptr<spdlog::formatter>) override {}
+
+        /// Requests complete in order, dropped one is counted as completed on timeout
+        void Wait(uint64_t request)
+        {
+            std::unique_lock lock(mMutex);
+            if (!mCondition.wait_for(lock, FLUSH_TIMEOUT, [&]() { return mCompletedCount >= request; }))
+                mCompletedCount = request;
+        }
+    };
+
+    /// Set when state is destroyed, static destructors which log after it use fallback logger
+    static bool sStateDestroyed = false;
+
+    struct LogState
+    {
+        spdlog::sink_ptr                                            sink;
+        std::shared_ptr<spdlog::details::thread_pool>               threadPool;
+        std::array<std::shared_ptr<spdlog::logger>, CATEGORY_COUNT> loggers;
+        std::shared_ptr<FlushMarkerSink>                            flushMarkerSink;
+        std::shared_ptr<spdlog::logger>                             flushMarker;
+        std::mutex                                                  flushMutex;
+        uint64_t                                                    flushRequestCount = 0;
+
+        LogState()
+        {
+            sink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
+            flushMarkerSink = std::make_shared<FlushMarkerSink>();
+            CreateLoggers();
+        }
+
+        ~LogState()
+        {
+            /// Thread pool drains queue before joining
+            sStateDestroyed = true;
+            flushMarker = nullptr;
+            for (auto& logger : loggers)
+                logger = nullptr;
+            threadPool = nullptr;
+        }
+
+        void CreateLoggers()
+        {
+            for (uint32_t i = 0; i < CATEGORY_COUNT; ++i)
+            {
+                auto level = loggers[i] ? loggers[i]->level() : spdlog::level::info;
+                if (threadPool)
+                {
+                    /// Render thread never waits for console, oldest messages are dropped instead
+                    loggers[i] = std::make_shared<spdlog::async_logger>
+                        (CATEGORY_NAMES[i], sink, threadPool, spdlog::async_overflow_policy::overrun_oldest);
+                }
+                else
+                {
+                    loggers[i] = std::make_shared<spdlog::logger>(CATEGORY_NAMES[i], sink);
+                }
+                loggers[i]->set_pattern(LOG_PATTERN);
+                loggers[i]->set_level(level);
+                loggers[i]->flush_on(spdlog::level::err);
+            }
+
+            flushMarker = threadPool ? std::make_shared<spdlog::async_logger>("FlushMarker", flushMarkerSink, threadPool) : nullptr;
+        }
+    };
+
+    static LogState& GetState()
+    {
+        static LogState state;
+        return state;
+    }
+
+    /// Never destroyed, so it outlives every static which logs in its destructor
+    static spdlog::logger* GetFallbackLogger()
+    {
+        static auto* logger = []()
+        {
+            auto result = new spdlog::logger("Fallback", std::make_shared<spdlog::sinks::stdout_color_sink_st>());
+            result->set_pattern(LOG_PATTERN);
+            return result;
+        }();
+        return logger;
+    }
+
+    static spdlog::level::level_enum ToSpdlogLevel(LogLevel level)
     {
         switch (level)
         {
         case LogLevel::eTrace:
-            spdlog::set_level(spdlog::level::trace);
-            break;
+            return spdlog::level::trace;
+        case LogLevel::eDebug:
+            return spdlog::level::debug;
         case LogLevel::eInfo:
-            spdlog::set_level(spdlog::level::info);
-            break;
+            return spdlog::level::info;
         case LogLevel::eWarn:
-            spdlog::set_level(spdlog::level::warn);
-            break;
+            return spdlog::level::warn;
         case LogLevel::eError:
-            spdlog::set_level(spdlog::level::err);
-            break;
+            return spdlog::level::err;
         default:
-            break;
+            return spdlog::level::info;
         }
     }
+
+    void SetAsync(bool async, uint32_t queueSize)
+    {
+        auto& state = GetState();
+        if (async == (state.threadPool != nullptr))
+            return;
+
+        Flush();
+        state.threadPool = async ? std::make_shared<spdlog::details::thread_pool>(queueSize, 1) : nullptr;
+        state.CreateLoggers();
+    }
+
+    void Flush()
+    {
+        if (sStateDestroyed)
+            return;
+
+        auto& state = GetState();
+        if (!state.threadPool)
+        {
+            for (auto& logger : state.loggers)
+                logger->flush();
+            return;
+        }
+
+        /// Async flush only enqueues request, marker is enqueued after those of every logger
+        uint64_t request;
+        {
+            std::scoped_lock lock(state.flushMutex);
+            for (auto& logger : state.loggers)
+                logger->flush();
+            request = ++state.flushRequestCount;
+            state.flushMarker->flush();
+        }
+
+        state.flushMarkerSink->Wait(request);
+    }
+
+    void SetLogLevel(LogLevel level)
+    {
+        if (sStateDestroyed)
+            return;
+
+        for (auto& logger : GetState().loggers)
+            logger->set_level(ToSpdlogLevel(level));
+    }
+
+    void SetLogLevel(Category category, LogLevel level)
+    {
+        GetLogger(category)->set_level(ToSpdlogLevel(level));
+    }
+
+    spdlog::logger* GetLogger(Category category)
+    {
+        if (sStateDestroyed)
+            return GetFallbackLogger();
+
+        return GetState().loggers[static_cast<uint32_t>(category)].get();
+    }
 } // namespace Fluent
@@ -2,20 +2,79 @@
 
 #include <spdlog/spdlog.h>
 
+/// Messages below this level are compiled out: 0 trace, 1 debug, 2 info, 3 warn, 4 error
+#ifndef FLUENT_LOG_ACTIVE_LEVEL
+#ifdef NDEBUG
+#define FLUENT_LOG_ACTIVE_LEVEL 2
+#else
+#define FLUENT_LOG_ACTIVE_LEVEL 0
+#endif
+#endif
+
 namespace Fluent::Log
 {
     enum class LogLevel
     {
         eTrace,
+        eDebug,
         eInfo,
         eWarn,
         eError
     };
 
+    /// Every category has own logger, so it can be filtered separately
+    enum class Category
+    {
+        eCore,
+        eRenderer,
+        eShader,
+        eScene,
+        eUI,
+        eLast
+    };
+
+    /// Messages are formatted on calling thread and written by background thread.
+    /// Call before other threads start logging
+    void SetAsync(bool async, uint32_t queueSize = 8192);
+    /// Blocks until all queued messages are written
+    void Flush();
+
     void SetLogLevel(LogLevel level);
+    void SetLogLevel(Category category, LogLevel level);
+
+    spdlog::logger* GetLogger(Category category);
 }
 
-#define LOG_TRACE(...) spdlog::trace(__VA_ARGS__)
-#define LOG_INFO(...) spdlog::info(__VA_ARGS__)
-#define LOG_WARN(...) spdlog::warn(__VA_ARGS__)
-#define LOG_ERROR(...) spdlog::error(__VA_ARGS__)
\ No newline at end of file
+#define FLUENT_LOG(category, level, ...) ::Fluent::Log::GetLogger(::Fluent::Log::Category::category)->level(__VA_ARGS__)
+
+#if FLUENT_LOG_ACTIVE_LEVEL <= 0
+#define LOG_CATEGORY_TRACE(category, ...) FLUENT_LOG(category, trace, __VA_ARGS__)
+#else
+#define LOG_CATEGORY_TRACE(category, ...) (void)0
+#endif
+
+#if FLUENT_LOG_ACTIVE_LEVEL <= 1
+#define LOG_CATEGORY_DEBUG(category, ...) FLUENT_LOG(category, debug, __VA_ARGS__)
+#else
+#define LOG_CATEGORY_DEBUG(category, ...) (void)0
+#endif
+
+#if FLUENT_LOG_ACTIVE_LEVEL <= 2
+#define LOG_CATEGORY_INFO(category, ...) FLUENT_LOG(category, info, __VA_ARGS__)
+#else
+#define LOG_CATEGORY_INFO(category, ...) (void)0
+#endif
+
+#if FLUENT_LOG_ACTIVE_LEVEL <= 3
+#define LOG_CATEGORY_WARN(category, ...) FLUENT_LOG(category, warn, __VA_ARGS__)
+#else
+#define LOG_CATEGORY_WARN(category, ...) (void)0
+#endif
+
+#define LOG_CATEGORY_ERROR(category, ...) FLUENT_LOG(category, error, __VA_ARGS__)
+
+#define LOG_TRACE(...) LOG_CATEGORY_TRACE(eCore, __VA_ARGS__)
+#define LOG_DEBUG(...) LOG_CATEGORY_DEBUG(eCore, __VA_ARGS__)
+#define LOG_INFO(...) LOG_CATEGORY_INFO(eCore, __VA_ARGS__)
+#define LOG_WARN(...) LOG_CATEGORY_WARN(eCore, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_CATEGORY_ERROR(eCore, __VA_ARGS__)
@@ -0,0 +1,195 @@
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+#include "Core/Log.hpp"
+#include "Core/Profiler.hpp"
+
+namespace Fluent::Profiler
+{
+    /// Sequence is odd while owning thread writes slot and 2 * (index + 1) after event index is
+    /// written, so exporter detects slots overwritten while it copied them
+    struct EventSlot
+    {
+        std::atomic<uint64_t>       sequence = 0;
+        std::atomic<const char*>    name = nullptr;
+        std::atomic<uint64_t>       begin = 0;
+        std::atomic<uint64_t>       end = 0;
+    };
+
+    struct ThreadBuffer
+    {
+        std::unique_ptr<EventSlot[]>    events;
+        /// Written only by owning thread
+        std::atomic<uint64_t>           head = 0;
+        /// First event still visible after Clear
+        std::atomic<uint64_t>           tail = 0;
+        uint32_t                        id = 0;
+        std::string                     name;
+    };
+
+    /// Buffers are shared with registry so events survive thread exit
+    static std::mutex                                   sRegistryMutex;
+    static std::vector<std::shared_ptr<ThreadBuffer>>   sThreadBuffers;
+    static std::mutex                                   sNamesMutex;
+    static std::unordered_set<std::string>              sNames;
+    static const auto                                   sStartTime = std::chrono::steady_clock::now();
+
+    static ThreadBuffer& GetThreadBuffer()
+    {
+        thread_local std::shared_ptr<ThreadBuffer> buffer;
+        if (!buffer)
+        {
+            buffer = std::make_shared<ThreadBuffer>();
+            buffer->events = std::make_unique<EventSlot[]>(EVENT_RING_SIZE);
+
+            std::scoped_lock lock(sRegistryMutex);
+            buffer->id = static_cast<uint32_t>(sThreadBuffers.size());
+            buffer->name = "Thread " + std::to_string(buffer->id);
+            sThreadBuffers.push_back(buffer);
+        }
+        return *buffer;
+    }
+
+    static void WriteEscaped(std::ofstream& out, const char* string)
+    {
+        for (const char* c = string; *c; ++c)
+        {
+            if (*c == '"' || *c == '\\')
+                out << '\\';
+            if (static_cast<unsigned char>(*c) >= 0x20)
+                out << *c;
+        }
+    }
+
+    uint64_t Now()
+    {
+        using namespace std::chrono;
+        return duration_cast<nanoseconds>(steady_clock::now() - sStartTime).count();
+    }
+
+    void Record(const char* name, uint64_t begin, uint64_t end)
+    {
+        auto& buffer = GetThreadBuffer();
+        uint64_t head = buffer.head.load(std::memory_order_relaxed);
+        auto& slot = buffer.events[head % EVENT_RING_SIZE];
+        slot.sequence.store(2 * head + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.name.store(name, std::memory_order_relaxed);
+        slot.begin.store(begin, std::memory_order_relaxed);
+        slot.end.store(end, std::memory_order_relaxed);
+        slot.sequence.store(2 * head + 2, std::memory_order_release);
+        buffer.head.store(head + 1, std::memory_order_release);
+    }
+
+    void SetThreadName(const std::string& name)
+    {
+        auto& buffer = GetThreadBuffer();
+        std::scoped_lock lock(sRegistryMutex);
+        buffer.name = name;
+    }
+
+    /// False when slot was overwritten by newer event before or while it was copied
+    static bool ReadEvent(const ThreadBuffer& buffer, uint64_t index, ProfileEvent& event)
+    {
+        const auto& slot = buffer.events[index % EVENT_RING_SIZE];
+        uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+        if (sequence != 2 * index + 2)
+            return false;
+
+        event.name = slot.name.load(std::memory_order_relaxed);
+        event.begin = slot.begin.load(std::memory_order_relaxed);
+        event.end = slot.end.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return slot.sequence.load(std::memory_order_relaxed) == sequence;
+    }
+
+    const char* InternName(const std::string& name)
+    {
+        std::scoped_lock lock(sNamesMutex);
+        return sNames.insert(name).first->c_str();
+    }
+
+    void Clear()
+    {
+        std::scoped_lock lock(sRegistryMutex);
+        for (auto& buffer : sThreadBuffers)
+            buffer->tail.store(buffer->head.load(std::memory_order_acquire), std::memory_order_relaxed);
+    }
+
+    bool WriteChromeTrace(const std::string& path)
+    {
+        struct ThreadEvents
+        {
+            uint32_t                    id;
+            std::string                 name;
+            std::vector<ProfileEvent>   events;
+        };
+
+        /// Events are copied first, so threads keep recording while file is written. Events
+        /// overwritten during copy are skipped, ring keeps only last EVENT_RING_SIZE events
+        std::vector<ThreadEvents> threads;
+        size_t eventCount = 0;
+        {
+            std::scoped_lock lock(sRegistryMutex);
+            threads.reserve(sThreadBuffers.size());
+            for (auto& buffer : sThreadBuffers)
+            {
+                auto& thread = threads.emplace_back();
+                thread.id = buffer->id;
+                thread.name = buffer->name;
+
+                uint64_t head = buffer->head.load(std::memory_order_acquire);
+                uint64_t tail = buffer->tail.load(std::memory_order_relaxed);
+                if (head - tail > EVENT_RING_SIZE)
+                    tail = head - EVENT_RING_SIZE;
+
+                thread.events.reserve(head - tail);
+                for (uint64_t i = tail; i < head; ++i)
+                {
+                    ProfileEvent event;
+                    if (ReadEvent(*buffer, i, event))
+                        thread.events.push_back(event);
+                }
+                eventCount += thread.events.size();
+            }
+        }
+
+        std::ofstream out(path, std::ios::trunc);
+        if (!out.is_open())
+        {
+            LOG_CATEGORY_WARN(eCore, "Failed to open trace file {}", path);
+            return false;
+        }
+
+        out << std::fixed << std::setprecision(3);
+
+        /// Timestamps are microseconds in chrome trace format
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        bool first = true;
+        for (auto& thread : threads)
+        {
+            out << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << thread.id << ",\"args\":{\"name\":\"";
+            WriteEscaped(out, thread.name.c_str());
+            out << "\"}}";
+            first = false;
+
+            for (const auto& event : thread.events)
+            {
+                out << ",\n{\"name\":\"";
+                WriteEscaped(out, event.name);
+                out << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << thread.id
+                    << ",\"ts\":" << static_cast<double>(event.begin) * 0.001
+                    << ",\"dur\":" << static_cast<double>(event.end - event.begin) * 0.001 << "}";
+            }
+        }
+        out << "\n]}\n";
+
+        LOG_CATEGORY_INFO(eCore, "Profiler trace with {} events written to {}", eventCount, path);
+        return out.good();
+    }
+} // namespace Fluent
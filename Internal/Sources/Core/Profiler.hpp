@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/// Build with -DFLUENT_PROFILING=1 (cmake option FluentProfiling) to enable scopes.
+/// When disabled every PROFILE_* macro expands to nothing
+#ifndef FLUENT_PROFILING
+#define FLUENT_PROFILING 0
+#endif
+
+namespace Fluent::Profiler
+{
+    /// Events per thread, oldest ones are overwritten when ring is full
+    static constexpr uint32_t EVENT_RING_SIZE = 1 << 16;
+
+    struct ProfileEvent
+    {
+        /// Must outlive export, use InternName for non literal strings
+        const char* name;
+        uint64_t    begin;
+        uint64_t    end;
+    };
+
+    /// Nanoseconds since profiler start
+    uint64_t Now();
+    void Record(const char* name, uint64_t begin, uint64_t end);
+    void SetThreadName(const std::string& name);
+    const char* InternName(const std::string& name);
+    /// Drops all recorded events, thread names are kept
+    void Clear();
+    /// Chrome trace event format, loads in chrome://tracing and ui.perfetto.dev
+    bool WriteChromeTrace(const std::string& path);
+
+    class ProfileScope
+    {
+    private:
+        const char* mName;
+        uint64_t    mBegin;
+    public:
+        explicit ProfileScope(const char* name) noexcept : mName(name), mBegin(Now()) {}
+        ~ProfileScope() { Record(mName, mBegin, Now()); }
+
+        ProfileScope(const ProfileScope&) = delete;
+        ProfileScope& operator=(const ProfileScope&) = delete;
+    };
+} // namespace Fluent
+
+#define FLUENT_PROFILE_CONCAT_IMPL(a, b) a##b
+#define FLUENT_PROFILE_CONCAT(a, b) FLUENT_PROFILE_CONCAT_IMPL(a, b)
+
+#if FLUENT_PROFILING
+#define PROFILE_SCOPE(name) ::Fluent::Profiler::ProfileScope FLUENT_PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_SCOPE_DYNAMIC(name) ::Fluent::Profiler::ProfileScope FLUENT_PROFILE_CONCAT(profileScope, __LINE__)(::Fluent::Profiler::InternName(name))
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__func__)
+#define PROFILE_THREAD(name) ::Fluent::Profiler::SetThreadName(name)
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_SCOPE_DYNAMIC(name)
+#define PROFILE_FUNCTION()
+#define PROFILE_THREAD(name)
+#endif
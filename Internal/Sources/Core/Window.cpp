@@ -17,14 +17,8 @@ namespace Fluent
 
         void SendEvent(const Event& event)
         {
-            if (event.GetType() == EventType::eWindowResizeEvent)
-            {
-                auto size = dynamic_cast<const WindowResizeEvent&>(event).GetSize();
-                mWidth = size.width;
-                mHeight = size.height;
-            }
-
-            mEventCallback(event);
+            if (mEventCallback)
+                mEventCallback(event);
         }
     public:
         explicit MultiplatformWindow(const WindowDescription& description)
@@ -52,26 +46,26 @@ namespace Fluent
             {
                 auto* handle = reinterpret_cast<MultiplatformWindow*>(glfwGetWindowUserPointer(window));
                 if (action == GLFW_PRESS)
-                    handle->SendEvent(KeyEvent(key, PressState::ePress));
+                    handle->SendEvent(KeyEvent{ key, PressState::ePress });
                 else
                 if (action == GLFW_RELEASE)
-                    handle->SendEvent(KeyEvent(key, PressState::eRelease));
+                    handle->SendEvent(KeyEvent{ key, PressState::eRelease });
             });
 
             glfwSetCharCallback(mHandle, [](GLFWwindow* window, uint32_t codepoint)
             {
                 auto* handle = reinterpret_cast<MultiplatformWindow*>(glfwGetWindowUserPointer(window));
-                handle->SendEvent(KeyTypedEvent(static_cast<int>(codepoint)));
+                handle->SendEvent(KeyTypedEvent{ static_cast<int>(codepoint) });
             });
 
             glfwSetMouseButtonCallback(mHandle, [](GLFWwindow* win, int button, int action, int mods)
             {
                 auto* handle = reinterpret_cast<MultiplatformWindow*>(glfwGetWindowUserPointer(win));
                 if (action == GLFW_PRESS)
-                    handle->SendEvent(MouseButtonEvent(button, PressState::ePress));
+                    handle->SendEvent(MouseButtonEvent{ button, PressState::ePress });
                 else
                 if (action == GLFW_RELEASE)
-                    handle->SendEvent(MouseButtonEvent(button, PressState::eRelease));
+                    handle->SendEvent(MouseButtonEvent{ button, PressState::eRelease });
             });
 
             glfwSetScrollCallback(mHandle, [](GLFWwindow* window, double xOffset, double yOffset)
@@ -79,34 +73,36 @@ namespace Fluent
                 auto* handle = reinterpret_cast<MultiplatformWindow*>(glfwGetWindowUserPointer(window));
 
                 if (yOffset > 0)
-                    handle->SendEvent(MouseScrollEvent(ScrollDirection::eUp));
+                    handle->SendEvent(MouseScrollEvent{ ScrollDirection::eUp });
                 else
                 if (yOffset < 0)
-                    handle->SendEvent(MouseScrollEvent(ScrollDirection::eDown));
+                    handle->SendEvent(MouseScrollEvent{ ScrollDirection::eDown });
             });
 
             glfwSetWindowCloseCallback(mHandle, [](GLFWwindow* window)
             {
                 auto* handle = reinterpret_cast<MultiplatformWindow*>(glfwGetWindowUserPointer(window));
-                handle->SendEvent(WindowCloseEvent());
+                handle->SendEvent(WindowCloseEvent{});
             });
 
 //            glfwSetWindowSizeCallback(mHandle, [](GLFWwindow* window, int width, int height)
 //            {
 //                auto* handle = reinterpret_cast<MultiplatformWindow*>(glfwGetWindowUserPointer(window));
-//                handle->SendEvent(WindowResizeEvent(width, height));
+//                handle->SendEvent(WindowResizeEvent{ width, height });
 //            });
 
             glfwSetFramebufferSizeCallback(mHandle, [](GLFWwindow* window, int width, int height)
             {
                 auto* handle = reinterpret_cast<MultiplatformWindow*>(glfwGetWindowUserPointer(window));
-                handle->SendEvent(WindowResizeEvent(width, height));
+                handle->mWidth = static_cast<uint32_t>(width);
+                handle->mHeight = static_cast<uint32_t>(height);
+                handle->SendEvent(WindowResizeEvent{ width, height });
             });
 
             glfwSetCursorPosCallback(mHandle, [](GLFWwindow* window, double x, double y)
             {
                 auto* handle = reinterpret_cast<MultiplatformWindow*>(glfwGetWindowUserPointer(window));
-                handle->SendEvent(MouseMoveEvent(static_cast<int>(x), static_cast<int>(y)));
+                handle->SendEvent(MouseMoveEvent{ static_cast<int>(x), static_cast<int>(y) });
             });
 
         }
@@ -8,6 +8,7 @@
 namespace Fluent
 {
     class Event;
+    /// Called from event polling, should only queue event
     using EventCallbackFn = std::function<void(const Event&)>;
 
     struct WindowDescription
@@ -4,6 +4,8 @@
 #include "Core/Window.hpp"
 #include "Core/Application.hpp"
 #include "Core/Input.hpp"
+#include "Core/Event.hpp"
+#include "Core/EventBus.hpp"
 #include "Core/Timer.hpp"
 #include "Core/KeyCodes.hpp"
 #include "Core/Layer.hpp"
@@ -11,6 +13,10 @@
 #include "Core/Log.hpp"
 #include "Core/MouseCodes.hpp"
 #include "Core/FileSystem.hpp"
+#include "Core/Archive.hpp"
+#include "Core/AsyncFileReader.hpp"
+#include "Core/FileWatcher.hpp"
+#include "Core/Profiler.hpp"
 
 #include "Math/Math.hpp"
 
@@ -23,9 +29,22 @@
 #include "Renderer/DescriptorSetLayout.hpp"
 #include "Renderer/DescriptorSet.hpp"
 #include "Renderer/Pipeline.hpp"
+#include "Renderer/PipelineCompiler.hpp"
+#include "Renderer/RenderQueue.hpp"
+#include "Renderer/CommandStream.hpp"
+#include "Renderer/ShaderHotReload.hpp"
+#include "Renderer/TextureStreamer.hpp"
+#include "Renderer/Downsampler.hpp"
 #include "Renderer/Sampler.hpp"
 
 #include "Scene/Model.hpp"
 #include "Scene/ModelLoader.hpp"
+#include "Scene/MeshOptimizer.hpp"
+#include "Scene/MeshSimplifier.hpp"
+#include "Scene/InstanceBatch.hpp"
+#include "Scene/TransformHierarchy.hpp"
+#include "Scene/World.hpp"
+#include "Scene/Components.hpp"
 
 #include "UI/UIContext.hpp"
+#include "UI/MemoryPanel.hpp"
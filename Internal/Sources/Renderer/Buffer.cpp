@@ -11,6 +11,7 @@ namespace Fluent
         VkBuffer mHandle;
         uint32_t mSize;
         void* mMappedMemory = nullptr;
+        bool mRelocatable = false;
 
         void InitBuffer(const BufferDescription& description)
         {
@@ -36,6 +37,17 @@ namespace Fluent
                 mHandle = (VkBuffer)buffer;
                 mAllocation = allocation;
             }
+
+            /// Vertex and index buffers are bound every frame so they never outlive relocation in descriptor sets
+            if (description.memoryUsage == MemoryUsage::eGpu &&
+                (description.bufferUsage & (BufferUsage::eVertexBuffer | BufferUsage::eIndexBuffer)))
+            {
+                context.GetDeviceAllocator().SetRelocationCallback(mAllocation, [this](Handle buffer)
+                {
+                    mHandle = (VkBuffer)buffer;
+                });
+                mRelocatable = true;
+            }
         }
     public:
         VulkanBuffer(const BufferDescription& description)
@@ -51,7 +63,16 @@ namespace Fluent
         {
             if (mAllocation)
             {
-                GetGraphicContext().GetDeviceAllocator().FreeBuffer(mHandle, mAllocation);
+                auto& context = GetGraphicContext();
+
+                /// Buffer can't be moved anymore when its owner is gone
+                if (mRelocatable)
+                    context.GetDeviceAllocator().SetRelocationCallback(mAllocation, nullptr);
+
+                context.DeferDestruction([handle = mHandle, allocation = mAllocation]()
+                {
+                    GetGraphicContext().GetDeviceAllocator().FreeBuffer(handle, allocation);
+                });
             }
         }
 
@@ -11,6 +11,7 @@ namespace Fluent
         BufferUsage::Bits   bufferUsage; // TODO: Can be changed to descriptor type
         void*               data;
         uint32_t            size;
+        MemoryTag           memoryTag = MemoryTag::eUnknown;
     };
     
     class Buffer
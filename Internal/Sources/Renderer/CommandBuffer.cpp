@@ -1,11 +1,60 @@
+#include <cassert>
+#include <array>
+#include <cstring>
 #include "Renderer/CommandBuffer.hpp"
+#include "Renderer/GraphicContext.hpp"
 
 namespace Fluent
 {
     class VulkanCommandBuffer : public CommandBuffer
     {
     private:
-        VkCommandBuffer mHandle;
+        /// Graphics and compute, ray tracing is not tracked
+        static constexpr uint32_t TRACKED_BIND_POINT_COUNT = 2;
+
+        struct BoundDescriptorSet
+        {
+            VkPipelineLayout    layout = VK_NULL_HANDLE;
+            VkDescriptorSet     set = VK_NULL_HANDLE;
+        };
+
+        struct BoundVertexBuffer
+        {
+            VkBuffer        buffer = VK_NULL_HANDLE;
+            VkDeviceSize    offset = 0;
+        };
+
+        /// Shadow of command buffer state, methods are const so it is mutable
+        struct TrackedState
+        {
+            std::array<VkPipeline, TRACKED_BIND_POINT_COUNT>    pipelines{};
+            std::array<std::array<BoundDescriptorSet, MAX_DESCRIPTOR_SET_COUNT>, TRACKED_BIND_POINT_COUNT> descriptorSets{};
+            std::array<BoundVertexBuffer, MAX_VERTEX_BINDING_COUNT> vertexBuffers{};
+            VkBuffer                                            indexBuffer = VK_NULL_HANDLE;
+            VkDeviceSize                                        indexOffset = 0;
+            VkIndexType                                         indexType = VK_INDEX_TYPE_MAX_ENUM;
+            bool                                                hasViewport = false;
+            VkViewport                                          viewport{};
+            bool                                                hasScissor = false;
+            VkRect2D                                            scissor{};
+        };
+
+        VkCommandBuffer             mHandle;
+        mutable TrackedState        mState;
+        mutable CommandBufferStats  mStats;
+
+        /// Returns true if bind must be recorded
+        bool TrackBind(bool redundant) const
+        {
+            if (redundant)
+            {
+                mStats.skippedBindCount++;
+                return false;
+            }
+
+            mStats.bindCount++;
+            return true;
+        }
     public:
         VulkanCommandBuffer(const CommandBufferDescription& description)
         {
@@ -28,6 +77,9 @@ namespace Fluent
             beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
             beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
+            /// All state is undefined when recording begins
+            mState = {};
+            mStats = {};
             vkBeginCommandBuffer(mHandle, &beginInfo);
         }
 
@@ -38,12 +90,15 @@ namespace Fluent
 
         void BeginRenderPass(const Ref<RenderPass>& renderPass, const Ref<Framebuffer>& framebuffer) const override
         {
-            std::vector<VkClearValue> clearValues(renderPass->GetClearValues().size()
-                                                    + (renderPass->HasDepthStencil() ? 1 : 0));
-            uint32_t i = 0;
+            /// Color attachments and depth stencil
+            std::array<VkClearValue, MAX_COLOR_ATTACHMENT_COUNT + 1> clearValues{};
+            uint32_t clearValueCount = 0;
             for (auto& clearValue : renderPass->GetClearValues())
             {
-                auto& vkClearValue = clearValues[i].color.float32;
+                if (clearValueCount == MAX_COLOR_ATTACHMENT_COUNT)
+                    break;
+
+                auto& vkClearValue = clearValues[clearValueCount++].color.float32;
                 vkClearValue[0] = clearValue.color.r;
                 vkClearValue[1] = clearValue.color.g;
                 vkClearValue[2] = clearValue.color.b;
@@ -51,10 +106,7 @@ namespace Fluent
             }
 
             if (renderPass->HasDepthStencil())
-            {
-                clearValues[clearValues.size() - 1] = {};
-                clearValues[clearValues.size() - 1].depthStencil = { renderPass->GetDepth(), renderPass->GetStencil() };
-            }
+                clearValues[clearValueCount++].depthStencil = { renderPass->GetDepth(), renderPass->GetStencil() };
 
             VkRect2D rect{};
             rect.extent = { renderPass->GetWidth(), renderPass->GetHeight() };
@@ -62,7 +114,7 @@ namespace Fluent
 
             VkRenderPassBeginInfo renderPassBeginInfo{};
             renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-            renderPassBeginInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+            renderPassBeginInfo.clearValueCount = clearValueCount;
             renderPassBeginInfo.pClearValues = clearValues.data();
             renderPassBeginInfo.renderArea = rect;
             renderPassBeginInfo.framebuffer = (VkFramebuffer)framebuffer->GetNativeHandle();
@@ -78,48 +130,126 @@ namespace Fluent
 
         void Dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ) const override
         {
+            mStats.dispatchCount++;
             vkCmdDispatch(mHandle, groupCountX, groupCountY, groupCountZ);
         }
 
         void Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance) const override
         {
+            mStats.drawCount++;
             vkCmdDraw(mHandle, vertexCount, instanceCount, firstVertex, firstInstance);
         }
 
         void DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance) const override
         {
+            mStats.drawCount++;
             vkCmdDrawIndexed(mHandle, indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
         }
         
-        void BindDescriptorSet(const Ref<Pipeline>& pipeline, const Ref<DescriptorSet>& set) const override
+        void BindDescriptorSet(const Ref<Pipeline>& pipeline, const Ref<DescriptorSet>& set, uint32_t setIndex) const override
         {
             VkPipelineLayout layout = (VkPipelineLayout)pipeline->GetPipelineLayout();
             VkDescriptorSet nativeSet = (VkDescriptorSet)set->GetNativeHandle();
+            auto bindPoint = ToVulkanPipelineBindPoint(pipeline->GetType());
+
+            if (bindPoint < TRACKED_BIND_POINT_COUNT && setIndex < MAX_DESCRIPTOR_SET_COUNT)
+            {
+                auto& bound = mState.descriptorSets[bindPoint];
+                if (!TrackBind(bound[setIndex].layout == layout && bound[setIndex].set == nativeSet))
+                    return;
+
+                /// Compatibility of layouts is not checked, so sets bound with other layout may be disturbed
+                for (auto& boundSet : bound)
+                {
+                    if (boundSet.layout != layout)
+                        boundSet = {};
+                }
+                bound[setIndex] = { layout, nativeSet };
+            }
+            else
+            {
+                mStats.bindCount++;
+            }
+
             vkCmdBindDescriptorSets
             (
                 mHandle,
-                ToVulkanPipelineBindPoint(pipeline->GetType()),
+                bindPoint,
                 layout,
-                0, 1, &nativeSet,
+                setIndex, 1, &nativeSet,
                 0, nullptr
             );
         }
 
         void BindPipeline(const Ref<Pipeline>& pipeline) const override
         {
-            vkCmdBindPipeline(mHandle, ToVulkanPipelineBindPoint(pipeline->GetType()), (VkPipeline)pipeline->GetNativeHandle());
+            VkPipeline nativePipeline = (VkPipeline)pipeline->GetNativeHandle();
+            auto bindPoint = ToVulkanPipelineBindPoint(pipeline->GetType());
+
+            if (bindPoint < TRACKED_BIND_POINT_COUNT)
+            {
+                if (!TrackBind(mState.pipelines[bindPoint] == nativePipeline))
+                    return;
+                mState.pipelines[bindPoint] = nativePipeline;
+            }
+            else
+            {
+                mStats.bindCount++;
+            }
+
+            vkCmdBindPipeline(mHandle, bindPoint, nativePipeline);
         }
 
         void BindVertexBuffer(const Ref<Buffer>& buffer, uint32_t offset) const override
         {
             VkBuffer vkBuffer = (VkBuffer)buffer->GetNativeHandle();
             VkDeviceSize vkOffsets = offset;
+
+            auto& bound = mState.vertexBuffers[0];
+            if (!TrackBind(bound.buffer == vkBuffer && bound.offset == vkOffsets))
+                return;
+            bound = { vkBuffer, vkOffsets };
+
             vkCmdBindVertexBuffers(mHandle, 0, 1, &vkBuffer, &vkOffsets);
         }
 
+        void BindVertexBuffers(uint32_t firstBinding, const std::vector<Ref<Buffer>>& buffers, const std::vector<uint32_t>& offsets) const override
+        {
+            VkBuffer vkBuffers[MAX_VERTEX_BINDING_COUNT];
+            VkDeviceSize vkOffsets[MAX_VERTEX_BINDING_COUNT];
+
+            if (firstBinding >= MAX_VERTEX_BINDING_COUNT)
+                return;
+
+            uint32_t bindingCount = std::min(static_cast<uint32_t>(buffers.size()), MAX_VERTEX_BINDING_COUNT - firstBinding);
+            bool redundant = true;
+            for (uint32_t i = 0; i < bindingCount; ++i)
+            {
+                vkBuffers[i] = (VkBuffer)buffers[i]->GetNativeHandle();
+                vkOffsets[i] = i < offsets.size() ? offsets[i] : 0;
+
+                auto& bound = mState.vertexBuffers[firstBinding + i];
+                redundant &= bound.buffer == vkBuffers[i] && bound.offset == vkOffsets[i];
+                bound = { vkBuffers[i], vkOffsets[i] };
+            }
+
+            if (!TrackBind(redundant))
+                return;
+
+            vkCmdBindVertexBuffers(mHandle, firstBinding, bindingCount, vkBuffers, vkOffsets);
+        }
+
         void BindIndexBuffer(const Ref<Buffer>& buffer, uint32_t offset, IndexType type) const override
         {
-            vkCmdBindIndexBuffer(mHandle, (VkBuffer)buffer->GetNativeHandle(), offset, ToVulkanIndexType(type));
+            VkBuffer vkBuffer = (VkBuffer)buffer->GetNativeHandle();
+            VkIndexType indexType = ToVulkanIndexType(type);
+            if (!TrackBind(mState.indexBuffer == vkBuffer && mState.indexOffset == offset && mState.indexType == indexType))
+                return;
+
+            mState.indexBuffer = vkBuffer;
+            mState.indexOffset = offset;
+            mState.indexType = indexType;
+            vkCmdBindIndexBuffer(mHandle, vkBuffer, offset, indexType);
         }
 
         void SetScissor(uint32_t width, uint32_t height, int32_t x, int32_t y) override
@@ -127,6 +257,14 @@ namespace Fluent
             VkRect2D scissor{};
             scissor.offset = { x, y };
             scissor.extent = { width, height };
+
+            bool redundant = mState.hasScissor &&
+                             std::memcmp(&mState.scissor, &scissor, sizeof(VkRect2D)) == 0;
+            if (!TrackBind(redundant))
+                return;
+
+            mState.hasScissor = true;
+            mState.scissor = scissor;
             vkCmdSetScissor(mHandle, 0, 1, &scissor);
         }
 
@@ -140,16 +278,33 @@ namespace Fluent
             viewport.x = static_cast<float>(x);
             viewport.y = static_cast<float>(y + height);
 
+            bool redundant = mState.hasViewport &&
+                             std::memcmp(&mState.viewport, &viewport, sizeof(VkViewport)) == 0;
+            if (!TrackBind(redundant))
+                return;
+
+            mState.hasViewport = true;
+            mState.viewport = viewport;
             vkCmdSetViewport(mHandle, 0, 1, &viewport);
         }
 
         void PushConstants(const Ref<Pipeline>& pipeline, uint32_t offset, uint32_t size, const void* data) const override
         {
+            /// Write must lie within ranges of pipeline layout, straddling ones are split by caller
+            VkShaderStageFlags stageFlags = GetPushConstantStages(pipeline->GetPushConstantRanges(), offset, size);
+            assert(stageFlags && "Push constants must lie within ranges of pipeline layout");
+            if (!stageFlags)
+            {
+                LOG_CATEGORY_ERROR(eRenderer, "Push constants at offset {} of size {} don't lie within ranges of pipeline layout", offset, size);
+                return;
+            }
+
+            mStats.pushConstantBytes += size;
             vkCmdPushConstants
             (
                mHandle,
                (VkPipelineLayout)pipeline->GetPipelineLayout(),
-               VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+               stageFlags,
                offset, size, data
             );
         }
@@ -164,7 +319,7 @@ namespace Fluent
             vkCmdCopyBuffer(mHandle, (VkBuffer)src->GetNativeHandle(), (VkBuffer)dst.GetNativeHandle(), 1, &bufferCopy);
         }
 
-        void CopyBufferToImage(const Ref<Buffer>& src, uint32_t srcOffset, Image& dst, ImageUsage::Bits dstUsage) override
+        void CopyBufferToImage(const Ref<Buffer>& src, uint32_t srcOffset, Image& dst, ImageUsage::Bits dstUsage, uint32_t mipLevel) override
         {
             if (dstUsage != ImageUsage::eTransferDst)
             {
@@ -179,6 +334,7 @@ namespace Fluent
                 toTransferDstBarrier.image = (VkImage)dst.GetNativeHandle();
                 toTransferDstBarrier.subresourceRange = GetImageSubresourceRange(dst);
 
+                mStats.barrierCount++;
                 vkCmdPipelineBarrier
                 (
                     mHandle,
@@ -192,6 +348,7 @@ namespace Fluent
             }
 
             auto dstLayers = GetImageSubresourceLayers(dst);
+            dstLayers.mipLevel = mipLevel;
 
             VkBufferImageCopy bufferToImageCopyInfo{};
             bufferToImageCopyInfo.bufferOffset = srcOffset;
@@ -199,7 +356,7 @@ namespace Fluent
             bufferToImageCopyInfo.bufferRowLength = 0;
             bufferToImageCopyInfo.imageSubresource = dstLayers;
             bufferToImageCopyInfo.imageOffset = VkOffset3D{ 0, 0, 0 };
-            bufferToImageCopyInfo.imageExtent = VkExtent3D { dst.GetWidth(), dst.GetHeight(), 1 };
+            bufferToImageCopyInfo.imageExtent = VkExtent3D { std::max(dst.GetWidth() >> mipLevel, 1u), std::max(dst.GetHeight() >> mipLevel, 1u), 1 };
 
             vkCmdCopyBufferToImage
             (
@@ -248,6 +405,7 @@ namespace Fluent
 
             if (barrierCount > 0)
             {
+                mStats.barrierCount += static_cast<uint32_t>(barrierCount);
                 vkCmdPipelineBarrier
                     (
                         mHandle,
@@ -306,6 +464,7 @@ namespace Fluent
             barrier.image = (VkImage)image.GetNativeHandle();
             barrier.subresourceRange = imageSubresourceRange;
 
+            mStats.barrierCount++;
             vkCmdPipelineBarrier
             (
                 mHandle,
@@ -322,6 +481,11 @@ namespace Fluent
         {
             if (image.GetMipLevelsCount() < 2) return;
 
+            /// Whole chain in one dispatch when image has storage views, blit per level otherwise
+            auto& downsampler = GetGraphicContext().GetDownsampler();
+            if (downsampler.IsSupported(image) && downsampler.GenerateMipLevels(*this, image, initialUsage))
+                return;
+
             auto srcRange = GetImageSubresourceRange(image);
             auto dstRange = GetImageSubresourceRange(image);
             auto srcLayers = GetImageSubresourceLayers(image);
@@ -358,6 +522,7 @@ namespace Fluent
                 imageBarrier.image = (VkImage)image.GetNativeHandle();
                 imageBarrier.subresourceRange = srcRange;
 
+                mStats.barrierCount++;
                 vkCmdPipelineBarrier
                     (
                         mHandle,
@@ -375,7 +540,7 @@ namespace Fluent
                 imageBlitInfo.srcOffsets[0] = { 0, 0, 0 };
                 imageBlitInfo.srcOffsets[1] = { (int32_t)sourceWidth, (int32_t)sourceHeight, 1 };
                 imageBlitInfo.dstOffsets[0] = { 0, 0, 0 };
-                imageBlitInfo.dstOffsets[1] = { (int32_t)destinationWidth, (int32_t)destinationWidth, 1 };
+                imageBlitInfo.dstOffsets[1] = { (int32_t)destinationWidth, (int32_t)destinationHeight, 1 };
                 imageBlitInfo.srcSubresource = srcLayers;
                 imageBlitInfo.dstSubresource = dstLayers;
 
@@ -404,6 +569,7 @@ namespace Fluent
             mipLevelsTransfer.image = (VkImage)image.GetNativeHandle();
             mipLevelsTransfer.subresourceRange = mipLevelsSubresourceRange;
 
+            mStats.barrierCount++;
             vkCmdPipelineBarrier
                 (
                     mHandle,
@@ -416,6 +582,26 @@ namespace Fluent
                 );
         }
 
+        void InvalidateState() const override
+        {
+            mState = {};
+        }
+
+        void AddStats(const CommandBufferStats& stats) const override
+        {
+            mStats.drawCount += stats.drawCount;
+            mStats.dispatchCount += stats.dispatchCount;
+            mStats.bindCount += stats.bindCount;
+            mStats.skippedBindCount += stats.skippedBindCount;
+            mStats.barrierCount += stats.barrierCount;
+            mStats.pushConstantBytes += stats.pushConstantBytes;
+        }
+
+        const CommandBufferStats& GetStats() const override
+        {
+            return mStats;
+        }
+
         Handle GetNativeHandle() const override
         {
             return mHandle;
@@ -17,6 +17,21 @@ namespace Fluent
         Handle commandPool;
     };
 
+    /// Counters of commands recorded since last Begin
+    struct CommandBufferStats
+    {
+        uint32_t drawCount = 0;
+        uint32_t dispatchCount = 0;
+        /// Pipeline, descriptor set, vertex and index buffer binds and viewport and scissor sets
+        uint32_t bindCount = 0;
+        /// Same calls dropped because state was already set
+        uint32_t skippedBindCount = 0;
+        uint32_t barrierCount = 0;
+        uint32_t pushConstantBytes = 0;
+    };
+
+    /// Binds and dynamic state equal to already set ones are not forwarded to driver.
+    /// Tracked state is reset by Begin
     class CommandBuffer
     {
     protected:
@@ -35,24 +50,34 @@ namespace Fluent
         virtual void Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance) const = 0;
         virtual void DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance) const = 0;
         
-        virtual void BindDescriptorSet(const Ref<Pipeline>& pipeline, const Ref<DescriptorSet>& set) const = 0;
+        /// Sets with lower index stay bound when pipeline layouts are compatible up to them
+        virtual void BindDescriptorSet(const Ref<Pipeline>& pipeline, const Ref<DescriptorSet>& set, uint32_t setIndex) const = 0;
         virtual void BindPipeline(const Ref<Pipeline>& pipeline) const = 0;
 
         virtual void BindVertexBuffer(const Ref<Buffer>& buffer, uint32_t offset) const = 0;
+        virtual void BindVertexBuffers(uint32_t firstBinding, const std::vector<Ref<Buffer>>& buffers, const std::vector<uint32_t>& offsets) const = 0;
         virtual void BindIndexBuffer(const Ref<Buffer>& buffer, uint32_t offset, IndexType type) const = 0;
 
+        /// Stages are taken from reflected ranges which overlap written bytes
         virtual void PushConstants(const Ref<Pipeline>& pipeline, uint32_t offset, uint32_t size, const void* data) const = 0;
 
         virtual void SetScissor(uint32_t width, uint32_t height, int32_t x, int32_t y) = 0;
         virtual void SetViewport(uint32_t width, uint32_t height, float minDepth, float maxDepth, uint32_t x, uint32_t y) = 0;
         virtual void CopyBuffer(const Ref<Buffer>& src, uint32_t srcOffset, Buffer& dst, uint32_t dstOffset, uint32_t size) = 0;
-        virtual void CopyBufferToImage(const Ref<Buffer>& src, uint32_t srcOffset, Image& dst, ImageUsage::Bits dstUsage) = 0;
+        /// Barrier to transfer dst covers all mips, pass eTransferDst for next levels
+        virtual void CopyBufferToImage(const Ref<Buffer>& src, uint32_t srcOffset, Image& dst, ImageUsage::Bits dstUsage, uint32_t mipLevel = 0) = 0;
         virtual void BlitImage(const Ref<Image>& src, ImageUsage::Bits srcUsage, const Ref<Image>& dst, ImageUsage::Bits dstUsage, Filter filter) const = 0;
         virtual void GenerateMipLevels(const Image& image, ImageUsage::Bits initialUsage, Filter filter) const = 0;
         
         virtual void ImageBarrier(Ref<Image>& image, ImageUsage::Bits src, ImageUsage::Bits dst) const = 0;
         virtual void ImageBarrier(Image& image, ImageUsage::Bits src, ImageUsage::Bits dst) const = 0;
 
+        /// Call after recording into native handle directly, tracked binds are forgotten
+        virtual void InvalidateState() const = 0;
+        /// Counts commands recorded into native handle directly
+        virtual void AddStats(const CommandBufferStats& stats) const = 0;
+        virtual const CommandBufferStats& GetStats() const = 0;
+
         virtual Handle GetNativeHandle() const = 0;
 
         static Ref<CommandBuffer> Create(const CommandBufferDescription& description);
@@ -0,0 +1,356 @@
+#include <algorithm>
+#include <cassert>
+#include "Core/Log.hpp"
+#include "Core/Profiler.hpp"
+#include "Renderer/CommandStream.hpp"
+
+namespace Fluent
+{
+    static constexpr uint32_t STREAM_MAGIC = 0x4D525453; // STRM
+
+    void CommandStream::BeginGroup(uint64_t sortKey)
+    {
+        auto offset = static_cast<uint32_t>(mData.size());
+        /// Empty group is reused
+        if (!mGroups.empty() && mGroups.back().begin == mGroups.back().end)
+            mGroups.back().sortKey = sortKey;
+        else
+            mGroups.push_back({ sortKey, offset, offset });
+    }
+
+    void CommandStream::BindPipeline(const Ref<Pipeline>& pipeline)
+    {
+        BindPipelineCommand command{};
+        command.pipeline = pipeline->GetNativeHandle();
+        command.bindPoint = ToVulkanPipelineBindPoint(pipeline->GetType());
+        Push(command);
+    }
+
+    void CommandStream::BindDescriptorSet(const Ref<Pipeline>& pipeline, const Ref<DescriptorSet>& set, uint32_t setIndex)
+    {
+        BindDescriptorSetCommand command{};
+        command.layout = pipeline->GetPipelineLayout();
+        command.set = set->GetNativeHandle();
+        command.bindPoint = ToVulkanPipelineBindPoint(pipeline->GetType());
+        command.setIndex = setIndex;
+        Push(command);
+    }
+
+    void CommandStream::BindVertexBuffer(const Ref<Buffer>& buffer, uint64_t offset, uint32_t binding)
+    {
+        BindVertexBufferCommand command{};
+        command.buffer = buffer->GetNativeHandle();
+        command.offset = offset;
+        command.binding = binding;
+        Push(command);
+    }
+
+    void CommandStream::BindIndexBuffer(const Ref<Buffer>& buffer, uint64_t offset, IndexType type)
+    {
+        BindIndexBufferCommand command{};
+        command.buffer = buffer->GetNativeHandle();
+        command.offset = offset;
+        command.indexType = ToVulkanIndexType(type);
+        Push(command);
+    }
+
+    void CommandStream::PushConstants(const Ref<Pipeline>& pipeline, uint32_t offset, uint32_t size, const void* data)
+    {
+        /// Write must lie within ranges of pipeline layout, straddling ones are split by caller
+        VkShaderStageFlags stageFlags = GetPushConstantStages(pipeline->GetPushConstantRanges(), offset, size);
+        assert(stageFlags && "Push constants must lie within ranges of pipeline layout");
+        if (!stageFlags)
+        {
+            LOG_CATEGORY_ERROR(eRenderer, "Push constants at offset {} of size {} don't lie within ranges of pipeline layout", offset, size);
+            return;
+        }
+
+        PushConstantsCommand command{};
+        command.layout = pipeline->GetPipelineLayout();
+        command.stageFlags = stageFlags;
+        command.offset = offset;
+        command.size = size;
+        std::memcpy(Push(command, size), data, size);
+    }
+
+    void CommandStream::SetViewport(uint32_t width, uint32_t height, float minDepth, float maxDepth, uint32_t x, uint32_t y)
+    {
+        SetViewportCommand command{};
+        command.x = static_cast<float>(x);
+        command.y = static_cast<float>(y + height);
+        command.width = static_cast<float>(width);
+        command.height = -static_cast<float>(height);
+        command.minDepth = minDepth;
+        command.maxDepth = maxDepth;
+        Push(command);
+    }
+
+    void CommandStream::SetScissor(uint32_t width, uint32_t height, int32_t x, int32_t y)
+    {
+        Push(SetScissorCommand{ x, y, width, height });
+    }
+
+    void CommandStream::Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance)
+    {
+        Push(DrawCommand{ vertexCount, instanceCount, firstVertex, firstInstance });
+    }
+
+    void CommandStream::DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance)
+    {
+        Push(DrawIndexedCommand{ indexCount, instanceCount, firstIndex, vertexOffset, firstInstance });
+    }
+
+    void CommandStream::Dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
+    {
+        Push(DispatchCommand{ groupCountX, groupCountY, groupCountZ });
+    }
+
+    void CommandStream::Reset()
+    {
+        mData.clear();
+        mGroups.clear();
+    }
+
+    template<typename T>
+    static constexpr uint32_t GetCommandOffset()
+    {
+        return (sizeof(CommandHeader) + alignof(T) - 1) / alignof(T) * alignof(T);
+    }
+
+    template<typename T>
+    static constexpr uint32_t GetMinPacketSize()
+    {
+        return GetCommandOffset<T>() + sizeof(T);
+    }
+
+    static uint32_t GetMinPacketSize(CommandType type)
+    {
+        switch (type)
+        {
+            case CommandType::eBindPipeline: return GetMinPacketSize<BindPipelineCommand>();
+            case CommandType::eBindDescriptorSet: return GetMinPacketSize<BindDescriptorSetCommand>();
+            case CommandType::eBindVertexBuffer: return GetMinPacketSize<BindVertexBufferCommand>();
+            case CommandType::eBindIndexBuffer: return GetMinPacketSize<BindIndexBufferCommand>();
+            case CommandType::ePushConstants: return GetMinPacketSize<PushConstantsCommand>();
+            case CommandType::eSetViewport: return GetMinPacketSize<SetViewportCommand>();
+            case CommandType::eSetScissor: return GetMinPacketSize<SetScissorCommand>();
+            case CommandType::eDraw: return GetMinPacketSize<DrawCommand>();
+            case CommandType::eDrawIndexed: return GetMinPacketSize<DrawIndexedCommand>();
+            case CommandType::eDispatch: return GetMinPacketSize<DispatchCommand>();
+            default: break;
+        }
+        return 0;
+    }
+
+    template<typename T>
+    static const T& ReadCommand(const uint8_t* packet)
+    {
+        return *reinterpret_cast<const T*>(packet + GetCommandOffset<T>());
+    }
+
+    bool CommandStream::ValidatePackets() const
+    {
+        for (const auto& group : mGroups)
+        {
+            if (group.begin > group.end || group.end > mData.size() || group.begin % PACKET_ALIGNMENT != 0)
+                return false;
+
+            for (uint32_t offset = group.begin; offset < group.end;)
+            {
+                if (group.end - offset < sizeof(CommandHeader))
+                    return false;
+
+                CommandHeader header;
+                std::memcpy(&header, mData.data() + offset, sizeof(header));
+
+                uint32_t minSize = GetMinPacketSize(header.type);
+                if (minSize == 0 || header.size < minSize || header.size % PACKET_ALIGNMENT != 0 || header.size > group.end - offset)
+                    return false;
+
+                /// Inline data must fit into packet too
+                if (header.type == CommandType::ePushConstants)
+                {
+                    PushConstantsCommand command;
+                    std::memcpy(&command, mData.data() + offset + GetCommandOffset<PushConstantsCommand>(), sizeof(command));
+                    if (command.size > header.size - minSize)
+                        return false;
+                }
+
+                offset += header.size;
+            }
+        }
+
+        return true;
+    }
+
+    void CommandStream::Serialize(std::vector<uint8_t>& data) const
+    {
+        uint32_t header[3] = { STREAM_MAGIC, static_cast<uint32_t>(mGroups.size()), static_cast<uint32_t>(mData.size()) };
+        size_t groupsSize = mGroups.size() * sizeof(CommandGroup);
+
+        data.resize(sizeof(header) + groupsSize + mData.size());
+        std::memcpy(data.data(), header, sizeof(header));
+        /// Data of empty vector may be null, which memcpy doesn't take even for zero size
+        if (groupsSize)
+            std::memcpy(data.data() + sizeof(header), mGroups.data(), groupsSize);
+        if (!mData.empty())
+            std::memcpy(data.data() + sizeof(header) + groupsSize, mData.data(), mData.size());
+    }
+
+    bool CommandStream::Deserialize(const std::vector<uint8_t>& data)
+    {
+        uint32_t header[3];
+        if (data.size() < sizeof(header))
+            return false;
+
+        std::memcpy(header, data.data(), sizeof(header));
+        size_t groupsSize = static_cast<size_t>(header[1]) * sizeof(CommandGroup);
+        if (header[0] != STREAM_MAGIC || data.size() != sizeof(header) + groupsSize + header[2])
+        {
+            LOG_CATEGORY_ERROR(eRenderer, "Invalid serialized command stream");
+            return false;
+        }
+
+        mGroups.resize(header[1]);
+        mData.resize(header[2]);
+        if (groupsSize)
+            std::memcpy(mGroups.data(), data.data() + sizeof(header), groupsSize);
+        if (!mData.empty())
+            std::memcpy(mData.data(), data.data() + sizeof(header) + groupsSize, mData.size());
+
+        if (!ValidatePackets())
+        {
+            LOG_CATEGORY_ERROR(eRenderer, "Invalid serialized command stream");
+            Reset();
+            return false;
+        }
+        return true;
+    }
+
+    void CommandStreamExecutor::Merge(const CommandStream& stream)
+    {
+        const uint8_t* data = stream.GetData().data();
+        for (const auto& group : stream.GetGroups())
+        {
+            if (group.begin != group.end)
+                mGroups.push_back({ group.sortKey, data + group.begin, data + group.end });
+        }
+    }
+
+    void CommandStreamExecutor::Execute(const Ref<CommandBuffer>& cmd, bool sort)
+    {
+        PROFILE_SCOPE("CommandStreamExecutor::Execute");
+        if (sort)
+        {
+            std::stable_sort(mGroups.begin(), mGroups.end(), [](const GroupRef& a, const GroupRef& b)
+            {
+                return a.sortKey < b.sortKey;
+            });
+        }
+
+        auto nativeCmd = (VkCommandBuffer)cmd->GetNativeHandle();
+        CommandBufferStats stats;
+        for (const auto& group : mGroups)
+        {
+            for (const uint8_t* packet = group.begin; packet < group.end;)
+            {
+                CommandHeader header;
+                std::memcpy(&header, packet, sizeof(header));
+
+                switch (header.type)
+                {
+                    case CommandType::eBindPipeline:
+                    {
+                        const auto& command = ReadCommand<BindPipelineCommand>(packet);
+                        stats.bindCount++;
+                        vkCmdBindPipeline(nativeCmd, VkPipelineBindPoint(command.bindPoint), (VkPipeline)command.pipeline);
+                        break;
+                    }
+                    case CommandType::eBindDescriptorSet:
+                    {
+                        const auto& command = ReadCommand<BindDescriptorSetCommand>(packet);
+                        VkDescriptorSet set = (VkDescriptorSet)command.set;
+                        stats.bindCount++;
+                        vkCmdBindDescriptorSets(nativeCmd, VkPipelineBindPoint(command.bindPoint), (VkPipelineLayout)command.layout,
+                                                command.setIndex, 1, &set, 0, nullptr);
+                        break;
+                    }
+                    case CommandType::eBindVertexBuffer:
+                    {
+                        const auto& command = ReadCommand<BindVertexBufferCommand>(packet);
+                        VkBuffer buffer = (VkBuffer)command.buffer;
+                        VkDeviceSize offset = command.offset;
+                        stats.bindCount++;
+                        vkCmdBindVertexBuffers(nativeCmd, command.binding, 1, &buffer, &offset);
+                        break;
+                    }
+                    case CommandType::eBindIndexBuffer:
+                    {
+                        const auto& command = ReadCommand<BindIndexBufferCommand>(packet);
+                        stats.bindCount++;
+                        vkCmdBindIndexBuffer(nativeCmd, (VkBuffer)command.buffer, command.offset, VkIndexType(command.indexType));
+                        break;
+                    }
+                    case CommandType::ePushConstants:
+                    {
+                        const auto& command = ReadCommand<PushConstantsCommand>(packet);
+                        stats.pushConstantBytes += command.size;
+                        vkCmdPushConstants(nativeCmd, (VkPipelineLayout)command.layout, command.stageFlags,
+                                           command.offset, command.size, &command + 1);
+                        break;
+                    }
+                    case CommandType::eSetViewport:
+                    {
+                        const auto& command = ReadCommand<SetViewportCommand>(packet);
+                        VkViewport viewport{ command.x, command.y, command.width, command.height, command.minDepth, command.maxDepth };
+                        stats.bindCount++;
+                        vkCmdSetViewport(nativeCmd, 0, 1, &viewport);
+                        break;
+                    }
+                    case CommandType::eSetScissor:
+                    {
+                        const auto& command = ReadCommand<SetScissorCommand>(packet);
+                        VkRect2D scissor{ { command.x, command.y }, { command.width, command.height } };
+                        stats.bindCount++;
+                        vkCmdSetScissor(nativeCmd, 0, 1, &scissor);
+                        break;
+                    }
+                    case CommandType::eDraw:
+                    {
+                        const auto& command = ReadCommand<DrawCommand>(packet);
+                        stats.drawCount++;
+                        vkCmdDraw(nativeCmd, command.vertexCount, command.instanceCount, command.firstVertex, command.firstInstance);
+                        break;
+                    }
+                    case CommandType::eDrawIndexed:
+                    {
+                        const auto& command = ReadCommand<DrawIndexedCommand>(packet);
+                        stats.drawCount++;
+                        vkCmdDrawIndexed(nativeCmd, command.indexCount, command.instanceCount, command.firstIndex,
+                                         command.vertexOffset, command.firstInstance);
+                        break;
+                    }
+                    case CommandType::eDispatch:
+                    {
+                        const auto& command = ReadCommand<DispatchCommand>(packet);
+                        stats.dispatchCount++;
+                        vkCmdDispatch(nativeCmd, command.groupCountX, command.groupCountY, command.groupCountZ);
+                        break;
+                    }
+                    default:
+                        LOG_CATEGORY_ERROR(eRenderer, "Unknown command type {} in command stream", static_cast<uint32_t>(header.type));
+                        break;
+                }
+
+                if (header.size == 0)
+                    break;
+                packet += header.size;
+            }
+        }
+
+        /// Commands bypassed command buffer, so its tracked binds are stale
+        cmd->AddStats(stats);
+        cmd->InvalidateState();
+        mGroups.clear();
+    }
+} // namespace Fluent
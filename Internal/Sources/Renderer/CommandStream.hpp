@@ -0,0 +1,210 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+#include "Core/Base.hpp"
+#include "Renderer/Renderer.hpp"
+#include "Renderer/Buffer.hpp"
+#include "Renderer/CommandBuffer.hpp"
+#include "Renderer/DescriptorSet.hpp"
+#include "Renderer/Pipeline.hpp"
+
+namespace Fluent
+{
+    enum class CommandType : uint32_t
+    {
+        eBindPipeline,
+        eBindDescriptorSet,
+        eBindVertexBuffer,
+        eBindIndexBuffer,
+        ePushConstants,
+        eSetViewport,
+        eSetScissor,
+        eDraw,
+        eDrawIndexed,
+        eDispatch,
+        eMaxCommand
+    };
+
+    /// Packets hold native handles and values already converted to Vulkan ones,
+    /// so translation is a plain switch over packet types
+    struct CommandHeader
+    {
+        CommandType type;
+        /// Size of packet including header and inline data
+        uint32_t    size;
+    };
+
+    struct BindPipelineCommand
+    {
+        static constexpr CommandType TYPE = CommandType::eBindPipeline;
+        Handle      pipeline;
+        uint32_t    bindPoint;
+    };
+
+    struct BindDescriptorSetCommand
+    {
+        static constexpr CommandType TYPE = CommandType::eBindDescriptorSet;
+        Handle      layout;
+        Handle      set;
+        uint32_t    bindPoint;
+        uint32_t    setIndex;
+    };
+
+    struct BindVertexBufferCommand
+    {
+        static constexpr CommandType TYPE = CommandType::eBindVertexBuffer;
+        Handle      buffer;
+        uint64_t    offset;
+        uint32_t    binding;
+    };
+
+    struct BindIndexBufferCommand
+    {
+        static constexpr CommandType TYPE = CommandType::eBindIndexBuffer;
+        Handle      buffer;
+        uint64_t    offset;
+        uint32_t    indexType;
+    };
+
+    /// Followed by size bytes of data
+    struct PushConstantsCommand
+    {
+        static constexpr CommandType TYPE = CommandType::ePushConstants;
+        Handle      layout;
+        uint32_t    stageFlags;
+        uint32_t    offset;
+        uint32_t    size;
+    };
+
+    struct SetViewportCommand
+    {
+        static constexpr CommandType TYPE = CommandType::eSetViewport;
+        float x, y, width, height, minDepth, maxDepth;
+    };
+
+    struct SetScissorCommand
+    {
+        static constexpr CommandType TYPE = CommandType::eSetScissor;
+        int32_t     x, y;
+        uint32_t    width, height;
+    };
+
+    struct DrawCommand
+    {
+        static constexpr CommandType TYPE = CommandType::eDraw;
+        uint32_t vertexCount, instanceCount, firstVertex, firstInstance;
+    };
+
+    struct DrawIndexedCommand
+    {
+        static constexpr CommandType TYPE = CommandType::eDrawIndexed;
+        uint32_t    indexCount, instanceCount, firstIndex;
+        int32_t     vertexOffset;
+        uint32_t    firstInstance;
+    };
+
+    struct DispatchCommand
+    {
+        static constexpr CommandType TYPE = CommandType::eDispatch;
+        uint32_t groupCountX, groupCountY, groupCountZ;
+    };
+
+    /// Range of packets which is sorted as a whole, packets inside keep their order
+    struct CommandGroup
+    {
+        uint64_t sortKey;
+        uint32_t begin;
+        uint32_t end;
+    };
+
+    /// Linear buffer of POD command packets. One stream must be recorded by one thread,
+    /// use one stream per worker. Memory is kept by Reset, so steady state recording
+    /// doesn't allocate. Resources referenced by packets must outlive execution
+    class CommandStream
+    {
+    private:
+        /// Packets are padded so handles in them are naturally aligned
+        static constexpr uint32_t PACKET_ALIGNMENT = alignof(uint64_t);
+
+        std::vector<uint8_t>        mData;
+        std::vector<CommandGroup>   mGroups;
+
+        /// Checks type, size and alignment of every packet, so executor never reads past group
+        bool ValidatePackets() const;
+
+        template<typename T>
+        uint8_t* Push(const T& command, uint32_t extraSize = 0)
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "Commands are copied as bytes");
+            static_assert(alignof(T) <= PACKET_ALIGNMENT);
+            constexpr uint32_t commandOffset = (sizeof(CommandHeader) + alignof(T) - 1) / alignof(T) * alignof(T);
+
+            uint32_t size = commandOffset + static_cast<uint32_t>(sizeof(T)) + extraSize;
+            size = (size + PACKET_ALIGNMENT - 1) / PACKET_ALIGNMENT * PACKET_ALIGNMENT;
+
+            auto offset = static_cast<uint32_t>(mData.size());
+            mData.resize(mData.size() + size);
+            uint8_t* packet = mData.data() + offset;
+
+            CommandHeader header{ T::TYPE, size };
+            std::memcpy(packet, &header, sizeof(header));
+            std::memcpy(packet + commandOffset, &command, sizeof(T));
+
+            if (mGroups.empty())
+                mGroups.push_back({ 0, offset, offset });
+            mGroups.back().end = offset + size;
+            return packet + commandOffset + sizeof(T);
+        }
+    public:
+        /// Packets recorded until next BeginGroup are sorted by this key
+        void BeginGroup(uint64_t sortKey);
+
+        void BindPipeline(const Ref<Pipeline>& pipeline);
+        void BindDescriptorSet(const Ref<Pipeline>& pipeline, const Ref<DescriptorSet>& set, uint32_t setIndex);
+        void BindVertexBuffer(const Ref<Buffer>& buffer, uint64_t offset, uint32_t binding = 0);
+        void BindIndexBuffer(const Ref<Buffer>& buffer, uint64_t offset, IndexType type);
+        /// Stages are resolved from reflected ranges at record time, data is copied
+        void PushConstants(const Ref<Pipeline>& pipeline, uint32_t offset, uint32_t size, const void* data);
+        /// Same flipped viewport as CommandBuffer::SetViewport
+        void SetViewport(uint32_t width, uint32_t height, float minDepth, float maxDepth, uint32_t x, uint32_t y);
+        void SetScissor(uint32_t width, uint32_t height, int32_t x, int32_t y);
+        void Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance);
+        void DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance);
+        void Dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ);
+
+        /// Drops recorded packets, capacity is kept
+        void Reset();
+
+        /// Packets contain native handles, so serialized stream can be replayed only
+        /// while resources it references are alive, e.g. for capture and debugging
+        void Serialize(std::vector<uint8_t>& data) const;
+        bool Deserialize(const std::vector<uint8_t>& data);
+
+        const std::vector<uint8_t>& GetData() const { return mData; }
+        const std::vector<CommandGroup>& GetGroups() const { return mGroups; }
+        bool IsEmpty() const { return mData.empty(); }
+    };
+
+    /// Merges streams recorded on different threads and translates them into one command buffer
+    class CommandStreamExecutor
+    {
+    private:
+        struct GroupRef
+        {
+            uint64_t        sortKey;
+            const uint8_t*  begin;
+            const uint8_t*  end;
+        };
+
+        std::vector<GroupRef> mGroups;
+    public:
+        /// Stream must not be modified until Execute
+        void Merge(const CommandStream& stream);
+        /// Groups are stable sorted by key when requested, otherwise they are executed
+        /// in merge order. Tracked command buffer state is invalidated afterwards
+        void Execute(const Ref<CommandBuffer>& cmd, bool sort = true);
+    };
+} // namespace Fluent
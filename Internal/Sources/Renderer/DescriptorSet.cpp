@@ -12,7 +12,7 @@ namespace Fluent
         {
             VkDescriptorPool descriptorPool = (VkDescriptorPool)GetGraphicContext().GetDescriptorPool();
             VkDevice device = (VkDevice)GetGraphicContext().GetDevice();
-            VkDescriptorSetLayout layout = (VkDescriptorSetLayout)description.descriptorSetLayout->GetNativeHandle();
+            VkDescriptorSetLayout layout = (VkDescriptorSetLayout)description.descriptorSetLayout->GetNativeHandle(description.set);
 
             VkDescriptorSetAllocateInfo descriptorAllocateInfo{};
             descriptorAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
@@ -23,7 +23,15 @@ namespace Fluent
             vkAllocateDescriptorSets(device, &descriptorAllocateInfo, &mHandle);
         }
 
-        ~VulkanDescriptorSet() override = default;
+        ~VulkanDescriptorSet() override
+        {
+            GetGraphicContext().DeferDestruction([handle = mHandle]()
+            {
+                VkDevice device = (VkDevice)GetGraphicContext().GetDevice();
+                VkDescriptorPool descriptorPool = (VkDescriptorPool)GetGraphicContext().GetDescriptorPool();
+                vkFreeDescriptorSets(device, descriptorPool, 1, &handle);
+            });
+        }
 
         void UpdateDescriptorSet(const std::vector<DescriptorSetUpdateDesc>& updateDescs) override
         {
@@ -12,6 +12,8 @@ namespace Fluent
     struct DescriptorSetDescription
     {
         Ref<DescriptorSetLayout> descriptorSetLayout;
+        /// Index of set in layout, see DescriptorSetFrequency
+        uint32_t                 set = 0;
     };
 
     struct BufferUpdateDesc
@@ -1,34 +1,145 @@
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
 #include "Renderer/GraphicContext.hpp"
 #include "Renderer/DescriptorSetLayout.hpp"
 
 namespace Fluent
 {
+    /// Native layout of one set, shared by every layout which has same bindings in that set
+    class VulkanSetLayout
+    {
+    private:
+        std::vector<VkDescriptorSetLayoutBinding>   mBindings;
+        std::vector<VkDescriptorBindingFlags>       mBindingFlags;
+        VkDescriptorSetLayout                       mHandle = VK_NULL_HANDLE;
+    public:
+        VulkanSetLayout(std::vector<VkDescriptorSetLayoutBinding> bindings, std::vector<VkDescriptorBindingFlags> bindingFlags)
+            : mBindings(std::move(bindings))
+            , mBindingFlags(std::move(bindingFlags))
+        {
+            VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsCreateInfo{};
+            bindingFlagsCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+            bindingFlagsCreateInfo.bindingCount = mBindingFlags.size();
+            bindingFlagsCreateInfo.pBindingFlags = mBindingFlags.data();
+
+            VkDescriptorSetLayoutCreateInfo layoutCreateInfo{};
+            layoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+            layoutCreateInfo.bindingCount = static_cast<uint32_t>(mBindings.size());
+            layoutCreateInfo.pBindings = mBindings.data();
+            layoutCreateInfo.pNext = &bindingFlagsCreateInfo;
+
+            VkDevice device = (VkDevice)GetGraphicContext().GetDevice();
+            VK_ASSERT(vkCreateDescriptorSetLayout(device, &layoutCreateInfo, nullptr, &mHandle));
+        }
+
+        ~VulkanSetLayout()
+        {
+            VkDevice device = (VkDevice)GetGraphicContext().GetDevice();
+            vkDestroyDescriptorSetLayout(device, mHandle, nullptr);
+        }
+
+        bool IsSame(const std::vector<VkDescriptorSetLayoutBinding>& bindings, const std::vector<VkDescriptorBindingFlags>& bindingFlags) const
+        {
+            auto sameBinding = [](const auto& l, const auto& r)
+            {
+                return l.binding == r.binding && l.descriptorType == r.descriptorType &&
+                       l.descriptorCount == r.descriptorCount && l.stageFlags == r.stageFlags;
+            };
+
+            return std::equal(mBindings.begin(), mBindings.end(), bindings.begin(), bindings.end(), sameBinding) &&
+                   mBindingFlags == bindingFlags;
+        }
+
+        VkDescriptorSetLayout GetHandle() const { return mHandle; }
+    };
+
+    static std::mutex sSetLayoutCacheMutex;
+    static std::unordered_multimap<size_t, std::weak_ptr<VulkanSetLayout>> sSetLayoutCache;
+
+    static Ref<VulkanSetLayout> FindOrCreateSetLayout(std::vector<VkDescriptorSetLayoutBinding> bindings, std::vector<VkDescriptorBindingFlags> bindingFlags)
+    {
+        /// Binding order depends on shader order, sort so equal sets hash equally
+        std::vector<uint32_t> order(bindings.size());
+        for (uint32_t i = 0; i < order.size(); ++i)
+            order[i] = i;
+        std::sort(order.begin(), order.end(), [&bindings](uint32_t l, uint32_t r) { return bindings[l].binding < bindings[r].binding; });
+
+        std::vector<VkDescriptorSetLayoutBinding> sortedBindings(bindings.size());
+        std::vector<VkDescriptorBindingFlags> sortedFlags(bindingFlags.size());
+        size_t hash = 0;
+        for (uint32_t i = 0; i < order.size(); ++i)
+        {
+            sortedBindings[i] = bindings[order[i]];
+            sortedFlags[i] = bindingFlags[order[i]];
+            HashCombine(hash, sortedBindings[i].binding);
+            HashCombine(hash, sortedBindings[i].descriptorType);
+            HashCombine(hash, sortedBindings[i].descriptorCount);
+            HashCombine(hash, sortedBindings[i].stageFlags);
+            HashCombine(hash, sortedFlags[i]);
+        }
+
+        std::scoped_lock lock(sSetLayoutCacheMutex);
+        auto [begin, end] = sSetLayoutCache.equal_range(hash);
+        for (auto it = begin; it != end;)
+        {
+            auto cached = it->second.lock();
+            if (!cached)
+            {
+                it = sSetLayoutCache.erase(it);
+                continue;
+            }
+
+            if (cached->IsSame(sortedBindings, sortedFlags))
+                return cached;
+
+            ++it;
+        }
+
+        auto setLayout = CreateRef<VulkanSetLayout>(std::move(sortedBindings), std::move(sortedFlags));
+        sSetLayoutCache.emplace(hash, setLayout);
+        return setLayout;
+    }
+
     class VulkanDescriptorSetLayout : public DescriptorSetLayout
     {
+        struct SetBindings
+        {
+            std::vector<VkDescriptorSetLayoutBinding>   bindings;
+            std::vector<VkDescriptorBindingFlags>       bindingFlags;
+        };
     private:
-        VkDescriptorSetLayout mHandle = VK_NULL_HANDLE;
+        std::vector<Ref<VulkanSetLayout>> mSetLayouts;
         std::vector<Ref<Shader>> mShaders;
     public:
         VulkanDescriptorSetLayout(const DescriptorSetLayoutDescription& description)
             : mShaders(description.shaders)
         {
-            std::vector<VkDescriptorSetLayoutBinding> bindings;
-            std::vector<VkDescriptorBindingFlags> bindingFlags;
-
-            size_t totalUniformCount = 0;
+            /// Sets without resources between used ones still need empty layout
+            uint32_t setCount = 0;
             for (const auto& shader : description.shaders)
             {
                 for (const auto& uniformsPerShader : shader->GetUniforms())
-                    totalUniformCount += uniformsPerShader.uniforms.size();
+                {
+                    for (const auto& uniform : uniformsPerShader.uniforms)
+                        setCount = std::max(setCount, uniform.set + 1);
+                }
             }
 
-            bindings.reserve(totalUniformCount);
+            if (setCount > MAX_DESCRIPTOR_SET_COUNT)
+            {
+                LOG_CATEGORY_WARN(eRenderer, "Shaders use {} descriptor sets, only {} are guaranteed by device", setCount, MAX_DESCRIPTOR_SET_COUNT);
+            }
+
+            std::vector<SetBindings> sets(setCount);
             for (const auto& shader : description.shaders)
             {
                 for (const auto& uniformsPerShader : shader->GetUniforms())
                 {
                     for (const auto& uniform : uniformsPerShader.uniforms)
                     {
+                        auto& [bindings, bindingFlags] = sets[uniform.set];
+
                         auto layoutIt = std::find_if(bindings.begin(), bindings.end(),
                             [&uniform](const auto& layout) { return layout.binding == uniform.binding; });
 
@@ -52,33 +163,47 @@ namespace Fluent
                 }
             }
 
-            VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsCreateInfo{};
-            bindingFlagsCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
-            bindingFlagsCreateInfo.bindingCount = bindingFlags.size();
-            bindingFlagsCreateInfo.pBindingFlags = bindingFlags.data();
-
-            VkDescriptorSetLayoutCreateInfo layoutCreateInfo{};
-            layoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-            layoutCreateInfo.bindingCount = static_cast<uint32_t>(bindings.size());
-            layoutCreateInfo.pBindings = bindings.data();
-            layoutCreateInfo.pNext = &bindingFlagsCreateInfo;
-
-            VkDevice device = (VkDevice)GetGraphicContext().GetDevice();
-            VK_ASSERT(vkCreateDescriptorSetLayout(device, &layoutCreateInfo, nullptr, &mHandle));
-        }
-
-        ~VulkanDescriptorSetLayout() override
-        {
-            VkDevice device = (VkDevice)GetGraphicContext().GetDevice();
-            vkDestroyDescriptorSetLayout(device, mHandle, nullptr);
+            mSetLayouts.resize(setCount);
+            for (uint32_t i = 0; i < setCount; ++i)
+                mSetLayouts[i] = FindOrCreateSetLayout(std::move(sets[i].bindings), std::move(sets[i].bindingFlags));
         }
 
         const std::vector<Ref<Shader>>& GetShaders() const override { return mShaders; }
-        Handle GetNativeHandle() const override { return mHandle; }
+        uint32_t GetSetCount() const override { return static_cast<uint32_t>(mSetLayouts.size()); }
+        Handle GetNativeHandle(uint32_t set) const override { return mSetLayouts[set]->GetHandle(); }
     };
 
+    /// Same shaders give same layout object, so pipelines created from separately built layouts hit pipeline cache
+    static std::mutex sLayoutCacheMutex;
+    static std::unordered_multimap<size_t, std::weak_ptr<DescriptorSetLayout>> sLayoutCache;
+
+    /// Interface
+
     Ref<DescriptorSetLayout> DescriptorSetLayout::Create(const DescriptorSetLayoutDescription& description)
     {
-        return CreateRef<VulkanDescriptorSetLayout>(description);
+        size_t hash = 0;
+        for (const auto& shader : description.shaders)
+            HashCombine(hash, shader.get());
+
+        std::scoped_lock lock(sLayoutCacheMutex);
+        auto [begin, end] = sLayoutCache.equal_range(hash);
+        for (auto it = begin; it != end;)
+        {
+            auto cached = it->second.lock();
+            if (!cached)
+            {
+                it = sLayoutCache.erase(it);
+                continue;
+            }
+
+            if (cached->GetShaders() == description.shaders)
+                return cached;
+
+            ++it;
+        }
+
+        auto layout = CreateRef<VulkanDescriptorSetLayout>(description);
+        sLayoutCache.emplace(hash, layout);
+        return layout;
     }
 } // namespace Fluent
@@ -18,7 +18,9 @@ namespace Fluent
         virtual ~DescriptorSetLayout() = default;
 
         virtual const std::vector<Ref<Shader>>& GetShaders() const = 0;
-        virtual Handle GetNativeHandle() const = 0;
+        /// One native layout per descriptor set, up to the highest set used by shaders
+        virtual uint32_t GetSetCount() const = 0;
+        virtual Handle GetNativeHandle(uint32_t set) const = 0;
         
         static Ref<DescriptorSetLayout> Create(const DescriptorSetLayoutDescription& description);
     };
@@ -1,16 +1,167 @@
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
 #include "Renderer/Renderer.hpp"
 #include <vk_mem_alloc.h>
 #include "Renderer/DeviceAllocator.hpp"
+#include "Renderer/Downsampler.hpp"
 
 namespace Fluent
 {
+    static MemoryTag DeduceMemoryTag(const BufferDescription& description)
+    {
+        if (description.memoryTag != MemoryTag::eUnknown)
+            return description.memoryTag;
+
+        if (description.bufferUsage & (BufferUsage::eVertexBuffer | BufferUsage::eIndexBuffer))
+            return MemoryTag::eMesh;
+
+        if (description.memoryUsage == MemoryUsage::eCpu && (description.bufferUsage & BufferUsage::eTransferSrc))
+            return MemoryTag::eStaging;
+
+        return MemoryTag::eUnknown;
+    }
+
+    static MemoryTag DeduceMemoryTag(const ImageDescription& description)
+    {
+        if (description.memoryTag != MemoryTag::eUnknown)
+            return description.memoryTag;
+
+        if (!description.filename.empty())
+            return MemoryTag::eTexture;
+
+        switch (description.initialUsage)
+        {
+            case ImageUsage::eColorAttachment:
+            case ImageUsage::eDepthStencilAttachment:
+            case ImageUsage::eStorage:
+                return MemoryTag::eRenderTarget;
+            case ImageUsage::eSampled:
+                return MemoryTag::eTexture;
+            default:
+                break;
+        }
+
+        return MemoryTag::eUnknown;
+    }
+
     class VulkanAllocator : public DeviceAllocator
     {
+        struct MovableBuffer
+        {
+            VkBufferCreateInfo  createInfo;
+            VkBuffer            buffer;
+            RelocationCallback  callback;
+        };
     private:
         VkInstance        mInstance;
         VkPhysicalDevice  mPhysicalDevice;
         VkDevice          mDevice;
         VmaAllocator        mAllocator;
+
+        mutable std::mutex  mStatisticsMutex;
+        MemoryStatistics    mStatistics;
+
+        /// Guards movable buffers and state of defragmentation pass, buffers are freed from any thread
+        mutable std::mutex                                  mDefragmentationMutex;
+        std::unordered_map<VmaAllocation, MovableBuffer>    mMovableBuffers;
+        VmaDefragmentationContext                           mDefragmentationContext = nullptr;
+        std::vector<VmaAllocation>                          mDefragmentationAllocations;
+        std::vector<VmaDefragmentationPassMoveInfo>         mDefragmentationMoves;
+        /// Buffers bound to old place of moved allocations, used by frames recorded before the pass
+        std::vector<VkBuffer>                               mRetiredBuffers;
+        /// Frees of moved allocations which arrived while pass was in flight
+        std::vector<std::pair<VkBuffer, VmaAllocation>>     mPendingFrees;
+        VmaDefragmentationStats                             mDefragmentationPassStatistics{};
+        DefragmentationStatistics                           mDefragmentationStatistics;
+        /// Fragmentation is evaluated lazily once per frame after something was freed
+        mutable bool                                        mFragmentationChanged = false;
+        mutable bool                                        mFragmented = false;
+        bool                                                mDefragmentationRequested = false;
+
+        /// Pass starts when at least this part of free device local memory is outside of the largest free range
+        static constexpr float                              MAX_FRAGMENTATION = 0.5f;
+        static constexpr uint64_t                           MIN_FRAGMENTED_BYTES = 4 * 1024 * 1024;
+
+        static void OnAllocate(MemoryTagStatistics& statistics, uint64_t size)
+        {
+            statistics.allocationCount++;
+            statistics.currentBytes += size;
+            statistics.peakBytes = std::max(statistics.peakBytes, statistics.currentBytes);
+        }
+
+        static void OnFree(MemoryTagStatistics& statistics, uint64_t size)
+        {
+            statistics.allocationCount--;
+            statistics.currentBytes -= size;
+        }
+
+        void TrackAllocation(VmaAllocation allocation, MemoryTag tag)
+        {
+            vmaSetAllocationUserData(mAllocator, allocation, reinterpret_cast<void*>(static_cast<uintptr_t>(tag)));
+
+            VmaAllocationInfo allocationInfo{};
+            vmaGetAllocationInfo(mAllocator, allocation, &allocationInfo);
+
+            std::scoped_lock lock(mStatisticsMutex);
+            OnAllocate(mStatistics.tags[static_cast<size_t>(tag)], allocationInfo.size);
+            OnAllocate(mStatistics.total, allocationInfo.size);
+        }
+
+        void UntrackAllocation(VmaAllocation allocation)
+        {
+            VmaAllocationInfo allocationInfo{};
+            vmaGetAllocationInfo(mAllocator, allocation, &allocationInfo);
+            auto tag = static_cast<MemoryTag>(reinterpret_cast<uintptr_t>(allocationInfo.pUserData));
+
+            std::scoped_lock lock(mStatisticsMutex);
+            OnFree(mStatistics.tags[static_cast<size_t>(tag)], allocationInfo.size);
+            OnFree(mStatistics.total, allocationInfo.size);
+        }
+
+        /// Only device local memory is defragmented, holes in host visible one can't be closed by gpu copies
+        bool IsFragmented() const
+        {
+            const VkPhysicalDeviceMemoryProperties* memoryProperties = nullptr;
+            vmaGetMemoryProperties(mAllocator, &memoryProperties);
+
+            VmaStats stats{};
+            vmaCalculateStats(mAllocator, &stats);
+
+            for (uint32_t i = 0; i < memoryProperties->memoryTypeCount; ++i)
+            {
+                auto flags = memoryProperties->memoryTypes[i].propertyFlags;
+                if (!(flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) || (flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT))
+                    continue;
+
+                const auto& info = stats.memoryType[i];
+                if (info.unusedRangeCount <= 1 || info.unusedBytes == 0)
+                    continue;
+
+                uint64_t fragmentedBytes = info.unusedBytes - info.unusedRangeSizeMax;
+                if (fragmentedBytes >= MIN_FRAGMENTED_BYTES &&
+                    static_cast<float>(fragmentedBytes) / static_cast<float>(info.unusedBytes) >= MAX_FRAGMENTATION)
+                    return true;
+            }
+
+            return false;
+        }
+
+        bool IsMovedByDefragmentation(VmaAllocation allocation) const
+        {
+            return std::any_of(mDefragmentationMoves.begin(), mDefragmentationMoves.end(),
+                               [allocation](const auto& move) { return move.allocation == allocation; });
+        }
+
+        static void WriteTagStatisticsJson(std::ostream& os, const MemoryTagStatistics& statistics)
+        {
+            os << "{ \"AllocationCount\": " << statistics.allocationCount
+               << ", \"CurrentBytes\": " << statistics.currentBytes
+               << ", \"PeakBytes\": " << statistics.peakBytes << " }";
+        }
     public:
         VulkanAllocator(const DeviceAllocatorDescription& description)
             : mInstance(static_cast<VkInstance>(description.instance))
@@ -23,6 +174,8 @@ namespace Fluent
             allocatorCreateInfo.instance            = mInstance;
             allocatorCreateInfo.physicalDevice      = mPhysicalDevice;
             allocatorCreateInfo.device              = mDevice;
+            if (description.memoryBudget)
+                allocatorCreateInfo.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
             vmaCreateAllocator(&allocatorCreateInfo, &mAllocator);
         }
 
@@ -58,6 +211,17 @@ namespace Fluent
             else
                 imageUsage |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
                 
+            /// Generated mips are written by compute through storage views, srgb images get unorm ones.
+            /// Mip 0 is sampled by shader whatever initial usage is
+            bool generateMips = static_cast<bool>((uint32_t)description.flags & (uint32_t)ImageDescriptionFlagBits::eGenerateMipMaps);
+            auto storageFormat = generateMips ? Downsampler::GetStorageFormat(description.format) : Format::eUndefined;
+            if (storageFormat != Format::eUndefined)
+            {
+                imageUsage |= VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+                if (storageFormat != description.format)
+                    imageCreateInfo.flags |= VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT | VK_IMAGE_CREATE_EXTENDED_USAGE_BIT;
+            }
+
             if ((imageUsage & VK_IMAGE_USAGE_SAMPLED_BIT) || (imageUsage & VK_IMAGE_USAGE_STORAGE_BIT))
                 imageUsage |= (VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT);
 
@@ -72,13 +236,20 @@ namespace Fluent
             );
 
             VK_ASSERT(result);
+
+            if (result == VK_SUCCESS)
+                TrackAllocation(allocation, DeduceMemoryTag(description));
        
             return { image, allocation };
         }
 
         void FreeImage(Handle image, Allocation allocation) override
         {
+            UntrackAllocation(static_cast<VmaAllocation>(allocation));
             vmaDestroyImage(mAllocator, static_cast<VkImage>(image), static_cast<VmaAllocation>(allocation));
+
+            std::scoped_lock lock(mDefragmentationMutex);
+            mFragmentationChanged = true;
         }
 
         AllocatedBuffer AllocateBuffer(const BufferDescription& description, MemoryUsage memoryUsage) override
@@ -116,14 +287,233 @@ namespace Fluent
 
             // TODO: ASSERT()
             if (result != VK_SUCCESS)
-                LOG_ERROR("Buffer allocation failed with result {}", result);
+                LOG_CATEGORY_ERROR(eRenderer, "Buffer allocation failed with result {}", result);
+            else
+                TrackAllocation(allocation, DeduceMemoryTag(description));
+
+            /// Only device local memory is moved by gpu copies
+            if (result == VK_SUCCESS && memoryUsage == MemoryUsage::eGpu)
+            {
+                std::scoped_lock lock(mDefragmentationMutex);
+                mMovableBuffers[allocation] = { bufferCreateInfo, buffer, nullptr };
+            }
 
             return { buffer, allocation };
         }
 
         void FreeBuffer(Handle buffer, Allocation allocation) override
         {
-            vmaDestroyBuffer(mAllocator, static_cast<VkBuffer>(buffer), static_cast<VmaAllocation>(allocation));
+            auto vmaAllocation = static_cast<VmaAllocation>(allocation);
+
+            {
+                std::scoped_lock lock(mDefragmentationMutex);
+                mFragmentationChanged = true;
+
+                /// Pass still references allocation, it is freed when pass ends
+                if (mDefragmentationContext && IsMovedByDefragmentation(vmaAllocation))
+                {
+                    mPendingFrees.emplace_back(static_cast<VkBuffer>(buffer), vmaAllocation);
+                    return;
+                }
+
+                /// Relocated buffer replaced the one owner knew about
+                auto it = mMovableBuffers.find(vmaAllocation);
+                if (it != mMovableBuffers.end())
+                {
+                    buffer = it->second.buffer;
+                    mMovableBuffers.erase(it);
+                }
+            }
+
+            UntrackAllocation(vmaAllocation);
+            vmaDestroyBuffer(mAllocator, static_cast<VkBuffer>(buffer), vmaAllocation);
+        }
+
+        void SetRelocationCallback(Allocation allocation, RelocationCallback&& callback) override
+        {
+            std::scoped_lock lock(mDefragmentationMutex);
+            auto it = mMovableBuffers.find(static_cast<VmaAllocation>(allocation));
+            if (it == mMovableBuffers.end())
+            {
+                LOG_CATEGORY_WARN(eRenderer, "Allocation can't be moved, only gpu buffers are supported");
+                return;
+            }
+
+            it->second.callback = std::move(callback);
+        }
+
+        bool BeginDefragmentation(Handle commandBuffer, uint64_t maxBytesToMove) override
+        {
+            std::scoped_lock lock(mDefragmentationMutex);
+            if (mDefragmentationContext)
+                return false;
+
+            mDefragmentationAllocations.clear();
+            for (const auto& [allocation, movable] : mMovableBuffers)
+            {
+                if (movable.callback)
+                    mDefragmentationAllocations.emplace_back(allocation);
+            }
+
+            mDefragmentationRequested = false;
+            mFragmented = false;
+
+            if (mDefragmentationAllocations.empty())
+                return false;
+
+            /// Incremental pass doesn't keep memory locked until copies finish, so frame can still allocate
+            VmaDefragmentationInfo2 defragmentationInfo{};
+            defragmentationInfo.flags                   = VMA_DEFRAGMENTATION_FLAG_INCREMENTAL;
+            defragmentationInfo.allocationCount         = static_cast<uint32_t>(mDefragmentationAllocations.size());
+            defragmentationInfo.pAllocations            = mDefragmentationAllocations.data();
+            defragmentationInfo.maxCpuBytesToMove       = 0;
+            defragmentationInfo.maxCpuAllocationsToMove = 0;
+            defragmentationInfo.maxGpuBytesToMove       = maxBytesToMove;
+            defragmentationInfo.maxGpuAllocationsToMove = std::numeric_limits<uint32_t>::max();
+
+            mDefragmentationPassStatistics = {};
+            auto result = vmaDefragmentationBegin(mAllocator, &defragmentationInfo, &mDefragmentationPassStatistics, &mDefragmentationContext);
+
+            if (result < 0)
+            {
+                LOG_CATEGORY_WARN(eRenderer, "Defragmentation failed with result {}", result);
+                vmaDefragmentationEnd(mAllocator, mDefragmentationContext);
+                mDefragmentationContext = nullptr;
+                return false;
+            }
+
+            mDefragmentationMoves.resize(mDefragmentationAllocations.size());
+            VmaDefragmentationPassInfo passInfo{};
+            passInfo.moveCount  = static_cast<uint32_t>(mDefragmentationMoves.size());
+            passInfo.pMoves     = mDefragmentationMoves.data();
+            vmaBeginDefragmentationPass(mAllocator, mDefragmentationContext, &passInfo);
+            mDefragmentationMoves.resize(passInfo.moveCount);
+
+            if (mDefragmentationMoves.empty())
+            {
+                vmaEndDefragmentationPass(mAllocator, mDefragmentationContext);
+                vmaDefragmentationEnd(mAllocator, mDefragmentationContext);
+                mDefragmentationContext = nullptr;
+                return false;
+            }
+
+            auto nativeCmd = static_cast<VkCommandBuffer>(commandBuffer);
+
+            /// Work of previous frames on source and destination ranges must be finished before copies
+            VkMemoryBarrier barrier{};
+            barrier.sType           = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            barrier.srcAccessMask   = VK_ACCESS_MEMORY_WRITE_BIT;
+            barrier.dstAccessMask   = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+            vkCmdPipelineBarrier(nativeCmd, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+            /// Buffers are immutably bound to memory so they are recreated at new place right away. Following
+            /// commands use them while old ones stay valid for frames in flight until the pass ends
+            mRetiredBuffers.clear();
+            for (const auto& move : mDefragmentationMoves)
+            {
+                auto& movable = mMovableBuffers[move.allocation];
+
+                VkBuffer buffer = VK_NULL_HANDLE;
+                vkCreateBuffer(mDevice, &movable.createInfo, nullptr, &buffer);
+                VkMemoryRequirements memoryRequirements{};
+                vkGetBufferMemoryRequirements(mDevice, buffer, &memoryRequirements);
+                vkBindBufferMemory(mDevice, buffer, move.memory, move.offset);
+
+                VkBufferCopy region{};
+                region.size = movable.createInfo.size;
+                vkCmdCopyBuffer(nativeCmd, movable.buffer, buffer, 1, &region);
+
+                mRetiredBuffers.emplace_back(movable.buffer);
+                movable.buffer = buffer;
+                if (movable.callback)
+                    movable.callback(buffer);
+            }
+
+            barrier.srcAccessMask   = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask   = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+            vkCmdPipelineBarrier(nativeCmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+            return true;
+        }
+
+        DefragmentationStatistics EndDefragmentation() override
+        {
+            std::vector<std::pair<VkBuffer, VmaAllocation>> pendingFrees;
+            DefragmentationStatistics statistics{};
+
+            {
+                std::scoped_lock lock(mDefragmentationMutex);
+                if (!mDefragmentationContext)
+                    return statistics;
+
+                for (auto buffer : mRetiredBuffers)
+                    vkDestroyBuffer(mDevice, buffer, nullptr);
+                mRetiredBuffers.clear();
+
+                vmaEndDefragmentationPass(mAllocator, mDefragmentationContext);
+                vmaDefragmentationEnd(mAllocator, mDefragmentationContext);
+                mDefragmentationContext = nullptr;
+                mDefragmentationMoves.clear();
+
+                for (auto& [buffer, allocation] : mPendingFrees)
+                    mMovableBuffers.erase(allocation);
+                pendingFrees.swap(mPendingFrees);
+
+                statistics.bytesMoved               = mDefragmentationPassStatistics.bytesMoved;
+                statistics.bytesFreed               = mDefragmentationPassStatistics.bytesFreed;
+                statistics.allocationsMoved         = mDefragmentationPassStatistics.allocationsMoved;
+                statistics.deviceMemoryBlocksFreed  = mDefragmentationPassStatistics.deviceMemoryBlocksFreed;
+
+                /// Keep going while passes make progress and memory stays fragmented
+                mFragmentationChanged = statistics.allocationsMoved > 0;
+            }
+
+            for (auto& [buffer, allocation] : pendingFrees)
+            {
+                UntrackAllocation(allocation);
+                vmaDestroyBuffer(mAllocator, buffer, allocation);
+            }
+
+            {
+                std::scoped_lock lock(mStatisticsMutex);
+                mDefragmentationStatistics.bytesMoved               += statistics.bytesMoved;
+                mDefragmentationStatistics.bytesFreed               += statistics.bytesFreed;
+                mDefragmentationStatistics.allocationsMoved         += statistics.allocationsMoved;
+                mDefragmentationStatistics.deviceMemoryBlocksFreed  += statistics.deviceMemoryBlocksFreed;
+            }
+
+            if (statistics.allocationsMoved > 0)
+                LOG_CATEGORY_TRACE(eRenderer, "Defragmentation moved {} allocations ({} bytes), freed {} bytes",
+                          statistics.allocationsMoved, statistics.bytesMoved, statistics.bytesFreed);
+
+            return statistics;
+        }
+
+        bool IsDefragmentationRequired() const override
+        {
+            std::scoped_lock lock(mDefragmentationMutex);
+            if (mDefragmentationContext)
+                return false;
+
+            if (mFragmentationChanged)
+            {
+                mFragmented = IsFragmented();
+                mFragmentationChanged = false;
+            }
+
+            return mDefragmentationRequested || mFragmented;
+        }
+
+        void RequestDefragmentation() override
+        {
+            std::scoped_lock lock(mDefragmentationMutex);
+            mDefragmentationRequested = true;
+        }
+
+        DefragmentationStatistics GetDefragmentationStatistics() const override
+        {
+            std::scoped_lock lock(mStatisticsMutex);
+            return mDefragmentationStatistics;
         }
 
         void MapMemory(Allocation allocation, void** data) const override
@@ -140,8 +530,112 @@ namespace Fluent
         {
             vmaFlushAllocation(mAllocator, (VmaAllocation)allocation, offset, size);
         }
+
+        void SetCurrentFrameIndex(uint32_t frameIndex) override
+        {
+            vmaSetCurrentFrameIndex(mAllocator, frameIndex);
+        }
+
+        std::vector<MemoryHeapBudget> GetHeapBudgets() const override
+        {
+            const VkPhysicalDeviceMemoryProperties* memoryProperties = nullptr;
+            vmaGetMemoryProperties(mAllocator, &memoryProperties);
+
+            VmaBudget budgets[VK_MAX_MEMORY_HEAPS] = {};
+            vmaGetBudget(mAllocator, budgets);
+
+            std::vector<MemoryHeapBudget> result(memoryProperties->memoryHeapCount);
+            for (uint32_t i = 0; i < memoryProperties->memoryHeapCount; ++i)
+            {
+                result[i].size              = memoryProperties->memoryHeaps[i].size;
+                result[i].budget            = budgets[i].budget;
+                result[i].usage             = budgets[i].usage;
+                result[i].blockBytes        = budgets[i].blockBytes;
+                result[i].allocationBytes   = budgets[i].allocationBytes;
+                result[i].deviceLocal       = memoryProperties->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+            }
+
+            return result;
+        }
+
+        MemoryStatistics GetStatistics() const override
+        {
+            std::scoped_lock lock(mStatisticsMutex);
+            return mStatistics;
+        }
+
+        std::string BuildStatisticsJson(bool detailed) const override
+        {
+            auto statistics = GetStatistics();
+            auto budgets = GetHeapBudgets();
+
+            std::ostringstream os;
+            os << "{\n  \"Tags\": {";
+            for (size_t i = 0; i < statistics.tags.size(); ++i)
+            {
+                os << (i == 0 ? "\n    \"" : ",\n    \"") << ToString(static_cast<MemoryTag>(i)) << "\": ";
+                WriteTagStatisticsJson(os, statistics.tags[i]);
+            }
+            os << "\n  },\n  \"Total\": ";
+            WriteTagStatisticsJson(os, statistics.total);
+
+            os << ",\n  \"Heaps\": [";
+            for (size_t i = 0; i < budgets.size(); ++i)
+            {
+                os << (i == 0 ? "\n    " : ",\n    ")
+                   << "{ \"Size\": " << budgets[i].size
+                   << ", \"Budget\": " << budgets[i].budget
+                   << ", \"Usage\": " << budgets[i].usage
+                   << ", \"BlockBytes\": " << budgets[i].blockBytes
+                   << ", \"AllocationBytes\": " << budgets[i].allocationBytes
+                   << ", \"DeviceLocal\": " << (budgets[i].deviceLocal ? "true" : "false") << " }";
+            }
+            os << "\n  ]";
+
+            auto defragmentation = GetDefragmentationStatistics();
+            os << ",\n  \"Defragmentation\": "
+               << "{ \"BytesMoved\": " << defragmentation.bytesMoved
+               << ", \"BytesFreed\": " << defragmentation.bytesFreed
+               << ", \"AllocationsMoved\": " << defragmentation.allocationsMoved
+               << ", \"DeviceMemoryBlocksFreed\": " << defragmentation.deviceMemoryBlocksFreed << " }";
+
+            char* vmaStatistics = nullptr;
+            vmaBuildStatsString(mAllocator, &vmaStatistics, detailed);
+            os << ",\n  \"Allocator\": " << vmaStatistics << "\n}\n";
+            vmaFreeStatsString(mAllocator, vmaStatistics);
+
+            return os.str();
+        }
+
+        bool DumpStatistics(const std::string& filename, bool detailed) const override
+        {
+            std::ofstream file(filename);
+            if (!file.is_open())
+            {
+                LOG_CATEGORY_WARN(eRenderer, "Failed to open file {}", filename);
+                return false;
+            }
+
+            file << BuildStatisticsJson(detailed);
+            return true;
+        }
     };
 
+    const char* ToString(MemoryTag tag)
+    {
+        switch (tag)
+        {
+            case MemoryTag::eUnknown: return "Unknown";
+            case MemoryTag::eMesh: return "Mesh";
+            case MemoryTag::eTexture: return "Texture";
+            case MemoryTag::eStaging: return "Staging";
+            case MemoryTag::eRenderTarget: return "RenderTarget";
+            default: break;
+        }
+
+        return "Invalid";
+    }
+
     Scope<DeviceAllocator> DeviceAllocator::Create(const DeviceAllocatorDescription& description)
     {
         return CreateScope<VulkanAllocator>(description); 
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <array>
+#include <functional>
+#include <string>
+#include <vector>
 #include <vk_mem_alloc.h>
 #include "Core/Base.hpp"
 #include "Renderer/Renderer.hpp"
@@ -15,8 +19,46 @@ namespace Fluent
         Handle instance;
         Handle physicalDevice;
         Handle device;
+        bool memoryBudget = false;
     };
 
+    struct MemoryTagStatistics
+    {
+        uint64_t allocationCount = 0;
+        uint64_t currentBytes = 0;
+        uint64_t peakBytes = 0;
+    };
+
+    struct MemoryStatistics
+    {
+        std::array<MemoryTagStatistics, static_cast<size_t>(MemoryTag::eLast)> tags;
+        MemoryTagStatistics total;
+    };
+
+    struct MemoryHeapBudget
+    {
+        uint64_t size;
+        /// Estimated bytes available for the application
+        uint64_t budget;
+        /// Estimated bytes used by the application, including implicit objects
+        uint64_t usage;
+        uint64_t blockBytes;
+        uint64_t allocationBytes;
+        bool     deviceLocal;
+    };
+
+    struct DefragmentationStatistics
+    {
+        uint64_t bytesMoved = 0;
+        /// Device memory released back to the system
+        uint64_t bytesFreed = 0;
+        uint32_t allocationsMoved = 0;
+        uint32_t deviceMemoryBlocksFreed = 0;
+    };
+
+    /// Receives native handle recreated after allocation was moved
+    using RelocationCallback = std::function<void(Handle)>;
+
     struct AllocatedImage
     {
         Handle image;
@@ -42,10 +84,35 @@ namespace Fluent
         virtual AllocatedBuffer AllocateBuffer(const BufferDescription& description, MemoryUsage memoryUsage) = 0;
         virtual void FreeBuffer(Handle buffer, Allocation allocation) = 0;
 
+        /// Only gpu buffers with relocation callback can be moved by defragmentation
+        virtual void SetRelocationCallback(Allocation allocation, RelocationCallback&& callback) = 0;
+
         virtual void MapMemory(Allocation allocation, void** data) const = 0;
         virtual void UnmapMemory(Allocation allocation) const = 0;
         virtual void FlushMemory(Allocation allocation, uint32_t size, uint32_t offset) const = 0;
 
+        /// Budget values refreshed once per frame
+        virtual void SetCurrentFrameIndex(uint32_t frameIndex) = 0;
+
+        /// Records copies of at most maxBytesToMove into commandBuffer and hands recreated buffers to relocation
+        /// callbacks. Old buffers stay valid until EndDefragmentation, command buffer must finish execution before it
+        virtual bool BeginDefragmentation(Handle commandBuffer, uint64_t maxBytesToMove) = 0;
+        /// Releases old places of moved buffers and returns statistics of the pass
+        virtual DefragmentationStatistics EndDefragmentation() = 0;
+        /// True if free device local memory is fragmented or pass was requested
+        virtual bool IsDefragmentationRequired() const = 0;
+        /// Forces pass regardless of fragmentation
+        virtual void RequestDefragmentation() = 0;
+        /// Accumulated over all passes
+        virtual DefragmentationStatistics GetDefragmentationStatistics() const = 0;
+
+        virtual std::vector<MemoryHeapBudget> GetHeapBudgets() const = 0;
+        virtual MemoryStatistics GetStatistics() const = 0;
+        virtual std::string BuildStatisticsJson(bool detailed) const = 0;
+        virtual bool DumpStatistics(const std::string& filename, bool detailed) const = 0;
+
         static Scope<DeviceAllocator> Create(const DeviceAllocatorDescription& description);
     };
+
+    const char* ToString(MemoryTag tag);
 } // namespace Fluent
@@ -0,0 +1,312 @@
+#include <algorithm>
+#include <iterator>
+#include <vector>
+#include "Core/Profiler.hpp"
+#include "Renderer/Buffer.hpp"
+#include "Renderer/CommandBuffer.hpp"
+#include "Renderer/GraphicContext.hpp"
+#include "Renderer/Pipeline.hpp"
+#include "Renderer/Sampler.hpp"
+#include "Renderer/Shader.hpp"
+#include "Renderer/Downsampler.hpp"
+
+namespace Fluent
+{
+#ifdef FLUENT_EMBEDDED_SHADERS
+    /// Compiled from Renderer/Shaders/Downsample.comp.glsl at build time
+    static const uint32_t DOWNSAMPLE_SHADER[] =
+    {
+        #include "Renderer/Shaders/Downsample.comp.spv.inl"
+    };
+#endif
+
+    /// Mip 1 texels written by one work group along each side
+    static constexpr uint32_t DOWNSAMPLE_TILE_SIZE = 32;
+    /// Counter with padding and mip 6 texel of every work group
+    static constexpr uint32_t DOWNSAMPLE_GLOBAL_SIZE = 16 + 64 * 64 * 16;
+
+    struct DownsampleConstants
+    {
+        uint32_t width;
+        uint32_t height;
+        uint32_t mipCount;
+        uint32_t workGroupCount;
+        uint32_t srgb;
+    };
+
+    class VulkanDownsampler : public Downsampler
+    {
+    private:
+        Ref<Pipeline>       mPipeline;
+        Ref<Sampler>        mSampler;
+        /// Work group counter and mip 6, counter is reset by shader after each dispatch
+        Ref<Buffer>         mGlobalBuffer;
+        bool                mGlobalBufferCleared = false;
+        VkDescriptorPool    mDescriptorPool = VK_NULL_HANDLE;
+
+        VkDescriptorSet AllocateDescriptorSet(const Image& image, uint32_t mipCount) const
+        {
+            VkDevice device = (VkDevice)GetGraphicContext().GetDevice();
+            auto layout = (VkDescriptorSetLayout)mPipeline->GetDescription().descriptorSetLayout->GetNativeHandle(0);
+
+            VkDescriptorSetAllocateInfo descriptorAllocateInfo{};
+            descriptorAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+            descriptorAllocateInfo.descriptorPool = mDescriptorPool;
+            descriptorAllocateInfo.descriptorSetCount = 1;
+            descriptorAllocateInfo.pSetLayouts = &layout;
+
+            VkDescriptorSet set = VK_NULL_HANDLE;
+            if (vkAllocateDescriptorSets(device, &descriptorAllocateInfo, &set) != VK_SUCCESS)
+                return VK_NULL_HANDLE;
+
+            VkDescriptorImageInfo sourceInfo{};
+            sourceInfo.imageView = (VkImageView)image.GetImageView();
+            sourceInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+            VkDescriptorImageInfo samplerInfo{};
+            samplerInfo.sampler = (VkSampler)mSampler->GetNativeHandle();
+
+            std::vector<VkDescriptorImageInfo> mipInfos(mipCount);
+            for (uint32_t i = 0; i < mipCount; ++i)
+            {
+                mipInfos[i].imageView = (VkImageView)image.GetStorageImageView(i + 1);
+                mipInfos[i].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+            }
+
+            VkDescriptorBufferInfo globalInfo{};
+            globalInfo.buffer = (VkBuffer)mGlobalBuffer->GetNativeHandle();
+            globalInfo.range = VK_WHOLE_SIZE;
+
+            VkWriteDescriptorSet writes[4]{};
+            for (uint32_t i = 0; i < 4; ++i)
+            {
+                writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                writes[i].dstSet = set;
+                writes[i].dstBinding = i;
+                writes[i].descriptorCount = 1;
+            }
+
+            writes[0].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+            writes[0].pImageInfo = &sourceInfo;
+            writes[1].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+            writes[1].pImageInfo = &samplerInfo;
+            /// Binding is partially bound, mips past image mip count are left empty
+            writes[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+            writes[2].descriptorCount = mipCount;
+            writes[2].pImageInfo = mipInfos.data();
+            writes[3].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            writes[3].pBufferInfo = &globalInfo;
+
+            vkUpdateDescriptorSets(device, 4, writes, 0, nullptr);
+            return set;
+        }
+    public:
+        VulkanDownsampler(const DownsamplerDescription& description)
+        {
+#ifdef FLUENT_EMBEDDED_SHADERS
+            ShaderDescription shaderDescription{};
+            shaderDescription.stage = ShaderStage::eCompute;
+            shaderDescription.byteCode.assign(std::begin(DOWNSAMPLE_SHADER), std::end(DOWNSAMPLE_SHADER));
+
+            DescriptorSetLayoutDescription descriptorSetLayoutDescription{};
+            descriptorSetLayoutDescription.shaders = { Shader::Create(shaderDescription) };
+
+            PipelineDescription pipelineDescription{};
+            pipelineDescription.type = PipelineType::eCompute;
+            pipelineDescription.descriptorSetLayout = DescriptorSetLayout::Create(descriptorSetLayoutDescription);
+            mPipeline = Pipeline::Create(pipelineDescription);
+
+            SamplerDescription samplerDescription{};
+            samplerDescription.magFilter = Filter::eLinear;
+            samplerDescription.minFilter = Filter::eLinear;
+            samplerDescription.addressModeU = SamplerAddressMode::eClampToEdge;
+            samplerDescription.addressModeV = SamplerAddressMode::eClampToEdge;
+            samplerDescription.addressModeW = SamplerAddressMode::eClampToEdge;
+            mSampler = Sampler::Create(samplerDescription);
+
+            BufferDescription bufferDescription{};
+            bufferDescription.memoryUsage = MemoryUsage::eGpu;
+            bufferDescription.bufferUsage = BufferUsage::eStorageBuffer;
+            bufferDescription.size = DOWNSAMPLE_GLOBAL_SIZE;
+            bufferDescription.memoryTag = MemoryTag::eTexture;
+            mGlobalBuffer = Buffer::Create(bufferDescription);
+
+            uint32_t setCount = description.maxGenerationsInFlight;
+            VkDescriptorPoolSize descriptorPoolSizes [] =
+            {
+                { VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,     setCount },
+                { VK_DESCRIPTOR_TYPE_SAMPLER,           setCount },
+                { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,     setCount * DOWNSAMPLER_MAX_MIP_COUNT },
+                { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,    setCount },
+            };
+
+            /// Sets are freed one by one after frames which use them
+            VkDescriptorPoolCreateInfo descriptorPoolCreateInfo{};
+            descriptorPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+            descriptorPoolCreateInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+            descriptorPoolCreateInfo.poolSizeCount = static_cast<uint32_t>(std::size(descriptorPoolSizes));
+            descriptorPoolCreateInfo.pPoolSizes = descriptorPoolSizes;
+            descriptorPoolCreateInfo.maxSets = setCount;
+
+            VkDevice device = (VkDevice)GetGraphicContext().GetDevice();
+            VK_ASSERT(vkCreateDescriptorPool(device, &descriptorPoolCreateInfo, nullptr, &mDescriptorPool));
+#else
+            LOG_CATEGORY_INFO(eRenderer, "Engine is built without FluentComputeMips, mips are generated by blits");
+#endif
+        }
+
+        ~VulkanDownsampler() override
+        {
+            if (!mDescriptorPool)
+                return;
+
+            GetGraphicContext().DeferDestruction([descriptorPool = mDescriptorPool]()
+            {
+                VkDevice device = (VkDevice)GetGraphicContext().GetDevice();
+                vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+            });
+        }
+
+        bool IsSupported(const Image& image) const override
+        {
+            uint32_t mipCount = image.GetMipLevelsCount() - 1;
+            return mPipeline && mipCount > 0 && mipCount <= DOWNSAMPLER_MAX_MIP_COUNT &&
+                   std::max(image.GetWidth(), image.GetHeight()) <= DOWNSAMPLER_MAX_SIZE &&
+                   image.GetStorageImageView(mipCount) != nullptr;
+        }
+
+        bool GenerateMipLevels(const CommandBuffer& cmd, const Image& image, ImageUsage::Bits initialUsage) override
+        {
+            PROFILE_SCOPE("Downsampler::GenerateMipLevels");
+            if (!IsSupported(image))
+                return false;
+
+            uint32_t mipCount = image.GetMipLevelsCount() - 1;
+            VkDescriptorSet set = AllocateDescriptorSet(image, mipCount);
+            if (!set)
+                return false;
+
+            GetGraphicContext().DeferDestruction([descriptorPool = mDescriptorPool, set]()
+            {
+                VkDevice device = (VkDevice)GetGraphicContext().GetDevice();
+                vkFreeDescriptorSets(device, descriptorPool, 1, &set);
+            });
+
+            auto nativeCmd = (VkCommandBuffer)cmd.GetNativeHandle();
+            auto globalBuffer = (VkBuffer)mGlobalBuffer->GetNativeHandle();
+            if (!mGlobalBufferCleared)
+            {
+                vkCmdFillBuffer(nativeCmd, globalBuffer, 0, sizeof(uint32_t), 0);
+                mGlobalBufferCleared = true;
+            }
+
+            /// Previous dispatch may still use global buffer
+            VkMemoryBarrier memoryBarrier{};
+            memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+            memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+            VkImageMemoryBarrier imageBarrier{};
+            imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            imageBarrier.srcAccessMask = ImageUsageToAccessFlags(initialUsage);
+            imageBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+            imageBarrier.oldLayout = ImageUsageToImageLayout(initialUsage);
+            imageBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+            imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            imageBarrier.image = (VkImage)image.GetNativeHandle();
+            imageBarrier.subresourceRange = GetImageSubresourceRange(image);
+
+            vkCmdPipelineBarrier
+            (
+                nativeCmd,
+                ImageUsageToPipelineStage(initialUsage) | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                {},
+                1, &memoryBarrier,
+                0, nullptr,
+                1, &imageBarrier
+            );
+
+            uint32_t mip1Width = std::max(image.GetWidth() / 2, 1u);
+            uint32_t mip1Height = std::max(image.GetHeight() / 2, 1u);
+            uint32_t groupCountX = (mip1Width + DOWNSAMPLE_TILE_SIZE - 1) / DOWNSAMPLE_TILE_SIZE;
+            uint32_t groupCountY = (mip1Height + DOWNSAMPLE_TILE_SIZE - 1) / DOWNSAMPLE_TILE_SIZE;
+
+            DownsampleConstants constants{};
+            constants.width = image.GetWidth();
+            constants.height = image.GetHeight();
+            constants.mipCount = mipCount;
+            constants.workGroupCount = groupCountX * groupCountY;
+            constants.srgb = GetStorageFormat(image.GetFormat()) != image.GetFormat();
+
+            auto layout = (VkPipelineLayout)mPipeline->GetPipelineLayout();
+            vkCmdBindPipeline(nativeCmd, VK_PIPELINE_BIND_POINT_COMPUTE, (VkPipeline)mPipeline->GetNativeHandle());
+            vkCmdBindDescriptorSets(nativeCmd, VK_PIPELINE_BIND_POINT_COMPUTE, layout, 0, 1, &set, 0, nullptr);
+            vkCmdPushConstants(nativeCmd, layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+            vkCmdDispatch(nativeCmd, groupCountX, groupCountY, 1);
+
+            /// Leave image as blit path does
+            imageBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+            imageBarrier.dstAccessMask = ImageUsageToAccessFlags(ImageUsage::eTransferDst);
+            imageBarrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+            imageBarrier.newLayout = ImageUsageToImageLayout(ImageUsage::eTransferDst);
+
+            vkCmdPipelineBarrier
+            (
+                nativeCmd,
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                {},
+                0, nullptr,
+                0, nullptr,
+                1, &imageBarrier
+            );
+
+            /// Binds were recorded past tracked state of command buffer
+            cmd.InvalidateState();
+            return true;
+        }
+    };
+
+    /// Interface
+
+    Format Downsampler::GetStorageFormat(Format format)
+    {
+#ifdef FLUENT_EMBEDDED_SHADERS
+        /// Srgb formats can't be written from compute, their unorm aliases are encoded by shader
+        Format storageFormat = format;
+        switch (format)
+        {
+            case Format::eR8Srgb: storageFormat = Format::eR8Unorm; break;
+            case Format::eR8G8Srgb: storageFormat = Format::eR8G8Unorm; break;
+            case Format::eR8G8B8A8Srgb: storageFormat = Format::eR8G8B8A8Unorm; break;
+            case Format::eB8G8R8A8Srgb: storageFormat = Format::eB8G8R8A8Unorm; break;
+            default: break;
+        }
+
+        auto physicalDevice = (VkPhysicalDevice)GetGraphicContext().GetPhysicalDevice();
+
+        VkPhysicalDeviceFeatures features{};
+        vkGetPhysicalDeviceFeatures(physicalDevice, &features);
+
+        VkFormatProperties properties{};
+        VkFormatProperties storageProperties{};
+        vkGetPhysicalDeviceFormatProperties(physicalDevice, ToVulkanFormat(format), &properties);
+        vkGetPhysicalDeviceFormatProperties(physicalDevice, ToVulkanFormat(storageFormat), &storageProperties);
+
+        bool filterable = properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+        bool writable = features.shaderStorageImageWriteWithoutFormat &&
+                        (storageProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT);
+
+        if (filterable && writable && !IsDepthFormat(format))
+            return storageFormat;
+#endif
+        return Format::eUndefined;
+    }
+
+    Scope<Downsampler> Downsampler::Create(const DownsamplerDescription& description)
+    {
+        return CreateScope<VulkanDownsampler>(description);
+    }
+} // namespace Fluent
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Core/Base.hpp"
+#include "Renderer/Renderer.hpp"
+#include "Renderer/Image.hpp"
+
+namespace Fluent
+{
+    class CommandBuffer;
+
+    /// Mips below 4096 texels which one dispatch generates
+    static constexpr uint32_t DOWNSAMPLER_MAX_MIP_COUNT = 12;
+    /// Shader keeps mip 6 of at most 64x64 work groups, larger images fall back to blits
+    static constexpr uint32_t DOWNSAMPLER_MAX_SIZE = 4096;
+
+    struct DownsamplerDescription
+    {
+        /// Descriptor sets are released after frame, generations above it in one frame fall back to blits
+        uint32_t maxGenerationsInFlight = 256;
+    };
+
+    /// Generates whole mip chain of image in one compute dispatch instead of blit per level. Works on
+    /// images created with eGenerateMipMaps whose format has storage views, see GetStorageFormat.
+    /// Off unless engine is built with FluentComputeMips, blits are used then
+    class Downsampler
+    {
+    protected:
+        Downsampler() = default;
+    public:
+        virtual ~Downsampler() = default;
+
+        virtual bool IsSupported(const Image& image) const = 0;
+        /// Mip 0 is read in initial usage, afterwards all mips are in eTransferDst as after blits.
+        /// Returns false when nothing was recorded
+        virtual bool GenerateMipLevels(const CommandBuffer& cmd, const Image& image, ImageUsage::Bits initialUsage) = 0;
+
+        /// Format of per mip storage views, unorm for srgb ones. eUndefined when device can't
+        /// write format from compute or engine was built without FluentComputeMips option
+        static Format GetStorageFormat(Format format);
+
+        static Scope<Downsampler> Create(const DownsamplerDescription& description);
+    };
+} // namespace Fluent
@@ -32,8 +32,11 @@ namespace Fluent
 
         ~VulkanFramebuffer() override
         {
-            VkDevice device = (VkDevice)GetGraphicContext().GetDevice();
-            vkDestroyFramebuffer(device, mHandle, nullptr);
+            GetGraphicContext().DeferDestruction([handle = mHandle]()
+            {
+                VkDevice device = (VkDevice)GetGraphicContext().GetDevice();
+                vkDestroyFramebuffer(device, handle, nullptr);
+            });
         }
 
         Handle GetNativeHandle() const override { return mHandle; }
@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <mutex>
 #include <volk.h>
 #include <GLFW/glfw3.h>
 #include "Renderer/VirtualFrame.hpp"
@@ -20,8 +21,11 @@ namespace Fluent
         return result;
     };
 
-    std::vector<const char*> GetBestInstanceExtensions()
+    std::vector<const char*> GetBestInstanceExtensions(bool headless)
     {
+        if (headless)
+            return {};
+
         uint32_t glfwExtensionCount = 0;
         const char** glfwExtensions;
         glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
@@ -45,6 +49,8 @@ namespace Fluent
         Scope<DeviceAllocator>          mDeviceAllocator;
         VkCommandPool                   mCommandPool = VK_NULL_HANDLE;
         uint32_t                        mActiveImageIndex{};
+        uint32_t                        mFrameNumber{};
+        uint64_t                        mDefragmentationBudget = DEFAULT_DEFRAGMENTATION_BUDGET;
         bool                            mRenderingEnabled{};
         VkExtent2D                      mExtent{};
         VkSwapchainKHR                  mSwapchain = VK_NULL_HANDLE;
@@ -52,12 +58,32 @@ namespace Fluent
         std::vector<ImageUsage::Bits>   mSwapchainImageUsages;
         VkDescriptorPool                mDescriptorPool = VK_NULL_HANDLE;
 
-        static constexpr uint32_t       FRAME_COUNT = 2;
+        static constexpr uint64_t       DEFAULT_DEFRAGMENTATION_BUDGET = 8 * 1024 * 1024;
         Scope<VirtualFrameProvider>     mFrameProvider;
+        /// Guards provider pointer for deferred destruction from worker threads
+        std::mutex                      mFrameProviderMutex;
+
+        Scope<Downsampler>              mDownsampler;
 
         Ref<RenderPass>                 mDefaultRenderPass;
         std::vector<Ref<Framebuffer>>   mDefaultFramebuffers;
 
+        /// Copies go first into frame command buffer, pass ends once fence of this frame signals
+        void Defragment()
+        {
+            if (!mDefragmentationBudget || !mDeviceAllocator->IsDefragmentationRequired())
+                return;
+
+            auto& cmd = GetCurrentCommandBuffer();
+            if (!mDeviceAllocator->BeginDefragmentation(cmd->GetNativeHandle(), mDefragmentationBudget))
+                return;
+
+            DeferDestruction([this]()
+            {
+                mDeviceAllocator->EndDefragmentation();
+            });
+        }
+
         void CreateDescriptorPool()
         {
             // TODO
@@ -79,13 +105,78 @@ namespace Fluent
 
             VkDescriptorPoolCreateInfo descriptorPoolCreateInfo{};
             descriptorPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-            descriptorPoolCreateInfo.flags = 0;
+            /// Sets are freed one by one, so resources can rebuild theirs
+            descriptorPoolCreateInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
             descriptorPoolCreateInfo.poolSizeCount = poolSizeCount;
             descriptorPoolCreateInfo.pPoolSizes = descriptorPoolSizes;
             descriptorPoolCreateInfo.maxSets = 2048 * poolSizeCount;
 
             VK_ASSERT(vkCreateDescriptorPool(mDevice, &descriptorPoolCreateInfo, nullptr, &mDescriptorPool));
         }
+
+        void CollectSurfaceInfo()
+        {
+            uint32_t presentModeCount = 0;
+            vkGetPhysicalDeviceSurfacePresentModesKHR(mPhysicalDevice, mSurface, &presentModeCount, nullptr);
+            std::vector<VkPresentModeKHR> presentModes(presentModeCount);
+            vkGetPhysicalDeviceSurfacePresentModesKHR(mPhysicalDevice, mSurface, &presentModeCount, presentModes.data());
+            VkSurfaceCapabilitiesKHR surfaceCapabilities{};
+            vkGetPhysicalDeviceSurfaceCapabilitiesKHR(mPhysicalDevice, mSurface, &surfaceCapabilities);
+            uint32_t surfaceFormatsCount = 0;
+            vkGetPhysicalDeviceSurfaceFormatsKHR(mPhysicalDevice, mSurface, &surfaceFormatsCount, nullptr);
+            std::vector<VkSurfaceFormatKHR> surfaceFormats(surfaceFormatsCount);
+            vkGetPhysicalDeviceSurfaceFormatsKHR(mPhysicalDevice, mSurface, &surfaceFormatsCount, surfaceFormats.data());
+
+            /// Find best surface present mode
+            mPresentMode = VkPresentModeKHR::VK_PRESENT_MODE_IMMEDIATE_KHR;
+            if (std::find(presentModes.begin(), presentModes.end(), VkPresentModeKHR::VK_PRESENT_MODE_MAILBOX_KHR) != presentModes.end())
+                mPresentMode = VkPresentModeKHR::VK_PRESENT_MODE_MAILBOX_KHR;
+
+            /// Determine present image count
+            mPresentImageCount = std::clamp(FRAME_COUNT, surfaceCapabilities.minImageCount, surfaceCapabilities.maxImageCount);
+            /// Find best surface format
+            mSurfaceFormat = surfaceFormats.front();
+            for (const auto& format : surfaceFormats)
+            {
+                if (format.format == VK_FORMAT_R8G8B8A8_UNORM || format.format == VK_FORMAT_B8G8R8A8_UNORM)
+                    mSurfaceFormat = format;
+            }
+        }
+
+        /// Provider runs pending destructors, meanwhile new ones are executed immediately
+        void DestroyFrameProvider()
+        {
+            Scope<VirtualFrameProvider> frameProvider;
+            {
+                std::scoped_lock lock(mFrameProviderMutex);
+                std::swap(frameProvider, mFrameProvider);
+            }
+        }
+
+        void CreateFrameProvider()
+        {
+            DestroyFrameProvider();
+
+            VirtualFrameProviderDescription frameProviderDesc{};
+            frameProviderDesc.device = mDevice;
+            frameProviderDesc.commandPool = mCommandPool;
+            frameProviderDesc.queue = mDeviceQueue;
+            frameProviderDesc.swapchain = mSwapchain;
+            frameProviderDesc.frameCount = FRAME_COUNT;
+            frameProviderDesc.swapchainImageCount = mSwapchainImages.size();
+            // TODO: Find optimal size
+            frameProviderDesc.stagingBufferSize = 1024 * 1024 * 512;
+
+            LOG_CATEGORY_INFO(eRenderer, "Current staging buffer size {}", frameProviderDesc.stagingBufferSize);
+
+            auto frameProvider = VirtualFrameProvider::Create(frameProviderDesc);
+            {
+                std::scoped_lock lock(mFrameProviderMutex);
+                mFrameProvider = std::move(frameProvider);
+            }
+
+            mRenderingEnabled = true;
+        }
     public:
         explicit VulkanContext(const GraphicContextDescription& description)
             : mWindowHandle(description.window)
@@ -101,7 +192,8 @@ namespace Fluent
             appInfo.apiVersion = FLUENT_VK_API_VERSION;
 
             auto instanceLayers = GetBestInstanceLayers(description.requestValidation);
-            auto instanceExtensions = GetBestInstanceExtensions();
+            bool headless = mWindowHandle == nullptr;
+            auto instanceExtensions = GetBestInstanceExtensions(headless);
 
             VkInstanceCreateInfo instanceCI{};
             instanceCI.sType                    = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -115,13 +207,24 @@ namespace Fluent
             volkLoadInstance(mInstance);
 
             // TODO: Wrap
-            auto result = glfwCreateWindowSurface
-            (
-                static_cast<VkInstance>(mInstance), 
-                static_cast<GLFWwindow*>(mWindowHandle), 
-                nullptr, 
-                (VkSurfaceKHR*)&mSurface
-            );
+            if (!headless)
+            {
+                auto result = glfwCreateWindowSurface
+                (
+                    static_cast<VkInstance>(mInstance),
+                    static_cast<GLFWwindow*>(mWindowHandle),
+                    nullptr,
+                    (VkSurfaceKHR*)&mSurface
+                );
+
+                /// Nothing is presented then, but offscreen rendering still works
+                if (result != VK_SUCCESS)
+                {
+                    LOG_CATEGORY_ERROR(eRenderer, "Failed to create window surface {}, context is headless", (int)result);
+                    mSurface = VK_NULL_HANDLE;
+                    headless = true;
+                }
+            }
 
             /// Select physical device
             uint32_t physicalDevicesCount = 0;
@@ -150,8 +253,9 @@ namespace Fluent
             uint32_t index = 0;
             for (const auto& property : queueFamilyProperties)
             {
-                VkBool32 supportSurface = false;
-                vkGetPhysicalDeviceSurfaceSupportKHR(mPhysicalDevice, index, mSurface, &supportSurface);
+                VkBool32 supportSurface = headless;
+                if (!headless)
+                    vkGetPhysicalDeviceSurfaceSupportKHR(mPhysicalDevice, index, mSurface, &supportSurface);
 
                 if
                 (
@@ -166,32 +270,11 @@ namespace Fluent
                 index++;
             }
 
-            /// Collect surface present info
-            uint32_t presentModeCount = 0;
-            vkGetPhysicalDeviceSurfacePresentModesKHR(mPhysicalDevice, mSurface, &presentModeCount, nullptr);
-            std::vector<VkPresentModeKHR> presentModes(presentModeCount);
-            vkGetPhysicalDeviceSurfacePresentModesKHR(mPhysicalDevice, mSurface, &presentModeCount, presentModes.data());
-            VkSurfaceCapabilitiesKHR surfaceCapabilities{};
-            vkGetPhysicalDeviceSurfaceCapabilitiesKHR(mPhysicalDevice, mSurface, &surfaceCapabilities);
-            uint32_t surfaceFormatsCount = 0;
-            vkGetPhysicalDeviceSurfaceFormatsKHR(mPhysicalDevice, mSurface, &surfaceFormatsCount, nullptr);
-            std::vector<VkSurfaceFormatKHR> surfaceFormats(surfaceFormatsCount);
-            vkGetPhysicalDeviceSurfaceFormatsKHR(mPhysicalDevice, mSurface, &surfaceFormatsCount, surfaceFormats.data());
-
-            /// Find best surface present mode
-            mPresentMode = VkPresentModeKHR::VK_PRESENT_MODE_IMMEDIATE_KHR;
-            if (std::find(presentModes.begin(), presentModes.end(), VkPresentModeKHR::VK_PRESENT_MODE_MAILBOX_KHR) != presentModes.end())
-                mPresentMode = VkPresentModeKHR::VK_PRESENT_MODE_MAILBOX_KHR;
-
-            /// Determine present image count
-            mPresentImageCount = std::clamp(FRAME_COUNT, surfaceCapabilities.minImageCount, surfaceCapabilities.maxImageCount);
-            /// Find best surface format
-            mSurfaceFormat = surfaceFormats.front();
-            for (const auto& format : surfaceFormats)
-            {
-                if (format.format == VK_FORMAT_R8G8B8A8_UNORM || format.format == VK_FORMAT_B8G8R8A8_UNORM)
-                    mSurfaceFormat = format;
-            }
+            /// Offscreen images use the same format as swapchain would
+            mSurfaceFormat = { VK_FORMAT_R8G8B8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR };
+            mPresentImageCount = FRAME_COUNT;
+            if (!headless)
+                CollectSurfaceInfo();
             
             /// Find device extensions
             uint32_t extensionsCount = 0;
@@ -208,11 +291,22 @@ namespace Fluent
                     return false;
             });
 
-            std::vector<const char*> deviceExtensions { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+            std::vector<const char*> deviceExtensions;
+            if (!headless)
+                deviceExtensions.emplace_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
             if (it != installedExtensions.end())
                 deviceExtensions.emplace_back("VK_KHR_portability_subset");
             deviceExtensions.emplace_back(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
 
+            /// Lets allocator report real heap budget and usage
+            bool memoryBudgetSupported = std::find_if(installedExtensions.begin(), installedExtensions.end(), [](auto& p)
+            {
+                return std::string(p.extensionName) == VK_EXT_MEMORY_BUDGET_EXTENSION_NAME;
+            }) != installedExtensions.end();
+
+            if (memoryBudgetSupported)
+                deviceExtensions.emplace_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
             /// Logical device and device queue
             float queuePriorities [] = { 1.0f };
             VkDeviceQueueCreateInfo deviceQueueCreateInfo{};
@@ -230,8 +324,15 @@ namespace Fluent
             multiviewFeatures.multiview = true;
             multiviewFeatures.pNext = &descriptorIndexingFeatures;
 
+            /// Compute mip generation writes storage views of any format, see Downsampler
+            VkPhysicalDeviceFeatures supportedFeatures{};
+            vkGetPhysicalDeviceFeatures(mPhysicalDevice, &supportedFeatures);
+            VkPhysicalDeviceFeatures features{};
+            features.shaderStorageImageWriteWithoutFormat = supportedFeatures.shaderStorageImageWriteWithoutFormat;
+
             VkDeviceCreateInfo deviceCreateInfo{};
             deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+            deviceCreateInfo.pEnabledFeatures = &features;
             deviceCreateInfo.queueCreateInfoCount = 1;
             deviceCreateInfo.pQueueCreateInfos = &deviceQueueCreateInfo;
             deviceCreateInfo.enabledExtensionCount = deviceExtensions.size();
@@ -247,6 +348,7 @@ namespace Fluent
             deviceAllocatorDescription.instance = mInstance;
             deviceAllocatorDescription.physicalDevice = mPhysicalDevice;
             deviceAllocatorDescription.device = mDevice;
+            deviceAllocatorDescription.memoryBudget = memoryBudgetSupported;
             mDeviceAllocator = DeviceAllocator::Create(deviceAllocatorDescription);
 
             /// Create command pool
@@ -273,21 +375,28 @@ namespace Fluent
 
             mDefaultRenderPass = RenderPass::Create(renderPassDesc);
 
+            DownsamplerDescription downsamplerDesc{};
+            mDownsampler = Downsampler::Create(downsamplerDesc);
+
             SetGraphicContext(*oldContext);
         }
 
         ~VulkanContext() override
         {
+            mDownsampler = nullptr;
             mDefaultFramebuffers.clear();
             mSwapchainImages.clear();
-            mFrameProvider.reset(nullptr);
+            DestroyFrameProvider();
             mDefaultRenderPass = nullptr;
             vkDestroyDescriptorPool(mDevice, mDescriptorPool, nullptr);
             vkDestroyCommandPool(mDevice, mCommandPool, nullptr);
-            vkDestroySwapchainKHR(mDevice, mSwapchain, nullptr);
+            /// Swapchain and surface functions aren't loaded for headless context
+            if (mSwapchain)
+                vkDestroySwapchainKHR(mDevice, mSwapchain, nullptr);
             mDeviceAllocator.reset(nullptr);
             vkDestroyDevice(mDevice, nullptr);
-            vkDestroySurfaceKHR(mInstance, mSurface, nullptr);
+            if (mSurface)
+                vkDestroySurfaceKHR(mInstance, mSurface, nullptr);
             vkDestroyInstance(mInstance, nullptr);
         }
 
@@ -299,6 +408,14 @@ namespace Fluent
             auto surfaceWidth   = static_cast<uint32_t>(width);
             auto surfaceHeight  = static_cast<uint32_t>(height);
 
+            if (!mSurface)
+            {
+                mExtent = VkExtent2D{ surfaceWidth, surfaceHeight };
+                mDefaultRenderPass->SetRenderArea(mExtent.width, mExtent.height);
+                CreateFrameProvider();
+                return;
+            }
+
             VkSurfaceCapabilitiesKHR surfaceCapabilities{};
             vkGetPhysicalDeviceSurfaceCapabilitiesKHR(mPhysicalDevice, mSurface, &surfaceCapabilities);
             mExtent = VkExtent2D
@@ -361,23 +478,7 @@ namespace Fluent
 
             mSwapchainImageUsages.resize(mSwapchainImages.size(), ImageUsage::eUndefined);
 
-            mFrameProvider = nullptr;
-            
-            VirtualFrameProviderDescription frameProviderDesc{};
-            frameProviderDesc.device = mDevice;
-            frameProviderDesc.commandPool = mCommandPool;
-            frameProviderDesc.queue = mDeviceQueue;
-            frameProviderDesc.swapchain = mSwapchain;
-            frameProviderDesc.frameCount = FRAME_COUNT;
-            frameProviderDesc.swapchainImageCount = mSwapchainImages.size();
-            // TODO: Find optimal size
-            frameProviderDesc.stagingBufferSize = 1024 * 1024 * 512;
-
-            LOG_INFO("Current staging buffer size {}", frameProviderDesc.stagingBufferSize);
-
-            mFrameProvider = VirtualFrameProvider::Create(frameProviderDesc);
-
-            mRenderingEnabled = true;
+            CreateFrameProvider();
         }
 
         Ref<Image> AcquireImage(uint32_t imageIndex, ImageUsage::Bits usage) override
@@ -393,7 +494,9 @@ namespace Fluent
 
         void BeginFrame() override
         {
+            mDeviceAllocator->SetCurrentFrameIndex(mFrameNumber++);
             mRenderingEnabled = mFrameProvider->BeginFrame();
+            Defragment();
         }
 
         void EndFrame() override
@@ -405,6 +508,11 @@ namespace Fluent
         {
             vkDeviceWaitIdle(mDevice);
         }
+
+        void SetDefragmentationBudget(uint64_t maxBytesPerFrame) override
+        {
+            mDefragmentationBudget = maxBytesPerFrame;
+        }
         
         void ImmediateSubmit(const Ref<CommandBuffer>& cmd) const override
         {
@@ -417,6 +525,19 @@ namespace Fluent
             vkQueueWaitIdle(mDeviceQueue);
         }
 
+        void DeferDestruction(std::function<void()>&& destructor) override
+        {
+            /// No frames in flight while frame provider is recreated or destroyed
+            std::unique_lock lock(mFrameProviderMutex);
+            if (!mFrameProvider)
+            {
+                lock.unlock();
+                destructor();
+                return;
+            }
+
+            mFrameProvider->DeferDestruction(std::move(destructor));
+        }
 
         Ref<RenderPass> GetDefaultRenderPass() const override { return mDefaultRenderPass; }
         Ref<Framebuffer> GetDefaultFramebuffer(uint32_t index) const override { return mDefaultFramebuffers[index]; }
@@ -434,8 +555,10 @@ namespace Fluent
         Handle              GetDescriptorPool() const override { return mDescriptorPool; }
         uint32_t            GetPresentImageCount() const override { return mPresentImageCount; }
         uint32_t            GetActiveImageIndex() const override { return mFrameProvider->GetActiveImageIndex(); };
+        uint32_t            GetFrameIndex() const override { return mFrameProvider->GetFrameIndex(); }
         Ref<CommandBuffer>& GetCurrentCommandBuffer() override { return mFrameProvider->GetCommandBuffer(); }
         Ref<StagingBuffer>& GetStagingBuffer() override { return mFrameProvider->GetStagingBuffer(); }
+        Downsampler&        GetDownsampler() override { return *mDownsampler; }
     };
 
     /// Interface
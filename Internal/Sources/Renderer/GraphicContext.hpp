@@ -1,17 +1,23 @@
 #pragma once
 
+#include <functional>
 #include "Core/Base.hpp"
 #include "Renderer/Renderer.hpp"
 #include "Renderer/DeviceAllocator.hpp"
 #include "Renderer/Image.hpp"
 #include "Renderer/CommandBuffer.hpp"
+#include "Renderer/Downsampler.hpp"
 #include "Renderer/StagingBuffer.hpp"
 
 namespace Fluent
 {
+    /// Frames recorded on cpu while previous ones are still executed by gpu
+    static constexpr uint32_t FRAME_COUNT = 2;
+
     struct GraphicContextDescription
     {
         bool                    requestValidation;
+        /// nullptr creates headless context without surface and swapchain, frames are only submitted
         Handle                  window;
     };
 
@@ -30,12 +36,18 @@ namespace Fluent
 
         virtual void WaitIdle() = 0;
 
+        /// Bytes of device memory moved at the beginning of frame to compact heaps, 0 disables defragmentation
+        virtual void SetDefragmentationBudget(uint64_t maxBytesPerFrame) = 0;
+
         virtual Ref<RenderPass> GetDefaultRenderPass() const = 0;
         virtual Ref<Framebuffer> GetDefaultFramebuffer(uint32_t index) const = 0;
 
         virtual ImageUsage::Bits GetSwapchainImageUsage(uint32_t index) const = 0;
         virtual Ref<Image> AcquireImage(uint32_t imageIndex, ImageUsage::Bits usage) = 0;
         virtual void ImmediateSubmit(const Ref<CommandBuffer>& cmd) const = 0;
+        /// Postpones destruction of native objects until frames in flight can't reference them.
+        /// Can be called from any thread
+        virtual void DeferDestruction(std::function<void()>&& destructor) = 0;
         
         virtual Handle              GetInstance() const = 0;
         virtual Handle              GetPhysicalDevice() const = 0;
@@ -48,8 +60,11 @@ namespace Fluent
         virtual Handle              GetDescriptorPool() const = 0;
         virtual uint32_t            GetPresentImageCount() const = 0;
         virtual uint32_t            GetActiveImageIndex() const = 0;
+        /// Virtual frame being recorded, below FRAME_COUNT. Its resources are not used by gpu anymore
+        virtual uint32_t            GetFrameIndex() const = 0;
         virtual Ref<CommandBuffer>& GetCurrentCommandBuffer() = 0;
         virtual Ref<StagingBuffer>& GetStagingBuffer() = 0;
+        virtual Downsampler&        GetDownsampler() = 0;
 
         static Scope<GraphicContext> Create(const GraphicContextDescription& description);
     };
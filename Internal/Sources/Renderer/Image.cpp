@@ -1,47 +1,54 @@
 #include <filesystem>
 #include <tinyimageformat_base.h>
-#include <tiny_ktx.h>
-#include <fstream>
+#include <cstring>
 #include "Core/FileSystem.hpp"
+#include "Core/Profiler.hpp"
 #include "Renderer/DeviceAllocator.hpp"
+#include "Renderer/Downsampler.hpp"
 #include "Renderer/GraphicContext.hpp"
 #include "Renderer/Image.hpp"
+#include "Renderer/KtxStream.hpp"
 
 namespace Fluent
 {
-    static std::vector<char> LoadKtxImageDescription(ImageDescription& description)
+    struct KtxImageData
     {
-        TinyKtx_Callbacks callbacks
+        /// Empty when file is mapped from archive
+        std::vector<char>   storage;
+        /// Top mip
+        const char*         data = nullptr;
+        uint32_t            size = 0;
+    };
+
+    static KtxImageData LoadKtxImageDescription(ImageDescription& description)
+    {
+        auto callbacks = GetKtxMemoryStreamCallbacks();
+
+        /// Mapped archive entries are copied to staging memory without intermediate copy
+        KtxImageData image;
+        auto mapped = static_cast<const char*>(description.fileData);
+        size_t size = description.fileDataSize;
+        if (!mapped)
         {
-            [](void* user, char const* msg) { LOG_ERROR("KTX Image load failed {}", msg); },
-            [](void* user, size_t size) { return malloc(size); },
-            [](void* user, void* memory) { free(memory); },
-            [](void* user, void* buffer, size_t byteCount) 
-            { 
-                std::ifstream& ifs = *((std::ifstream*)user);
-                ifs.read(static_cast<char*>(buffer), byteCount);
-                return byteCount;
-            },
-            [](void* user, int64_t offset) 
-            { 
-                std::ifstream& ifs = *((std::ifstream*)user);
-                ifs.seekg(offset);
-                return true;
-            },
-            [](void *user) 
-            { 
-                std::ifstream& ifs = *((std::ifstream*)user);
-                return (int64_t)ifs.tellg();
+            auto path = FileSystem::GetTexturesDirectory() + description.filename;
+            mapped = static_cast<const char*>(FileSystem::MapFile(path));
+            if (!mapped)
+            {
+                image.storage = FileSystem::ReadFile(path);
+                mapped = image.storage.data();
             }
-        };
-        
-        std::ifstream ifs(FileSystem::GetTexturesDirectory() + description.filename, std::ios::binary);
-        TinyKtx_ContextHandle ctx = TinyKtx_CreateContext(&callbacks, &ifs);
+
+            size = mapped ? FileSystem::GetFileSize(path) : 0;
+        }
+
+        KtxMemoryStream stream{ mapped, size, 0 };
+        TinyKtx_ContextHandle ctx = TinyKtx_CreateContext(&callbacks, &stream);
         bool headerOkay = TinyKtx_ReadHeader(ctx);
         if (!headerOkay)
         {
             TinyKtx_DestroyContext(ctx);
-            LOG_WARN("[ KTX Image Load ] Failed to read ktx header");
+            LOG_CATEGORY_WARN(eRenderer, "[ KTX Image Load ] Failed to read ktx header");
+            return image;
         }
 
         description.width = TinyKtx_Width(ctx);
@@ -56,15 +63,25 @@ namespace Fluent
         if (description.format == Format::eUndefined)
         {
             TinyKtx_DestroyContext(ctx);
-            LOG_WARN("[ KTX Image Load ] Format is undefined");
+            LOG_CATEGORY_WARN(eRenderer, "[ KTX Image Load ] Format is undefined");
+            return image;
         }
 
         if (TinyKtx_IsCubemap(ctx))
             description.arraySize *= 6;
 
+        /// Every mip starts with its byte size
+        size_t topMipOffset = stream.position + sizeof(uint32_t);
+        uint32_t topMipSize = TinyKtx_ImageSize(ctx, 0);
         TinyKtx_DestroyContext(ctx);
 
-        return std::vector<char>(std::istreambuf_iterator(ifs), std::istreambuf_iterator<char>());
+        if (topMipOffset <= stream.size)
+        {
+            image.data = mapped + topMipOffset;
+            image.size = static_cast<uint32_t>(std::min<size_t>(topMipSize, stream.size - topMipOffset));
+        }
+
+        return image;
     }
 
     class VulkanImage : public Image
@@ -77,6 +94,7 @@ namespace Fluent
         uint32_t                mHeight;
         uint32_t                mMipLevels;
         VkImageView           mImageView;
+        std::vector<VkImageView> mStorageViews;
 
         void ApplyDescription(ImageDescription& description)
         {
@@ -97,11 +115,11 @@ namespace Fluent
                 auto& context = GetGraphicContext();
                 auto& allocator = context.GetDeviceAllocator();
 
-                if (!description.filename.empty())
+                if (!description.filename.empty() || description.fileData)
                 {
                     auto imageData = LoadKtxImageDescription(description);
                     ApplyDescription(description);
-                    auto stage = context.GetStagingBuffer()->Submit(imageData.data(), imageData.size() * sizeof(imageData[0]));
+                    auto stage = context.GetStagingBuffer()->Submit(imageData.data, imageData.size);
                     auto [image, allocation] = allocator.AllocateImage(description, MemoryUsage::eGpu);
                     
                     // TODO: Not beautiful solution
@@ -122,11 +140,15 @@ namespace Fluent
                 }
                 else
                 {
+                    ApplyDescription(description);
+                    description.mipLevels = std::max(description.mipLevels, 1u);
+                    mMipLevels = description.mipLevels;
                     auto [image, allocation] = allocator.AllocateImage(description, MemoryUsage::eGpu);
                     mHandle = static_cast<VkImage>(image);
                     mAllocation = allocation;
                     auto& cmd = context.GetCurrentCommandBuffer();
-                    if (description.initialUsage != ImageUsage::eUndefined)
+                    bool skipTransition = static_cast<bool>((uint32_t)description.flags & (uint32_t)ImageDescriptionFlagBits::eSkipInitialTransition);
+                    if (description.initialUsage != ImageUsage::eUndefined && !skipTransition)
                     {
                         cmd->Begin();
                         cmd->ImageBarrier(*this, ImageUsage::eUndefined, description.initialUsage);
@@ -136,7 +158,28 @@ namespace Fluent
                 }
             }
 
-            CreateImageView();
+            /// Same condition as in DeviceAllocator which adds storage usage
+            bool generateMips = static_cast<bool>((uint32_t)description.flags & (uint32_t)ImageDescriptionFlagBits::eGenerateMipMaps);
+            auto storageFormat = mAllocation && generateMips ? Downsampler::GetStorageFormat(mFormat) : Format::eUndefined;
+
+            /// Srgb format can't be used for storage, so its view is limited to other usages of image.
+            /// Downsampler samples it, so sampled usage is kept for any initial usage
+            VkImageUsageFlags viewUsage = 0;
+            if (storageFormat != Format::eUndefined && storageFormat != mFormat)
+            {
+                viewUsage = ToVulkanImageUsage(description.initialUsage) | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+                            VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+                viewUsage &= ~VK_IMAGE_USAGE_STORAGE_BIT;
+            }
+
+            mImageView = CreateImageView(mFormat, 0, mMipLevels, viewUsage);
+
+            if (storageFormat != Format::eUndefined)
+            {
+                mStorageViews.resize(mMipLevels);
+                for (uint32_t i = 0; i < mMipLevels; ++i)
+                    mStorageViews[i] = CreateImageView(storageFormat, i, 1);
+            }
         }
     public:
         VulkanImage(const ImageDescription& description)
@@ -152,28 +195,40 @@ namespace Fluent
         
         ~VulkanImage() override
         {
-            if (mImageView)
-            {
-                VkDevice device = (VkDevice)GetGraphicContext().GetDevice();
-                vkDestroyImageView(device, mImageView, nullptr);
-            }
-            
-            if (mAllocation)
+            if (!mImageView && !mAllocation)
+                return;
+
+            GetGraphicContext().DeferDestruction([imageView = mImageView, storageViews = mStorageViews, handle = mHandle, allocation = mAllocation]()
             {
-                auto& allocator = GetGraphicContext().GetDeviceAllocator();
-                allocator.FreeImage(mHandle, mAllocation);
-                mAllocation = nullptr;
-            }
+                auto& context = GetGraphicContext();
+
+                if (imageView)
+                    vkDestroyImageView((VkDevice)context.GetDevice(), imageView, nullptr);
+
+                for (auto storageView : storageViews)
+                    vkDestroyImageView((VkDevice)context.GetDevice(), storageView, nullptr);
+
+                if (allocation)
+                    context.GetDeviceAllocator().FreeImage(handle, allocation);
+            });
         }
 
-        void CreateImageView()
+        /// Usage limits view to part of image usages, zero keeps all of them
+        VkImageView CreateImageView(Format format, uint32_t baseMipLevel, uint32_t mipLevelCount, VkImageUsageFlags usage = 0) const
         {
             auto imageSubresourceRange = GetImageSubresourceRange(*this);
+            imageSubresourceRange.baseMipLevel = baseMipLevel;
+            imageSubresourceRange.levelCount = mipLevelCount;
+
+            VkImageViewUsageCreateInfo imageViewUsageCreateInfo{};
+            imageViewUsageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_USAGE_CREATE_INFO;
+            imageViewUsageCreateInfo.usage = usage;
 
             VkImageViewCreateInfo imageViewCreateInfo{};
             imageViewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            imageViewCreateInfo.pNext = usage ? &imageViewUsageCreateInfo : nullptr;
             imageViewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-            imageViewCreateInfo.format = ToVulkanFormat(mFormat);
+            imageViewCreateInfo.format = ToVulkanFormat(format);
             imageViewCreateInfo.image = mHandle;
             imageViewCreateInfo.subresourceRange = imageSubresourceRange;
             imageViewCreateInfo.components = VkComponentMapping
@@ -184,8 +239,10 @@ namespace Fluent
                     VK_COMPONENT_SWIZZLE_IDENTITY
                 };
 
+            VkImageView imageView = VK_NULL_HANDLE;
             VkDevice device = (VkDevice)GetGraphicContext().GetDevice();
-            vkCreateImageView(device, &imageViewCreateInfo, nullptr, &mImageView);
+            vkCreateImageView(device, &imageViewCreateInfo, nullptr, &imageView);
+            return imageView;
         }
 
         Format GetFormat() const override
@@ -195,6 +252,7 @@ namespace Fluent
 
         Handle GetNativeHandle() const override { return mHandle; }
         Handle GetImageView() const override { return mImageView; }
+        Handle GetStorageImageView(uint32_t mipLevel) const override { return mipLevel < mStorageViews.size() ? mStorageViews[mipLevel] : nullptr; }
         uint32_t GetWidth() const override { return mWidth; };
         uint32_t GetHeight() const override { return mHeight; };
         uint32_t GetMipLevelsCount() const override { return mMipLevels; }
@@ -202,6 +260,7 @@ namespace Fluent
 
     Ref<Image> Image::Create(const ImageDescription& description)
     {
+        PROFILE_SCOPE("Image::Create");
         return CreateRef<VulkanImage>(description);
     }
 } // namespace Fluent
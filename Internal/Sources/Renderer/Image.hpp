@@ -8,7 +8,10 @@ namespace Fluent
 {
     enum class ImageDescriptionFlagBits
     {
-        eGenerateMipMaps = 1 << 0
+        eGenerateMipMaps = 1 << 0,
+        /// Memory is allocated for initial usage, but layout stays undefined and
+        /// no commands are submitted, caller records transition itself
+        eSkipInitialTransition = 1 << 1
     };
 
     struct ImageDescription
@@ -24,7 +27,11 @@ namespace Fluent
         ImageUsage::Bits            initialUsage = ImageUsage::eUndefined;
         DescriptorType              descriptors;
         std::string                 filename;
+        /// Ktx file already read into memory, used instead of reading filename
+        const void*                 fileData = nullptr;
+        size_t                      fileDataSize = 0;
         ImageDescriptionFlagBits    flags;
+        MemoryTag                   memoryTag = MemoryTag::eUnknown;
     };
 
     class Image
@@ -37,6 +44,8 @@ namespace Fluent
         virtual Format GetFormat() const = 0;
         virtual Handle GetNativeHandle() const = 0;
         virtual Handle GetImageView() const = 0;
+        /// Single mip view for compute writes, nullptr when image has no storage views
+        virtual Handle GetStorageImageView(uint32_t mipLevel) const = 0;
         virtual uint32_t GetWidth() const = 0;
         virtual uint32_t GetHeight() const = 0;
         virtual uint32_t GetMipLevelsCount() const = 0;
@@ -0,0 +1,83 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include "Core/Base.hpp"
+#include "Renderer/KtxStream.hpp"
+
+namespace Fluent
+{
+    static void KtxError(void* user, char const* msg)
+    {
+        LOG_CATEGORY_ERROR(eRenderer, "KTX Image load failed {}", msg);
+    }
+
+    static void* KtxAlloc(void* user, size_t size)
+    {
+        return malloc(size);
+    }
+
+    static void KtxFree(void* user, void* memory)
+    {
+        free(memory);
+    }
+
+    TinyKtx_Callbacks GetKtxMemoryStreamCallbacks()
+    {
+        return
+        {
+            KtxError,
+            KtxAlloc,
+            KtxFree,
+            [](void* user, void* buffer, size_t byteCount)
+            {
+                auto& stream = *((KtxMemoryStream*)user);
+                byteCount = std::min(byteCount, stream.size - stream.position);
+                std::memcpy(buffer, stream.data + stream.position, byteCount);
+                stream.position += byteCount;
+                return byteCount;
+            },
+            [](void* user, int64_t offset)
+            {
+                auto& stream = *((KtxMemoryStream*)user);
+                if (offset < 0 || static_cast<size_t>(offset) > stream.size)
+                    return false;
+                stream.position = static_cast<size_t>(offset);
+                return true;
+            },
+            [](void* user)
+            {
+                return (int64_t)((KtxMemoryStream*)user)->position;
+            }
+        };
+    }
+
+    TinyKtx_Callbacks GetKtxFileStreamCallbacks()
+    {
+        return
+        {
+            KtxError,
+            KtxAlloc,
+            KtxFree,
+            [](void* user, void* buffer, size_t byteCount)
+            {
+                std::ifstream& ifs = *((std::ifstream*)user);
+                ifs.read(static_cast<char*>(buffer), byteCount);
+                return static_cast<size_t>(ifs.gcount());
+            },
+            [](void* user, int64_t offset)
+            {
+                std::ifstream& ifs = *((std::ifstream*)user);
+                /// Short read of previous call leaves eof set, which makes seekg fail
+                ifs.clear();
+                ifs.seekg(offset);
+                return !ifs.fail();
+            },
+            [](void* user)
+            {
+                std::ifstream& ifs = *((std::ifstream*)user);
+                return (int64_t)ifs.tellg();
+            }
+        };
+    }
+} // namespace Fluent
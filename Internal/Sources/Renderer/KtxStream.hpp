@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+#include <tiny_ktx.h>
+
+namespace Fluent
+{
+    /// Ktx file in memory, mapped archive entry or file read up front
+    struct KtxMemoryStream
+    {
+        const char* data = nullptr;
+        size_t      size = 0;
+        size_t      position = 0;
+    };
+
+    /// TinyKtx callbacks with KtxMemoryStream as user pointer, errors are logged
+    TinyKtx_Callbacks GetKtxMemoryStreamCallbacks();
+    /// TinyKtx callbacks with std::ifstream as user pointer, reads return bytes actually read
+    TinyKtx_Callbacks GetKtxFileStreamCallbacks();
+} // namespace Fluent
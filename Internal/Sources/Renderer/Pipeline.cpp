@@ -1,95 +1,372 @@
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+#include "Core/Profiler.hpp"
 #include "Renderer/GraphicContext.hpp"
 #include "Renderer/Pipeline.hpp"
+#include "Renderer/ShaderHotReload.hpp"
 
 namespace Fluent
 {
+    struct SpecializationData
+    {
+        std::vector<VkSpecializationMapEntry>   entries;
+        std::vector<uint32_t>                   data;
+        VkSpecializationInfo                    info{};
+    };
+
+    static const VkSpecializationInfo* FillSpecializationInfo(const Shader& shader, SpecializationData& specialization)
+    {
+        auto& constants = shader.GetSpecializationConstants();
+        if (constants.empty())
+            return nullptr;
+
+        specialization.entries.reserve(constants.size());
+        specialization.data.reserve(constants.size());
+        for (const auto& constant : constants)
+        {
+            auto& entry = specialization.entries.emplace_back();
+            entry.constantID = constant.constantId;
+            entry.offset = static_cast<uint32_t>(specialization.data.size() * sizeof(uint32_t));
+            entry.size = sizeof(uint32_t);
+            specialization.data.emplace_back(constant.value);
+        }
+
+        specialization.info.mapEntryCount = static_cast<uint32_t>(specialization.entries.size());
+        specialization.info.pMapEntries = specialization.entries.data();
+        specialization.info.dataSize = specialization.data.size() * sizeof(uint32_t);
+        specialization.info.pData = specialization.data.data();
+
+        return &specialization.info;
+    }
+
+    struct VertexInputData
+    {
+        std::vector<VkVertexInputBindingDescription>    bindings;
+        std::vector<VkVertexInputAttributeDescription>  attributes;
+    };
+
+    static size_t FindVertexAttribute(const std::vector<VertexAttributeDescription>& attributes, const std::vector<bool>& consumed,
+                                      const VertexInput& input, uint32_t column)
+    {
+        if (input.semantic != VertexSemantic::eUnknown)
+        {
+            for (size_t i = 0; i < attributes.size(); ++i)
+            {
+                if (!consumed[i] && attributes[i].semantic == input.semantic)
+                    return i;
+            }
+        }
+
+        for (size_t i = 0; i < attributes.size(); ++i)
+        {
+            bool semanticMatches = input.semantic == VertexSemantic::eUnknown || attributes[i].semantic == VertexSemantic::eUnknown;
+            if (!consumed[i] && semanticMatches && attributes[i].location == input.location + column)
+                return i;
+        }
+
+        return attributes.size();
+    }
+
+    /// Attributes are placed at reflected locations, streams which vertex shader never reads are dropped
+    static VertexInputData ResolveVertexInput(const PipelineDescription& description, const std::vector<Ref<Shader>>& shaders)
+    {
+        VertexInputData result;
+
+        auto& bindings = description.bindingDescriptions;
+        auto& attributes = description.attributeDescriptions;
+
+        auto vertexShader = std::find_if(shaders.begin(), shaders.end(), [](const auto& shader)
+        {
+            return shader->GetStage() == ShaderStage::eVertex;
+        });
+
+        const std::vector<VertexInput>* inputs = vertexShader != shaders.end() ? &(*vertexShader)->GetInputAttributes() : nullptr;
+        if (!inputs || inputs->empty())
+        {
+            for (const auto& binding : bindings)
+                result.bindings.push_back({ binding.binding, binding.stride, ToVulkanVertexInputRate(binding.inputRate) });
+            for (const auto& attribute : attributes)
+                result.attributes.push_back({ attribute.location, attribute.binding, ToVulkanFormat(attribute.format), attribute.offset });
+            return result;
+        }
+
+        /// Without layout of mesh expect tightly packed inputs in location order
+        if (attributes.empty())
+        {
+            uint32_t offset = 0;
+            for (const auto& input : *inputs)
+            {
+                for (uint32_t column = 0; column < input.type.componentCount; ++column)
+                {
+                    result.attributes.push_back({ input.location + column, 0, ToVulkanFormat(input.type.format), offset });
+                    offset += input.type.byteSize;
+                }
+            }
+
+            uint32_t stride = bindings.empty() ? offset : bindings[0].stride;
+            result.bindings.push_back({ 0, stride, VK_VERTEX_INPUT_RATE_VERTEX });
+            return result;
+        }
+
+        std::vector<bool> consumed(attributes.size(), false);
+        for (const auto& input : *inputs)
+        {
+            if (!input.used)
+                continue;
+
+            for (uint32_t column = 0; column < input.type.componentCount; ++column)
+            {
+                size_t index = FindVertexAttribute(attributes, consumed, input, column);
+                if (index == attributes.size())
+                {
+                    LOG_CATEGORY_ERROR(eRenderer, "Vertex input {} at location {} isn't provided by vertex layout", input.name, input.location + column);
+                    continue;
+                }
+
+                auto& attribute = attributes[index];
+                if (attribute.format != input.type.format)
+                {
+                    LOG_CATEGORY_WARN(eRenderer, "Vertex input {} expects format {} but vertex layout provides {}",
+                             input.name, uint32_t(input.type.format), uint32_t(attribute.format));
+                }
+
+                consumed[index] = true;
+                result.attributes.push_back({ input.location + column, attribute.binding, ToVulkanFormat(attribute.format), attribute.offset });
+            }
+        }
+
+        uint32_t strippedCount = static_cast<uint32_t>(std::count(consumed.begin(), consumed.end(), false));
+        if (strippedCount)
+            LOG_CATEGORY_TRACE(eRenderer, "Stripped {} vertex attributes which aren't read by {}", strippedCount, (*vertexShader)->GetFilename());
+
+        for (const auto& binding : bindings)
+        {
+            bool referenced = std::any_of(result.attributes.begin(), result.attributes.end(), [&binding](const auto& attribute)
+            {
+                return attribute.binding == binding.binding;
+            });
+
+            if (referenced)
+                result.bindings.push_back({ binding.binding, binding.stride, ToVulkanVertexInputRate(binding.inputRate) });
+        }
+
+        return result;
+    }
+
+    /// Create info together with storage it points to, so several pipelines can be created by one call
+    struct GraphicsPipelineState
+    {
+        std::vector<SpecializationData>                 specializations;
+        std::vector<VkPipelineShaderStageCreateInfo>    shaderStageCreateInfos;
+        VertexInputData                                 vertexInput;
+        VkPipelineVertexInputStateCreateInfo            vertexInputStateCreateInfo{};
+        VkPipelineInputAssemblyStateCreateInfo          inputAssemblyStateCreateInfo{};
+        VkViewport                                      viewport{};
+        VkRect2D                                        scissor{};
+        VkPipelineViewportStateCreateInfo               viewportStateCreateInfo{};
+        VkPipelineRasterizationStateCreateInfo          rasterizationStateCreateInfo{};
+        VkPipelineMultisampleStateCreateInfo            multisampleStateCreateInfo{};
+        VkPipelineColorBlendAttachmentState             colorBlendAttachmentState{};
+        VkPipelineColorBlendStateCreateInfo             colorBlendStateCreateInfo{};
+        VkPipelineDepthStencilStateCreateInfo           depthStencilStateCreateInfo{};
+        VkDynamicState                                  dynamicStates[2] = { VK_DYNAMIC_STATE_SCISSOR, VK_DYNAMIC_STATE_VIEWPORT };
+        VkPipelineDynamicStateCreateInfo                dynamicStateCreateInfo{};
+        VkGraphicsPipelineCreateInfo                    pipelineCreateInfo{};
+    };
+
+    struct ComputePipelineState
+    {
+        SpecializationData                              specialization;
+        VkComputePipelineCreateInfo                     computePipelineCreateInfo{};
+    };
+
+    /// Pipelines with same set layouts and push constant ranges share one native layout, so binding
+    /// descriptor sets stays compatible between them
+    class VulkanPipelineLayout
+    {
+    private:
+        std::vector<VkDescriptorSetLayout>  mSetLayouts;
+        std::vector<VkPushConstantRange>    mPushConstantRanges;
+        VkPipelineLayout                    mHandle = VK_NULL_HANDLE;
+    public:
+        VulkanPipelineLayout(std::vector<VkDescriptorSetLayout> setLayouts, std::vector<VkPushConstantRange> pushConstantRanges)
+            : mSetLayouts(std::move(setLayouts))
+            , mPushConstantRanges(std::move(pushConstantRanges))
+        {
+            VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{};
+            pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+            pipelineLayoutCreateInfo.setLayoutCount = static_cast<uint32_t>(mSetLayouts.size());
+            pipelineLayoutCreateInfo.pSetLayouts = mSetLayouts.data();
+            pipelineLayoutCreateInfo.pushConstantRangeCount = static_cast<uint32_t>(mPushConstantRanges.size());
+            pipelineLayoutCreateInfo.pPushConstantRanges = mPushConstantRanges.data();
+
+            VkDevice device = (VkDevice)GetGraphicContext().GetDevice();
+            VK_ASSERT(vkCreatePipelineLayout(device, &pipelineLayoutCreateInfo, nullptr, &mHandle));
+        }
+
+        ~VulkanPipelineLayout()
+        {
+            GetGraphicContext().DeferDestruction([handle = mHandle]()
+            {
+                VkDevice device = (VkDevice)GetGraphicContext().GetDevice();
+                vkDestroyPipelineLayout(device, handle, nullptr);
+            });
+        }
+
+        bool IsSame(const std::vector<VkDescriptorSetLayout>& setLayouts, const std::vector<VkPushConstantRange>& pushConstantRanges) const
+        {
+            auto sameRange = [](const auto& l, const auto& r)
+            {
+                return l.stageFlags == r.stageFlags && l.offset == r.offset && l.size == r.size;
+            };
+
+            return mSetLayouts == setLayouts &&
+                   std::equal(mPushConstantRanges.begin(), mPushConstantRanges.end(),
+                              pushConstantRanges.begin(), pushConstantRanges.end(), sameRange);
+        }
+
+        VkPipelineLayout GetHandle() const { return mHandle; }
+    };
+
+    static std::mutex sPipelineLayoutCacheMutex;
+    static std::unordered_multimap<size_t, std::weak_ptr<VulkanPipelineLayout>> sPipelineLayoutCache;
+
+    static Ref<VulkanPipelineLayout> FindOrCreatePipelineLayout(std::vector<VkDescriptorSetLayout> setLayouts, std::vector<VkPushConstantRange> pushConstantRanges)
+    {
+        size_t hash = 0;
+        for (auto setLayout : setLayouts)
+            HashCombine(hash, setLayout);
+        for (const auto& range : pushConstantRanges)
+        {
+            HashCombine(hash, range.stageFlags);
+            HashCombine(hash, range.offset);
+            HashCombine(hash, range.size);
+        }
+
+        std::scoped_lock lock(sPipelineLayoutCacheMutex);
+        auto [begin, end] = sPipelineLayoutCache.equal_range(hash);
+        for (auto it = begin; it != end;)
+        {
+            auto cached = it->second.lock();
+            if (!cached)
+            {
+                it = sPipelineLayoutCache.erase(it);
+                continue;
+            }
+
+            if (cached->IsSame(setLayouts, pushConstantRanges))
+                return cached;
+
+            ++it;
+        }
+
+        auto pipelineLayout = CreateRef<VulkanPipelineLayout>(std::move(setLayouts), std::move(pushConstantRanges));
+        sPipelineLayoutCache.emplace(hash, pipelineLayout);
+        return pipelineLayout;
+    }
+
     class VulkanPipeline : public Pipeline
     {
     private:
         PipelineType mType;
+        PipelineDescription mDescription;
         VkPipeline mHandle = VK_NULL_HANDLE;
-        VkPipelineLayout mPipelineLayout = VK_NULL_HANDLE;
-        const uint32_t mMaxPushConstantRange = 128;
+        Ref<VulkanPipelineLayout> mPipelineLayout;
+        std::vector<PushConstantRange> mPushConstantRanges;
 
-        void InitGraphicsPipeline(const PipelineDescription& description)
+        void InitPipelineLayout(const PipelineDescription& description)
         {
-            std::vector<VkPipelineShaderStageCreateInfo> shaderStageCreateInfos;
-            for (auto& shader : description.descriptorSetLayout->GetShaders())
+            auto& layout = description.descriptorSetLayout;
+            std::vector<VkDescriptorSetLayout> descriptorSetLayouts(layout->GetSetCount());
+            for (uint32_t i = 0; i < descriptorSetLayouts.size(); ++i)
+                descriptorSetLayouts[i] = (VkDescriptorSetLayout)layout->GetNativeHandle(i);
+
+            /// Stages which declare same block share one range
+            std::vector<VkPushConstantRange> pushConstantRanges;
+            for (const auto& shader : layout->GetShaders())
             {
-                VkPipelineShaderStageCreateInfo shaderStageCreateInfo{};
-                shaderStageCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-                shaderStageCreateInfo.module = (VkShaderModule)shader->GetNativeHandle();
-                shaderStageCreateInfo.pName = "main";
-                shaderStageCreateInfo.stage = ToVulkanShaderStage(shader->GetStage());
-                shaderStageCreateInfos.push_back(shaderStageCreateInfo);
-            }
+                for (const auto& range : shader->GetPushConstantRanges())
+                {
+                    mPushConstantRanges.push_back(range);
 
-            std::vector<VkVertexInputBindingDescription> bindingDescriptions;
-            bindingDescriptions.reserve(description.bindingDescriptions.size());
-            for (auto& bindingDescription : description.bindingDescriptions)
-            {
-                bindingDescriptions.emplace_back
-                (
-                    VkVertexInputBindingDescription
+                    auto rangeIt = std::find_if(pushConstantRanges.begin(), pushConstantRanges.end(), [&range](const auto& r)
                     {
-                        bindingDescription.binding,
-                        bindingDescription.stride,
-                        ToVulkanVertexInputRate(bindingDescription.inputRate)
+                        return r.offset == range.offset && r.size == range.size;
+                    });
+
+                    if (rangeIt != pushConstantRanges.end())
+                    {
+                        rangeIt->stageFlags |= ToVulkanShaderStage(range.stage);
+                        continue;
                     }
-                );
+
+                    auto& pushConstantRange = pushConstantRanges.emplace_back();
+                    pushConstantRange.stageFlags = ToVulkanShaderStage(range.stage);
+                    pushConstantRange.offset = range.offset;
+                    pushConstantRange.size = range.size;
+                }
             }
 
-            std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
-            attributeDescriptions.reserve(description.attributeDescriptions.size());
-            for (auto& attributeDescription : description.attributeDescriptions)
-            {
-                attributeDescriptions.emplace_back
-                (
-                VkVertexInputAttributeDescription
-                { 
-                    attributeDescription.location,
-                    attributeDescription.binding,
-                    ToVulkanFormat(attributeDescription.format),
-                    attributeDescription.offset
-                });
+            mPipelineLayout = FindOrCreatePipelineLayout(std::move(descriptorSetLayouts), std::move(pushConstantRanges));
+        }
+
+        void FillGraphicsPipelineState(const PipelineDescription& description, const std::vector<Ref<Shader>>& shaders,
+                                       GraphicsPipelineState& state) const
+        {
+            auto& specializations = state.specializations;
+            auto& shaderStageCreateInfos = state.shaderStageCreateInfos;
+            specializations.resize(shaders.size());
+            for (size_t i = 0; i < shaders.size(); ++i)
+            {
+                VkPipelineShaderStageCreateInfo shaderStageCreateInfo{};
+                shaderStageCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+                shaderStageCreateInfo.module = (VkShaderModule)shaders[i]->GetNativeHandle();
+                shaderStageCreateInfo.pName = "main";
+                shaderStageCreateInfo.stage = ToVulkanShaderStage(shaders[i]->GetStage());
+                shaderStageCreateInfo.pSpecializationInfo = FillSpecializationInfo(*shaders[i], specializations[i]);
+                shaderStageCreateInfos.push_back(shaderStageCreateInfo);
             }
 
-            VkPipelineVertexInputStateCreateInfo vertexInputStateCreateInfo{};
+            auto& vertexInput = state.vertexInput;
+            vertexInput = ResolveVertexInput(description, shaders);
+
+            auto& vertexInputStateCreateInfo = state.vertexInputStateCreateInfo;
             vertexInputStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-            vertexInputStateCreateInfo.vertexBindingDescriptionCount = bindingDescriptions.size();
-            vertexInputStateCreateInfo.pVertexBindingDescriptions = bindingDescriptions.data();
-            vertexInputStateCreateInfo.vertexAttributeDescriptionCount = attributeDescriptions.size();
-            vertexInputStateCreateInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
+            vertexInputStateCreateInfo.vertexBindingDescriptionCount = vertexInput.bindings.size();
+            vertexInputStateCreateInfo.pVertexBindingDescriptions = vertexInput.bindings.data();
+            vertexInputStateCreateInfo.vertexAttributeDescriptionCount = vertexInput.attributes.size();
+            vertexInputStateCreateInfo.pVertexAttributeDescriptions = vertexInput.attributes.data();
 
-            VkPipelineInputAssemblyStateCreateInfo inputAssemblyStateCreateInfo{};
+            auto& inputAssemblyStateCreateInfo = state.inputAssemblyStateCreateInfo;
             inputAssemblyStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
             inputAssemblyStateCreateInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
             inputAssemblyStateCreateInfo.primitiveRestartEnable = false;
 
             // Dynamic states
-            VkViewport viewport{};
-            VkRect2D scissor{};
+            auto& viewport = state.viewport;
+            auto& scissor = state.scissor;
 
-            VkPipelineViewportStateCreateInfo viewportStateCreateInfo{};
+            auto& viewportStateCreateInfo = state.viewportStateCreateInfo;
             viewportStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
             viewportStateCreateInfo.viewportCount = 1;
             viewportStateCreateInfo.pViewports = &viewport;
             viewportStateCreateInfo.scissorCount = 1;
             viewportStateCreateInfo.pScissors = &scissor;
 
-            VkPipelineRasterizationStateCreateInfo rasterizationStateCreateInfo{};
+            auto& rasterizationStateCreateInfo = state.rasterizationStateCreateInfo;
             rasterizationStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
             rasterizationStateCreateInfo.polygonMode = VK_POLYGON_MODE_FILL;
             rasterizationStateCreateInfo.cullMode = ToVulkanCullMode(description.rasterizerDescription.cullMode);
             rasterizationStateCreateInfo.frontFace = ToVulkanFrontFace(description.rasterizerDescription.frontFace);
             rasterizationStateCreateInfo.lineWidth = 1.0f;
 
-            VkPipelineMultisampleStateCreateInfo multisampleStateCreateInfo{};
+            auto& multisampleStateCreateInfo = state.multisampleStateCreateInfo;
             multisampleStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
             multisampleStateCreateInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
             multisampleStateCreateInfo.minSampleShading = 1.0f;
 
-            VkPipelineColorBlendAttachmentState colorBlendAttachmentState{};
+            auto& colorBlendAttachmentState = state.colorBlendAttachmentState;
             colorBlendAttachmentState.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
             colorBlendAttachmentState.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
             colorBlendAttachmentState.colorBlendOp = VK_BLEND_OP_ADD;
@@ -100,14 +377,14 @@ namespace Fluent
                                                      | VK_COLOR_COMPONENT_B_BIT
                                                      | VK_COLOR_COMPONENT_A_BIT;
 
-            VkPipelineColorBlendStateCreateInfo colorBlendStateCreateInfo{};
+            auto& colorBlendStateCreateInfo = state.colorBlendStateCreateInfo;
             colorBlendStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
             colorBlendStateCreateInfo.logicOpEnable = false;
             colorBlendStateCreateInfo.logicOp = VK_LOGIC_OP_COPY;
             colorBlendStateCreateInfo.attachmentCount = 1;
             colorBlendStateCreateInfo.pAttachments = &colorBlendAttachmentState;
 
-            VkPipelineDepthStencilStateCreateInfo depthStencilStateCreateInfo{};
+            auto& depthStencilStateCreateInfo = state.depthStencilStateCreateInfo;
             depthStencilStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
             depthStencilStateCreateInfo.depthTestEnable = description.depthStateDescription.depthTest;
             depthStencilStateCreateInfo.depthWriteEnable = description.depthStateDescription.depthWrite;
@@ -116,35 +393,12 @@ namespace Fluent
             depthStencilStateCreateInfo.depthBoundsTestEnable = VK_FALSE;
             depthStencilStateCreateInfo.stencilTestEnable = VK_FALSE;
 
-            const uint32_t dynamicStatesCount = 2;
-            VkDynamicState dynamicStates[dynamicStatesCount] =
-                { VK_DYNAMIC_STATE_SCISSOR, VK_DYNAMIC_STATE_VIEWPORT };
-
-            VkPipelineDynamicStateCreateInfo dynamicStateCreateInfo{};
+            auto& dynamicStateCreateInfo = state.dynamicStateCreateInfo;
             dynamicStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-            dynamicStateCreateInfo.dynamicStateCount = dynamicStatesCount;
-            dynamicStateCreateInfo.pDynamicStates = dynamicStates;
-
-            VkDevice device = (VkDevice)GetGraphicContext().GetDevice();
-
-            VkDescriptorSetLayout descriptorSetLayout = (VkDescriptorSetLayout)description.descriptorSetLayout->GetNativeHandle();
-            
-            VkPushConstantRange pushConstantRange{};
-            pushConstantRange.size = mMaxPushConstantRange;
-            pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT
-                                         | VK_SHADER_STAGE_COMPUTE_BIT
-                                         | VK_SHADER_STAGE_FRAGMENT_BIT;
-
-            VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{};
-            pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-            pipelineLayoutCreateInfo.setLayoutCount = 1;
-            pipelineLayoutCreateInfo.pSetLayouts = &descriptorSetLayout;
-            pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
-            pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
-
-            VK_ASSERT(vkCreatePipelineLayout(device, &pipelineLayoutCreateInfo, nullptr, &mPipelineLayout));
+            dynamicStateCreateInfo.dynamicStateCount = static_cast<uint32_t>(std::size(state.dynamicStates));
+            dynamicStateCreateInfo.pDynamicStates = state.dynamicStates;
 
-            VkGraphicsPipelineCreateInfo pipelineCreateInfo{};
+            auto& pipelineCreateInfo = state.pipelineCreateInfo;
             pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
             pipelineCreateInfo.stageCount = shaderStageCreateInfos.size();
             pipelineCreateInfo.pStages = shaderStageCreateInfos.data();
@@ -156,99 +410,372 @@ namespace Fluent
             pipelineCreateInfo.pColorBlendState = &colorBlendStateCreateInfo;
             pipelineCreateInfo.pDepthStencilState = &depthStencilStateCreateInfo;
             pipelineCreateInfo.pDynamicState = &dynamicStateCreateInfo;
-            pipelineCreateInfo.layout = mPipelineLayout;
+            pipelineCreateInfo.layout = mPipelineLayout->GetHandle();
             pipelineCreateInfo.renderPass = (VkRenderPass)description.renderPass->GetNativeHandle();
+        }
+
+        VkPipeline CreateGraphicsPipeline(const PipelineDescription& description, const std::vector<Ref<Shader>>& shaders) const
+        {
+            GraphicsPipelineState state;
+            FillGraphicsPipelineState(description, shaders, state);
+
+            VkDevice device = (VkDevice)GetGraphicContext().GetDevice();
 
-            VK_ASSERT(vkCreateGraphicsPipelines(device, {}, 1, &pipelineCreateInfo, nullptr, &mHandle));
+            VkPipeline pipeline = VK_NULL_HANDLE;
+            VK_ASSERT(vkCreateGraphicsPipelines(device, {}, 1, &state.pipelineCreateInfo, nullptr, &pipeline));
+            return pipeline;
         }
 
-        void InitComputePipeline(const PipelineDescription& description)
+        void FillComputePipelineState(const std::vector<Ref<Shader>>& shaders, ComputePipelineState& state) const
         {
             // TODO: check that only one exist
-            auto& shader = description.descriptorSetLayout->GetShaders()[0];
+            auto& shader = shaders[0];
             VkPipelineShaderStageCreateInfo shaderStageCreateInfo{};
             shaderStageCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
             shaderStageCreateInfo.module = (VkShaderModule)shader->GetNativeHandle();
             shaderStageCreateInfo.pName = "main";
             shaderStageCreateInfo.stage = ToVulkanShaderStage(shader->GetStage());
+            shaderStageCreateInfo.pSpecializationInfo = FillSpecializationInfo(*shader, state.specialization);
 
-            std::vector<VkVertexInputBindingDescription> bindingDescriptions;
-            bindingDescriptions.reserve(description.bindingDescriptions.size());
-            for (auto& bindingDescription : description.bindingDescriptions)
-            {
-                bindingDescriptions.emplace_back
-                (
-                VkVertexInputBindingDescription
-                { 
-                    bindingDescription.binding,
-                    bindingDescription.stride,
-                    ToVulkanVertexInputRate(bindingDescription.inputRate)
-                });
-            }
-
-            VkDevice device = (VkDevice)GetGraphicContext().GetDevice();
-
-            VkDescriptorSetLayout descriptorSetLayout = (VkDescriptorSetLayout)description.descriptorSetLayout->GetNativeHandle();
-            
-            VkPushConstantRange pushConstantRange{};
-            pushConstantRange.size = mMaxPushConstantRange;
-            pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT
-                                           | VK_SHADER_STAGE_COMPUTE_BIT
-                                           | VK_SHADER_STAGE_FRAGMENT_BIT;
-
-            VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{};
-            pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-            pipelineLayoutCreateInfo.setLayoutCount = 1;
-            pipelineLayoutCreateInfo.pSetLayouts = &descriptorSetLayout;
-            pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
-            pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
-
-            VK_ASSERT(vkCreatePipelineLayout(device, &pipelineLayoutCreateInfo, nullptr, &mPipelineLayout));
-
-            VkComputePipelineCreateInfo computePipelineCreateInfo{};
+            auto& computePipelineCreateInfo = state.computePipelineCreateInfo;
             computePipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
             computePipelineCreateInfo.stage = shaderStageCreateInfo;
-            computePipelineCreateInfo.layout = mPipelineLayout;
+            computePipelineCreateInfo.layout = mPipelineLayout->GetHandle();
+        }
+
+        VkPipeline CreateComputePipeline(const std::vector<Ref<Shader>>& shaders) const
+        {
+            ComputePipelineState state;
+            FillComputePipelineState(shaders, state);
 
+            VkDevice device = (VkDevice)GetGraphicContext().GetDevice();
+
+            VkPipeline pipeline = VK_NULL_HANDLE;
             VK_ASSERT
             (vkCreateComputePipelines
                 (device, {}, 1,
-                 &computePipelineCreateInfo,
-                 nullptr, &mHandle)
+                 &state.computePipelineCreateInfo,
+                 nullptr, &pipeline)
              );
+            return pipeline;
         }
     public:
-        VulkanPipeline(const PipelineDescription& description)
+        /// Without compile native pipeline is created later by CompileBatch
+        VulkanPipeline(const PipelineDescription& description, bool compile = true)
             : mType(description.type)
+            , mDescription(description)
+        {
+            InitPipelineLayout(description);
+            if (compile)
+                mHandle = (VkPipeline)Rebuild(description.descriptorSetLayout->GetShaders());
+        }
+
+        ~VulkanPipeline() override
+        {
+            GetGraphicContext().DeferDestruction([handle = mHandle]()
+            {
+                VkDevice device = (VkDevice)GetGraphicContext().GetDevice();
+                vkDestroyPipeline(device, handle, nullptr);
+            });
+        }
+
+        Handle Rebuild(const std::vector<Ref<Shader>>& shaders) const override
         {
             switch (mType)
             {
                 case PipelineType::eGraphics:
-                    InitGraphicsPipeline(description);
-                    break;
+                    return CreateGraphicsPipeline(mDescription, shaders);
                 case PipelineType::eCompute:
-                    InitComputePipeline(description);
-                    break;
+                    return CreateComputePipeline(shaders);
                 default:
-                    LOG_WARN("Unknown pipeline type {}", uint32_t(mType));
+                    LOG_CATEGORY_WARN(eRenderer, "Unknown pipeline type {}", uint32_t(mType));
                     break;
             }
+
+            return VK_NULL_HANDLE;
         }
 
-        ~VulkanPipeline() override
+        /// One create call per pipeline type, so driver may compile them in parallel
+        static void CompileBatch(const std::vector<Ref<VulkanPipeline>>& pipelines)
         {
+            std::vector<VulkanPipeline*> graphicsPipelines;
+            std::vector<VulkanPipeline*> computePipelines;
+            for (const auto& pipeline : pipelines)
+            {
+                switch (pipeline->mType)
+                {
+                    case PipelineType::eGraphics:
+                        graphicsPipelines.push_back(pipeline.get());
+                        break;
+                    case PipelineType::eCompute:
+                        computePipelines.push_back(pipeline.get());
+                        break;
+                    default:
+                        LOG_CATEGORY_WARN(eRenderer, "Unknown pipeline type {}", uint32_t(pipeline->mType));
+                        break;
+                }
+            }
+
             VkDevice device = (VkDevice)GetGraphicContext().GetDevice();
-            vkDestroyPipelineLayout(device, mPipelineLayout, nullptr);
-            vkDestroyPipeline(device, mHandle, nullptr);
+
+            if (!graphicsPipelines.empty())
+            {
+                std::vector<GraphicsPipelineState> states(graphicsPipelines.size());
+                std::vector<VkGraphicsPipelineCreateInfo> createInfos;
+                createInfos.reserve(graphicsPipelines.size());
+                for (size_t i = 0; i < graphicsPipelines.size(); ++i)
+                {
+                    auto& description = graphicsPipelines[i]->mDescription;
+                    graphicsPipelines[i]->FillGraphicsPipelineState(description, description.descriptorSetLayout->GetShaders(), states[i]);
+                    createInfos.push_back(states[i].pipelineCreateInfo);
+                }
+
+                std::vector<VkPipeline> handles(createInfos.size(), VK_NULL_HANDLE);
+                VK_ASSERT(vkCreateGraphicsPipelines(device, {}, createInfos.size(), createInfos.data(), nullptr, handles.data()));
+                for (size_t i = 0; i < graphicsPipelines.size(); ++i)
+                    graphicsPipelines[i]->mHandle = handles[i];
+            }
+
+            if (!computePipelines.empty())
+            {
+                std::vector<ComputePipelineState> states(computePipelines.size());
+                std::vector<VkComputePipelineCreateInfo> createInfos;
+                createInfos.reserve(computePipelines.size());
+                for (size_t i = 0; i < computePipelines.size(); ++i)
+                {
+                    computePipelines[i]->FillComputePipelineState(computePipelines[i]->mDescription.descriptorSetLayout->GetShaders(), states[i]);
+                    createInfos.push_back(states[i].computePipelineCreateInfo);
+                }
+
+                std::vector<VkPipeline> handles(createInfos.size(), VK_NULL_HANDLE);
+                VK_ASSERT(vkCreateComputePipelines(device, {}, createInfos.size(), createInfos.data(), nullptr, handles.data()));
+                for (size_t i = 0; i < computePipelines.size(); ++i)
+                    computePipelines[i]->mHandle = handles[i];
+            }
+        }
+
+        void Replace(Handle pipeline) override
+        {
+            GetGraphicContext().DeferDestruction([handle = mHandle]()
+            {
+                VkDevice device = (VkDevice)GetGraphicContext().GetDevice();
+                vkDestroyPipeline(device, handle, nullptr);
+            });
+
+            mHandle = (VkPipeline)pipeline;
         }
 
         PipelineType GetType() const override { return mType; }
+        const PipelineDescription& GetDescription() const override { return mDescription; }
+        const std::vector<PushConstantRange>& GetPushConstantRanges() const override { return mPushConstantRanges; }
         Handle GetNativeHandle() const override { return mHandle; }
-        Handle GetPipelineLayout() const override { return mPipelineLayout; }
+        Handle GetPipelineLayout() const override { return mPipelineLayout->GetHandle(); }
     };
 
+    /// Each permutation of shaders and states is created once while somebody holds it. Layouts are
+    /// compared by their shaders, so layouts created separately from same shaders share pipelines
+    static std::mutex sPipelineCacheMutex;
+    static std::unordered_multimap<size_t, std::weak_ptr<Pipeline>> sPipelineCache;
+
+    /// Shaders with same module, specialization values and semantics are one permutation wherever
+    /// module came from, so shader recreated from changed spirv never gets stale pipeline
+    static bool IsSameShader(const Ref<Shader>& lhs, const Ref<Shader>& rhs)
+    {
+        if (lhs == rhs)
+            return true;
+
+        if (lhs->GetStage() != rhs->GetStage() || lhs->GetByteCodeHash() != rhs->GetByteCodeHash())
+            return false;
+
+        auto sameConstant = [](const auto& l, const auto& r)
+        {
+            return l.constantId == r.constantId && l.value == r.value;
+        };
+
+        auto sameSemantic = [](const auto& l, const auto& r)
+        {
+            return l.location == r.location && l.semantic == r.semantic;
+        };
+
+        const auto& lhsConstants = lhs->GetSpecializationConstants();
+        const auto& rhsConstants = rhs->GetSpecializationConstants();
+        const auto& lhsSemantics = lhs->GetInputSemantics();
+        const auto& rhsSemantics = rhs->GetInputSemantics();
+        return std::equal(lhsConstants.begin(), lhsConstants.end(), rhsConstants.begin(), rhsConstants.end(), sameConstant) &&
+               std::equal(lhsSemantics.begin(), lhsSemantics.end(), rhsSemantics.begin(), rhsSemantics.end(), sameSemantic);
+    }
+
+    static void HashShaders(size_t& result, const DescriptorSetLayout& layout)
+    {
+        for (const auto& shader : layout.GetShaders())
+        {
+            HashCombine(result, shader->GetStage());
+            HashCombine(result, shader->GetByteCodeHash());
+            for (const auto& constant : shader->GetSpecializationConstants())
+            {
+                HashCombine(result, constant.constantId);
+                HashCombine(result, constant.value);
+            }
+            for (const auto& semantic : shader->GetInputSemantics())
+            {
+                HashCombine(result, semantic.location);
+                HashCombine(result, semantic.semantic);
+            }
+        }
+    }
+
+    static size_t HashDescription(const PipelineDescription& description)
+    {
+        size_t result = 0;
+        HashCombine(result, description.type);
+        HashShaders(result, *description.descriptorSetLayout);
+        HashCombine(result, description.renderPass.get());
+        for (const auto& binding : description.bindingDescriptions)
+        {
+            HashCombine(result, binding.binding);
+            HashCombine(result, binding.stride);
+            HashCombine(result, binding.inputRate);
+        }
+        for (const auto& attribute : description.attributeDescriptions)
+        {
+            HashCombine(result, attribute.location);
+            HashCombine(result, attribute.binding);
+            HashCombine(result, attribute.format);
+            HashCombine(result, attribute.offset);
+            HashCombine(result, attribute.semantic);
+        }
+        HashCombine(result, description.rasterizerDescription.cullMode);
+        HashCombine(result, description.rasterizerDescription.frontFace);
+        HashCombine(result, description.depthStateDescription.depthTest);
+        HashCombine(result, description.depthStateDescription.depthWrite);
+        HashCombine(result, description.depthStateDescription.compareOp);
+        return result;
+    }
+
+    static bool IsSameDescription(const PipelineDescription& lhs, const PipelineDescription& rhs)
+    {
+        auto sameBinding = [](const auto& l, const auto& r)
+        {
+            return l.binding == r.binding && l.stride == r.stride && l.inputRate == r.inputRate;
+        };
+
+        auto sameAttribute = [](const auto& l, const auto& r)
+        {
+            return l.location == r.location && l.binding == r.binding && l.format == r.format && l.offset == r.offset && l.semantic == r.semantic;
+        };
+
+        const auto& lhsShaders = lhs.descriptorSetLayout->GetShaders();
+        const auto& rhsShaders = rhs.descriptorSetLayout->GetShaders();
+
+        return lhs.type == rhs.type &&
+               std::equal(lhsShaders.begin(), lhsShaders.end(), rhsShaders.begin(), rhsShaders.end(), IsSameShader) &&
+               lhs.renderPass == rhs.renderPass &&
+               std::equal(lhs.bindingDescriptions.begin(), lhs.bindingDescriptions.end(),
+                          rhs.bindingDescriptions.begin(), rhs.bindingDescriptions.end(), sameBinding) &&
+               std::equal(lhs.attributeDescriptions.begin(), lhs.attributeDescriptions.end(),
+                          rhs.attributeDescriptions.begin(), rhs.attributeDescriptions.end(), sameAttribute) &&
+               lhs.rasterizerDescription.cullMode == rhs.rasterizerDescription.cullMode &&
+               lhs.rasterizerDescription.frontFace == rhs.rasterizerDescription.frontFace &&
+               lhs.depthStateDescription.depthTest == rhs.depthStateDescription.depthTest &&
+               lhs.depthStateDescription.depthWrite == rhs.depthStateDescription.depthWrite &&
+               lhs.depthStateDescription.compareOp == rhs.depthStateDescription.compareOp;
+    }
+
+    /// Cache mutex should be locked
+    static Ref<Pipeline> FindCachedPipeline(size_t hash, const PipelineDescription& description)
+    {
+        auto [begin, end] = sPipelineCache.equal_range(hash);
+        for (auto it = begin; it != end;)
+        {
+            auto cached = it->second.lock();
+            if (!cached)
+            {
+                it = sPipelineCache.erase(it);
+                continue;
+            }
+
+            if (IsSameDescription(cached->GetDescription(), description))
+                return cached;
+
+            ++it;
+        }
+
+        return nullptr;
+    }
+
+    /// Interface
+
     Ref<Pipeline> Pipeline::Create(const PipelineDescription& description)
     {
-        return CreateRef<VulkanPipeline>(description);
+        PROFILE_SCOPE("Pipeline::Create");
+        auto hash = HashDescription(description);
+
+        {
+            std::scoped_lock lock(sPipelineCacheMutex);
+            if (auto cached = FindCachedPipeline(hash, description))
+                return cached;
+        }
+
+        /// Cache isn't locked while compiling, so compiler workers aren't blocked by this thread
+        Ref<Pipeline> pipeline = CreateRef<VulkanPipeline>(description);
+
+        {
+            std::scoped_lock lock(sPipelineCacheMutex);
+            /// Another thread finished same pipeline meanwhile, ours is released
+            if (auto cached = FindCachedPipeline(hash, description))
+                return cached;
+
+            sPipelineCache.emplace(hash, pipeline);
+        }
+
+        ShaderHotReload::RegisterPipeline(pipeline);
+        return pipeline;
+    }
+
+    std::vector<Ref<Pipeline>> Pipeline::CreateBatch(const std::vector<PipelineDescription>& descriptions)
+    {
+        PROFILE_SCOPE("Pipeline::CreateBatch");
+        std::vector<Ref<Pipeline>> result(descriptions.size());
+        {
+            std::scoped_lock lock(sPipelineCacheMutex);
+            for (size_t i = 0; i < descriptions.size(); ++i)
+                result[i] = FindCachedPipeline(HashDescription(descriptions[i]), descriptions[i]);
+        }
+
+        std::vector<Ref<VulkanPipeline>> compiled;
+        for (size_t i = 0; i < descriptions.size(); ++i)
+        {
+            if (result[i])
+                continue;
+
+            /// Same description may be requested twice in one batch
+            auto duplicate = std::find_if(compiled.begin(), compiled.end(), [&description = descriptions[i]](const auto& pipeline)
+            {
+                return IsSameDescription(pipeline->GetDescription(), description);
+            });
+
+            if (duplicate != compiled.end())
+            {
+                result[i] = *duplicate;
+                continue;
+            }
+
+            auto& pipeline = compiled.emplace_back(CreateRef<VulkanPipeline>(descriptions[i], false));
+            result[i] = pipeline;
+        }
+
+        /// Cache isn't locked while compiling, another thread may add same pipeline meanwhile, it just stays unused
+        VulkanPipeline::CompileBatch(compiled);
+
+        {
+            std::scoped_lock lock(sPipelineCacheMutex);
+            for (const auto& pipeline : compiled)
+                sPipelineCache.emplace(HashDescription(pipeline->GetDescription()), pipeline);
+        }
+
+        for (const auto& pipeline : compiled)
+            ShaderHotReload::RegisterPipeline(pipeline);
+
+        return result;
     }
 } // namespace Fluent
@@ -40,10 +40,22 @@ namespace Fluent
         virtual ~Pipeline() = default;
 
         virtual PipelineType GetType() const = 0;
+        virtual const PipelineDescription& GetDescription() const = 0;
+        /// Reflected ranges of every stage
+        virtual const std::vector<PushConstantRange>& GetPushConstantRanges() const = 0;
+
+        /// Creates new native pipeline with given shaders, can be called from worker thread
+        virtual Handle Rebuild(const std::vector<Ref<Shader>>& shaders) const = 0;
+        /// Previous native pipeline is destroyed once frames in flight are finished
+        virtual void Replace(Handle pipeline) = 0;
 
         virtual Handle GetPipelineLayout() const = 0;
         virtual Handle GetNativeHandle() const = 0;
 
+        /// Returns alive pipeline of same permutation, descriptor set layouts are compared by their shaders
         static Ref<Pipeline> Create(const PipelineDescription& description);
+        /// Pipelines which aren't cached yet are compiled with one create call per type.
+        /// Can be called from worker thread, see PipelineCompiler
+        static std::vector<Ref<Pipeline>> CreateBatch(const std::vector<PipelineDescription>& descriptions);
     };
 } // namespace Fluent
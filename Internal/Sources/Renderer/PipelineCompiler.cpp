@@ -0,0 +1,202 @@
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include "Core/Profiler.hpp"
+#include "Renderer/PipelineCompiler.hpp"
+
+namespace Fluent
+{
+    class VulkanAsyncPipeline : public AsyncPipeline
+    {
+    private:
+        friend class VulkanPipelineCompiler;
+
+        PipelineDescription mDescription;
+        Ref<Pipeline>       mPipeline;
+        bool                mReady = false;
+    public:
+        VulkanAsyncPipeline(const PipelineDescription& description, const Ref<Pipeline>& fallback)
+            : mDescription(description)
+            , mPipeline(fallback)
+        {}
+
+        bool IsReady() const override { return mReady; }
+        const Ref<Pipeline>& Get() const override { return mPipeline; }
+        const PipelineDescription& GetDescription() const override { return mDescription; }
+    };
+
+    class VulkanPipelineCompiler : public PipelineCompiler
+    {
+        struct CompiledBatch
+        {
+            std::vector<Ref<VulkanAsyncPipeline>>   requests;
+            /// nullptr for skipped requests
+            std::vector<Ref<Pipeline>>              pipelines;
+        };
+    private:
+        uint32_t                                mMaxBatchSize;
+        std::vector<std::thread>                mWorkers;
+        mutable std::mutex                      mMutex;
+        std::condition_variable                 mQueueCondition;
+        std::condition_variable                 mIdleCondition;
+        std::deque<Ref<VulkanAsyncPipeline>>    mQueue;
+        std::vector<CompiledBatch>              mCompiled;
+        uint32_t                                mInFlightCount = 0;
+        /// Queued, compiling and compiled but not published yet
+        uint32_t                                mPendingCount = 0;
+        bool                                    mStopping = false;
+        bool                                    mPaused = false;
+
+        void WorkerLoop()
+        {
+            PROFILE_THREAD("PipelineCompiler");
+            while (true)
+            {
+                std::vector<Ref<VulkanAsyncPipeline>> requests;
+                {
+                    std::unique_lock lock(mMutex);
+                    mQueueCondition.wait(lock, [this]() { return mStopping || (!mPaused && !mQueue.empty()); });
+                    if (mStopping)
+                        return;
+
+                    while (!mQueue.empty() && requests.size() < mMaxBatchSize)
+                    {
+                        requests.push_back(std::move(mQueue.front()));
+                        mQueue.pop_front();
+                    }
+
+                    mInFlightCount += static_cast<uint32_t>(requests.size());
+                }
+
+                /// Only compiler holds request, so nobody waits for it
+                std::vector<PipelineDescription> descriptions;
+                std::vector<size_t> compiledIndices;
+                for (size_t i = 0; i < requests.size(); ++i)
+                {
+                    if (requests[i].use_count() == 1)
+                        continue;
+
+                    descriptions.push_back(requests[i]->mDescription);
+                    compiledIndices.push_back(i);
+                }
+
+                CompiledBatch batch;
+                batch.pipelines.resize(requests.size());
+                if (!descriptions.empty())
+                {
+                    auto pipelines = Pipeline::CreateBatch(descriptions);
+                    for (size_t i = 0; i < pipelines.size(); ++i)
+                        batch.pipelines[compiledIndices[i]] = std::move(pipelines[i]);
+                }
+
+                /// Requests and pipelines are released on main thread in Update
+                batch.requests = std::move(requests);
+                {
+                    std::scoped_lock lock(mMutex);
+                    mInFlightCount -= static_cast<uint32_t>(batch.requests.size());
+                    mCompiled.emplace_back(std::move(batch));
+                }
+
+                mIdleCondition.notify_all();
+            }
+        }
+    public:
+        explicit VulkanPipelineCompiler(const PipelineCompilerDescription& description)
+            : mMaxBatchSize(std::max(description.maxBatchSize, 1u))
+        {
+            uint32_t workerCount = std::max(description.workerCount, 1u);
+            for (uint32_t i = 0; i < workerCount; ++i)
+                mWorkers.emplace_back(&VulkanPipelineCompiler::WorkerLoop, this);
+        }
+
+        ~VulkanPipelineCompiler() override
+        {
+            {
+                std::scoped_lock lock(mMutex);
+                mStopping = true;
+            }
+
+            mQueueCondition.notify_all();
+            for (auto& worker : mWorkers)
+                worker.join();
+        }
+
+        Ref<AsyncPipeline> Compile(const PipelineDescription& description, const Ref<Pipeline>& fallback) override
+        {
+            auto request = CreateRef<VulkanAsyncPipeline>(description, fallback);
+            {
+                std::scoped_lock lock(mMutex);
+                mQueue.push_back(request);
+                mPendingCount++;
+            }
+
+            mQueueCondition.notify_one();
+            return request;
+        }
+
+        void Update() override
+        {
+            std::vector<CompiledBatch> compiled;
+            {
+                std::scoped_lock lock(mMutex);
+                std::swap(compiled, mCompiled);
+            }
+
+            for (auto& batch : compiled)
+            {
+                for (size_t i = 0; i < batch.requests.size(); ++i)
+                {
+                    auto& request = batch.requests[i];
+                    if (batch.pipelines[i])
+                        request->mPipeline = std::move(batch.pipelines[i]);
+                    request->mReady = true;
+                }
+
+                std::scoped_lock lock(mMutex);
+                mPendingCount -= static_cast<uint32_t>(batch.requests.size());
+            }
+        }
+
+        void WaitIdle() override
+        {
+            {
+                std::unique_lock lock(mMutex);
+                mIdleCondition.wait(lock, [this]() { return mQueue.empty() && mInFlightCount == 0; });
+            }
+
+            Update();
+        }
+
+        void Pause() override
+        {
+            std::unique_lock lock(mMutex);
+            mPaused = true;
+            mIdleCondition.wait(lock, [this]() { return mInFlightCount == 0; });
+        }
+
+        void Resume() override
+        {
+            {
+                std::scoped_lock lock(mMutex);
+                mPaused = false;
+            }
+
+            mQueueCondition.notify_all();
+        }
+
+        uint32_t GetPendingCount() const override
+        {
+            std::scoped_lock lock(mMutex);
+            return mPendingCount;
+        }
+    };
+
+    /// Interface
+
+    Scope<PipelineCompiler> PipelineCompiler::Create(const PipelineCompilerDescription& description)
+    {
+        return CreateScope<VulkanPipelineCompiler>(description);
+    }
+} // namespace Fluent
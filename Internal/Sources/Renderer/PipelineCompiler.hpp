@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include "Core/Base.hpp"
+#include "Renderer/Pipeline.hpp"
+
+namespace Fluent
+{
+    struct PipelineCompilerDescription
+    {
+        uint32_t workerCount = 2;
+        /// Max pipelines passed to one create call
+        uint32_t maxBatchSize = 16;
+    };
+
+    /// Pipeline which is compiled on worker thread
+    class AsyncPipeline
+    {
+    protected:
+        AsyncPipeline() = default;
+    public:
+        virtual ~AsyncPipeline() = default;
+
+        virtual bool IsReady() const = 0;
+        /// Fallback pipeline until compiled one is ready, could be nullptr so draw should be skipped
+        virtual const Ref<Pipeline>& Get() const = 0;
+        virtual const PipelineDescription& GetDescription() const = 0;
+    };
+
+    class PipelineCompiler
+    {
+    protected:
+        PipelineCompiler() = default;
+    public:
+        virtual ~PipelineCompiler() = default;
+
+        /// Queues description to workers, requests which nobody holds anymore are skipped
+        virtual Ref<AsyncPipeline> Compile(const PipelineDescription& description, const Ref<Pipeline>& fallback = nullptr) = 0;
+        /// Should be called between frames. Pipelines become ready only here, so they are
+        /// published and released on main thread
+        virtual void Update() = 0;
+        /// Blocks until every queued pipeline is compiled and published. Must not be called while paused
+        virtual void WaitIdle() = 0;
+        /// Blocks until workers finished current batches, queued requests wait until Resume.
+        /// Shaders may be replaced in between
+        virtual void Pause() = 0;
+        virtual void Resume() = 0;
+
+        virtual uint32_t GetPendingCount() const = 0;
+
+        static Scope<PipelineCompiler> Create(const PipelineCompilerDescription& description);
+    };
+} // namespace Fluent
@@ -118,8 +118,11 @@ namespace Fluent
 
         ~VulkanPass() override
         {
-            auto device = (VkDevice)GetGraphicContext().GetDevice();
-            vkDestroyRenderPass(device, mHandle, nullptr);
+            GetGraphicContext().DeferDestruction([handle = mHandle]()
+            {
+                auto device = (VkDevice)GetGraphicContext().GetDevice();
+                vkDestroyRenderPass(device, handle, nullptr);
+            });
         }
 
         const std::vector<ClearValue>& GetClearValues() const override { return mClearValues; }
@@ -0,0 +1,234 @@
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include "Core/Profiler.hpp"
+#include "Renderer/CommandStream.hpp"
+#include "Renderer/RenderQueue.hpp"
+
+namespace Fluent
+{
+    static constexpr uint32_t INVALID_INDEX = ~0u;
+
+    static uint64_t KeyField(uint64_t value, uint32_t bits, uint32_t shift)
+    {
+        return (value & ((1ull << bits) - 1)) << shift;
+    }
+
+    uint64_t RenderQueue::MakeSortKey(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t mesh, float depth, bool translucent)
+    {
+        constexpr uint32_t maxDepth = (1u << DEPTH_BITS) - 1;
+        auto quantizedDepth = static_cast<uint32_t>(std::clamp(depth, 0.0f, 1.0f) * maxDepth);
+
+        uint64_t key = KeyField(pass, PASS_BITS, 64 - PASS_BITS);
+        if (translucent)
+        {
+            uint32_t shift = 64 - PASS_BITS - DEPTH_BITS;
+            key |= KeyField(maxDepth - quantizedDepth, DEPTH_BITS, shift);
+            shift -= PIPELINE_BITS;
+            key |= KeyField(pipeline, PIPELINE_BITS, shift);
+            shift -= MATERIAL_BITS;
+            key |= KeyField(material, MATERIAL_BITS, shift);
+            key |= KeyField(mesh, MESH_BITS, 0);
+        }
+        else
+        {
+            uint32_t shift = 64 - PASS_BITS - PIPELINE_BITS;
+            key |= KeyField(pipeline, PIPELINE_BITS, shift);
+            shift -= MATERIAL_BITS;
+            key |= KeyField(material, MATERIAL_BITS, shift);
+            shift -= MESH_BITS;
+            key |= KeyField(mesh, MESH_BITS, shift);
+            key |= KeyField(quantizedDepth, DEPTH_BITS, 0);
+        }
+        return key;
+    }
+
+    uint32_t RenderQueue::AddPipeline(const Ref<Pipeline>& pipeline)
+    {
+        auto it = std::find(mPipelines.begin(), mPipelines.end(), pipeline);
+        if (it != mPipelines.end())
+            return static_cast<uint32_t>(it - mPipelines.begin());
+
+        mPipelines.push_back(pipeline);
+        return static_cast<uint32_t>(mPipelines.size() - 1);
+    }
+
+    uint32_t RenderQueue::AddMaterial(const RenderMaterial& material)
+    {
+        for (uint32_t i = 0; i < mMaterials.size(); ++i)
+        {
+            const auto& other = mMaterials[i];
+            if (other.descriptorSet == material.descriptorSet &&
+                other.setIndex == material.setIndex &&
+                other.pushConstantOffset == material.pushConstantOffset &&
+                other.pushConstants == material.pushConstants)
+                return i;
+        }
+
+        mMaterials.push_back(material);
+        return static_cast<uint32_t>(mMaterials.size() - 1);
+    }
+
+    uint32_t RenderQueue::AddMesh(const RenderMesh& mesh)
+    {
+        mMeshes.push_back(mesh);
+        return static_cast<uint32_t>(mMeshes.size() - 1);
+    }
+
+    void RenderQueue::Reset()
+    {
+        Clear();
+        mPipelines.clear();
+        mMaterials.clear();
+        mMeshes.clear();
+    }
+
+    void RenderQueue::Submit(const DrawItem& item, const void* pushConstants, uint32_t size, uint32_t offset)
+    {
+        QueuedDraw draw{};
+        draw.item = item;
+        draw.pushConstantData = static_cast<uint32_t>(mPushConstantData.size());
+        draw.pushConstantSize = pushConstants ? size : 0;
+        draw.pushConstantOffset = offset;
+        if (draw.pushConstantSize)
+        {
+            mPushConstantData.resize(mPushConstantData.size() + size);
+            std::memcpy(mPushConstantData.data() + draw.pushConstantData, pushConstants, size);
+        }
+
+        mDraws.push_back(draw);
+        mSorted = false;
+    }
+
+    void RenderQueue::Sort()
+    {
+        PROFILE_SCOPE("RenderQueue::Sort");
+        auto count = static_cast<uint32_t>(mDraws.size());
+        mSorted = true;
+        if (count == 0)
+            return;
+
+        mKeys.resize(count);
+        mOrder.resize(count);
+        mScratchKeys.resize(count);
+        mScratchOrder.resize(count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            mKeys[i] = mDraws[i].item.sortKey;
+            mOrder[i] = i;
+        }
+
+        /// LSD radix sort by bytes, stable so equal keys keep submission order
+        for (uint32_t shift = 0; shift < 64; shift += 8)
+        {
+            std::array<uint32_t, 256> histogram{};
+            for (auto key : mKeys)
+                histogram[(key >> shift) & 0xFF]++;
+
+            /// All keys share this byte, nothing to reorder
+            if (histogram[(mKeys[0] >> shift) & 0xFF] == count)
+                continue;
+
+            uint32_t offset = 0;
+            for (auto& bucket : histogram)
+            {
+                auto bucketCount = bucket;
+                bucket = offset;
+                offset += bucketCount;
+            }
+
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                auto destination = histogram[(mKeys[i] >> shift) & 0xFF]++;
+                mScratchKeys[destination] = mKeys[i];
+                mScratchOrder[destination] = mOrder[i];
+            }
+
+            mKeys.swap(mScratchKeys);
+            mOrder.swap(mScratchOrder);
+        }
+    }
+
+    template<typename Recorder>
+    void RenderQueue::Record(Recorder& recorder, uint32_t pass)
+    {
+        if (!mSorted)
+            Sort();
+
+        auto begin = mKeys.begin();
+        auto end = mKeys.end();
+        if (pass != INVALID_INDEX)
+        {
+            begin = std::lower_bound(mKeys.begin(), mKeys.end(), KeyField(pass, PASS_BITS, 64 - PASS_BITS));
+            if (pass + 1 < (1u << PASS_BITS))
+                end = std::lower_bound(begin, mKeys.end(), KeyField(pass + 1, PASS_BITS, 64 - PASS_BITS));
+        }
+
+        uint32_t boundPipeline = INVALID_INDEX;
+        uint32_t boundMaterial = INVALID_INDEX;
+        uint32_t boundMesh = INVALID_INDEX;
+        for (auto it = begin; it != end; ++it)
+        {
+            const auto& draw = mDraws[mOrder[it - mKeys.begin()]];
+            const auto& item = draw.item;
+            const auto& pipeline = mPipelines[item.pipeline];
+
+            if (item.pipeline != boundPipeline)
+            {
+                recorder.BindPipeline(pipeline);
+                boundPipeline = item.pipeline;
+                /// Material push constants may belong to other layout now
+                boundMaterial = INVALID_INDEX;
+                mStats.pipelineBindCount++;
+            }
+
+            if (item.material != boundMaterial)
+            {
+                const auto& material = mMaterials[item.material];
+                if (material.descriptorSet)
+                    recorder.BindDescriptorSet(pipeline, material.descriptorSet, material.setIndex);
+                if (!material.pushConstants.empty())
+                    recorder.PushConstants(pipeline, material.pushConstantOffset, static_cast<uint32_t>(material.pushConstants.size()), material.pushConstants.data());
+                boundMaterial = item.material;
+                mStats.materialBindCount++;
+            }
+
+            const auto& mesh = mMeshes[item.mesh];
+            if (item.mesh != boundMesh)
+            {
+                recorder.BindVertexBuffer(mesh.vertexBuffer, 0);
+                recorder.BindIndexBuffer(mesh.indexBuffer, 0, mesh.indexType);
+                boundMesh = item.mesh;
+                mStats.meshBindCount++;
+            }
+
+            if (draw.pushConstantSize)
+                recorder.PushConstants(pipeline, draw.pushConstantOffset, draw.pushConstantSize, mPushConstantData.data() + draw.pushConstantData);
+
+            recorder.DrawIndexed(mesh.indexCount, item.instanceCount, mesh.firstIndex, 0, item.firstInstance);
+            mStats.drawCount++;
+        }
+    }
+
+    void RenderQueue::Execute(const Ref<CommandBuffer>& cmd, uint32_t pass)
+    {
+        PROFILE_SCOPE("RenderQueue::Execute");
+        Record(*cmd, pass);
+    }
+
+    void RenderQueue::Execute(CommandStream& stream, uint32_t pass)
+    {
+        PROFILE_SCOPE("RenderQueue::Execute");
+        Record(stream, pass);
+    }
+
+    void RenderQueue::Clear()
+    {
+        mDraws.clear();
+        mPushConstantData.clear();
+        mKeys.clear();
+        mOrder.clear();
+        mSorted = true;
+        mStats = {};
+    }
+} // namespace Fluent
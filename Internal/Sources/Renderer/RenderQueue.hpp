@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Core/Base.hpp"
+#include "Renderer/Buffer.hpp"
+#include "Renderer/CommandBuffer.hpp"
+#include "Renderer/DescriptorSet.hpp"
+#include "Renderer/Pipeline.hpp"
+
+namespace Fluent
+{
+    class CommandStream;
+
+    /// State shared by many draws, bound only when it differs from previous draw
+    struct RenderMaterial
+    {
+        /// Optional, bound at setIndex
+        Ref<DescriptorSet>      descriptorSet;
+        uint32_t                setIndex = DescriptorSetFrequency::ePerMaterial;
+        /// Optional, pushed at pushConstantOffset
+        std::vector<uint8_t>    pushConstants;
+        uint32_t                pushConstantOffset = 0;
+    };
+
+    struct RenderMesh
+    {
+        Ref<Buffer>     vertexBuffer;
+        Ref<Buffer>     indexBuffer;
+        uint32_t        firstIndex = 0;
+        uint32_t        indexCount = 0;
+        IndexType       indexType = IndexType::eUint32;
+    };
+
+    struct DrawItem
+    {
+        uint64_t    sortKey = 0;
+        uint32_t    pipeline = 0;
+        uint32_t    material = 0;
+        uint32_t    mesh = 0;
+        uint32_t    instanceCount = 1;
+        uint32_t    firstInstance = 0;
+    };
+
+    struct RenderQueueStats
+    {
+        uint32_t drawCount = 0;
+        uint32_t pipelineBindCount = 0;
+        uint32_t materialBindCount = 0;
+        uint32_t meshBindCount = 0;
+    };
+
+    /// Draws are submitted in any order each frame, sorted by key and recorded with
+    /// redundant pipeline, material and mesh binds skipped.
+    /// Pipelines, materials and meshes are registered once and referenced by index
+    class RenderQueue
+    {
+    private:
+        struct QueuedDraw
+        {
+            DrawItem    item;
+            uint32_t    pushConstantData;
+            uint32_t    pushConstantSize;
+            uint32_t    pushConstantOffset;
+        };
+
+        std::vector<Ref<Pipeline>>  mPipelines;
+        std::vector<RenderMaterial> mMaterials;
+        std::vector<RenderMesh>     mMeshes;
+
+        std::vector<QueuedDraw>     mDraws;
+        std::vector<uint8_t>        mPushConstantData;
+        /// Key and draw index pairs, second buffer is radix sort scratch
+        std::vector<uint64_t>       mKeys;
+        std::vector<uint32_t>       mOrder;
+        std::vector<uint64_t>       mScratchKeys;
+        std::vector<uint32_t>       mScratchOrder;
+        bool                        mSorted = true;
+        RenderQueueStats            mStats;
+
+        /// Recorder is command buffer or command stream, both take same calls
+        template<typename Recorder>
+        void Record(Recorder& recorder, uint32_t pass);
+    public:
+        static constexpr uint32_t PASS_BITS = 4;
+        static constexpr uint32_t PIPELINE_BITS = 12;
+        static constexpr uint32_t MATERIAL_BITS = 16;
+        static constexpr uint32_t MESH_BITS = 16;
+        static constexpr uint32_t DEPTH_BITS = 16;
+        static_assert(PASS_BITS + PIPELINE_BITS + MATERIAL_BITS + MESH_BITS + DEPTH_BITS == 64);
+
+        /// Opaque: pass, pipeline, material, mesh, then front to back.
+        /// Translucent: pass, then back to front, state changes are not minimized.
+        /// Depth is normalized to [0, 1], indices are truncated to their bit count
+        static uint64_t MakeSortKey(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t mesh, float depth, bool translucent = false);
+
+        uint32_t AddPipeline(const Ref<Pipeline>& pipeline);
+        /// Identical materials share index
+        uint32_t AddMaterial(const RenderMaterial& material);
+        uint32_t AddMesh(const RenderMesh& mesh);
+        /// Drops registered resources and queued draws
+        void Reset();
+
+        /// Push constants are per draw and copied into queue
+        void Submit(const DrawItem& item, const void* pushConstants = nullptr, uint32_t size = 0, uint32_t offset = 0);
+        void Sort();
+        /// Records sorted draws of one pass, all passes when pass is ~0u. Sorts if needed
+        void Execute(const Ref<CommandBuffer>& cmd, uint32_t pass = ~0u);
+        /// Same as above but packets go to stream which is translated later by CommandStreamExecutor
+        void Execute(CommandStream& stream, uint32_t pass = ~0u);
+        /// Drops queued draws, call once per frame after execution
+        void Clear();
+
+        /// Binds and draws recorded since last Clear
+        const RenderQueueStats& GetStats() const { return mStats; }
+        uint32_t GetDrawCount() const { return static_cast<uint32_t>(mDraws.size()); }
+    };
+} // namespace Fluent
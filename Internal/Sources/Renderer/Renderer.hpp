@@ -231,6 +231,17 @@ namespace Fluent
         eGpuLazilyAllocated = 6
     };
 
+    /// Category used for device memory statistics
+    enum class MemoryTag
+    {
+        eUnknown,
+        eMesh,
+        eTexture,
+        eStaging,
+        eRenderTarget,
+        eLast
+    };
+
     struct ImageUsage
     {
         using Flags = uint32_t;
@@ -314,6 +325,22 @@ namespace Fluent
         eDontCare = 2
     };
 
+    /// Descriptor sets grouped by update frequency.
+    /// Lower sets stay bound while higher ones are rebound
+    struct DescriptorSetFrequency
+    {
+        enum Index : uint32_t
+        {
+            ePerFrame       = 0,
+            ePerPass        = 1,
+            ePerMaterial    = 2,
+            ePerDraw        = 3
+        };
+    };
+
+    /// Minimal maxBoundDescriptorSets guaranteed by Vulkan
+    static constexpr uint32_t MAX_DESCRIPTOR_SET_COUNT = 4;
+
     enum class ShaderStage
     {
         eVertex                 = 0x00000001,
@@ -356,6 +383,13 @@ namespace Fluent
         eVertex,
         eInstance
     };
+
+    /// Minimal maxVertexInputBindings guaranteed by Vulkan
+    static constexpr uint32_t MAX_VERTEX_BINDING_COUNT = 16;
+
+    /// maxColorAttachments of practically all desktop devices
+    static constexpr uint32_t MAX_COLOR_ATTACHMENT_COUNT = 8;
+
     struct VertexBindingDescription
     {
         uint32_t binding;
@@ -363,13 +397,28 @@ namespace Fluent
         VertexInputRate inputRate;
     };
 
-    // TODO: Maybe reflect it too?
+    /// Meaning of vertex attribute, shader inputs get it from ShaderDescription::inputSemantics or their location
+    enum class VertexSemantic
+    {
+        eUnknown,
+        ePosition,
+        eNormal,
+        eTexCoord,
+        eTangent,
+        eBitangent,
+        eColor,
+        eInstanceTransform,
+        eInstanceMaterial
+    };
+
+    /// Matched against reflected vertex shader inputs by semantic, or by location when semantic is unknown
     struct VertexAttributeDescription
     {
         uint32_t location;
         uint32_t binding;
         Format format;
         uint32_t offset;
+        VertexSemantic semantic = VertexSemantic::eUnknown;
     };
 
     enum class CullMode
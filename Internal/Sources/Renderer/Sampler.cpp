@@ -1,3 +1,5 @@
+#include <mutex>
+#include <unordered_map>
 #include "Renderer/GraphicContext.hpp"
 #include "Renderer/Sampler.hpp"
 
@@ -6,9 +8,11 @@ namespace Fluent
     class VulkanSampler : public Sampler
     {
     private:
-        VkSampler mHandle;
+        SamplerDescription  mDescription;
+        VkSampler           mHandle;
     public:
         VulkanSampler(const SamplerDescription& description)
+            : mDescription(description)
         {
             VkSamplerCreateInfo samplerCreateInfo{};
             samplerCreateInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
@@ -32,15 +36,82 @@ namespace Fluent
 
         ~VulkanSampler() override
         {
-            VkDevice device = (VkDevice)GetGraphicContext().GetDevice();
-            vkDestroySampler(device, mHandle, nullptr);
+            GetGraphicContext().DeferDestruction([handle = mHandle]()
+            {
+                VkDevice device = (VkDevice)GetGraphicContext().GetDevice();
+                vkDestroySampler(device, handle, nullptr);
+            });
         }
 
+        const SamplerDescription& GetDescription() const { return mDescription; }
         Handle GetNativeHandle() const override { return mHandle; }
     };
 
+    /// Samplers are immutable, equal descriptions share one native sampler while somebody holds it
+    static std::mutex sSamplerCacheMutex;
+    static std::unordered_multimap<size_t, std::weak_ptr<VulkanSampler>> sSamplerCache;
+
+    static size_t HashDescription(const SamplerDescription& description)
+    {
+        size_t result = 0;
+        HashCombine(result, description.magFilter);
+        HashCombine(result, description.minFilter);
+        HashCombine(result, description.mipmapMode);
+        HashCombine(result, description.addressModeU);
+        HashCombine(result, description.addressModeV);
+        HashCombine(result, description.addressModeW);
+        HashCombine(result, description.mipLodBias);
+        HashCombine(result, description.anisotropyEnable);
+        HashCombine(result, description.maxAnisotropy);
+        HashCombine(result, description.compareEnable);
+        HashCombine(result, description.compareOp);
+        HashCombine(result, description.minLod);
+        HashCombine(result, description.maxLod);
+        return result;
+    }
+
+    static bool IsSameDescription(const SamplerDescription& lhs, const SamplerDescription& rhs)
+    {
+        return lhs.magFilter == rhs.magFilter &&
+               lhs.minFilter == rhs.minFilter &&
+               lhs.mipmapMode == rhs.mipmapMode &&
+               lhs.addressModeU == rhs.addressModeU &&
+               lhs.addressModeV == rhs.addressModeV &&
+               lhs.addressModeW == rhs.addressModeW &&
+               lhs.mipLodBias == rhs.mipLodBias &&
+               lhs.anisotropyEnable == rhs.anisotropyEnable &&
+               lhs.maxAnisotropy == rhs.maxAnisotropy &&
+               lhs.compareEnable == rhs.compareEnable &&
+               lhs.compareOp == rhs.compareOp &&
+               lhs.minLod == rhs.minLod &&
+               lhs.maxLod == rhs.maxLod;
+    }
+
+    /// Interface
+
     Ref<Sampler> Sampler::Create(const SamplerDescription& description)
     {
-        return CreateRef<VulkanSampler>(description);
+        auto hash = HashDescription(description);
+
+        std::scoped_lock lock(sSamplerCacheMutex);
+        auto [begin, end] = sSamplerCache.equal_range(hash);
+        for (auto it = begin; it != end;)
+        {
+            auto cached = it->second.lock();
+            if (!cached)
+            {
+                it = sSamplerCache.erase(it);
+                continue;
+            }
+
+            if (IsSameDescription(cached->GetDescription(), description))
+                return cached;
+
+            ++it;
+        }
+
+        auto sampler = CreateRef<VulkanSampler>(description);
+        sSamplerCache.emplace(hash, sampler);
+        return sampler;
     }
 } // namespace Fluent
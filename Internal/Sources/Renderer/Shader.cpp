@@ -1,40 +1,66 @@
-#include <fstream>
+#include <cstring>
 #include <vector>
 #include "Core/FileSystem.hpp"
+#include "Core/Profiler.hpp"
 #include "Renderer/GraphicContext.hpp"
 #include "Renderer/Shader.hpp"
 
 namespace Fluent
 {
+    static std::string GetSpirvPath(const ShaderDescription& description)
+    {
+        return FileSystem::GetShadersDirectory() + description.filename + ".spv";
+    }
+
+    /// FNV-1a over words of module
+    static uint64_t HashByteCode(const std::vector<uint32_t>& byteCode)
+    {
+        uint64_t result = 14695981039346656037ull;
+        for (auto word : byteCode)
+            result = (result ^ word) * 1099511628211ull;
+        return result;
+    }
+
     class VulkanShader : public Shader
     {
     protected:
         ShaderStage                 mShaderStage;
+        std::string                 mFilename;
+        uint64_t                    mByteCodeHash;
         VkShaderModule              mHandle;
-        std::vector<ShaderType>     mInputAttributes;
+        std::vector<VertexInput>    mInputAttributes;
         std::vector<ShaderUniforms> mUniforms;
+        std::vector<PushConstantRange> mPushConstantRanges;
+        std::vector<SpecializationConstant> mSpecializationConstants;
+        std::vector<VertexInputSemantic> mInputSemantics;
 
         static std::vector<uint32_t> ReadSpirvBytecode(const std::string& filepath)
         {
-            std::ifstream file(filepath, std::ios_base::binary);
-            if (!file.is_open())
-                LOG_WARN("Failed to open file {}", filepath);
+            auto size = FileSystem::GetFileSize(filepath);
+            std::vector<uint32_t> byteCode(size / sizeof(uint32_t));
+            if (byteCode.empty() || size % sizeof(uint32_t) != 0 || !FileSystem::ReadFile(filepath, byteCode.data()))
+            {
+                LOG_CATEGORY_WARN(eShader, "Failed to open file {}", filepath);
+                byteCode.clear();
+            }
 
-            std::vector<char> res = { std::istreambuf_iterator(file), std::istreambuf_iterator<char>() };
-            return std::vector<uint32_t>(reinterpret_cast<uint32_t*>(res.data()), reinterpret_cast<uint32_t*>(res.data() + res.size()));
+            return byteCode;
         }
 
         static ShaderDescription LoadShader(const ShaderDescription& description)
         {
             ShaderDescription result = description;
-            result.byteCode = ReadSpirvBytecode(FileSystem::GetShadersDirectory() + description.filename + ".spv");
+            if (result.byteCode.empty())
+                result.byteCode = ReadSpirvBytecode(GetSpirvPath(description));
             return Reflect(result);
         }
     public:
         VulkanShader(const ShaderDescription& description)
             : mShaderStage(description.stage)
+            , mFilename(description.filename)
         {
             auto loadedDescription = LoadShader(description);
+            mByteCodeHash = HashByteCode(loadedDescription.byteCode);
             
             VkDevice device = (VkDevice)GetGraphicContext().GetDevice();
 
@@ -48,6 +74,10 @@ namespace Fluent
             if (loadedDescription.stage == ShaderStage::eVertex)
                 mInputAttributes = loadedDescription.inputAttributes;
 
+            mPushConstantRanges = loadedDescription.pushConstantRanges;
+            mSpecializationConstants = loadedDescription.specializationConstants;
+            mInputSemantics = loadedDescription.inputSemantics;
+
             auto& uniforms = mUniforms.emplace_back();
             uniforms.stage = loadedDescription.stage;
             uniforms.uniforms.insert(uniforms.uniforms.end(), loadedDescription.uniforms.begin(), loadedDescription.uniforms.end());
@@ -55,11 +85,32 @@ namespace Fluent
 
         ~VulkanShader() override
         {
-            VkDevice device = (VkDevice)GetGraphicContext().GetDevice();
-            vkDestroyShaderModule(device, mHandle, nullptr);
+            GetGraphicContext().DeferDestruction([handle = mHandle]()
+            {
+                VkDevice device = (VkDevice)GetGraphicContext().GetDevice();
+                vkDestroyShaderModule(device, handle, nullptr);
+            });
+        }
+
+        void Replace(const Ref<Shader>& reloaded) override
+        {
+            auto& other = static_cast<VulkanShader&>(*reloaded);
+            std::swap(mHandle, other.mHandle);
+            std::swap(mByteCodeHash, other.mByteCodeHash);
+            std::swap(mInputAttributes, other.mInputAttributes);
+            std::swap(mUniforms, other.mUniforms);
+            std::swap(mPushConstantRanges, other.mPushConstantRanges);
+            std::swap(mSpecializationConstants, other.mSpecializationConstants);
+            std::swap(mInputSemantics, other.mInputSemantics);
         }
 
+        const std::vector<VertexInput>& GetInputAttributes() const override { return mInputAttributes; }
         const std::vector<ShaderUniforms>& GetUniforms() const override { return mUniforms; }
+        const std::vector<PushConstantRange>& GetPushConstantRanges() const override { return mPushConstantRanges; }
+        const std::vector<SpecializationConstant>& GetSpecializationConstants() const override { return mSpecializationConstants; }
+        const std::vector<VertexInputSemantic>& GetInputSemantics() const override { return mInputSemantics; }
+        const std::string& GetFilename() const override { return mFilename; }
+        uint64_t GetByteCodeHash() const override { return mByteCodeHash; }
         ShaderStage GetStage() const override { return mShaderStage; }
         Handle GetNativeHandle() const override { return mHandle; }
     };
@@ -70,4 +121,44 @@ namespace Fluent
     {
         return CreateRef<VulkanShader>(description);
     }
+
+    void Shader::CreateBatch(const std::vector<ShaderDescription>& descriptions, ShaderBatchCallback callback)
+    {
+        PROFILE_SCOPE("Shader::CreateBatch");
+        std::vector<std::string> paths;
+        for (const auto& description : descriptions)
+        {
+            if (description.byteCode.empty())
+                paths.push_back(GetSpirvPath(description));
+        }
+
+        FileSystem::ReadFiles(paths, [descriptions, callback = std::move(callback)](std::vector<std::vector<char>>& files)
+        {
+            PROFILE_SCOPE("Shader::CreateBatch::Create");
+            std::vector<Ref<Shader>> shaders;
+            shaders.reserve(descriptions.size());
+            size_t fileIndex = 0;
+            for (const auto& description : descriptions)
+            {
+                if (!description.byteCode.empty())
+                {
+                    shaders.push_back(Create(description));
+                    continue;
+                }
+
+                /// Failed reads are left empty, so shader reports them when reading again
+                auto& file = files[fileIndex++];
+                auto loadedDescription = description;
+                if (file.size() % sizeof(uint32_t) == 0)
+                {
+                    loadedDescription.byteCode.resize(file.size() / sizeof(uint32_t));
+                    std::memcpy(loadedDescription.byteCode.data(), file.data(), file.size());
+                }
+
+                shaders.push_back(Create(loadedDescription));
+            }
+
+            callback(shaders);
+        });
+    }
 } // namespace Fluent
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <functional>
 #include <string>
 #include "Core/Base.hpp"
 #include "Renderer/Renderer.hpp"
@@ -12,10 +13,18 @@ namespace Fluent
         std::vector<uint32_t>   byteCode;
         ShaderStage             stage;
         std::string             filename;
-        std::vector<ShaderType> inputAttributes;
+        std::vector<VertexInput> inputAttributes;
         std::vector<Uniform>    uniforms;
+        std::vector<PushConstantRange> pushConstantRanges;
+        /// Values by name, after reflection contains every constant of shader
+        std::vector<SpecializationConstant> specializationConstants;
+        /// Meaning of vertex inputs whose location doesn't follow GetDefaultVertexSemantic
+        std::vector<VertexInputSemantic> inputSemantics;
     };
 
+    class Shader;
+    using ShaderBatchCallback = std::function<void(std::vector<Ref<Shader>>& shaders)>;
+
     class Shader
     {
     protected:
@@ -24,9 +33,24 @@ namespace Fluent
         virtual ~Shader() = default;
 
         virtual ShaderStage GetStage() const = 0;
+        /// Reflected inputs of vertex shader in location order, empty for other stages
+        virtual const std::vector<VertexInput>& GetInputAttributes() const = 0;
         virtual const std::vector<ShaderUniforms>& GetUniforms() const = 0;
+        virtual const std::vector<PushConstantRange>& GetPushConstantRanges() const = 0;
+        virtual const std::vector<SpecializationConstant>& GetSpecializationConstants() const = 0;
+        /// Explicit semantics of description, reflected ones are in input attributes
+        virtual const std::vector<VertexInputSemantic>& GetInputSemantics() const = 0;
+        virtual const std::string& GetFilename() const = 0;
+        /// Hash of spirv module, shaders with equal hash and description share pipelines
+        virtual uint64_t GetByteCodeHash() const = 0;
         virtual Handle GetNativeHandle() const = 0;
+
+        /// Takes module of reloaded shader, previous module is destroyed together with reloaded object
+        virtual void Replace(const Ref<Shader>& reloaded) = 0;
         
         static Ref<Shader> Create(const ShaderDescription& description);
+        /// Spirv files of all descriptions without byte code are read at once, shaders are created
+        /// in description order when reads finish, see FileSystem::ReadFiles
+        static void CreateBatch(const std::vector<ShaderDescription>& descriptions, ShaderBatchCallback callback);
     };
 } // namespace Fluent
@@ -0,0 +1,298 @@
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <future>
+#include <mutex>
+#include "Core/FileWatcher.hpp"
+#include "Renderer/GraphicContext.hpp"
+#include "Renderer/Pipeline.hpp"
+#include "Renderer/PipelineCompiler.hpp"
+#include "Renderer/ShaderHotReload.hpp"
+
+namespace Fluent
+{
+    static std::mutex sPipelinesMutex;
+    static std::vector<std::weak_ptr<Pipeline>> sPipelines;
+    /// Pipelines are registered only while some hot reload exists
+    static uint32_t sHotReloadCount = 0;
+
+    static constexpr const char* SPIRV_EXTENSION = ".spv";
+
+    /// sPipelinesMutex should be locked
+    static void PruneExpiredPipelines()
+    {
+        sPipelines.erase(std::remove_if(sPipelines.begin(), sPipelines.end(),
+            [](const auto& pipeline) { return pipeline.expired(); }), sPipelines.end());
+    }
+
+    class VulkanShaderHotReload : public ShaderHotReload
+    {
+        struct ReloadResult
+        {
+            std::string                                     filename;
+            bool                                            failed = false;
+            std::vector<Ref<Pipeline>>                      dependents;
+            /// Original shader and shader loaded from changed file
+            std::vector<std::pair<Ref<Shader>, Ref<Shader>>> shaders;
+            std::vector<std::pair<Ref<Pipeline>, Handle>>   pipelines;
+        };
+    private:
+        Scope<FileWatcher>          mFileWatcher;
+        PipelineCompiler*           mPipelineCompiler;
+        std::deque<std::string>     mQueuedFiles;
+        std::future<ReloadResult>   mPendingReload;
+
+        static bool IsSameLayout(const Shader& lhs, const Shader& rhs)
+        {
+            auto& lhsUniforms = lhs.GetUniforms();
+            auto& rhsUniforms = rhs.GetUniforms();
+            if (lhsUniforms.size() != rhsUniforms.size())
+                return false;
+
+            for (size_t i = 0; i < lhsUniforms.size(); ++i)
+            {
+                auto& lhsStage = lhsUniforms[i].uniforms;
+                auto& rhsStage = rhsUniforms[i].uniforms;
+                if (lhsStage.size() != rhsStage.size())
+                    return false;
+
+                for (size_t j = 0; j < lhsStage.size(); ++j)
+                {
+                    if (lhsStage[j].set != rhsStage[j].set ||
+                        lhsStage[j].binding != rhsStage[j].binding ||
+                        lhsStage[j].descriptorType != rhsStage[j].descriptorType ||
+                        lhsStage[j].descriptorCount != rhsStage[j].descriptorCount)
+                        return false;
+                }
+            }
+
+            auto& lhsRanges = lhs.GetPushConstantRanges();
+            auto& rhsRanges = rhs.GetPushConstantRanges();
+            return std::equal(lhsRanges.begin(), lhsRanges.end(), rhsRanges.begin(), rhsRanges.end(), [](const auto& l, const auto& r)
+            {
+                return l.offset == r.offset && l.size == r.size;
+            });
+        }
+
+        /// Runs on worker thread. Everything created here is returned to main thread,
+        /// so deferred destruction is never called concurrently with frame
+        static ReloadResult Reload(std::string filename, std::vector<Ref<Pipeline>> dependents)
+        {
+            ReloadResult result;
+            result.filename = std::move(filename);
+            result.dependents = std::move(dependents);
+
+            try
+            {
+                for (auto& pipeline : result.dependents)
+                {
+                    auto shaders = pipeline->GetDescription().descriptorSetLayout->GetShaders();
+                    for (auto& shader : shaders)
+                    {
+                        if (shader->GetFilename() != result.filename)
+                            continue;
+
+                        auto it = std::find_if(result.shaders.begin(), result.shaders.end(),
+                            [&shader](const auto& pair) { return pair.first == shader; });
+
+                        if (it == result.shaders.end())
+                        {
+                            ShaderDescription shaderDescription{};
+                            shaderDescription.stage = shader->GetStage();
+                            shaderDescription.filename = result.filename;
+                            shaderDescription.specializationConstants = shader->GetSpecializationConstants();
+                            shaderDescription.inputSemantics = shader->GetInputSemantics();
+
+                            auto reloaded = Shader::Create(shaderDescription);
+                            result.shaders.emplace_back(shader, reloaded);
+
+                            /// Descriptor sets were allocated with old layout
+                            if (!IsSameLayout(*shader, *reloaded))
+                            {
+                                LOG_CATEGORY_WARN(eShader, "Shader {} changed its resource layout, restart is required", result.filename);
+                                result.failed = true;
+                                return result;
+                            }
+
+                            shader = reloaded;
+                        }
+                        else
+                        {
+                            shader = it->second;
+                        }
+                    }
+
+                    auto handle = pipeline->Rebuild(shaders);
+                    if (!handle)
+                    {
+                        LOG_CATEGORY_ERROR(eShader, "Failed to rebuild pipeline with shader {}", result.filename);
+                        result.failed = true;
+                        return result;
+                    }
+
+                    result.pipelines.emplace_back(pipeline, handle);
+                }
+            }
+            catch (const std::exception& e)
+            {
+                LOG_CATEGORY_ERROR(eShader, "Failed to reload shader {}: {}", result.filename, e.what());
+                result.failed = true;
+            }
+
+            return result;
+        }
+
+        void Apply(ReloadResult& result)
+        {
+            if (result.failed)
+            {
+                for (auto& [pipeline, handle] : result.pipelines)
+                {
+                    GetGraphicContext().DeferDestruction([handle = handle]()
+                    {
+                        VkDevice device = (VkDevice)GetGraphicContext().GetDevice();
+                        vkDestroyPipeline(device, (VkPipeline)handle, nullptr);
+                    });
+                }
+                return;
+            }
+
+            /// Old modules go to reloaded shaders and are destroyed with them
+            if (mPipelineCompiler)
+                mPipelineCompiler->Pause();
+
+            for (auto& [shader, reloaded] : result.shaders)
+                shader->Replace(reloaded);
+
+            for (auto& [pipeline, handle] : result.pipelines)
+                pipeline->Replace(handle);
+
+            if (mPipelineCompiler)
+                mPipelineCompiler->Resume();
+
+            LOG_CATEGORY_INFO(eShader, "Shader {} reloaded, {} pipelines rebuilt", result.filename, result.pipelines.size());
+        }
+    public:
+        explicit VulkanShaderHotReload(const ShaderHotReloadDescription& description)
+            : mPipelineCompiler(description.pipelineCompiler)
+        {
+            if (!description.directory.empty())
+                Watch(description.directory);
+
+            std::scoped_lock lock(sPipelinesMutex);
+            sHotReloadCount++;
+        }
+
+        ~VulkanShaderHotReload() override
+        {
+            {
+                std::scoped_lock lock(sPipelinesMutex);
+                if (--sHotReloadCount == 0)
+                    sPipelines = {};
+            }
+
+            if (!mPendingReload.valid())
+                return;
+
+            /// Discard result but release it on this thread
+            auto result = mPendingReload.get();
+            result.failed = true;
+            Apply(result);
+        }
+
+        void Update() override
+        {
+            if (!mFileWatcher)
+                return;
+
+            for (auto& path : mFileWatcher->PollChanges())
+            {
+                /// Only compiled spirv is reloaded, glsl is compiled by external tool
+                auto extensionLength = std::char_traits<char>::length(SPIRV_EXTENSION);
+                if (path.size() <= extensionLength || path.compare(path.size() - extensionLength, extensionLength, SPIRV_EXTENSION) != 0)
+                    continue;
+
+                auto filename = path.substr(0, path.size() - extensionLength);
+                if (std::find(mQueuedFiles.begin(), mQueuedFiles.end(), filename) == mQueuedFiles.end())
+                    mQueuedFiles.emplace_back(std::move(filename));
+            }
+
+            if (mPendingReload.valid())
+            {
+                if (mPendingReload.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+                    return;
+
+                auto result = mPendingReload.get();
+                Apply(result);
+            }
+
+            /// One reload at a time, so worker never reads shaders which are replaced here
+            while (!mQueuedFiles.empty())
+            {
+                auto filename = std::move(mQueuedFiles.front());
+                mQueuedFiles.pop_front();
+
+                auto dependents = GetDependentPipelines(filename);
+                if (dependents.empty())
+                    continue;
+
+                mPendingReload = std::async(std::launch::async, &VulkanShaderHotReload::Reload, std::move(filename), std::move(dependents));
+                break;
+            }
+        }
+
+        void Watch(const std::string& directory) override
+        {
+            /// Changes queued from previous directory are relative to it
+            mQueuedFiles.clear();
+
+            FileWatcherDescription fileWatcherDescription{};
+            fileWatcherDescription.directory = directory;
+            fileWatcherDescription.recursive = true;
+            mFileWatcher = FileWatcher::Create(fileWatcherDescription);
+        }
+    };
+
+    /// Interface
+
+    void ShaderHotReload::RegisterPipeline(const Ref<Pipeline>& pipeline)
+    {
+        std::scoped_lock lock(sPipelinesMutex);
+        if (sHotReloadCount == 0)
+            return;
+
+        /// Pruned before vector grows, so released pipelines don't accumulate and cost stays amortized
+        if (sPipelines.size() == sPipelines.capacity())
+            PruneExpiredPipelines();
+        sPipelines.emplace_back(pipeline);
+    }
+
+    std::vector<Ref<Pipeline>> ShaderHotReload::GetDependentPipelines(const std::string& filename)
+    {
+        std::vector<Ref<Pipeline>> result;
+
+        std::scoped_lock lock(sPipelinesMutex);
+        PruneExpiredPipelines();
+
+        for (auto& weakPipeline : sPipelines)
+        {
+            auto pipeline = weakPipeline.lock();
+            if (!pipeline)
+                continue;
+
+            auto& shaders = pipeline->GetDescription().descriptorSetLayout->GetShaders();
+            bool dependent = std::any_of(shaders.begin(), shaders.end(),
+                [&filename](const auto& shader) { return shader->GetFilename() == filename; });
+
+            if (dependent)
+                result.emplace_back(std::move(pipeline));
+        }
+
+        return result;
+    }
+
+    Scope<ShaderHotReload> ShaderHotReload::Create(const ShaderHotReloadDescription& description)
+    {
+        return CreateScope<VulkanShaderHotReload>(description);
+    }
+} // namespace Fluent
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "Core/Base.hpp"
+
+namespace Fluent
+{
+    class Pipeline;
+    class PipelineCompiler;
+
+    struct ShaderHotReloadDescription
+    {
+        /// Optional, directory can be set later with Watch
+        std::string directory;
+        /// Paused while shaders are replaced, its workers read shader modules
+        PipelineCompiler* pipelineCompiler = nullptr;
+    };
+
+    class ShaderHotReload
+    {
+    protected:
+        ShaderHotReload() = default;
+    public:
+        virtual ~ShaderHotReload() = default;
+
+        /// Should be called between frames. Starts rebuild of pipelines which depend on changed
+        /// spirv files and swaps pipelines finished on worker thread
+        virtual void Update() = 0;
+        /// Replaces watched directory. Hot reload can be created before directory is known, so
+        /// pipelines created in between are registered and reloaded too
+        virtual void Watch(const std::string& directory) = 0;
+
+        /// Pipeline::Create registers every pipeline while some hot reload exists, registry keeps
+        /// only weak references. Pipelines created before hot reload are not reloaded
+        static void RegisterPipeline(const Ref<Pipeline>& pipeline);
+        /// Registered pipelines which use shader with filename relative to shaders directory
+        static std::vector<Ref<Pipeline>> GetDependentPipelines(const std::string& filename);
+
+        static Scope<ShaderHotReload> Create(const ShaderHotReloadDescription& description);
+    };
+} // namespace Fluent
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <limits>
 #include <spirv_glsl.hpp>
 #include "Core/Base.hpp"
 #include "Renderer/Shader.hpp"
@@ -57,15 +59,45 @@ namespace Fluent
         return ShaderType{ format, componentCount, byteSize };
     }
 
+    VkShaderStageFlags GetPushConstantStages(const std::vector<PushConstantRange>& ranges, uint32_t offset, uint32_t size)
+    {
+        VkShaderStageFlags stageFlags = 0;
+        for (const auto& range : ranges)
+        {
+            if (offset >= range.offset + range.size || range.offset >= offset + size)
+                continue;
+
+            if (offset < range.offset || offset + size > range.offset + range.size)
+                return 0;
+
+            stageFlags |= ToVulkanShaderStage(range.stage);
+        }
+
+        return stageFlags;
+    }
+
+    VertexSemantic GetDefaultVertexSemantic(uint32_t location)
+    {
+        switch (location)
+        {
+            case 0: return VertexSemantic::ePosition;
+            case 1: return VertexSemantic::eNormal;
+            case 2: return VertexSemantic::eTexCoord;
+            case 3: return VertexSemantic::eTangent;
+            case 4: return VertexSemantic::eBitangent;
+            default: return VertexSemantic::eUnknown;
+        }
+    }
+
     ShaderDescription& Reflect(ShaderDescription& description)
     {
         switch (description.stage)
         {
             case ShaderStage::eVertex:
-                LOG_TRACE("[ VERTEX SHADER ]");
+                LOG_CATEGORY_TRACE(eShader, "[ VERTEX SHADER ]");
                 break;
             case ShaderStage::eFragment:
-                LOG_TRACE("[ FRAGMENT SHADER ]");
+                LOG_CATEGORY_TRACE(eShader, "[ FRAGMENT SHADER ]");
                 break;
             default:
                 break;
@@ -83,88 +115,180 @@ namespace Fluent
                     compiler.get_decoration(v2.id, spv::Decoration::DecorationLocation);
             });
 
+        auto activeVariables = compiler.get_active_interface_variables();
         for (const auto& inputAttribute : inputAttributes)
         {
-            description.inputAttributes.push_back(GetTypeByReflection(compiler, inputAttribute));
+            auto& input = description.inputAttributes.emplace_back();
+            input.name = inputAttribute.name;
+            input.location = compiler.get_decoration(inputAttribute.id, spv::Decoration::DecorationLocation);
+            input.type = GetTypeByReflection(compiler, inputAttribute);
+            auto explicitSemantic = std::find_if(description.inputSemantics.begin(), description.inputSemantics.end(), [&input](const auto& semantic)
+            {
+                return semantic.location == input.location;
+            });
+            input.semantic = explicitSemantic != description.inputSemantics.end() ? explicitSemantic->semantic : GetDefaultVertexSemantic(input.location);
+            input.used = activeVariables.count(inputAttribute.id) != 0;
+            LOG_CATEGORY_TRACE(eShader, "Input: {} location {} used {}", input.name, input.location, input.used);
         }
 
-        LOG_TRACE("UNIFORM BUFFERS:");
+        LOG_CATEGORY_TRACE(eShader, "UNIFORM BUFFERS:");
         for (auto& uniformBuffer : resources.uniform_buffers)
         {
             auto& uniform = description.uniforms.emplace_back();
             uniform.descriptorCount = 1;
             uniform.descriptorType = DescriptorType::eUniformBuffer;
             uniform.binding = compiler.get_decoration(uniformBuffer.id, spv::Decoration::DecorationBinding);
+            uniform.set = compiler.get_decoration(uniformBuffer.id, spv::Decoration::DecorationDescriptorSet);
 
             for (auto count : compiler.get_type(uniformBuffer.type_id).array)
                 uniform.descriptorCount *= count;
-            LOG_TRACE("Name: {}", uniformBuffer.name);
-            LOG_TRACE("Binding: {}", uniform.binding);
-            LOG_TRACE("Descriptor count: {}", uniform.descriptorCount);
-            LOG_TRACE("Width: {}", compiler.get_type(uniformBuffer.base_type_id).width);
-            LOG_TRACE("Vecsize: {}", compiler.get_type(uniformBuffer.base_type_id).vecsize);
-            LOG_TRACE("Columns: {}", compiler.get_type(uniformBuffer.base_type_id).columns);
+            LOG_CATEGORY_TRACE(eShader, "Name: {}", uniformBuffer.name);
+            LOG_CATEGORY_TRACE(eShader, "Binding: {}", uniform.binding);
+            LOG_CATEGORY_TRACE(eShader, "Descriptor count: {}", uniform.descriptorCount);
+            LOG_CATEGORY_TRACE(eShader, "Width: {}", compiler.get_type(uniformBuffer.base_type_id).width);
+            LOG_CATEGORY_TRACE(eShader, "Vecsize: {}", compiler.get_type(uniformBuffer.base_type_id).vecsize);
+            LOG_CATEGORY_TRACE(eShader, "Columns: {}", compiler.get_type(uniformBuffer.base_type_id).columns);
+        }
+
+        LOG_CATEGORY_TRACE(eShader, "STORAGE BUFFERS:");
+        for (auto& storageBuffer : resources.storage_buffers)
+        {
+            auto& uniform = description.uniforms.emplace_back();
+            uniform.descriptorCount = 1;
+            uniform.descriptorType = DescriptorType::eStorageBuffer;
+            uniform.binding = compiler.get_decoration(storageBuffer.id, spv::Decoration::DecorationBinding);
+            uniform.set = compiler.get_decoration(storageBuffer.id, spv::Decoration::DecorationDescriptorSet);
+
+            for (auto count : compiler.get_type(storageBuffer.type_id).array)
+                uniform.descriptorCount *= count;
+            LOG_CATEGORY_TRACE(eShader, "Name: {}", storageBuffer.name);
+            LOG_CATEGORY_TRACE(eShader, "Binding: {}", uniform.binding);
+            LOG_CATEGORY_TRACE(eShader, "Descriptor count: {}", uniform.descriptorCount);
         }
 
-        LOG_TRACE("SEPARATE SAMPLERS:");
+        LOG_CATEGORY_TRACE(eShader, "SEPARATE SAMPLERS:");
 
         for (auto& sampler : resources.separate_samplers)
         {
             auto& uniform = description.uniforms.emplace_back();
             uniform.descriptorType = DescriptorType::eSampler;
             uniform.binding = compiler.get_decoration(sampler.id, spv::Decoration::DecorationBinding);
+            uniform.set = compiler.get_decoration(sampler.id, spv::Decoration::DecorationDescriptorSet);
 
             for (auto count : compiler.get_type(sampler.type_id).array)
                 uniform.descriptorCount *= count;
 
-            LOG_TRACE("Name: {}", sampler.name);
-            LOG_TRACE("Set: {}", compiler.get_decoration(sampler.id, spv::Decoration::DecorationDescriptorSet));
-            LOG_TRACE("Binding: {}", compiler.get_decoration(sampler.id, spv::Decoration::DecorationBinding));
-            LOG_TRACE("Width: {}", compiler.get_type(sampler.base_type_id).width);
-            LOG_TRACE("Vecsize: {}", compiler.get_type(sampler.base_type_id).vecsize);
-            LOG_TRACE("Columns: {}", compiler.get_type(sampler.base_type_id).columns);
+            LOG_CATEGORY_TRACE(eShader, "Name: {}", sampler.name);
+            LOG_CATEGORY_TRACE(eShader, "Set: {}", compiler.get_decoration(sampler.id, spv::Decoration::DecorationDescriptorSet));
+            LOG_CATEGORY_TRACE(eShader, "Binding: {}", compiler.get_decoration(sampler.id, spv::Decoration::DecorationBinding));
+            LOG_CATEGORY_TRACE(eShader, "Width: {}", compiler.get_type(sampler.base_type_id).width);
+            LOG_CATEGORY_TRACE(eShader, "Vecsize: {}", compiler.get_type(sampler.base_type_id).vecsize);
+            LOG_CATEGORY_TRACE(eShader, "Columns: {}", compiler.get_type(sampler.base_type_id).columns);
         }
 
-        LOG_TRACE("SEPARATE IMAGES:");
+        LOG_CATEGORY_TRACE(eShader, "SEPARATE IMAGES:");
 
         for (auto& image : resources.separate_images)
         {
             auto& uniform = description.uniforms.emplace_back();
             uniform.descriptorType = DescriptorType::eSampledImage;
             uniform.binding = compiler.get_decoration(image.id, spv::Decoration::DecorationBinding);
+            uniform.set = compiler.get_decoration(image.id, spv::Decoration::DecorationDescriptorSet);
 
             // Here I try to count descriptors if it's array
             for (auto count : compiler.get_type(image.type_id).array)
                 uniform.descriptorCount *= count;
 
-            LOG_TRACE("Name: {}", image.name);
-            LOG_TRACE("Set: {}", compiler.get_decoration(image.id, spv::Decoration::DecorationDescriptorSet));
-            LOG_TRACE("Binding: {}", compiler.get_decoration(image.id, spv::Decoration::DecorationBinding));
-            LOG_TRACE("Width: {}", compiler.get_type(image.base_type_id).width);
-            LOG_TRACE("Vecsize: {}", compiler.get_type(image.base_type_id).vecsize);
-            LOG_TRACE("Columns: {}", compiler.get_type(image.base_type_id).columns);
+            LOG_CATEGORY_TRACE(eShader, "Name: {}", image.name);
+            LOG_CATEGORY_TRACE(eShader, "Set: {}", compiler.get_decoration(image.id, spv::Decoration::DecorationDescriptorSet));
+            LOG_CATEGORY_TRACE(eShader, "Binding: {}", compiler.get_decoration(image.id, spv::Decoration::DecorationBinding));
+            LOG_CATEGORY_TRACE(eShader, "Width: {}", compiler.get_type(image.base_type_id).width);
+            LOG_CATEGORY_TRACE(eShader, "Vecsize: {}", compiler.get_type(image.base_type_id).vecsize);
+            LOG_CATEGORY_TRACE(eShader, "Columns: {}", compiler.get_type(image.base_type_id).columns);
         }
 
-        LOG_TRACE("STORAGE IMAGES:");
+        LOG_CATEGORY_TRACE(eShader, "STORAGE IMAGES:");
 
         for (auto& image : resources.storage_images)
         {
             auto& uniform = description.uniforms.emplace_back();
             uniform.descriptorType = DescriptorType::eStorageImage;
             uniform.binding = compiler.get_decoration(image.id, spv::Decoration::DecorationBinding);
+            uniform.set = compiler.get_decoration(image.id, spv::Decoration::DecorationDescriptorSet);
 
             // Here I try to count descriptors if it's array
             for (auto count : compiler.get_type(image.type_id).array)
                 uniform.descriptorCount *= count;
 
-            LOG_TRACE("Name: {}", image.name);
-            LOG_TRACE("Set: {}", compiler.get_decoration(image.id, spv::Decoration::DecorationDescriptorSet));
-            LOG_TRACE("Binding: {}", compiler.get_decoration(image.id, spv::Decoration::DecorationBinding));
-            LOG_TRACE("Width: {}", compiler.get_type(image.base_type_id).width);
-            LOG_TRACE("Vecsize: {}", compiler.get_type(image.base_type_id).vecsize);
-            LOG_TRACE("Columns: {}", compiler.get_type(image.base_type_id).columns);
+            LOG_CATEGORY_TRACE(eShader, "Name: {}", image.name);
+            LOG_CATEGORY_TRACE(eShader, "Set: {}", compiler.get_decoration(image.id, spv::Decoration::DecorationDescriptorSet));
+            LOG_CATEGORY_TRACE(eShader, "Binding: {}", compiler.get_decoration(image.id, spv::Decoration::DecorationBinding));
+            LOG_CATEGORY_TRACE(eShader, "Width: {}", compiler.get_type(image.base_type_id).width);
+            LOG_CATEGORY_TRACE(eShader, "Vecsize: {}", compiler.get_type(image.base_type_id).vecsize);
+            LOG_CATEGORY_TRACE(eShader, "Columns: {}", compiler.get_type(image.base_type_id).columns);
         }
 
+        LOG_CATEGORY_TRACE(eShader, "PUSH CONSTANTS:");
+
+        for (auto& pushConstant : resources.push_constant_buffers)
+        {
+            auto& type = compiler.get_type(pushConstant.base_type_id);
+            if (type.member_types.empty())
+                continue;
+
+            /// Block can start with explicit offset when other stages use beginning of it
+            uint32_t offset = std::numeric_limits<uint32_t>::max();
+            for (uint32_t i = 0; i < type.member_types.size(); ++i)
+                offset = std::min(offset, compiler.type_struct_member_offset(type, i));
+
+            auto& range = description.pushConstantRanges.emplace_back();
+            range.stage = description.stage;
+            range.offset = offset;
+            range.size = static_cast<uint32_t>(compiler.get_declared_struct_size(type)) - offset;
+
+            LOG_CATEGORY_TRACE(eShader, "Name: {}", pushConstant.name);
+            LOG_CATEGORY_TRACE(eShader, "Offset: {}", range.offset);
+            LOG_CATEGORY_TRACE(eShader, "Size: {}", range.size);
+        }
+
+        LOG_CATEGORY_TRACE(eShader, "SPECIALIZATION CONSTANTS:");
+
+        std::vector<SpecializationConstant> specializationConstants;
+        for (auto& constant : compiler.get_specialization_constants())
+        {
+            auto& type = compiler.get_type(compiler.get_constant(constant.id).constant_type);
+            if (type.width > 32)
+            {
+                LOG_CATEGORY_WARN(eShader, "Specialization constant {} is not 32 bit and will not be specialized", compiler.get_name(constant.id));
+                continue;
+            }
+
+            auto& specializationConstant = specializationConstants.emplace_back();
+            specializationConstant.name = compiler.get_name(constant.id);
+            specializationConstant.constantId = constant.constant_id;
+            specializationConstant.value = compiler.get_constant(constant.id).scalar();
+
+            LOG_CATEGORY_TRACE(eShader, "Name: {}", specializationConstant.name);
+            LOG_CATEGORY_TRACE(eShader, "Constant id: {}", specializationConstant.constantId);
+            LOG_CATEGORY_TRACE(eShader, "Default value: {}", specializationConstant.value);
+        }
+
+        for (const auto& requested : description.specializationConstants)
+        {
+            auto it = std::find_if(specializationConstants.begin(), specializationConstants.end(),
+                [&requested](const auto& constant) { return constant.name == requested.name; });
+
+            if (it == specializationConstants.end())
+            {
+                LOG_CATEGORY_WARN(eShader, "Shader {} has no specialization constant {}", description.filename, requested.name);
+                continue;
+            }
+
+            it->value = requested.value;
+        }
+
+        description.specializationConstants = std::move(specializationConstants);
+
         return description;
     }
 } // namespace Fluent
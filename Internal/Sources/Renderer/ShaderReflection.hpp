@@ -1,6 +1,10 @@
 #pragma once
 
 #include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
 #include "Renderer/Renderer.hpp"
 
 namespace Fluent
@@ -14,11 +18,36 @@ namespace Fluent
         uint32_t byteSize;
     };
 
+    struct VertexInput
+    {
+        std::string    name;
+        uint32_t       location;
+        ShaderType     type;
+        VertexSemantic semantic = VertexSemantic::eUnknown;
+        /// Declared inputs which main never reads don't need a stream
+        bool           used = true;
+    };
+
+    /// Explicit meaning of vertex shader input at location
+    struct VertexInputSemantic
+    {
+        uint32_t       location = 0;
+        VertexSemantic semantic = VertexSemantic::eUnknown;
+    };
+
     struct Uniform
     {
         DescriptorType descriptorType;
         uint32_t       binding;
         uint32_t       descriptorCount = 1;
+        uint32_t       set = 0;
+    };
+
+    struct PushConstantRange
+    {
+        ShaderStage stage;
+        uint32_t    offset;
+        uint32_t    size;
     };
 
     struct ShaderUniforms
@@ -27,5 +56,37 @@ namespace Fluent
         std::vector<Uniform> uniforms;
     };
 
+    struct SpecializationConstant
+    {
+        std::string name;
+        uint32_t    constantId = 0;
+        /// Raw 32 bit value of bool, int, uint or float constant
+        uint32_t    value = 0;
+    };
+
+    template<typename T>
+    SpecializationConstant MakeSpecializationConstant(const std::string& name, T value)
+    {
+        static_assert(sizeof(T) <= sizeof(uint32_t), "Only 32 bit specialization constants are supported");
+
+        SpecializationConstant result{};
+        result.name = name;
+        if constexpr (std::is_same_v<T, bool>)
+            result.value = value ? 1 : 0;
+        else
+            std::memcpy(&result.value, &value, sizeof(T));
+        return result;
+    }
+
+    /// Stages whose ranges contain whole write. Every range overlapping written bytes must be passed to
+    /// vkCmdPushConstants, so 0 is returned when one of them contains only part of the write
+    VkShaderStageFlags GetPushConstantStages(const std::vector<PushConstantRange>& ranges, uint32_t offset, uint32_t size);
+
+    /// Semantic of input at location in layout of ModelLoader with every stream loaded: position 0,
+    /// normal 1, tex coord 2, tangent 3, bitangent 4. Other locations are unknown and matched by location
+    VertexSemantic GetDefaultVertexSemantic(uint32_t location);
+
+    /// Fills input attributes, uniforms and specialization constants.
+    /// Requested specialization constants are matched by name, others keep default values
     ShaderDescription& Reflect(ShaderDescription& description);
 } // namespace Fluent
@@ -0,0 +1,171 @@
+#version 460
+
+/// Single pass mip chain generation in the style of AMD FidelityFX SPD. Every work group reduces
+/// 64x64 texels of mip 0 to mips 1-6, the last finished group reduces mip 6 to mips 7-12
+
+layout (local_size_x = 256) in;
+
+#define MAX_MIP_COUNT 12
+
+layout (set = 0, binding = 0) uniform texture2D uSource;
+layout (set = 0, binding = 1) uniform sampler uSampler;
+/// Storage views are unorm for srgb images, values are encoded before store
+layout (set = 0, binding = 2) writeonly uniform image2D uMips[MAX_MIP_COUNT];
+layout (set = 0, binding = 3, std430) coherent buffer Global
+{
+    uint counter;
+    uint padding[3];
+    /// Mip 6 of every work group, read by last one
+    vec4 mip6[64 * 64];
+} uGlobal;
+
+layout (push_constant) uniform constants
+{
+    uvec2 size;
+    uint mipCount;
+    uint workGroupCount;
+    uint srgb;
+} PushConstants;
+
+shared vec4 sTile[16][16];
+shared uint sCounter;
+
+uvec2 MipSize(uint mip)
+{
+    return max(PushConstants.size >> mip, uvec2(1));
+}
+
+vec3 LinearToSrgb(vec3 color)
+{
+    return mix(color * 12.92, 1.055 * pow(color, vec3(1.0 / 2.4)) - 0.055, greaterThan(color, vec3(0.0031308)));
+}
+
+/// Array is indexed by constants only, dynamic indexing of storage image arrays is an optional feature
+void Store(uint mip, uvec2 coord, vec4 value)
+{
+    if (mip > PushConstants.mipCount || any(greaterThanEqual(coord, MipSize(mip))))
+        return;
+
+    if (PushConstants.srgb != 0)
+        value.rgb = LinearToSrgb(value.rgb);
+
+    ivec2 p = ivec2(coord);
+    switch (mip)
+    {
+        case 1u: imageStore(uMips[0], p, value); break;
+        case 2u: imageStore(uMips[1], p, value); break;
+        case 3u: imageStore(uMips[2], p, value); break;
+        case 4u: imageStore(uMips[3], p, value); break;
+        case 5u: imageStore(uMips[4], p, value); break;
+        case 6u: imageStore(uMips[5], p, value); break;
+        case 7u: imageStore(uMips[6], p, value); break;
+        case 8u: imageStore(uMips[7], p, value); break;
+        case 9u: imageStore(uMips[8], p, value); break;
+        case 10u: imageStore(uMips[9], p, value); break;
+        case 11u: imageStore(uMips[10], p, value); break;
+        case 12u: imageStore(uMips[11], p, value); break;
+    }
+}
+
+/// Bilinear sample at texel center of mip 1 covers 2x2 texels of mip 0, for odd sizes footprint is weighted
+vec4 SampleSource(uvec2 coord)
+{
+    vec2 uv = (vec2(coord) + 0.5) / vec2(MipSize(1));
+    return textureLod(sampler2D(uSource, uSampler), uv, 0.0);
+}
+
+vec4 LoadMip6(uvec2 coord)
+{
+    uvec2 p = min(coord, MipSize(6) - 1u);
+    return uGlobal.mip6[p.y * 64 + p.x];
+}
+
+/// Thread writes 2x2 texels of first mip and their average to second one, tile keeps second mip
+void ReduceFirstMips(uint mip, uvec2 tileOrigin, bool fromSource)
+{
+    uvec2 thread = uvec2(gl_LocalInvocationIndex % 16, gl_LocalInvocationIndex / 16);
+    uvec2 base = tileOrigin * 32 + thread * 2;
+
+    vec4 sum = vec4(0.0);
+    for (uint i = 0; i < 4; ++i)
+    {
+        uvec2 coord = base + uvec2(i % 2, i / 2);
+        vec4 value;
+        if (fromSource)
+        {
+            value = SampleSource(coord);
+        }
+        else
+        {
+            uvec2 src = coord * 2;
+            value = (LoadMip6(src) + LoadMip6(src + uvec2(1, 0)) + LoadMip6(src + uvec2(0, 1)) + LoadMip6(src + uvec2(1, 1))) * 0.25;
+        }
+
+        Store(mip, coord, value);
+        sum += value;
+    }
+
+    vec4 average = sum * 0.25;
+    Store(mip + 1, tileOrigin * 16 + thread, average);
+    sTile[thread.y][thread.x] = average;
+    barrier();
+}
+
+/// Halves tile from 16x16 down to 1x1 writing mips after first two
+vec4 ReduceTile(uint mip, uvec2 tileOrigin)
+{
+    vec4 average = vec4(0.0);
+    for (uint size = 8; size > 0; size /= 2, ++mip)
+    {
+        uvec2 thread = uvec2(gl_LocalInvocationIndex % size, gl_LocalInvocationIndex / size);
+        bool active = gl_LocalInvocationIndex < size * size;
+        if (active)
+        {
+            uvec2 src = thread * 2;
+            average = (sTile[src.y][src.x] + sTile[src.y][src.x + 1] + sTile[src.y + 1][src.x] + sTile[src.y + 1][src.x + 1]) * 0.25;
+        }
+        barrier();
+
+        if (active)
+        {
+            sTile[thread.y][thread.x] = average;
+            Store(mip, tileOrigin * size + thread, average);
+        }
+        barrier();
+    }
+
+    return average;
+}
+
+void main()
+{
+    uvec2 workGroup = gl_WorkGroupID.xy;
+
+    ReduceFirstMips(1, workGroup, true);
+    if (PushConstants.mipCount <= 2)
+        return;
+
+    vec4 mip6 = ReduceTile(3, workGroup);
+    if (PushConstants.mipCount <= 6)
+        return;
+
+    if (gl_LocalInvocationIndex == 0)
+    {
+        uGlobal.mip6[workGroup.y * 64 + workGroup.x] = mip6;
+        memoryBarrierBuffer();
+        sCounter = atomicAdd(uGlobal.counter, 1u);
+    }
+    barrier();
+
+    if (sCounter != PushConstants.workGroupCount - 1u)
+        return;
+
+    memoryBarrierBuffer();
+    ReduceFirstMips(7, uvec2(0), false);
+    if (PushConstants.mipCount > 8)
+        ReduceTile(9, uvec2(0));
+
+    /// Ready for next dispatch
+    if (gl_LocalInvocationIndex == 0)
+        uGlobal.counter = 0;
+}
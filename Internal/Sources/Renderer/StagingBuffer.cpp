@@ -16,6 +16,7 @@ namespace Fluent
             bufferDesc.bufferUsage = BufferUsage::eTransferSrc;
             bufferDesc.memoryUsage = MemoryUsage::eCpu;
             bufferDesc.size = description.size;
+            bufferDesc.memoryTag = MemoryTag::eStaging;
 
             mBuffer = Buffer::Create(bufferDesc);
             mBuffer->MapMemory();
@@ -31,8 +32,9 @@ namespace Fluent
         {
             if (mCurrentOffset + byteSize > mBuffer->GetSize())
             {
-                LOG_ERROR
+                LOG_CATEGORY_ERROR
                 (
+                    eRenderer,
                     "Staging buffer free space less than data to write. Write size {} Buffer Size {} Free Space {}", 
                     byteSize, mBuffer->GetSize(), mBuffer->GetSize() - mCurrentOffset
                 );
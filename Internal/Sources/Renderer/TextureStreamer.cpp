@@ -0,0 +1,617 @@
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <tinyimageformat_base.h>
+#include "Core/FileSystem.hpp"
+#include "Core/Profiler.hpp"
+#include "Renderer/CommandBuffer.hpp"
+#include "Renderer/GraphicContext.hpp"
+#include "Renderer/KtxStream.hpp"
+#include "Renderer/StagingBuffer.hpp"
+#include "Renderer/TextureStreamer.hpp"
+
+namespace Fluent
+{
+    /// Copy offsets of mips in staging buffer
+    static constexpr uint32_t STREAM_DATA_ALIGNMENT = 16;
+
+    /// Reads separate mips of ktx file, each mip is read only when requested.
+    /// Archived files are read from memory, loose files through stream
+    class KtxReader
+    {
+    private:
+        std::ifstream           mStream;
+        KtxMemoryStream         mMemory;
+        /// Compressed archive entry
+        std::vector<char>       mStorage;
+        TinyKtx_ContextHandle   mContext = nullptr;
+        bool                    mValid = false;
+    public:
+        explicit KtxReader(const std::string& filename)
+        {
+            auto path = FileSystem::GetTexturesDirectory() + filename;
+            void* user = nullptr;
+            TinyKtx_Callbacks callbacks;
+            if (FileSystem::IsArchived(path))
+            {
+                mMemory.data = static_cast<const char*>(FileSystem::MapFile(path));
+                if (!mMemory.data)
+                {
+                    mStorage = FileSystem::ReadFile(path);
+                    mMemory.data = mStorage.data();
+                }
+
+                mMemory.size = mMemory.data ? FileSystem::GetFileSize(path) : 0;
+                user = &mMemory;
+                callbacks = GetKtxMemoryStreamCallbacks();
+            }
+            else
+            {
+                mStream.open(path, std::ios::binary);
+                user = &mStream;
+                callbacks = GetKtxFileStreamCallbacks();
+            }
+
+            if (user == &mStream ? !mStream.is_open() : mMemory.size == 0)
+                return;
+
+            mContext = TinyKtx_CreateContext(&callbacks, user);
+            mValid = TinyKtx_ReadHeader(mContext) && GetFormat() != Format::eUndefined;
+        }
+
+        ~KtxReader()
+        {
+            if (mContext)
+                TinyKtx_DestroyContext(mContext);
+        }
+
+        KtxReader(const KtxReader&) = delete;
+        KtxReader& operator=(const KtxReader&) = delete;
+
+        bool IsValid() const { return mValid; }
+        /// Only plain 2D textures are streamed
+        bool Is2D() const { return TinyKtx_Depth(mContext) <= 1 && TinyKtx_ArraySlices(mContext) <= 1 && !TinyKtx_IsCubemap(mContext); }
+        Format GetFormat() const { return (Format)TinyImageFormat_FromTinyKtxFormat(TinyKtx_GetFormat(mContext)); }
+        uint32_t GetWidth() const { return TinyKtx_Width(mContext); }
+        uint32_t GetHeight() const { return TinyKtx_Height(mContext); }
+        uint32_t GetMipCount() const { return std::max(1u, TinyKtx_NumberOfMipmaps(mContext)); }
+        uint32_t GetMipSize(uint32_t mip) const { return TinyKtx_ImageSize(mContext, mip); }
+
+        /// Appends mips from first to last, every mip starts at aligned offset
+        bool ReadMips(uint32_t firstMip, std::vector<char>& data, std::vector<uint32_t>& offsets) const
+        {
+            for (uint32_t mip = firstMip; mip < GetMipCount(); ++mip)
+            {
+                auto size = GetMipSize(mip);
+                auto mipData = static_cast<const char*>(TinyKtx_ImageRawData(mContext, mip));
+                if (!mipData || size == 0)
+                    return false;
+
+                offsets.push_back(static_cast<uint32_t>(data.size()));
+                data.insert(data.end(), mipData, mipData + size);
+                data.resize((data.size() + STREAM_DATA_ALIGNMENT - 1) & ~size_t(STREAM_DATA_ALIGNMENT - 1));
+            }
+
+            return true;
+        }
+    };
+
+    class VulkanStreamedTexture : public StreamedTexture
+    {
+    private:
+        friend class VulkanTextureStreamer;
+
+        std::string             mFilename;
+        Format                  mFormat;
+        uint32_t                mWidth;
+        uint32_t                mHeight;
+        /// Bytes of every mip of source file
+        std::vector<uint32_t>   mMipSizes;
+        uint32_t                mBaseMip;
+        Ref<Image>              mBaseImage;
+        Ref<Image>              mImage;
+        uint32_t                mResidentMip;
+        uint32_t                mVersion = 0;
+        /// Finest mip requested since last Update
+        uint32_t                mRequestedMip;
+        uint64_t                mLastRequestFrame = 0;
+        bool                    mLoading = false;
+
+        uint64_t GetMipChainBytes(uint32_t firstMip) const
+        {
+            uint64_t bytes = 0;
+            for (uint32_t mip = firstMip; mip < mMipSizes.size(); ++mip)
+                bytes += mMipSizes[mip];
+            return bytes;
+        }
+
+        /// Bytes of image which replaced base image
+        uint64_t GetStreamedBytes() const
+        {
+            return mResidentMip < mBaseMip ? GetMipChainBytes(mResidentMip) : 0;
+        }
+    public:
+        VulkanStreamedTexture(const std::string& filename, const KtxReader& reader, uint32_t baseMip)
+            : mFilename(filename)
+            , mFormat(reader.GetFormat())
+            , mWidth(reader.GetWidth())
+            , mHeight(reader.GetHeight())
+            , mBaseMip(baseMip)
+            , mResidentMip(baseMip)
+            , mRequestedMip(std::numeric_limits<uint32_t>::max())
+        {
+            mMipSizes.resize(reader.GetMipCount());
+            for (uint32_t mip = 0; mip < mMipSizes.size(); ++mip)
+                mMipSizes[mip] = reader.GetMipSize(mip);
+        }
+
+        void RequestMip(uint32_t mip) override
+        {
+            mRequestedMip = std::min(mRequestedMip, std::min(mip, GetMipCount() - 1));
+        }
+
+        void RequestScreenSize(float screenSize) override
+        {
+            float texels = static_cast<float>(std::max(mWidth, mHeight));
+            if (screenSize >= texels)
+            {
+                RequestMip(0);
+                return;
+            }
+
+            float mip = screenSize > 0.0f ? std::floor(std::log2(texels / screenSize)) : static_cast<float>(GetMipCount());
+            RequestMip(static_cast<uint32_t>(std::min(mip, static_cast<float>(GetMipCount() - 1))));
+        }
+
+        const Ref<Image>& GetImage() const override { return mImage; }
+        uint32_t GetResidentMip() const override { return mResidentMip; }
+        uint32_t GetMipCount() const override { return static_cast<uint32_t>(mMipSizes.size()); }
+        uint32_t GetVersion() const override { return mVersion; }
+        uint64_t GetResidentBytes() const override { return mBaseImage ? GetMipChainBytes(mBaseMip) + GetStreamedBytes() : 0; }
+    };
+
+    class VulkanTextureStreamer : public TextureStreamer
+    {
+        struct StreamJob
+        {
+            Ref<VulkanStreamedTexture>  texture;
+            uint32_t                    firstMip;
+            /// Budget reserved when job was queued
+            uint64_t                    reservedBytes = 0;
+            std::vector<char>           data;
+            std::vector<uint32_t>       offsets;
+            bool                        failed = false;
+        };
+
+        struct Upload
+        {
+            Ref<VulkanStreamedTexture>  texture;
+            Ref<Image>                  image;
+            uint32_t                    firstMip;
+            uint64_t                    reservedBytes;
+        };
+    private:
+        VkDevice                    mDevice;
+        VkQueue                     mDeviceQueue;
+        VkFence                     mFence = VK_NULL_HANDLE;
+        Ref<CommandBuffer>          mCmd;
+        Ref<StagingBuffer>          mStagingBuffer;
+        uint32_t                    mStagingBufferSize;
+        uint32_t                    mBaseMipSize;
+        uint32_t                    mEvictionDelay;
+        uint64_t                    mMemoryBudget;
+
+        std::vector<std::thread>    mWorkers;
+        mutable std::mutex          mMutex;
+        std::condition_variable     mQueueCondition;
+        std::deque<StreamJob>       mQueue;
+        std::deque<StreamJob>       mLoaded;
+        bool                        mStopping = false;
+
+        /// Main thread state
+        std::vector<Ref<VulkanStreamedTexture>> mTextures;
+        std::deque<StreamJob>       mReady;
+        std::vector<Upload>         mUploads;
+        bool                        mUploadInFlight = false;
+        uint64_t                    mFrame = 0;
+        uint64_t                    mResidentBytes = 0;
+        uint64_t                    mPendingBytes = 0;
+        uint32_t                    mPendingCount = 0;
+        uint64_t                    mUploadedBytes = 0;
+        uint32_t                    mEvictionCount = 0;
+
+        static void ReadJob(StreamJob& job)
+        {
+            KtxReader reader(job.texture->mFilename);
+            job.failed = !reader.IsValid() || !reader.ReadMips(job.firstMip, job.data, job.offsets);
+            if (job.failed)
+                LOG_CATEGORY_ERROR(eRenderer, "[ Texture Streamer ] Failed to read mips of {}", job.texture->mFilename);
+        }
+
+        void WorkerLoop()
+        {
+            PROFILE_THREAD("TextureStreamer");
+            while (true)
+            {
+                StreamJob job;
+                {
+                    std::unique_lock lock(mMutex);
+                    mQueueCondition.wait(lock, [this]() { return mStopping || !mQueue.empty(); });
+                    if (mStopping)
+                        return;
+
+                    job = std::move(mQueue.front());
+                    mQueue.pop_front();
+                }
+
+                {
+                    PROFILE_SCOPE("TextureStreamer::Read");
+                    ReadJob(job);
+                }
+
+                std::scoped_lock lock(mMutex);
+                mLoaded.emplace_back(std::move(job));
+            }
+        }
+
+        Ref<Image> CreateImage(const VulkanStreamedTexture& texture, uint32_t firstMip) const
+        {
+            ImageDescription description{};
+            description.width = std::max(texture.mWidth >> firstMip, 1u);
+            description.height = std::max(texture.mHeight >> firstMip, 1u);
+            description.depth = 1;
+            description.arraySize = 1;
+            description.mipLevels = texture.GetMipCount() - firstMip;
+            description.format = texture.mFormat;
+            description.sampleCount = SampleCount::e1;
+            description.initialUsage = ImageUsage::eSampled;
+            description.descriptors = DescriptorType::eSampledImage;
+            description.flags = ImageDescriptionFlagBits::eSkipInitialTransition;
+            description.memoryTag = MemoryTag::eTexture;
+            return Image::Create(description);
+        }
+
+        /// Returns false when staging buffer has no space left for job
+        bool RecordUpload(StreamJob& job)
+        {
+            auto size = static_cast<uint32_t>(job.data.size());
+            if (mStagingBuffer->GetCurrentOffset() + size > mStagingBufferSize)
+                return false;
+
+            if (mUploads.empty())
+            {
+                vkResetFences(mDevice, 1, &mFence);
+                mCmd->Begin();
+            }
+
+            auto image = CreateImage(*job.texture, job.firstMip);
+            auto stage = mStagingBuffer->Submit(job.data.data(), size);
+            mCmd->ImageBarrier(*image, ImageUsage::eUndefined, ImageUsage::eTransferDst);
+            for (uint32_t i = 0; i < job.offsets.size(); ++i)
+                mCmd->CopyBufferToImage(mStagingBuffer->GetBuffer(), stage.offset + job.offsets[i], *image, ImageUsage::eTransferDst, i);
+            mCmd->ImageBarrier(*image, ImageUsage::eTransferDst, ImageUsage::eSampled);
+
+            mUploadedBytes += size;
+            mUploads.push_back({ job.texture, std::move(image), job.firstMip, job.reservedBytes });
+            return true;
+        }
+
+        void SubmitUploads()
+        {
+            if (mUploads.empty())
+                return;
+
+            mCmd->End();
+            mStagingBuffer->Flush();
+
+            auto nativeCmd = (VkCommandBuffer)mCmd->GetNativeHandle();
+            VkSubmitInfo submitInfo{};
+            submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            submitInfo.commandBufferCount = 1;
+            submitInfo.pCommandBuffers = &nativeCmd;
+            vkQueueSubmit(mDeviceQueue, 1, &submitInfo, mFence);
+            mUploadInFlight = true;
+        }
+
+        /// Swaps uploaded images in, old images are released through deferred destruction
+        void PublishUploads(bool wait)
+        {
+            if (!mUploadInFlight)
+                return;
+
+            if (wait)
+                vkWaitForFences(mDevice, 1, &mFence, true, std::numeric_limits<uint64_t>::max());
+            else if (vkGetFenceStatus(mDevice, mFence) != VK_SUCCESS)
+                return;
+
+            for (auto& upload : mUploads)
+            {
+                auto& texture = *upload.texture;
+                mPendingBytes -= upload.reservedBytes;
+                mPendingCount--;
+                texture.mLoading = false;
+
+                /// Base image upload of Load
+                if (!texture.mImage)
+                {
+                    texture.mBaseImage = texture.mImage = std::move(upload.image);
+                    texture.mVersion++;
+                    mResidentBytes += texture.GetResidentBytes();
+                    continue;
+                }
+
+                if (upload.firstMip >= texture.mResidentMip)
+                    continue;
+
+                mResidentBytes -= texture.GetStreamedBytes();
+                texture.mImage = std::move(upload.image);
+                texture.mResidentMip = upload.firstMip;
+                texture.mVersion++;
+                mResidentBytes += texture.GetStreamedBytes();
+            }
+
+            mUploads.clear();
+            mStagingBuffer->Reset();
+            mUploadInFlight = false;
+        }
+
+        void Evict(VulkanStreamedTexture& texture)
+        {
+            mResidentBytes -= texture.GetStreamedBytes();
+            texture.mImage = texture.mBaseImage;
+            texture.mResidentMip = texture.mBaseMip;
+            texture.mVersion++;
+            mEvictionCount++;
+        }
+
+        /// Least recently requested streamed texture which was not requested in eviction delay
+        VulkanStreamedTexture* FindEvictionCandidate(const VulkanStreamedTexture* exclude) const
+        {
+            VulkanStreamedTexture* candidate = nullptr;
+            for (auto& texture : mTextures)
+            {
+                if (texture.get() == exclude || texture->mLoading || texture->GetStreamedBytes() == 0)
+                    continue;
+                if (texture->mLastRequestFrame + mEvictionDelay >= mFrame)
+                    continue;
+                if (!candidate || texture->mLastRequestFrame < candidate->mLastRequestFrame)
+                    candidate = texture.get();
+            }
+
+            return candidate;
+        }
+
+        /// Evicts until extra bytes fit budget
+        bool MakeRoom(uint64_t bytes, const VulkanStreamedTexture* exclude)
+        {
+            while (mResidentBytes + mPendingBytes + bytes > mMemoryBudget)
+            {
+                auto candidate = FindEvictionCandidate(exclude);
+                if (!candidate)
+                    return false;
+
+                Evict(*candidate);
+            }
+
+            return true;
+        }
+
+        void QueueLoad(const Ref<VulkanStreamedTexture>& texture, uint32_t requestedMip)
+        {
+            /// Coarser mips are tried when finer ones do not fit staging buffer or budget
+            for (uint32_t mip = requestedMip; mip < texture->mResidentMip; ++mip)
+            {
+                uint64_t bytes = texture->GetMipChainBytes(mip);
+                if (bytes + (mip - requestedMip + 1) * STREAM_DATA_ALIGNMENT > mStagingBufferSize)
+                    continue;
+
+                /// Previous streamed image is released when new one is swapped in
+                uint64_t reserved = bytes - std::min(bytes, texture->GetStreamedBytes());
+                if (!MakeRoom(reserved, texture.get()))
+                    continue;
+
+                texture->mLoading = true;
+                mPendingBytes += reserved;
+                mPendingCount++;
+
+                StreamJob job;
+                job.texture = texture;
+                job.firstMip = mip;
+                job.reservedBytes = reserved;
+                {
+                    std::scoped_lock lock(mMutex);
+                    mQueue.emplace_back(std::move(job));
+                }
+
+                mQueueCondition.notify_one();
+                return;
+            }
+        }
+    public:
+        explicit VulkanTextureStreamer(const TextureStreamerDescription& description)
+            : mStagingBufferSize(description.stagingBufferSize)
+            , mBaseMipSize(std::max(description.baseMipSize, 1u))
+            , mEvictionDelay(description.evictionDelay)
+            , mMemoryBudget(description.memoryBudget)
+        {
+            auto& context = GetGraphicContext();
+            mDevice = (VkDevice)context.GetDevice();
+            mDeviceQueue = (VkQueue)context.GetDeviceQueue();
+
+            CommandBufferDescription cmdDesc{};
+            cmdDesc.commandPool = context.GetCommandPool();
+            cmdDesc.device = mDevice;
+            mCmd = CommandBuffer::Create(cmdDesc);
+
+            StagingBufferDescription stagingBufferDesc{};
+            stagingBufferDesc.size = mStagingBufferSize;
+            mStagingBuffer = StagingBuffer::Create(stagingBufferDesc);
+
+            VkFenceCreateInfo fenceCreateInfo{};
+            fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+            vkCreateFence(mDevice, &fenceCreateInfo, nullptr, &mFence);
+
+            uint32_t workerCount = std::max(description.workerCount, 1u);
+            for (uint32_t i = 0; i < workerCount; ++i)
+                mWorkers.emplace_back(&VulkanTextureStreamer::WorkerLoop, this);
+        }
+
+        ~VulkanTextureStreamer() override
+        {
+            {
+                std::scoped_lock lock(mMutex);
+                mStopping = true;
+            }
+
+            mQueueCondition.notify_all();
+            for (auto& worker : mWorkers)
+                worker.join();
+
+            PublishUploads(true);
+            vkDestroyFence(mDevice, mFence, nullptr);
+        }
+
+        Ref<StreamedTexture> Load(const std::string& filename) override
+        {
+            PROFILE_SCOPE("TextureStreamer::Load");
+            Ref<VulkanStreamedTexture> texture;
+            {
+                KtxReader reader(filename);
+                if (!reader.IsValid())
+                {
+                    LOG_CATEGORY_ERROR(eRenderer, "[ Texture Streamer ] Failed to load {}", filename);
+                    return nullptr;
+                }
+
+                /// Whole chain is base of textures which could not be streamed
+                uint32_t baseMip = 0;
+                if (reader.Is2D())
+                {
+                    uint32_t size = std::max(reader.GetWidth(), reader.GetHeight());
+                    while (baseMip + 1 < reader.GetMipCount() && (size >> baseMip) > mBaseMipSize)
+                        baseMip++;
+                }
+
+                texture = CreateRef<VulkanStreamedTexture>(filename, reader, baseMip);
+            }
+
+            /// Base mips take same path as streamed ones, so loading never waits for disk or gpu
+            uint32_t baseMipCount = texture->GetMipCount() - texture->mBaseMip;
+            if (texture->GetMipChainBytes(texture->mBaseMip) + baseMipCount * STREAM_DATA_ALIGNMENT > mStagingBufferSize)
+            {
+                LOG_CATEGORY_ERROR(eRenderer, "[ Texture Streamer ] Base mips of {} do not fit staging buffer", filename);
+                return nullptr;
+            }
+
+            texture->mLoading = true;
+            mPendingCount++;
+
+            StreamJob job;
+            job.texture = texture;
+            job.firstMip = texture->mBaseMip;
+            {
+                std::scoped_lock lock(mMutex);
+                mQueue.emplace_back(std::move(job));
+            }
+
+            mQueueCondition.notify_one();
+            mTextures.push_back(texture);
+            return texture;
+        }
+
+        void Update() override
+        {
+            PROFILE_SCOPE("TextureStreamer::Update");
+            mFrame++;
+
+            PublishUploads(false);
+
+            /// Textures which nobody holds anymore
+            auto released = std::remove_if(mTextures.begin(), mTextures.end(), [](const Ref<VulkanStreamedTexture>& texture)
+            {
+                return texture.use_count() == 1;
+            });
+
+            for (auto it = released; it != mTextures.end(); ++it)
+                mResidentBytes -= (*it)->GetResidentBytes();
+            mTextures.erase(released, mTextures.end());
+
+            /// Eviction first, so stale textures give their memory to requested ones
+            MakeRoom(0, nullptr);
+
+            for (auto& texture : mTextures)
+            {
+                uint32_t requestedMip = texture->mRequestedMip;
+                texture->mRequestedMip = std::numeric_limits<uint32_t>::max();
+                if (requestedMip == std::numeric_limits<uint32_t>::max())
+                    continue;
+
+                texture->mLastRequestFrame = mFrame;
+                if (requestedMip < texture->mResidentMip && !texture->mLoading)
+                    QueueLoad(texture, requestedMip);
+            }
+
+            /// Loaded mips are uploaded while next frame is recorded and swapped in on later Update
+            {
+                std::scoped_lock lock(mMutex);
+                while (!mLoaded.empty())
+                {
+                    mReady.emplace_back(std::move(mLoaded.front()));
+                    mLoaded.pop_front();
+                }
+            }
+
+            if (mUploadInFlight)
+                return;
+
+            while (!mReady.empty())
+            {
+                auto& job = mReady.front();
+                if (job.failed)
+                {
+                    job.texture->mLoading = false;
+                    mPendingBytes -= job.reservedBytes;
+                    mPendingCount--;
+                }
+                else if (!RecordUpload(job))
+                {
+                    break;
+                }
+
+                mReady.pop_front();
+            }
+
+            SubmitUploads();
+        }
+
+        void SetMemoryBudget(uint64_t bytes) override
+        {
+            mMemoryBudget = bytes;
+        }
+
+        TextureStreamerStats GetStats() const override
+        {
+            TextureStreamerStats stats;
+            stats.textureCount = static_cast<uint32_t>(mTextures.size());
+            stats.pendingCount = mPendingCount;
+            stats.residentBytes = mResidentBytes;
+            stats.memoryBudget = mMemoryBudget;
+            stats.uploadedBytes = mUploadedBytes;
+            stats.evictionCount = mEvictionCount;
+            return stats;
+        }
+    };
+
+    /// Interface
+
+    Scope<TextureStreamer> TextureStreamer::Create(const TextureStreamerDescription& description)
+    {
+        return CreateScope<VulkanTextureStreamer>(description);
+    }
+} // namespace Fluent
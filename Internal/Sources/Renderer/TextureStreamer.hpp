@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "Core/Base.hpp"
+#include "Renderer/Image.hpp"
+
+namespace Fluent
+{
+    struct TextureStreamerDescription
+    {
+        uint32_t workerCount = 2;
+        /// Resident bytes of all textures, base mips are always resident and counted too
+        uint64_t memoryBudget = 256ull * 1024 * 1024;
+        /// Mips not larger than this are loaded up front and never evicted
+        uint32_t baseMipSize = 64;
+        /// Upload size per Update, finer mips are not requested above it
+        uint32_t stagingBufferSize = 64 * 1024 * 1024;
+        /// Textures requested in last frames are evicted only when nothing else is left
+        uint32_t evictionDelay = 8;
+    };
+
+    /// Ktx texture which keeps low mips resident and streams finer ones on demand.
+    /// Image is replaced as a whole, so descriptors should be rewritten when version changes.
+    /// Image is nullptr until base mips are uploaded, version is 1 then
+    class StreamedTexture
+    {
+    protected:
+        StreamedTexture() = default;
+    public:
+        virtual ~StreamedTexture() = default;
+
+        /// Finest mip needed, requests of one frame are combined. Main thread only
+        virtual void RequestMip(uint32_t mip) = 0;
+        /// Requests mip which has at most one texel per pixel when texture covers screenSize pixels
+        virtual void RequestScreenSize(float screenSize) = 0;
+
+        virtual const Ref<Image>& GetImage() const = 0;
+        /// Mip of source file which is mip 0 of current image
+        virtual uint32_t GetResidentMip() const = 0;
+        virtual uint32_t GetMipCount() const = 0;
+        /// Incremented every time image is replaced
+        virtual uint32_t GetVersion() const = 0;
+        virtual uint64_t GetResidentBytes() const = 0;
+    };
+
+    struct TextureStreamerStats
+    {
+        uint32_t    textureCount = 0;
+        uint32_t    pendingCount = 0;
+        uint64_t    residentBytes = 0;
+        uint64_t    memoryBudget = 0;
+        uint64_t    uploadedBytes = 0;
+        uint32_t    evictionCount = 0;
+    };
+
+    class TextureStreamer
+    {
+    protected:
+        TextureStreamer() = default;
+    public:
+        virtual ~TextureStreamer() = default;
+
+        /// Reads header synchronously, base mips are read on workers and uploaded by later Update.
+        /// Filename is relative to textures directory
+        virtual Ref<StreamedTexture> Load(const std::string& filename) = 0;
+        /// Should be called between frames. Finished uploads are swapped in, new loads are
+        /// queued from last frame requests and textures are evicted to fit budget
+        virtual void Update() = 0;
+
+        virtual void SetMemoryBudget(uint64_t bytes) = 0;
+        virtual TextureStreamerStats GetStats() const = 0;
+
+        static Scope<TextureStreamer> Create(const TextureStreamerDescription& description);
+    };
+} // namespace Fluent
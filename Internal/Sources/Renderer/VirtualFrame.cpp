@@ -1,3 +1,5 @@
+#include <mutex>
+#include "Core/Profiler.hpp"
 #include "Renderer/Renderer.hpp"
 #include "Renderer/GraphicContext.hpp"
 #include "Renderer/VirtualFrame.hpp"
@@ -14,6 +16,7 @@ namespace Fluent
             VkSemaphore         renderCompleteSemaphore;
             Ref<CommandBuffer>  cmd;
             VkFence             fence;
+            std::vector<std::function<void()>> deletionQueue;
         };
     private:
         VkDevice                    mDevice;
@@ -24,6 +27,54 @@ namespace Fluent
         std::vector<bool>           mCommandBuffersRecorded;
         std::vector<VirtualFrame>   mVirtualFrames;
         uint32_t                    mActiveImageIndex{};
+        bool                        mRecording = false;
+        /// Objects are released from worker threads too, guards deletion queues and frame position
+        std::mutex                  mDeletionMutex;
+
+        /// Destructors run without lock, they may defer destruction of other objects
+        void FlushDeletionQueue(VirtualFrame& frame)
+        {
+            std::vector<std::function<void()>> deletionQueue;
+            {
+                std::scoped_lock lock(mDeletionMutex);
+                std::swap(deletionQueue, frame.deletionQueue);
+            }
+
+            for (auto& destructor : deletionQueue)
+                destructor();
+        }
+
+        void AdvanceFrame()
+        {
+            std::scoped_lock lock(mDeletionMutex);
+            mRecording = false;
+            mCommandBuffersRecorded[mCurrentFrameIndex] = false;
+            mCurrentFrameIndex = (mCurrentFrameIndex + 1) % mVirtualFrames.size();
+        }
+
+        bool SubmitHeadless()
+        {
+            auto& cmd = mVirtualFrames[mCurrentFrameIndex].cmd;
+            cmd->End();
+
+            auto nativeCmd = (VkCommandBuffer)cmd->GetNativeHandle();
+
+            VkSubmitInfo submitInfo{};
+            submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            submitInfo.commandBufferCount = 1;
+            submitInfo.pCommandBuffers = &nativeCmd;
+
+            mVirtualFrames[mCurrentFrameIndex].stagingBuffer->Flush();
+            {
+                PROFILE_SCOPE("VirtualFrame::Submit");
+                vkQueueSubmit(mQueue, 1, &submitInfo, mVirtualFrames[mCurrentFrameIndex].fence);
+            }
+
+            mVirtualFrames[mCurrentFrameIndex].stagingBuffer->Reset();
+            AdvanceFrame();
+
+            return true;
+        }
     public:
         explicit VulkanFrameProvider(const VirtualFrameProviderDescription& description)
             : mDevice((VkDevice)description.device)
@@ -64,9 +115,11 @@ namespace Fluent
 
         ~VulkanFrameProvider() override
         {
+            /// Device is idle here, staging buffers are destroyed immediately
             for (auto& frame : mVirtualFrames)
             {
                 frame.stagingBuffer = nullptr;
+                FlushDeletionQueue(frame);
                 vkDestroyFence(mDevice, frame.fence, nullptr);
                 vkDestroySemaphore(mDevice, frame.renderCompleteSemaphore, nullptr);
                 vkDestroySemaphore(mDevice, frame.acquireSemaphore, nullptr);
@@ -77,30 +130,40 @@ namespace Fluent
         {
             bool result = true;
 
-            auto acquireResult = vkAcquireNextImageKHR
-                (
-                    mDevice, mSwapchain,
-                    std::numeric_limits<uint64_t>::max(),
-                    mVirtualFrames[mCurrentFrameIndex].acquireSemaphore,
-                    VK_NULL_HANDLE,
-                    &mActiveImageIndex
-                );
-
-            if (acquireResult != VK_SUCCESS && acquireResult != VK_SUBOPTIMAL_KHR)
+            /// Headless context has nothing to acquire
+            if (mSwapchain)
             {
-                result = false;
+                auto acquireResult = vkAcquireNextImageKHR
+                    (
+                        mDevice, mSwapchain,
+                        std::numeric_limits<uint64_t>::max(),
+                        mVirtualFrames[mCurrentFrameIndex].acquireSemaphore,
+                        VK_NULL_HANDLE,
+                        &mActiveImageIndex
+                    );
+
+                if (acquireResult != VK_SUCCESS && acquireResult != VK_SUBOPTIMAL_KHR)
+                {
+                    result = false;
+                }
             }
 
             if (!mCommandBuffersRecorded[mCurrentFrameIndex])
             {
+                PROFILE_SCOPE("VirtualFrame::WaitFence");
                 vkWaitForFences(mDevice, 1, &mVirtualFrames[mCurrentFrameIndex].fence, true, std::numeric_limits<uint64_t>::max());
                 vkResetFences(mDevice, 1, &mVirtualFrames[mCurrentFrameIndex].fence);
                 mCommandBuffersRecorded[mCurrentFrameIndex] = true;
+                FlushDeletionQueue(mVirtualFrames[mCurrentFrameIndex]);
             }
 
             /// Recording command buffers
             auto& cmd = mVirtualFrames[mCurrentFrameIndex].cmd;
             cmd->Begin();
+            {
+                std::scoped_lock lock(mDeletionMutex);
+                mRecording = true;
+            }
             return result;
         }
 
@@ -108,6 +171,9 @@ namespace Fluent
         {
             auto& cmd = mVirtualFrames[mCurrentFrameIndex].cmd;
 
+            if (!mSwapchain)
+                return SubmitHeadless();
+
             auto imageUsage = GetGraphicContext().GetSwapchainImageUsage(mActiveImageIndex);
             auto image = GetGraphicContext().AcquireImage(mActiveImageIndex, ImageUsage::eUndefined);
 
@@ -151,7 +217,14 @@ namespace Fluent
             submitInfo.commandBufferCount = 1;
             submitInfo.pCommandBuffers = &nativeCmd;
 
-            vkQueueSubmit(mQueue, 1, &submitInfo, mVirtualFrames[mCurrentFrameIndex].fence);
+            {
+                PROFILE_SCOPE("VirtualFrame::Submit");
+                vkQueueSubmit(mQueue, 1, &submitInfo, mVirtualFrames[mCurrentFrameIndex].fence);
+            }
+            {
+                std::scoped_lock lock(mDeletionMutex);
+                mRecording = false;
+            }
 
             VkPresentInfoKHR presentInfo{};
             presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -164,25 +237,41 @@ namespace Fluent
             mVirtualFrames[mCurrentFrameIndex].stagingBuffer->Flush();
             mVirtualFrames[mCurrentFrameIndex].stagingBuffer->Reset();
 
-            auto presentResult = vkQueuePresentKHR(mQueue, &presentInfo);
+            VkResult presentResult;
+            {
+                PROFILE_SCOPE("VirtualFrame::Present");
+                presentResult = vkQueuePresentKHR(mQueue, &presentInfo);
+            }
 
             if (presentResult != VK_SUCCESS && presentResult != VK_SUBOPTIMAL_KHR)
             {
                 return false;
             }
 
-            mCommandBuffersRecorded[mCurrentFrameIndex] = false;
-            mCurrentFrameIndex = (mCurrentFrameIndex + 1) % mVirtualFrames.size();
+            AdvanceFrame();
 
             return true;
         }
 
+        void DeferDestruction(std::function<void()>&& destructor) override
+        {
+            std::scoped_lock lock(mDeletionMutex);
+
+            /// Outside of recording the latest submitted frame is the last one which could use the object
+            uint32_t frameIndex = mCurrentFrameIndex;
+            if (!mRecording)
+                frameIndex = (mCurrentFrameIndex + mVirtualFrames.size() - 1) % mVirtualFrames.size();
+
+            mVirtualFrames[frameIndex].deletionQueue.emplace_back(std::move(destructor));
+        }
+
         Ref<StagingBuffer>& GetStagingBuffer() override
         {
             return mVirtualFrames[mCurrentFrameIndex].stagingBuffer;
         }
 
         uint32_t GetActiveImageIndex() const override { return mActiveImageIndex; }
+        uint32_t GetFrameIndex() const override { return mCurrentFrameIndex; }
         Ref<CommandBuffer>& GetCommandBuffer() override { return mVirtualFrames[mCurrentFrameIndex].cmd; };
     };
     
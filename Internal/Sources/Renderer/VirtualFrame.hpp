@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <functional>
 #include "Core/Base.hpp"
 #include "Renderer/CommandBuffer.hpp"
 #include "Renderer/StagingBuffer.hpp"
@@ -28,7 +29,11 @@ namespace Fluent
         virtual bool BeginFrame() = 0;
         virtual bool EndFrame() = 0;
 
+        /// Destructor runs once the frame which could reference the object has finished on gpu
+        virtual void DeferDestruction(std::function<void()>&& destructor) = 0;
+
         virtual uint32_t GetActiveImageIndex() const = 0;
+        virtual uint32_t GetFrameIndex() const = 0;
         virtual Ref<CommandBuffer>& GetCommandBuffer() = 0;
         virtual Ref<StagingBuffer>& GetStagingBuffer() = 0;
 
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include "Math/Math.hpp"
+#include "Scene/Model.hpp"
+
+namespace Fluent
+{
+    /// Built-in components, plain data so World can store them in chunks
+
+    struct TransformComponent
+    {
+        Matrix4 world = Matrix4(1.0f);
+    };
+
+    /// Indices refer to models owned by application, no resource is referenced directly
+    struct RenderableComponent
+    {
+        uint32_t        model = 0;
+        uint32_t        mesh = 0;
+        /// -1 indices mean that mesh material is used, see InstanceBatch
+        TextureIndices  material;
+    };
+
+    /// Axis aligned box in entity local space
+    struct BoundsComponent
+    {
+        Vector3 min = Vector3(0.0f);
+        Vector3 max = Vector3(0.0f);
+    };
+
+    enum class LightType : uint32_t
+    {
+        eDirectional,
+        ePoint,
+        eSpot
+    };
+
+    /// Position and direction come from TransformComponent
+    struct LightComponent
+    {
+        LightType   type = LightType::ePoint;
+        Vector3     color = Vector3(1.0f);
+        float       intensity = 1.0f;
+        float       range = 10.0f;
+        /// Cosine of cone half angle, spot lights only
+        float       outerConeCos = 0.9f;
+    };
+} // namespace Fluent
@@ -0,0 +1,100 @@
+#include <algorithm>
+#include "Scene/InstanceBatch.hpp"
+
+namespace Fluent
+{
+    InstanceBatch::InstanceBatch(const InstanceBatchDescription& description)
+        : mMaxInstanceCount(description.maxInstanceCount)
+    {
+        mTransforms.reserve(mMaxInstanceCount);
+        mMaterials.reserve(mMaxInstanceCount);
+
+        BufferDescription bufferDesc{};
+        bufferDesc.bufferUsage = BufferUsage::eVertexBuffer;
+        bufferDesc.memoryUsage = MemoryUsage::eCpuToGpu;
+        bufferDesc.memoryTag = MemoryTag::eMesh;
+
+        /// Gpu may still read previous frame buffers while current ones are written
+        for (auto& frameBuffers : mFrameBuffers)
+        {
+            bufferDesc.size = mMaxInstanceCount * sizeof(Matrix4);
+            frameBuffers.transforms = Buffer::Create(bufferDesc);
+            bufferDesc.size = mMaxInstanceCount * sizeof(TextureIndices);
+            frameBuffers.materials = Buffer::Create(bufferDesc);
+        }
+
+        mVertexBuffers = { nullptr, nullptr, nullptr };
+        mVertexBufferOffsets = { 0, 0, 0 };
+    }
+
+    void InstanceBatch::Clear()
+    {
+        mTransforms.clear();
+        mMaterials.clear();
+    }
+
+    uint32_t InstanceBatch::AddInstance(const Matrix4& transform, const TextureIndices& material)
+    {
+        if (mTransforms.size() >= mMaxInstanceCount)
+        {
+            LOG_CATEGORY_WARN(eScene, "Instance batch is full. Max instance count {}", mMaxInstanceCount);
+            return INVALID_INSTANCE;
+        }
+
+        mTransforms.push_back(transform);
+        mMaterials.push_back(material);
+        return static_cast<uint32_t>(mTransforms.size() - 1);
+    }
+
+    void InstanceBatch::SetInstance(uint32_t index, const Matrix4& transform, const TextureIndices& material)
+    {
+        if (index >= mTransforms.size())
+        {
+            LOG_CATEGORY_WARN(eScene, "Instance {} is out of range. Instance count {}", index, mTransforms.size());
+            return;
+        }
+
+        mTransforms[index] = transform;
+        mMaterials[index] = material;
+    }
+
+    InstanceBatch::FrameBuffers& InstanceBatch::GetFrameBuffers()
+    {
+        auto& frameBuffers = mFrameBuffers[GetGraphicContext().GetFrameIndex()];
+        if (frameBuffers.version != mVersion && !mTransforms.empty())
+        {
+            frameBuffers.transforms->WriteData(mTransforms.data(), mTransforms.size() * sizeof(mTransforms[0]), 0);
+            frameBuffers.materials->WriteData(mMaterials.data(), mMaterials.size() * sizeof(mMaterials[0]), 0);
+        }
+        frameBuffers.version = mVersion;
+        return frameBuffers;
+    }
+
+    void InstanceBatch::Upload()
+    {
+        mVersion++;
+        GetFrameBuffers();
+    }
+
+    void InstanceBatch::DrawMesh(const Ref<CommandBuffer>& cmd, const Mesh& mesh, uint32_t lod)
+    {
+        if (mTransforms.empty()) return;
+
+        const auto& frameBuffers = GetFrameBuffers();
+        mVertexBuffers[0] = mesh.vertexBuffer;
+        mVertexBuffers[1] = frameBuffers.transforms;
+        mVertexBuffers[2] = frameBuffers.materials;
+        cmd->BindVertexBuffers(0, mVertexBuffers, mVertexBufferOffsets);
+        cmd->BindIndexBuffer(mesh.indexBuffer, 0, IndexType::eUint32);
+        const auto& meshLod = mesh.lods[std::min(lod, static_cast<uint32_t>(mesh.lods.size() - 1))];
+        cmd->DrawIndexed(meshLod.indexCount, GetInstanceCount(), meshLod.firstIndex, 0, 0);
+        // Do not keep mesh alive
+        mVertexBuffers[0] = nullptr;
+    }
+
+    void InstanceBatch::Draw(const Ref<CommandBuffer>& cmd, const Model& model, uint32_t lod)
+    {
+        for (const auto& mesh : model.meshes)
+            DrawMesh(cmd, mesh, lod);
+    }
+} // namespace Fluent
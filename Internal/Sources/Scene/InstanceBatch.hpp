@@ -0,0 +1,66 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include "Core/Base.hpp"
+#include "Math/Math.hpp"
+#include "Renderer/Buffer.hpp"
+#include "Renderer/CommandBuffer.hpp"
+#include "Renderer/GraphicContext.hpp"
+#include "Scene/Model.hpp"
+
+namespace Fluent
+{
+    struct InstanceBatchDescription
+    {
+        uint32_t maxInstanceCount;
+    };
+
+    /// Draws many copies of a model, one DrawIndexed per mesh.
+    /// Pipeline should be created with ModelLoader instanced attributes, vertex shader marks its
+    /// instance inputs as eInstanceTransform and eInstanceMaterial in ShaderDescription::inputSemantics
+    class InstanceBatch
+    {
+    private:
+        /// Instance streams of one frame in flight
+        struct FrameBuffers
+        {
+            Ref<Buffer> transforms;
+            Ref<Buffer> materials;
+            /// Upload count when buffers were written last
+            uint32_t    version = 0;
+        };
+
+        uint32_t                            mMaxInstanceCount;
+        std::vector<Matrix4>                mTransforms;
+        std::vector<TextureIndices>         mMaterials;
+        std::array<FrameBuffers, FRAME_COUNT> mFrameBuffers;
+        uint32_t                            mVersion = 0;
+        std::vector<Ref<Buffer>>            mVertexBuffers;
+        std::vector<uint32_t>               mVertexBufferOffsets;
+
+        /// Buffers of current frame, written when they are older than last Upload
+        FrameBuffers& GetFrameBuffers();
+    public:
+        static constexpr uint32_t INVALID_INSTANCE = ~0u;
+
+        explicit InstanceBatch(const InstanceBatchDescription& description);
+
+        void Clear();
+        /// Material with -1 indices means that mesh material should be used.
+        /// Returns INVALID_INSTANCE when batch is full
+        uint32_t AddInstance(const Matrix4& transform, const TextureIndices& material = {});
+        /// Index must be returned by AddInstance since last Clear
+        void SetInstance(uint32_t index, const Matrix4& transform, const TextureIndices& material = {});
+        /// Write instance streams to gpu, call it after instances changed. Frames in flight keep
+        /// their own copy, buffers of other frames are written when batch is drawn in them
+        void Upload();
+
+        void DrawMesh(const Ref<CommandBuffer>& cmd, const Mesh& mesh, uint32_t lod = 0);
+        /// Same lod is used for every mesh, clamped to mesh lod count
+        void Draw(const Ref<CommandBuffer>& cmd, const Model& model, uint32_t lod = 0);
+
+        uint32_t GetInstanceCount() const { return static_cast<uint32_t>(mTransforms.size()); }
+        uint32_t GetMaxInstanceCount() const { return mMaxInstanceCount; }
+    };
+} // namespace Fluent
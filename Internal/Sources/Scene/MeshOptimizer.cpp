@@ -0,0 +1,334 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_set>
+#include "Core/Profiler.hpp"
+#include "Scene/MeshOptimizer.hpp"
+
+namespace Fluent::MeshOptimizer
+{
+    static constexpr uint32_t INVALID_INDEX = ~0u;
+
+    /// Exact FIFO simulation, vertex stays cached until cacheSize misses happened after its own
+    struct VertexCache
+    {
+        std::vector<uint32_t>   timestamps;
+        uint32_t                time;
+        uint32_t                cacheSize;
+
+        VertexCache(uint32_t vertexCount, uint32_t cacheSize)
+            : timestamps(vertexCount, 0)
+            , time(cacheSize + 1)
+            , cacheSize(cacheSize)
+        {}
+
+        void Reset() { time += cacheSize + 1; }
+
+        uint32_t Access(const uint32_t* triangle)
+        {
+            uint32_t misses = 0;
+            for (uint32_t i = 0; i < 3; ++i)
+            {
+                if (time - timestamps[triangle[i]] > cacheSize)
+                {
+                    timestamps[triangle[i]] = time++;
+                    misses++;
+                }
+            }
+            return misses;
+        }
+    };
+
+    uint32_t DeduplicateVertices(std::vector<float>& vertices, std::vector<uint32_t>& indices, uint32_t stride)
+    {
+        PROFILE_SCOPE("MeshOptimizer::DeduplicateVertices");
+        auto vertexCount = static_cast<uint32_t>(vertices.size() / stride);
+        size_t vertexSize = stride * sizeof(float);
+
+        auto hash = [&vertices, stride, vertexSize](uint32_t index)
+        {
+            /// FNV-1a over vertex bytes
+            const auto* bytes = reinterpret_cast<const uint8_t*>(vertices.data() + size_t(index) * stride);
+            uint64_t result = 14695981039346656037ull;
+            for (size_t i = 0; i < vertexSize; ++i)
+                result = (result ^ bytes[i]) * 1099511628211ull;
+            return static_cast<size_t>(result);
+        };
+
+        auto equal = [&vertices, stride, vertexSize](uint32_t a, uint32_t b)
+        {
+            return std::memcmp(vertices.data() + size_t(a) * stride, vertices.data() + size_t(b) * stride, vertexSize) == 0;
+        };
+
+        /// Set holds compacted indices, candidate is moved to first free slot before lookup.
+        /// Slots at and after it are either duplicates or not read yet, so nothing in set is overwritten
+        std::unordered_set<uint32_t, decltype(hash), decltype(equal)> unique(vertexCount, hash, equal);
+        std::vector<uint32_t> remap(vertexCount);
+        uint32_t uniqueCount = 0;
+        for (uint32_t i = 0; i < vertexCount; ++i)
+        {
+            if (uniqueCount != i)
+                std::memmove(vertices.data() + size_t(uniqueCount) * stride, vertices.data() + size_t(i) * stride, vertexSize);
+
+            auto [it, inserted] = unique.insert(uniqueCount);
+            if (inserted)
+                uniqueCount++;
+            remap[i] = *it;
+        }
+
+        vertices.resize(size_t(uniqueCount) * stride);
+        for (auto& index : indices)
+            index = remap[index];
+
+        return uniqueCount;
+    }
+
+    void OptimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount)
+    {
+        PROFILE_SCOPE("MeshOptimizer::OptimizeVertexCache");
+        auto triangleCount = static_cast<uint32_t>(indices.size() / 3);
+        if (triangleCount == 0)
+            return;
+
+        /// Vertex to triangle adjacency
+        std::vector<uint32_t> liveTriangles(vertexCount, 0);
+        for (auto index : indices)
+            liveTriangles[index]++;
+
+        std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+        for (uint32_t i = 0; i < vertexCount; ++i)
+            adjacencyOffsets[i + 1] = adjacencyOffsets[i] + liveTriangles[i];
+
+        std::vector<uint32_t> adjacency(indices.size());
+        {
+            auto fill = adjacencyOffsets;
+            for (uint32_t i = 0; i < indices.size(); ++i)
+                adjacency[fill[indices[i]]++] = i / 3;
+        }
+
+        std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+        std::vector<bool> emitted(triangleCount, false);
+        std::vector<uint32_t> deadEnds;
+        std::vector<uint32_t> candidates;
+        std::vector<uint32_t> result;
+        result.reserve(indices.size());
+
+        uint32_t time = VERTEX_CACHE_SIZE + 1;
+        uint32_t scanCursor = 0;
+        uint32_t fanningVertex = indices[0];
+
+        while (fanningVertex != INVALID_INDEX)
+        {
+            /// Emit all remaining triangles around fanning vertex
+            candidates.clear();
+            for (uint32_t k = adjacencyOffsets[fanningVertex]; k < adjacencyOffsets[fanningVertex + 1]; ++k)
+            {
+                uint32_t triangle = adjacency[k];
+                if (emitted[triangle])
+                    continue;
+
+                for (uint32_t j = 0; j < 3; ++j)
+                {
+                    uint32_t vertex = indices[triangle * 3 + j];
+                    result.push_back(vertex);
+                    deadEnds.push_back(vertex);
+                    candidates.push_back(vertex);
+                    liveTriangles[vertex]--;
+                    if (time - cacheTimestamps[vertex] > VERTEX_CACHE_SIZE)
+                        cacheTimestamps[vertex] = time++;
+                }
+                emitted[triangle] = true;
+            }
+
+            /// Next fanning vertex is the oldest candidate which stays in cache while its triangles are emitted
+            uint32_t next = INVALID_INDEX;
+            int32_t bestPriority = -1;
+            for (auto vertex : candidates)
+            {
+                if (liveTriangles[vertex] == 0)
+                    continue;
+
+                int32_t priority = 0;
+                uint32_t age = time - cacheTimestamps[vertex];
+                if (age + 2 * liveTriangles[vertex] <= VERTEX_CACHE_SIZE)
+                    priority = static_cast<int32_t>(age);
+
+                if (priority > bestPriority)
+                {
+                    bestPriority = priority;
+                    next = vertex;
+                }
+            }
+
+            /// Dead end, continue from recently used vertex or any vertex with live triangles
+            while (next == INVALID_INDEX && !deadEnds.empty())
+            {
+                uint32_t vertex = deadEnds.back();
+                deadEnds.pop_back();
+                if (liveTriangles[vertex] > 0)
+                    next = vertex;
+            }
+
+            while (next == INVALID_INDEX && scanCursor < vertexCount)
+            {
+                if (liveTriangles[scanCursor] > 0)
+                    next = scanCursor;
+                scanCursor++;
+            }
+
+            fanningVertex = next;
+        }
+
+        indices.swap(result);
+    }
+
+    void OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<float>& vertices, uint32_t stride, float threshold)
+    {
+        PROFILE_SCOPE("MeshOptimizer::OptimizeOverdraw");
+        auto triangleCount = static_cast<uint32_t>(indices.size() / 3);
+        auto vertexCount = static_cast<uint32_t>(vertices.size() / stride);
+        if (triangleCount < 2)
+            return;
+
+        /// Hard boundaries are where cache restarts anyway, all three vertices miss
+        VertexCache cache(vertexCount, VERTEX_CACHE_SIZE);
+        std::vector<uint32_t> hardClusters;
+        for (uint32_t i = 0; i < triangleCount; ++i)
+        {
+            if (cache.Access(&indices[i * 3]) == 3)
+                hardClusters.push_back(i);
+        }
+        hardClusters.push_back(triangleCount);
+
+        /// Soft boundaries split hard clusters where restarting cache keeps ACMR within threshold
+        std::vector<uint32_t> clusters;
+        for (size_t c = 0; c + 1 < hardClusters.size(); ++c)
+        {
+            uint32_t begin = hardClusters[c];
+            uint32_t end = hardClusters[c + 1];
+
+            cache.Reset();
+            uint32_t misses = 0;
+            for (uint32_t i = begin; i < end; ++i)
+                misses += cache.Access(&indices[i * 3]);
+            float clusterAcmr = static_cast<float>(misses) / (end - begin);
+
+            cache.Reset();
+            clusters.push_back(begin);
+            uint32_t clusterBegin = begin;
+            misses = 0;
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                misses += cache.Access(&indices[i * 3]);
+                if (i + 1 < end && static_cast<float>(misses) / (i + 1 - clusterBegin) <= clusterAcmr * threshold)
+                {
+                    clusterBegin = i + 1;
+                    clusters.push_back(clusterBegin);
+                    cache.Reset();
+                    misses = 0;
+                }
+            }
+        }
+        clusters.push_back(triangleCount);
+
+        auto position = [&vertices, stride](uint32_t index) { return vertices.data() + size_t(index) * stride; };
+
+        /// Area weighted centroids of mesh and clusters
+        struct ClusterSortData
+        {
+            uint32_t    cluster;
+            float       centroid[3];
+            float       normal[3];
+            float       key;
+        };
+
+        std::vector<ClusterSortData> sortData(clusters.size() - 1);
+        float meshCentroid[3] = {};
+        float meshArea = 0.0f;
+        for (uint32_t c = 0; c + 1 < clusters.size(); ++c)
+        {
+            auto& data = sortData[c];
+            data = { c, {}, {}, 0.0f };
+            float clusterArea = 0.0f;
+            for (uint32_t i = clusters[c]; i < clusters[c + 1]; ++i)
+            {
+                const float* p0 = position(indices[i * 3]);
+                const float* p1 = position(indices[i * 3 + 1]);
+                const float* p2 = position(indices[i * 3 + 2]);
+                float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+                float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+                float normal[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+                float area = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+
+                for (uint32_t k = 0; k < 3; ++k)
+                {
+                    data.centroid[k] += (p0[k] + p1[k] + p2[k]) / 3.0f * area;
+                    data.normal[k] += normal[k];
+                }
+                clusterArea += area;
+            }
+
+            for (uint32_t k = 0; k < 3; ++k)
+            {
+                meshCentroid[k] += data.centroid[k];
+                data.centroid[k] = clusterArea > 0.0f ? data.centroid[k] / clusterArea : 0.0f;
+            }
+            meshArea += clusterArea;
+        }
+
+        for (auto& value : meshCentroid)
+            value = meshArea > 0.0f ? value / meshArea : 0.0f;
+
+        /// Clusters facing away from mesh center are likely to occlude others, draw them first
+        for (auto& data : sortData)
+        {
+            float length = std::sqrt(data.normal[0] * data.normal[0] + data.normal[1] * data.normal[1] + data.normal[2] * data.normal[2]);
+            for (uint32_t k = 0; k < 3; ++k)
+                data.key += (data.centroid[k] - meshCentroid[k]) * (length > 0.0f ? data.normal[k] / length : 0.0f);
+        }
+
+        std::stable_sort(sortData.begin(), sortData.end(), [](const ClusterSortData& a, const ClusterSortData& b) { return a.key > b.key; });
+
+        std::vector<uint32_t> result;
+        result.reserve(indices.size());
+        for (const auto& data : sortData)
+            result.insert(result.end(), indices.begin() + clusters[data.cluster] * 3, indices.begin() + clusters[data.cluster + 1] * 3);
+
+        indices.swap(result);
+    }
+
+    void OptimizeVertexFetch(std::vector<float>& vertices, std::vector<uint32_t>& indices, uint32_t stride)
+    {
+        PROFILE_SCOPE("MeshOptimizer::OptimizeVertexFetch");
+        auto vertexCount = static_cast<uint32_t>(vertices.size() / stride);
+        std::vector<uint32_t> remap(vertexCount, INVALID_INDEX);
+        std::vector<float> result;
+        result.reserve(vertices.size());
+
+        uint32_t nextVertex = 0;
+        for (auto& index : indices)
+        {
+            if (remap[index] == INVALID_INDEX)
+            {
+                remap[index] = nextVertex++;
+                result.insert(result.end(), vertices.begin() + size_t(index) * stride, vertices.begin() + size_t(index + 1) * stride);
+            }
+            index = remap[index];
+        }
+
+        vertices.swap(result);
+    }
+
+    VertexCacheStatistics AnalyzeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize)
+    {
+        VertexCacheStatistics statistics{};
+        statistics.vertexCount = vertexCount;
+        statistics.triangleCount = static_cast<uint32_t>(indices.size() / 3);
+
+        VertexCache cache(vertexCount, cacheSize);
+        for (size_t i = 0; i + 2 < indices.size(); i += 3)
+            statistics.cacheMissCount += cache.Access(&indices[i]);
+
+        return statistics;
+    }
+} // namespace Fluent::MeshOptimizer
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace Fluent
+{
+    /// Post transform cache size assumed by optimization and analysis
+    static constexpr uint32_t VERTEX_CACHE_SIZE = 16;
+
+    struct VertexCacheStatistics
+    {
+        uint32_t    vertexCount = 0;
+        uint32_t    triangleCount = 0;
+        uint32_t    cacheMissCount = 0;
+
+        /// Average cache miss ratio, transformed vertices per triangle, 0.5 is ideal for large grids
+        float GetAcmr() const { return triangleCount ? static_cast<float>(cacheMissCount) / triangleCount : 0.0f; }
+        /// Average transform to vertex ratio, 1.0 is ideal
+        float GetAtvr() const { return vertexCount ? static_cast<float>(cacheMissCount) / vertexCount : 0.0f; }
+
+        void Add(const VertexCacheStatistics& other)
+        {
+            vertexCount += other.vertexCount;
+            triangleCount += other.triangleCount;
+            cacheMissCount += other.cacheMissCount;
+        }
+    };
+
+    /// Vertices are arrays of stride floats, position is first three of them.
+    /// All functions keep triangle winding
+    namespace MeshOptimizer
+    {
+        /// Merges bitwise identical vertices, returns new vertex count
+        uint32_t DeduplicateVertices(std::vector<float>& vertices, std::vector<uint32_t>& indices, uint32_t stride);
+
+        /// Tipsify triangle order for post transform vertex cache
+        void OptimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount);
+
+        /// Sorts cache friendly clusters of triangles front to back from outside view points.
+        /// Cluster is split only where ACMR stays below threshold times ACMR of current order
+        void OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<float>& vertices, uint32_t stride, float threshold = 1.05f);
+
+        /// Orders vertices by first use in index buffer, unused vertices are dropped
+        void OptimizeVertexFetch(std::vector<float>& vertices, std::vector<uint32_t>& indices, uint32_t stride);
+
+        /// FIFO cache simulation
+        VertexCacheStatistics AnalyzeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize = VERTEX_CACHE_SIZE);
+    }
+} // namespace Fluent
@@ -0,0 +1,295 @@
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include "Core/Log.hpp"
+#include "Core/Profiler.hpp"
+#include "Scene/MeshSimplifier.hpp"
+
+namespace Fluent
+{
+    struct SimplifierPosition
+    {
+        double x, y, z;
+    };
+
+    /// Symmetric 4x4 matrix of plane equations, Evaluate gives weighted squared distance to planes
+    struct Quadric
+    {
+        double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+        double a11 = 0, a12 = 0, a13 = 0;
+        double a22 = 0, a23 = 0;
+        double a33 = 0;
+        double weight = 0;
+
+        void AddPlane(double a, double b, double c, double d, double w)
+        {
+            a00 += w * a * a; a01 += w * a * b; a02 += w * a * c; a03 += w * a * d;
+            a11 += w * b * b; a12 += w * b * c; a13 += w * b * d;
+            a22 += w * c * c; a23 += w * c * d;
+            a33 += w * d * d;
+            weight += w;
+        }
+
+        void Add(const Quadric& q)
+        {
+            a00 += q.a00; a01 += q.a01; a02 += q.a02; a03 += q.a03;
+            a11 += q.a11; a12 += q.a12; a13 += q.a13;
+            a22 += q.a22; a23 += q.a23;
+            a33 += q.a33;
+            weight += q.weight;
+        }
+
+        double Evaluate(const SimplifierPosition& p) const
+        {
+            double x = p.x, y = p.y, z = p.z;
+            double result = a00 * x * x + 2 * a01 * x * y + 2 * a02 * x * z + 2 * a03 * x
+                          + a11 * y * y + 2 * a12 * y * z + 2 * a13 * y
+                          + a22 * z * z + 2 * a23 * z
+                          + a33;
+            return std::max(result, 0.0);
+        }
+    };
+
+    struct Collapse
+    {
+        uint32_t    from;
+        uint32_t    to;
+        /// Squared distance
+        double      error;
+    };
+
+    static SimplifierPosition Sub(const SimplifierPosition& a, const SimplifierPosition& b)
+    {
+        return { a.x - b.x, a.y - b.y, a.z - b.z };
+    }
+
+    static SimplifierPosition Cross(const SimplifierPosition& a, const SimplifierPosition& b)
+    {
+        return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+    }
+
+    static double Dot(const SimplifierPosition& a, const SimplifierPosition& b)
+    {
+        return a.x * b.x + a.y * b.y + a.z * b.z;
+    }
+
+    static uint64_t EdgeKey(uint32_t a, uint32_t b)
+    {
+        return a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a;
+    }
+
+    static double CollapseError(const std::vector<Quadric>& quadrics, const std::vector<SimplifierPosition>& positions, uint32_t from, uint32_t to)
+    {
+        Quadric q = quadrics[from];
+        q.Add(quadrics[to]);
+        return q.weight > 0 ? q.Evaluate(positions[to]) / q.weight : 0.0;
+    }
+
+    std::vector<uint32_t> SimplifyMesh(const SimplifyMeshDescription& description, float* resultError)
+    {
+        PROFILE_SCOPE("SimplifyMesh");
+        uint32_t indexCount = description.indexCount / 3 * 3;
+        if (indexCount != description.indexCount)
+            LOG_CATEGORY_WARN(eScene, "Index count {} is not multiple of 3, trailing indices are dropped", description.indexCount);
+
+        std::vector<uint32_t> result(description.indices, description.indices + indexCount);
+        if (resultError)
+            *resultError = 0.0f;
+
+        uint32_t vertexCount = description.vertexCount;
+        if (result.size() <= description.targetIndexCount || vertexCount == 0)
+            return result;
+
+        auto invalidIndex = std::find_if(result.begin(), result.end(), [vertexCount](uint32_t index) { return index >= vertexCount; });
+        if (invalidIndex != result.end())
+        {
+            LOG_CATEGORY_ERROR(eScene, "Index {} is out of range of {} vertices, mesh is not simplified", *invalidIndex, vertexCount);
+            return result;
+        }
+
+        std::vector<SimplifierPosition> positions(vertexCount);
+        SimplifierPosition minBounds = { INFINITY, INFINITY, INFINITY };
+        SimplifierPosition maxBounds = { -INFINITY, -INFINITY, -INFINITY };
+        for (uint32_t i = 0; i < vertexCount; ++i)
+        {
+            const float* vertex = description.vertices + size_t(i) * description.stride;
+            positions[i] = { vertex[0], vertex[1], vertex[2] };
+            minBounds = { std::min(minBounds.x, positions[i].x), std::min(minBounds.y, positions[i].y), std::min(minBounds.z, positions[i].z) };
+            maxBounds = { std::max(maxBounds.x, positions[i].x), std::max(maxBounds.y, positions[i].y), std::max(maxBounds.z, positions[i].z) };
+        }
+
+        double extent = std::max({ maxBounds.x - minBounds.x, maxBounds.y - minBounds.y, maxBounds.z - minBounds.z });
+        double maxErrorSquared = description.maxError * extent * description.maxError * extent;
+
+        /// Area weighted plane quadrics
+        std::vector<Quadric> quadrics(vertexCount);
+        for (size_t i = 0; i + 2 < result.size(); i += 3)
+        {
+            const auto& p0 = positions[result[i]];
+            auto normal = Cross(Sub(positions[result[i + 1]], p0), Sub(positions[result[i + 2]], p0));
+            double length = std::sqrt(Dot(normal, normal));
+            if (length == 0.0)
+                continue;
+
+            double a = normal.x / length, b = normal.y / length, c = normal.z / length;
+            double d = -(a * p0.x + b * p0.y + c * p0.z);
+            for (uint32_t j = 0; j < 3; ++j)
+                quadrics[result[i + j]].AddPlane(a, b, c, d, length * 0.5);
+        }
+
+        /// Edges which are not shared by exactly two triangles are borders, seams or non manifold
+        std::vector<bool> locked(vertexCount, false);
+        {
+            std::unordered_map<uint64_t, uint32_t> edgeUses;
+            edgeUses.reserve(result.size());
+            for (size_t i = 0; i + 2 < result.size(); i += 3)
+            {
+                for (uint32_t j = 0; j < 3; ++j)
+                    edgeUses[EdgeKey(result[i + j], result[i + (j + 1) % 3])]++;
+            }
+
+            for (const auto& [key, uses] : edgeUses)
+            {
+                if (uses != 2)
+                {
+                    locked[uint32_t(key >> 32)] = true;
+                    locked[uint32_t(key)] = true;
+                }
+            }
+        }
+
+        double resultErrorSquared = 0.0;
+        std::vector<Collapse> collapses;
+        std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+        std::vector<uint32_t> adjacency;
+        std::vector<bool> touched(vertexCount);
+
+        while (result.size() > description.targetIndexCount)
+        {
+            uint32_t triangleCount = static_cast<uint32_t>(result.size() / 3);
+            uint32_t targetTriangleCount = description.targetIndexCount / 3;
+
+            /// Cheapest direction of every edge, interior edges appear in both directions so one is skipped
+            collapses.clear();
+            for (size_t i = 0; i < result.size(); i += 3)
+            {
+                for (uint32_t j = 0; j < 3; ++j)
+                {
+                    uint32_t a = result[i + j];
+                    uint32_t b = result[i + (j + 1) % 3];
+                    if (a > b)
+                        continue;
+
+                    double errorAB = locked[a] ? INFINITY : CollapseError(quadrics, positions, a, b);
+                    double errorBA = locked[b] ? INFINITY : CollapseError(quadrics, positions, b, a);
+                    if (errorAB == INFINITY && errorBA == INFINITY)
+                        continue;
+
+                    if (errorAB <= errorBA)
+                        collapses.push_back({ a, b, errorAB });
+                    else
+                        collapses.push_back({ b, a, errorBA });
+                }
+            }
+
+            std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) { return x.error < y.error; });
+
+            /// Vertex to triangle adjacency of current indices
+            std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+            for (auto index : result)
+                adjacencyOffsets[index + 1]++;
+            for (uint32_t i = 0; i < vertexCount; ++i)
+                adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+            adjacency.resize(result.size());
+            {
+                auto fill = adjacencyOffsets;
+                for (size_t i = 0; i < result.size(); ++i)
+                    adjacency[fill[result[i]]++] = static_cast<uint32_t>(i / 3);
+            }
+
+            std::fill(touched.begin(), touched.end(), false);
+            uint32_t removedTriangles = 0;
+            uint32_t appliedCollapses = 0;
+            for (const auto& collapse : collapses)
+            {
+                if (collapse.error > maxErrorSquared || triangleCount - removedTriangles <= targetTriangleCount)
+                    break;
+                if (touched[collapse.from] || touched[collapse.to])
+                    continue;
+
+                /// Reject collapses which flip any remaining triangle
+                bool flips = false;
+                uint32_t collapsedTriangles = 0;
+                for (uint32_t k = adjacencyOffsets[collapse.from]; k < adjacencyOffsets[collapse.from + 1] && !flips; ++k)
+                {
+                    const uint32_t* triangle = &result[adjacency[k] * 3];
+                    if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+                    {
+                        collapsedTriangles++;
+                        continue;
+                    }
+
+                    SimplifierPosition before[3], after[3];
+                    for (uint32_t j = 0; j < 3; ++j)
+                    {
+                        before[j] = positions[triangle[j]];
+                        after[j] = triangle[j] == collapse.from ? positions[collapse.to] : before[j];
+                    }
+
+                    auto normalBefore = Cross(Sub(before[1], before[0]), Sub(before[2], before[0]));
+                    auto normalAfter = Cross(Sub(after[1], after[0]), Sub(after[2], after[0]));
+                    /// Normal may rotate by up to about 75 degrees
+                    double lengths = std::sqrt(Dot(normalBefore, normalBefore) * Dot(normalAfter, normalAfter));
+                    flips = Dot(normalBefore, normalAfter) <= 0.25 * lengths;
+                }
+
+                if (flips)
+                    continue;
+
+                /// Vertices of affected triangles are not collapsed again in this pass,
+                /// so flip test above stays valid
+                for (uint32_t k = adjacencyOffsets[collapse.from]; k < adjacencyOffsets[collapse.from + 1]; ++k)
+                {
+                    const uint32_t* triangle = &result[adjacency[k] * 3];
+                    touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = true;
+                }
+
+                for (uint32_t k = adjacencyOffsets[collapse.from]; k < adjacencyOffsets[collapse.from + 1]; ++k)
+                {
+                    uint32_t* triangle = &result[adjacency[k] * 3];
+                    for (uint32_t j = 0; j < 3; ++j)
+                    {
+                        if (triangle[j] == collapse.from)
+                            triangle[j] = collapse.to;
+                    }
+                }
+
+                quadrics[collapse.to].Add(quadrics[collapse.from]);
+                resultErrorSquared = std::max(resultErrorSquared, collapse.error);
+                removedTriangles += collapsedTriangles;
+                appliedCollapses++;
+            }
+
+            if (appliedCollapses == 0)
+                break;
+
+            /// Drop triangles which became degenerate
+            size_t write = 0;
+            for (size_t i = 0; i < result.size(); i += 3)
+            {
+                uint32_t a = result[i], b = result[i + 1], c = result[i + 2];
+                if (a == b || b == c || a == c)
+                    continue;
+
+                result[write++] = a;
+                result[write++] = b;
+                result[write++] = c;
+            }
+            result.resize(write);
+        }
+
+        if (resultError)
+            *resultError = static_cast<float>(std::sqrt(resultErrorSquared));
+        return result;
+    }
+} // namespace Fluent
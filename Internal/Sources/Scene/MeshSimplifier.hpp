@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace Fluent
+{
+    struct SimplifyMeshDescription
+    {
+        /// Position is first three floats of every vertex
+        const float*    vertices = nullptr;
+        uint32_t        vertexCount = 0;
+        /// Vertex stride in floats
+        uint32_t        stride = 3;
+        const uint32_t* indices = nullptr;
+        uint32_t        indexCount = 0;
+        uint32_t        targetIndexCount = 0;
+        /// Max allowed error relative to mesh extent
+        float           maxError = 0.05f;
+    };
+
+    /// Quadric error edge collapse. Vertices are neither moved nor created, so simplified
+    /// indices can share vertex buffer with source mesh. Border and attribute seam vertices
+    /// are locked. Error is object space distance from source surface. Trailing indices which don't
+    /// form triangle are dropped, indices are returned unchanged when some is out of vertex range
+    std::vector<uint32_t> SimplifyMesh(const SimplifyMeshDescription& description, float* resultError = nullptr);
+} // namespace Fluent
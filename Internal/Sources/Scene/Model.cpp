@@ -1,7 +1,14 @@
+#include <algorithm>
+#include <cmath>
 #include "Scene/Model.hpp"
 
 namespace Fluent
 {
+    float GetLodScale(float verticalFov, uint32_t viewportHeight, float distance)
+    {
+        return static_cast<float>(viewportHeight) / (2.0f * std::tan(verticalFov * 0.5f) * std::max(distance, 1e-4f));
+    }
+
     void Mesh::InitMesh()
     {
         BufferDescription bufferDesc{};
@@ -9,6 +16,7 @@ namespace Fluent
         bufferDesc.memoryUsage = MemoryUsage::eGpu;
         bufferDesc.size = vertices.size() * sizeof(vertices[0]);
         bufferDesc.data = vertices.data();
+        bufferDesc.memoryTag = MemoryTag::eMesh;
 
         vertexBuffer = Buffer::Create(bufferDesc);
 
@@ -17,15 +25,47 @@ namespace Fluent
         bufferDesc.memoryUsage = MemoryUsage::eGpu;
         bufferDesc.size = indices.size() * sizeof(indices[0]);
         bufferDesc.data = indices.data();
+        bufferDesc.memoryTag = MemoryTag::eMesh;
 
         indexBuffer = Buffer::Create(bufferDesc);
     }
 
-    Mesh::Mesh(std::vector<float> vertices, std::vector<uint32_t> indices, Material material)
+    uint32_t Mesh::SelectLod(float lodScale, uint32_t currentLod, float maxPixelError) const
+    {
+        if (lods.empty())
+            return 0;
+
+        auto lastLod = static_cast<uint32_t>(lods.size() - 1);
+        currentLod = std::min(currentLod, lastLod);
+
+        auto coarsestBelow = [this, lodScale](float threshold)
+        {
+            uint32_t lod = 0;
+            while (lod + 1 < lods.size() && lods[lod + 1].error * lodScale <= threshold)
+                lod++;
+            return lod;
+        };
+
+        /// Switch to coarser lod only when it is clearly good enough
+        uint32_t coarser = coarsestBelow(maxPixelError * (1.0f - LOD_HYSTERESIS));
+        if (coarser > currentLod)
+            return coarser;
+
+        /// Switch to finer lod only when current is clearly too coarse
+        if (lods[currentLod].error * lodScale > maxPixelError * (1.0f + LOD_HYSTERESIS))
+            return coarsestBelow(maxPixelError);
+
+        return currentLod;
+    }
+
+    Mesh::Mesh(std::vector<float> vertices, std::vector<uint32_t> indices, Material material, std::vector<MeshLod> lods)
         : vertices(std::move(vertices))
         , indices(std::move(indices))
+        , lods(std::move(lods))
         , material(std::move(material))
     {
+        if (this->lods.empty())
+            this->lods.push_back({ 0, static_cast<uint32_t>(this->indices.size()), 0.0f });
         InitMesh();
     }
 }
\ No newline at end of file
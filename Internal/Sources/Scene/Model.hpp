@@ -2,7 +2,9 @@
 
 #include <vector>
 #include "Renderer/Buffer.hpp"
+#include "Renderer/TextureStreamer.hpp"
 #include "Math/Math.hpp"
+#include "Scene/TransformHierarchy.hpp"
 
 namespace Fluent
 {
@@ -19,23 +21,60 @@ namespace Fluent
         TextureIndices textureIndices;
     };
 
+    /// Per instance vertex streams bound next to mesh vertex buffer (binding 0)
+    static constexpr uint32_t INSTANCE_TRANSFORM_BINDING = 1;
+    static constexpr uint32_t INSTANCE_MATERIAL_BINDING = 2;
+
+    /// Range of mesh index buffer
+    struct MeshLod
+    {
+        uint32_t    firstIndex = 0;
+        uint32_t    indexCount = 0;
+        /// Object space distance from full detail surface
+        float       error = 0.0f;
+    };
+
+    /// Relative margin around lod switch threshold, prevents lods from flickering
+    static constexpr float LOD_HYSTERESIS = 0.25f;
+
+    /// Pixels covered by one object space unit at given view distance, scale it by object scale
+    float GetLodScale(float verticalFov, uint32_t viewportHeight, float distance);
+
     struct Mesh
     {
         std::vector<float>          vertices;
+        /// Indices of all lods, one after another
         std::vector<uint32_t>       indices;
+        /// First one is full detail, error grows with index
+        std::vector<MeshLod>        lods;
         Ref<Buffer>                 vertexBuffer;
         Ref<Buffer>                 indexBuffer;
+        /// Object space bounds
+        Vector3                     boundsMin = Vector3(0.0f);
+        Vector3                     boundsMax = Vector3(0.0f);
+        /// World transform at load time, node tracks it in model hierarchy
         Matrix4                     transform;
+        TransformHierarchy::NodeId  node = TransformHierarchy::INVALID_NODE;
         Material                    material;
 
         void InitMesh();
 
-        Mesh(std::vector<float> vertices, std::vector<uint32_t> indices, Material material);
+        /// Coarsest lod with screen space error below maxPixelError. Current lod is kept
+        /// while its error stays within LOD_HYSTERESIS of threshold
+        uint32_t SelectLod(float lodScale, uint32_t currentLod, float maxPixelError = 1.0f) const;
+
+        /// Without lods whole index buffer is one lod
+        Mesh(std::vector<float> vertices, std::vector<uint32_t> indices, Material material, std::vector<MeshLod> lods = {});
     };
 
     struct Model
     {
         std::vector<Mesh> meshes;
         std::vector<Ref<Image>> textures;
+        /// Replaces textures when model is loaded through texture streamer, same indices.
+        /// Failed loads are nullptr
+        std::vector<Ref<StreamedTexture>> streamedTextures;
+        /// One node per source scene node
+        TransformHierarchy hierarchy;
     };
 }
\ No newline at end of file
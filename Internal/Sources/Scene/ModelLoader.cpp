@@ -1,8 +1,47 @@
+#include <algorithm>
+#include <assimp/DefaultIOSystem.h>
+#include <assimp/MemoryIOWrapper.h>
 #include "Scene/ModelLoader.hpp"
 #include "Core/FileSystem.hpp"
+#include "Core/Profiler.hpp"
+#include "Scene/MeshSimplifier.hpp"
 
 namespace Fluent
 {
+    /// Model and files it references are read from mounted archives when they are there
+    class ArchiveIOSystem : public Assimp::DefaultIOSystem
+    {
+    public:
+        bool Exists(const char* file) const override
+        {
+            return FileSystem::IsArchived(file) || Assimp::DefaultIOSystem::Exists(file);
+        }
+
+        Assimp::IOStream* Open(const char* file, const char* mode) override
+        {
+            if (!FileSystem::IsArchived(file))
+                return Assimp::DefaultIOSystem::Open(file, mode);
+
+            auto size = static_cast<size_t>(FileSystem::GetFileSize(file));
+            if (auto mapped = FileSystem::MapFile(file))
+                return new Assimp::MemoryIOStream(static_cast<const uint8_t*>(mapped), size);
+
+            auto data = new uint8_t[size];
+            if (!FileSystem::ReadFile(file, data))
+            {
+                delete[] data;
+                return nullptr;
+            }
+
+            return new Assimp::MemoryIOStream(data, size, true);
+        }
+
+        void Close(Assimp::IOStream* file) override
+        {
+            delete file;
+        }
+    };
+
     void ModelLoader::CountStride(const LoadModelDescription& desc)
     {
         mStride += 3;
@@ -31,57 +70,171 @@ namespace Fluent
         }
     }
 
-    Model ModelLoader::Load(const LoadModelDescription& desc)
+    LoadModelDescription ModelLoader::StripUnusedStreams(const LoadModelDescription& desc)
+    {
+        LoadModelDescription result = desc;
+        if (!desc.vertexShader)
+            return result;
+
+        auto reads = [&desc](VertexSemantic semantic)
+        {
+            auto& inputs = desc.vertexShader->GetInputAttributes();
+            return std::any_of(inputs.begin(), inputs.end(), [semantic](const auto& input)
+            {
+                return input.used && input.semantic == semantic;
+            });
+        };
+
+        result.loadNormals = reads(VertexSemantic::eNormal);
+        result.loadTexCoords = reads(VertexSemantic::eTexCoord);
+        result.loadTangents = reads(VertexSemantic::eTangent);
+        result.loadBitangents = reads(VertexSemantic::eBitangent);
+
+        /// Shader decides, but requested streams going away silently usually means wrong semantics
+        auto warnDropped = [&desc](bool requested, bool loaded, const char* stream)
+        {
+            if (requested && !loaded)
+                LOG_CATEGORY_WARN(eScene, "{}: {} are not read by vertex shader {}, stream is not loaded", desc.filename, stream, desc.vertexShader->GetFilename());
+        };
+
+        warnDropped(desc.loadNormals, result.loadNormals, "normals");
+        warnDropped(desc.loadTexCoords, result.loadTexCoords, "tex coords");
+        warnDropped(desc.loadTangents, result.loadTangents, "tangents");
+        warnDropped(desc.loadBitangents, result.loadBitangents, "bitangents");
+
+        for (const auto& input : desc.vertexShader->GetInputAttributes())
+        {
+            if (input.used && input.semantic == VertexSemantic::eUnknown)
+                LOG_CATEGORY_WARN(eScene, "{}: input {} at location {} has no semantic, it is matched by location only", desc.filename, input.name, input.location);
+        }
+
+        return result;
+    }
+
+    void ModelLoader::Load(const LoadModelDescription& desc, ModelLoadCallback callback)
     {
         mDirectory = std::string(desc.filename.substr(0, desc.filename.find_last_of('/')));
-        CountStride(desc);
-        return Load(desc.filename);
+        mInstanced = desc.instanced;
+        mLodCount = std::max(desc.lodCount, 1u);
+        mLodReduction = desc.lodReduction;
+        mLodMaxError = desc.lodMaxError;
+        mOptimizeMeshes = desc.optimizeMeshes;
+        mOptimizeOverdraw = desc.optimizeOverdraw;
+        mTextureStreamer = desc.textureStreamer;
+        CountStride(StripUnusedStreams(desc));
+        Load(desc.filename, std::move(callback));
     }
 
-    Model ModelLoader::Load(const std::string& filename)
+    void ModelLoader::Load(const std::string& filename, ModelLoadCallback callback)
     {
+        PROFILE_SCOPE("ModelLoader::Load");
         Assimp::Importer importer;
-        const aiScene* scene = importer.ReadFile(FileSystem::GetModelsDirectory() + "/" + filename, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+        importer.SetIOHandler(new ArchiveIOSystem());
+        /// Lods need vertices shared between faces whether meshes are optimized or not
+        const aiScene* scene = importer.ReadFile(FileSystem::GetModelsDirectory() + "/" + filename, aiProcess_Triangulate | aiProcess_JoinIdenticalVertices | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
 
         if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
         {
-            LOG_WARN("ASSIMP ERROR: {}", importer.GetErrorString());
-            return {};
+            LOG_CATEGORY_WARN(eScene, "ASSIMP ERROR: {}", importer.GetErrorString());
+            Model model;
+            callback(model);
+            return;
         }
 
         Model model;
-        ProcessNode(model, scene->mRootNode, scene);
+        mCacheStatisticsBefore = {};
+        mCacheStatisticsAfter = {};
+        mTexturesLoaded.clear();
+        ProcessNode(model, scene->mRootNode, scene, TransformHierarchy::INVALID_NODE);
+        LOG_CATEGORY_INFO(eScene, "{} vertex cache ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}", filename,
+                          mCacheStatisticsBefore.GetAcmr(), mCacheStatisticsAfter.GetAcmr(),
+                          mCacheStatisticsBefore.GetAtvr(), mCacheStatisticsAfter.GetAtvr());
+        model.hierarchy.Update();
+        for (auto& mesh : model.meshes)
+            mesh.transform = model.hierarchy.GetWorldTransform(mesh.node);
+
+        LoadTextures(std::move(model), std::move(callback));
+    }
 
-        model.textures.resize(mTexturesLoaded.size());
+    void ModelLoader::LoadTextures(Model&& model, ModelLoadCallback callback)
+    {
+        PROFILE_SCOPE("ModelLoader::LoadTextures");
+        if (mTextureStreamer)
+        {
+            model.streamedTextures.reserve(mTexturesLoaded.size());
+            for (const auto& texture : mTexturesLoaded)
+                model.streamedTextures.push_back(mTextureStreamer->Load(texture.filename));
+
+            callback(model);
+            return;
+        }
+
+        /// Image::Create copies mapped archive entries itself, so only other files are read here
+        std::vector<std::string> paths;
+        std::vector<bool> mapped(mTexturesLoaded.size());
         for (uint32_t i = 0; i < mTexturesLoaded.size(); ++i)
-            model.textures[i] = mTexturesLoaded[i].texture;
+        {
+            auto path = FileSystem::GetTexturesDirectory() + mTexturesLoaded[i].filename;
+            mapped[i] = FileSystem::MapFile(path) != nullptr;
+            if (!mapped[i])
+                paths.push_back(std::move(path));
+        }
 
-        return model;
+        auto loaded = CreateRef<Model>(std::move(model));
+        FileSystem::ReadFiles(paths, [loaded, mapped, textures = mTexturesLoaded, callback = std::move(callback)](std::vector<std::vector<char>>& files)
+        {
+            PROFILE_SCOPE("ModelLoader::CreateTextures");
+            size_t fileIndex = 0;
+            loaded->textures.reserve(textures.size());
+            for (uint32_t i = 0; i < textures.size(); ++i)
+            {
+                ImageDescription imageDesc{};
+                imageDesc.initialUsage = ImageUsage::Bits::eSampled;
+                imageDesc.filename = textures[i].filename;
+                imageDesc.memoryTag = MemoryTag::eTexture;
+                /// Failed reads are left empty, so image reports them when reading again
+                if (!mapped[i])
+                {
+                    const auto& file = files[fileIndex++];
+                    if (!file.empty())
+                    {
+                        imageDesc.fileData = file.data();
+                        imageDesc.fileDataSize = file.size();
+                    }
+                }
+
+                loaded->textures.push_back(Image::Create(imageDesc));
+            }
+
+            callback(*loaded);
+        });
     }
 
-    void ModelLoader::ProcessNode(Model& model, aiNode *node, const aiScene *scene)
+    void ModelLoader::ProcessNode(Model& model, aiNode *node, const aiScene *scene, TransformHierarchy::NodeId parent)
     {
+        auto& t = node->mTransformation;
+        auto hierarchyNode = model.hierarchy.AddNode(Matrix4(t.a1, t.b1, t.c1, t.d1,
+                                                             t.a2, t.b2, t.c2, t.d2,
+                                                             t.a3, t.b3, t.c3, t.d3,
+                                                             t.a4, t.b4, t.c4, t.d4), parent);
+
         for (uint32_t i = 0; i < node->mNumMeshes; i++)
         {
             aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
             model.meshes.push_back(ProcessMesh(mesh, scene));
-            auto& t = node->mTransformation;
-            model.meshes.back().transform = Matrix4(t.a1, t.b1, t.c1, t.d1,
-                                                    t.a2, t.b2, t.c2, t.d2,
-                                                    t.a3, t.b3, t.c3, t.d3,
-                                                    t.a4, t.b4, t.c4, t.d4);
+            model.meshes.back().node = hierarchyNode;
         }
 
         for (uint32_t i = 0; i < node->mNumChildren; i++)
         {
-            ProcessNode(model, node->mChildren[i], scene);
+            ProcessNode(model, node->mChildren[i], scene, hierarchyNode);
         }
     }
 
     Mesh ModelLoader::ProcessMesh(aiMesh *mesh, const aiScene *scene)
     {
         // data to fill
-        LOG_INFO(mesh->mNumVertices * mStride);
+        LOG_CATEGORY_TRACE(eScene, "Mesh with {} vertices", mesh->mNumVertices);
         std::vector<float> vertices(mesh->mNumVertices * mStride);
         std::vector<uint32_t> indices;
         std::vector<LoadedTexture> textures;
@@ -171,7 +324,81 @@ namespace Fluent
         meshMaterial.textureIndices.height = prevTexSize != textures.size() ? textures.size() - 1 : -1;
         prevTexSize = textures.size();
 
-        return Mesh(vertices, indices, meshMaterial);
+        /// Stripped streams can make vertices identical, duplicates are removed before measuring
+        /// so statistics compare orders of the same vertices
+        uint32_t vertexCount = mesh->mNumVertices;
+        if (mOptimizeMeshes)
+            vertexCount = MeshOptimizer::DeduplicateVertices(vertices, indices, mStride);
+
+        mCacheStatisticsBefore.Add(MeshOptimizer::AnalyzeVertexCache(indices, vertexCount));
+        if (mOptimizeMeshes)
+            OptimizeMesh(vertices, indices, vertexCount);
+        mCacheStatisticsAfter.Add(MeshOptimizer::AnalyzeVertexCache(indices, static_cast<uint32_t>(vertices.size() / mStride)));
+
+        auto lods = GenerateLods(vertices, indices);
+        Mesh result(std::move(vertices), std::move(indices), meshMaterial, std::move(lods));
+
+        if (mesh->mNumVertices)
+        {
+            const auto& first = mesh->mVertices[0];
+            result.boundsMin = result.boundsMax = Vector3(first.x, first.y, first.z);
+        }
+        for (uint32_t i = 1; i < mesh->mNumVertices; ++i)
+        {
+            Vector3 position(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
+            result.boundsMin = glm::min(result.boundsMin, position);
+            result.boundsMax = glm::max(result.boundsMax, position);
+        }
+        return result;
+    }
+
+    void ModelLoader::OptimizeMesh(std::vector<float>& vertices, std::vector<uint32_t>& indices, uint32_t vertexCount)
+    {
+        MeshOptimizer::OptimizeVertexCache(indices, vertexCount);
+        if (mOptimizeOverdraw)
+            MeshOptimizer::OptimizeOverdraw(indices, vertices, mStride);
+        MeshOptimizer::OptimizeVertexFetch(vertices, indices, mStride);
+    }
+
+    std::vector<MeshLod> ModelLoader::GenerateLods(const std::vector<float>& vertices, std::vector<uint32_t>& indices) const
+    {
+        std::vector<MeshLod> lods;
+        lods.push_back({ 0, static_cast<uint32_t>(indices.size()), 0.0f });
+
+        SimplifyMeshDescription simplifyDesc{};
+        simplifyDesc.vertices = vertices.data();
+        simplifyDesc.vertexCount = static_cast<uint32_t>(vertices.size() / mStride);
+        simplifyDesc.stride = mStride;
+        simplifyDesc.maxError = mLodMaxError;
+
+        float targetIndexCount = static_cast<float>(indices.size());
+        for (uint32_t i = 1; i < mLodCount; ++i)
+        {
+            targetIndexCount *= mLodReduction;
+            /// Lods are simplified from full detail indices, so error is measured against source surface
+            simplifyDesc.indices = indices.data();
+            simplifyDesc.indexCount = lods[0].indexCount;
+            simplifyDesc.targetIndexCount = static_cast<uint32_t>(targetIndexCount) / 3 * 3;
+
+            float error = 0.0f;
+            auto lodIndices = SimplifyMesh(simplifyDesc, &error);
+            /// Error limit or locked seams stopped simplification
+            if (lodIndices.empty() || lodIndices.size() * 10 > lods.back().indexCount * 9)
+                break;
+
+            if (mOptimizeMeshes)
+                MeshOptimizer::OptimizeVertexCache(lodIndices, simplifyDesc.vertexCount);
+
+            MeshLod lod{};
+            lod.firstIndex = static_cast<uint32_t>(indices.size());
+            lod.indexCount = static_cast<uint32_t>(lodIndices.size());
+            lod.error = std::max(error, lods.back().error);
+            lods.push_back(lod);
+            indices.insert(indices.end(), lodIndices.begin(), lodIndices.end());
+        }
+
+        LOG_CATEGORY_TRACE(eScene, "Generated {} lods, coarsest has {} of {} indices", lods.size(), lods.back().indexCount, lods[0].indexCount);
+        return lods;
     }
 
     std::vector<ModelLoader::LoadedTexture> ModelLoader::LoadMaterialTextures(aiMaterial *mat, aiTextureType type, std::string typeName)
@@ -197,14 +424,10 @@ namespace Fluent
             {
                 std::string texName = str.C_Str();
                 texName = texName + ".ktx";
-                LOG_INFO(texName);
-                ImageDescription imageDesc{};
-                imageDesc.initialUsage = ImageUsage::Bits::eSampled;
-                imageDesc.filename = mDirectory + "/" + texName;
-
+                LOG_CATEGORY_DEBUG(eScene, "Loaded texture {}", texName);
                 LoadedTexture texture{};
                 texture.name = typeName;
-                texture.texture = Image::Create(imageDesc);
+                texture.filename = mDirectory + "/" + texName;
 
                 textures.push_back(texture);
                 mTexturesLoaded.push_back(texture);
@@ -221,7 +444,20 @@ namespace Fluent
         result.stride = mStride * sizeof(float);
         result.inputRate = VertexInputRate::eVertex;
 
-        return { result };
+        if (!mInstanced)
+            return { result };
+
+        VertexBindingDescription transformBinding;
+        transformBinding.binding = INSTANCE_TRANSFORM_BINDING;
+        transformBinding.stride = sizeof(Matrix4);
+        transformBinding.inputRate = VertexInputRate::eInstance;
+
+        VertexBindingDescription materialBinding;
+        materialBinding.binding = INSTANCE_MATERIAL_BINDING;
+        materialBinding.stride = sizeof(TextureIndices);
+        materialBinding.inputRate = VertexInputRate::eInstance;
+
+        return { result, transformBinding, materialBinding };
     }
 
     std::vector<VertexAttributeDescription> ModelLoader::GetVertexAttributeDescription()
@@ -234,6 +470,7 @@ namespace Fluent
             desc.binding = 0;
             desc.format = Format::eR32G32B32Sfloat;
             desc.offset = 0;
+            desc.semantic = VertexSemantic::ePosition;
         }
         // Normals
         if (mNormalOffset > -1)
@@ -243,6 +480,7 @@ namespace Fluent
             desc.binding = 0;
             desc.offset = mNormalOffset * sizeof(float);
             desc.format = Format::eR32G32B32Sfloat;
+            desc.semantic = VertexSemantic::eNormal;
         }
         // TexCoords
         if (mTexCoordOffset > -1)
@@ -252,6 +490,7 @@ namespace Fluent
             desc.binding = 0;
             desc.offset = mTexCoordOffset * sizeof(float);
             desc.format = Format::eR32G32Sfloat;
+            desc.semantic = VertexSemantic::eTexCoord;
         }
         // Tangents
         if (mTangentsOffset > -1)
@@ -261,6 +500,7 @@ namespace Fluent
             desc.binding = 0;
             desc.offset = mTangentsOffset * sizeof(float);
             desc.format = Format::eR32G32B32Sfloat;
+            desc.semantic = VertexSemantic::eTangent;
         }
         // Bitangents
         if (mBitangentsOffset > -1)
@@ -270,6 +510,27 @@ namespace Fluent
             desc.binding = 0;
             desc.offset = mBitangentsOffset * sizeof(float);
             desc.format = Format::eR32G32B32Sfloat;
+            desc.semantic = VertexSemantic::eBitangent;
+        }
+        // Instance transform takes one location per column
+        if (mInstanced)
+        {
+            for (uint32_t column = 0; column < 4; ++column)
+            {
+                auto& desc = result.emplace_back();
+                desc.location = static_cast<uint32_t>(result.size() - 1);
+                desc.binding = INSTANCE_TRANSFORM_BINDING;
+                desc.offset = column * sizeof(Vector4);
+                desc.format = Format::eR32G32B32A32Sfloat;
+                desc.semantic = VertexSemantic::eInstanceTransform;
+            }
+
+            auto& desc = result.emplace_back();
+            desc.location = static_cast<uint32_t>(result.size() - 1);
+            desc.binding = INSTANCE_MATERIAL_BINDING;
+            desc.offset = 0;
+            desc.format = Format::eR32G32B32A32Sint;
+            desc.semantic = VertexSemantic::eInstanceMaterial;
         }
 
         return result;
@@ -1,12 +1,17 @@
 #pragma once
 
 #include <cstdint>
+#include <functional>
 #include <string>
+#include <vector>
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
 #include "Renderer/Image.hpp"
+#include "Renderer/Shader.hpp"
+#include "Renderer/TextureStreamer.hpp"
+#include "Scene/MeshOptimizer.hpp"
 #include "Scene/Model.hpp"
 
 namespace Fluent
@@ -18,8 +23,27 @@ namespace Fluent
         bool loadTexCoords;
         bool loadTangents;
         bool loadBitangents;
+        /// Emit per instance transform and material attributes, see InstanceBatch
+        bool instanced = false;
+        /// Lods generated per mesh including full detail one, see Mesh::SelectLod
+        uint32_t lodCount = 1;
+        /// Target index count of each lod relative to previous one
+        float lodReduction = 0.5f;
+        /// Max simplification error relative to mesh extent
+        float lodMaxError = 0.05f;
+        /// Merge identical vertices, reorder triangles for vertex cache and vertices for fetch
+        bool optimizeMeshes = true;
+        /// Also reorder triangle clusters to reduce overdraw, costs a bit of vertex cache efficiency
+        bool optimizeOverdraw = false;
+        /// When set, only streams which shader reads are loaded and load flags are ignored
+        Ref<Shader> vertexShader;
+        /// When set, textures go to Model::streamedTextures instead of being read up front
+        TextureStreamer* textureStreamer = nullptr;
     };
 
+    /// Called on main thread when textures of model are created, see FileSystem::ReadFiles
+    using ModelLoadCallback = std::function<void(Model& model)>;
+
     class ModelLoader
     {
     private:
@@ -36,27 +60,52 @@ namespace Fluent
         struct LoadedTexture
         {
             std::string name;
-            Ref<Image> texture;
+            /// Relative to textures directory
+            std::string filename;
         };
 
         uint32_t                    mStride = 0;
+        bool                        mInstanced = false;
+        uint32_t                    mLodCount = 1;
+        float                       mLodReduction = 0.5f;
+        float                       mLodMaxError = 0.05f;
+        bool                        mOptimizeMeshes = true;
+        bool                        mOptimizeOverdraw = false;
+        VertexCacheStatistics       mCacheStatisticsBefore;
+        VertexCacheStatistics       mCacheStatisticsAfter;
         std::vector<LoadedTexture>  mTexturesLoaded;
         std::string                 mDirectory;
+        TextureStreamer*            mTextureStreamer = nullptr;
+
+        void Load(const std::string& filename, ModelLoadCallback callback);
 
-        [[nodiscard]]
-        Model Load(const std::string& filename);
+        /// Ktx files of all materials are read in one batch, images are created when it finishes.
+        /// With texture streamer they are loaded through it and callback is called right away
+        void LoadTextures(Model&& model, ModelLoadCallback callback);
 
-        void ProcessNode(Model& model, aiNode *node, const aiScene *scene);
+        void ProcessNode(Model& model, aiNode *node, const aiScene *scene, TransformHierarchy::NodeId parent);
 
         Mesh ProcessMesh(aiMesh *mesh, const aiScene *scene);
 
+        void OptimizeMesh(std::vector<float>& vertices, std::vector<uint32_t>& indices, uint32_t vertexCount);
+
+        /// Appends simplified lods to indices
+        std::vector<MeshLod> GenerateLods(const std::vector<float>& vertices, std::vector<uint32_t>& indices) const;
+
         std::vector<LoadedTexture> LoadMaterialTextures(aiMaterial *mat, aiTextureType type, std::string typeName);
 
         void CountStride(const LoadModelDescription& desc);
 
+        static LoadModelDescription StripUnusedStreams(const LoadModelDescription& desc);
+
     public:
-        [[nodiscard]]
-        Model Load(const LoadModelDescription& desc);
+        /// Meshes are processed before return, callback gets model once its textures are read.
+        /// Model which fails to import is passed empty right away
+        void Load(const LoadModelDescription& desc, ModelLoadCallback callback);
+
+        /// Full detail indices of all meshes of last loaded model, before and after optimization
+        const VertexCacheStatistics& GetCacheStatisticsBefore() const { return mCacheStatisticsBefore; }
+        const VertexCacheStatistics& GetCacheStatisticsAfter() const { return mCacheStatisticsAfter; }
 
         std::vector<VertexBindingDescription> GetVertexBindingDescription();
         std::vector<VertexAttributeDescription> GetVertexAttributeDescription();
@@ -0,0 +1,136 @@
+#include <algorithm>
+#include <cassert>
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#endif
+#include "Scene/TransformHierarchy.hpp"
+
+namespace Fluent
+{
+    static_assert(sizeof(Matrix4) == 16 * sizeof(float), "Matrix4 must be 16 packed floats");
+
+    /// result = a * b, column major. Result must not alias inputs
+    static inline void MultiplyMatrices(const Matrix4& a, const Matrix4& b, Matrix4& result)
+    {
+        const float* lhs = &a[0][0];
+        const float* rhs = &b[0][0];
+        float* out = &result[0][0];
+#if defined(__AVX__)
+        /// Two result columns per iteration, each lane holds whole lhs column
+        __m256 column0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(lhs));
+        __m256 column1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(lhs + 4));
+        __m256 column2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(lhs + 8));
+        __m256 column3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(lhs + 12));
+        for (uint32_t i = 0; i < 16; i += 8)
+        {
+            /// Splat each rhs component within its 128 bit lane
+            __m256 columns = _mm256_loadu_ps(rhs + i);
+            __m256 x = _mm256_permute_ps(columns, 0x00);
+            __m256 y = _mm256_permute_ps(columns, 0x55);
+            __m256 z = _mm256_permute_ps(columns, 0xAA);
+            __m256 w = _mm256_permute_ps(columns, 0xFF);
+            __m256 sum = _mm256_add_ps
+                (
+                    _mm256_add_ps(_mm256_mul_ps(column0, x), _mm256_mul_ps(column1, y)),
+                    _mm256_add_ps(_mm256_mul_ps(column2, z), _mm256_mul_ps(column3, w))
+                );
+            _mm256_storeu_ps(out + i, sum);
+        }
+#elif defined(__SSE__) || defined(_M_X64)
+        __m128 column0 = _mm_loadu_ps(lhs);
+        __m128 column1 = _mm_loadu_ps(lhs + 4);
+        __m128 column2 = _mm_loadu_ps(lhs + 8);
+        __m128 column3 = _mm_loadu_ps(lhs + 12);
+        for (uint32_t i = 0; i < 16; i += 4)
+        {
+            __m128 sum = _mm_add_ps
+                (
+                    _mm_add_ps(_mm_mul_ps(column0, _mm_set1_ps(rhs[i])), _mm_mul_ps(column1, _mm_set1_ps(rhs[i + 1]))),
+                    _mm_add_ps(_mm_mul_ps(column2, _mm_set1_ps(rhs[i + 2])), _mm_mul_ps(column3, _mm_set1_ps(rhs[i + 3])))
+                );
+            _mm_storeu_ps(out + i, sum);
+        }
+#else
+        (void)lhs;
+        (void)rhs;
+        (void)out;
+        result = a * b;
+#endif
+    }
+
+    void TransformHierarchy::Reserve(uint32_t count)
+    {
+        mParents.reserve(count);
+        mLocalTransforms.reserve(count);
+        mWorldTransforms.reserve(count);
+        mDirty.reserve(count);
+    }
+
+    void TransformHierarchy::Clear()
+    {
+        mParents.clear();
+        mLocalTransforms.clear();
+        mWorldTransforms.clear();
+        mDirty.clear();
+        mFirstDirty = 0;
+    }
+
+    TransformHierarchy::NodeId TransformHierarchy::AddNode(const Matrix4& localTransform, NodeId parent)
+    {
+        auto node = static_cast<NodeId>(mParents.size());
+        assert((parent == INVALID_NODE || parent < node) && "Parent must be added before its children");
+        if (parent != INVALID_NODE && parent >= node)
+        {
+            LOG_CATEGORY_WARN(eScene, "Parent {} of node {} doesn't exist yet, node is added as root", parent, node);
+            parent = INVALID_NODE;
+        }
+        mParents.push_back(parent);
+        mLocalTransforms.push_back(localTransform);
+        mWorldTransforms.push_back(localTransform);
+        mDirty.push_back(1);
+        mFirstDirty = std::min(mFirstDirty, node);
+        return node;
+    }
+
+    void TransformHierarchy::SetLocalTransform(NodeId node, const Matrix4& localTransform)
+    {
+        mLocalTransforms[node] = localTransform;
+        mDirty[node] = 1;
+        mFirstDirty = std::min(mFirstDirty, node);
+    }
+
+    void TransformHierarchy::Update()
+    {
+        auto count = GetNodeCount();
+        if (mFirstDirty >= count)
+            return;
+
+        /// Parent is always visited first, so its flag already includes its ancestors
+        for (uint32_t i = mFirstDirty; i < count; ++i)
+        {
+            NodeId parent = mParents[i];
+            if (parent != INVALID_NODE)
+                mDirty[i] |= mDirty[parent];
+
+            if (!mDirty[i])
+                continue;
+
+            if (parent == INVALID_NODE)
+                mWorldTransforms[i] = mLocalTransforms[i];
+            else
+                MultiplyMatrices(mWorldTransforms[parent], mLocalTransforms[i], mWorldTransforms[i]);
+        }
+
+        std::fill(mDirty.begin() + mFirstDirty, mDirty.end(), 0);
+        mFirstDirty = count;
+    }
+
+    void TransformHierarchy::Upload(const Ref<Buffer>& buffer, uint32_t offset) const
+    {
+        if (mWorldTransforms.empty()) return;
+
+        buffer->WriteData(mWorldTransforms.data(), mWorldTransforms.size() * sizeof(Matrix4), offset);
+    }
+} // namespace Fluent
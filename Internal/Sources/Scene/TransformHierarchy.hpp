@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Core/Base.hpp"
+#include "Math/Math.hpp"
+#include "Renderer/Buffer.hpp"
+
+namespace Fluent
+{
+    /// Flat transform tree, arrays are ordered parent before child so world
+    /// transforms are resolved in one forward pass. Hierarchies share no state
+    /// and can be updated from different threads
+    class TransformHierarchy
+    {
+    public:
+        using NodeId = uint32_t;
+        static constexpr NodeId INVALID_NODE = ~0u;
+    private:
+        std::vector<NodeId>     mParents;
+        std::vector<Matrix4>    mLocalTransforms;
+        std::vector<Matrix4>    mWorldTransforms;
+        std::vector<uint8_t>    mDirty;
+        /// Nodes before it are up to date
+        uint32_t                mFirstDirty = 0;
+    public:
+        void Reserve(uint32_t count);
+        void Clear();
+
+        /// Parent must already exist, so new node always goes after it. Missing parent
+        /// asserts, release builds add node as root
+        NodeId AddNode(const Matrix4& localTransform, NodeId parent = INVALID_NODE);
+        void SetLocalTransform(NodeId node, const Matrix4& localTransform);
+
+        /// Recomputes world transforms of changed nodes and their descendants
+        void Update();
+        /// Writes world transforms as tightly packed matrices, e.g. for instanced drawing
+        void Upload(const Ref<Buffer>& buffer, uint32_t offset = 0) const;
+
+        NodeId GetParent(NodeId node) const { return mParents[node]; }
+        const Matrix4& GetLocalTransform(NodeId node) const { return mLocalTransforms[node]; }
+        /// Valid after Update
+        const Matrix4& GetWorldTransform(NodeId node) const { return mWorldTransforms[node]; }
+        const std::vector<Matrix4>& GetWorldTransforms() const { return mWorldTransforms; }
+        uint32_t GetNodeCount() const { return static_cast<uint32_t>(mParents.size()); }
+    };
+} // namespace Fluent
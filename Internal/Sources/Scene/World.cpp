@@ -0,0 +1,304 @@
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include "Core/Profiler.hpp"
+#include "Scene/World.hpp"
+
+namespace Fluent
+{
+    static std::mutex                                           sComponentMutex;
+    static std::array<ComponentInfo, MAX_COMPONENT_TYPES>       sComponentInfos;
+    static uint32_t                                             sComponentCount = 0;
+
+    static uint32_t AlignUp(uint32_t value, uint32_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    /// Threads live as long as program, so parallel iteration doesn't pay for thread creation every call
+    class ChunkWorkerPool
+    {
+    private:
+        std::vector<std::thread>        mWorkers;
+        /// Held by caller for whole job, busy pool makes other callers work alone
+        std::mutex                      mDispatchMutex;
+        std::mutex                      mMutex;
+        std::condition_variable         mWorkCondition;
+        std::condition_variable         mDoneCondition;
+        const std::function<void()>*    mWork = nullptr;
+        uint64_t                        mGeneration = 0;
+        uint32_t                        mParticipantCount = 0;
+        uint32_t                        mRunningCount = 0;
+        bool                            mStopping = false;
+
+        void WorkerLoop(uint32_t index)
+        {
+            PROFILE_THREAD("ChunkWorker");
+            uint64_t generation = 0;
+            while (true)
+            {
+                const std::function<void()>* work;
+                {
+                    std::unique_lock lock(mMutex);
+                    mWorkCondition.wait(lock, [&]() { return mStopping || mGeneration != generation; });
+                    if (mStopping)
+                        return;
+
+                    generation = mGeneration;
+                    if (index >= mParticipantCount)
+                        continue;
+                    work = mWork;
+                }
+
+                (*work)();
+
+                std::scoped_lock lock(mMutex);
+                if (--mRunningCount == 0)
+                    mDoneCondition.notify_one();
+            }
+        }
+    public:
+        ChunkWorkerPool()
+        {
+            uint32_t workerCount = std::max(1u, std::thread::hardware_concurrency()) - 1;
+            for (uint32_t i = 0; i < workerCount; ++i)
+                mWorkers.emplace_back(&ChunkWorkerPool::WorkerLoop, this, i);
+        }
+
+        ~ChunkWorkerPool()
+        {
+            {
+                std::scoped_lock lock(mMutex);
+                mStopping = true;
+            }
+
+            mWorkCondition.notify_all();
+            for (auto& worker : mWorkers)
+                worker.join();
+        }
+
+        void Run(const std::function<void()>& work, uint32_t workerCount)
+        {
+            uint32_t participantCount = std::min(workerCount - 1, static_cast<uint32_t>(mWorkers.size()));
+            std::unique_lock dispatchLock(mDispatchMutex, std::try_to_lock);
+            if (participantCount == 0 || !dispatchLock.owns_lock())
+            {
+                work();
+                return;
+            }
+
+            {
+                std::scoped_lock lock(mMutex);
+                mWork = &work;
+                mParticipantCount = participantCount;
+                mRunningCount = participantCount;
+                mGeneration++;
+            }
+
+            mWorkCondition.notify_all();
+            work();
+
+            std::unique_lock lock(mMutex);
+            mDoneCondition.wait(lock, [this]() { return mRunningCount == 0; });
+            mWork = nullptr;
+        }
+    };
+
+    uint32_t ComponentRegistry::Register(const ComponentInfo& info)
+    {
+        std::scoped_lock lock(sComponentMutex);
+        if (sComponentCount >= MAX_COMPONENT_TYPES)
+        {
+            LOG_CATEGORY_ERROR(eScene, "Too many component types, max count {}", MAX_COMPONENT_TYPES);
+            std::abort();
+        }
+
+        sComponentInfos[sComponentCount] = info;
+        return sComponentCount++;
+    }
+
+    const ComponentInfo& ComponentRegistry::GetInfo(uint32_t id)
+    {
+        return sComponentInfos[id];
+    }
+
+    Archetype::Archetype(const ComponentMask& mask)
+        : mMask(mask)
+    {
+        uint32_t entityByteSize = sizeof(Entity);
+        for (uint32_t i = 0; i < MAX_COMPONENT_TYPES; ++i)
+        {
+            if (!mask.test(i))
+                continue;
+
+            mComponents.push_back(i);
+            entityByteSize += ComponentRegistry::GetInfo(i).size;
+        }
+
+        /// Alignment padding between columns may not fit, so shrink until layout does
+        mChunkCapacity = std::max(1u, ARCHETYPE_CHUNK_SIZE / entityByteSize);
+        while (true)
+        {
+            uint32_t offset = mChunkCapacity * sizeof(Entity);
+            for (auto component : mComponents)
+            {
+                const auto& info = ComponentRegistry::GetInfo(component);
+                offset = AlignUp(offset, info.alignment);
+                mColumnOffsets[component] = offset;
+                offset += mChunkCapacity * info.size;
+            }
+
+            mChunkByteSize = offset;
+            if (mChunkByteSize <= ARCHETYPE_CHUNK_SIZE || mChunkCapacity == 1)
+                break;
+            mChunkCapacity--;
+        }
+    }
+
+    uint32_t Archetype::AllocateRow(uint32_t& row)
+    {
+        if (mChunks.empty() || mChunks.back().count == mChunkCapacity)
+        {
+            ArchetypeChunk chunk;
+            chunk.data = std::make_unique<uint8_t[]>(mChunkByteSize);
+            mChunks.push_back(std::move(chunk));
+        }
+
+        row = mChunks.back().count++;
+        return static_cast<uint32_t>(mChunks.size() - 1);
+    }
+
+    Entity Archetype::RemoveRow(uint32_t chunk, uint32_t row)
+    {
+        auto& last = mChunks.back();
+        uint32_t lastChunk = static_cast<uint32_t>(mChunks.size() - 1);
+        uint32_t lastRow = last.count - 1;
+
+        Entity moved{};
+        if (chunk != lastChunk || row != lastRow)
+        {
+            moved = GetEntities(last)[lastRow];
+            GetEntities(mChunks[chunk])[row] = moved;
+            for (auto component : mComponents)
+            {
+                std::memcpy(GetComponent(chunk, row, component), GetComponent(lastChunk, lastRow, component),
+                            ComponentRegistry::GetInfo(component).size);
+            }
+        }
+
+        if (--last.count == 0)
+            mChunks.pop_back();
+
+        return moved;
+    }
+
+    Archetype* World::GetArchetype(const ComponentMask& mask)
+    {
+        auto& archetype = mArchetypeMap[mask];
+        if (!archetype)
+        {
+            archetype = CreateScope<Archetype>(mask);
+            mArchetypes.push_back(archetype.get());
+        }
+        return archetype.get();
+    }
+
+    Entity World::CreateEntityWithMask(const ComponentMask& mask)
+    {
+        Entity entity;
+        if (mFreeIndices.empty())
+        {
+            entity.index = static_cast<uint32_t>(mRecords.size());
+            mRecords.emplace_back();
+        }
+        else
+        {
+            entity.index = mFreeIndices.back();
+            mFreeIndices.pop_back();
+        }
+
+        auto& record = mRecords[entity.index];
+        entity.generation = record.generation;
+        record.archetype = GetArchetype(mask);
+        record.chunk = record.archetype->AllocateRow(record.row);
+        record.archetype->GetEntities(record.archetype->GetChunks()[record.chunk])[record.row] = entity;
+        mEntityCount++;
+        return entity;
+    }
+
+    void World::DestroyEntity(Entity entity)
+    {
+        if (!IsAlive(entity))
+            return;
+
+        auto& record = mRecords[entity.index];
+        auto moved = record.archetype->RemoveRow(record.chunk, record.row);
+        if (moved.index != ~0u)
+        {
+            mRecords[moved.index].chunk = record.chunk;
+            mRecords[moved.index].row = record.row;
+        }
+
+        record.archetype = nullptr;
+        record.generation++;
+        mFreeIndices.push_back(entity.index);
+        mEntityCount--;
+    }
+
+    bool World::IsAlive(Entity entity) const
+    {
+        return entity.index < mRecords.size() &&
+               mRecords[entity.index].generation == entity.generation &&
+               mRecords[entity.index].archetype != nullptr;
+    }
+
+    void World::MoveEntity(Entity entity, const ComponentMask& mask)
+    {
+        auto& record = mRecords[entity.index];
+        auto* source = record.archetype;
+        auto* destination = GetArchetype(mask);
+
+        uint32_t row;
+        uint32_t chunk = destination->AllocateRow(row);
+        destination->GetEntities(destination->GetChunks()[chunk])[row] = entity;
+        for (auto component : destination->GetComponents())
+        {
+            if (source->GetMask().test(component))
+            {
+                std::memcpy(destination->GetComponent(chunk, row, component),
+                            source->GetComponent(record.chunk, record.row, component),
+                            ComponentRegistry::GetInfo(component).size);
+            }
+        }
+
+        auto moved = source->RemoveRow(record.chunk, record.row);
+        if (moved.index != ~0u)
+        {
+            mRecords[moved.index].chunk = record.chunk;
+            mRecords[moved.index].row = record.row;
+        }
+
+        record.archetype = destination;
+        record.chunk = chunk;
+        record.row = row;
+    }
+
+    void* World::GetComponentData(Entity entity, uint32_t componentId)
+    {
+        if (!IsAlive(entity))
+            return nullptr;
+
+        auto& record = mRecords[entity.index];
+        if (!record.archetype->GetMask().test(componentId))
+            return nullptr;
+
+        return record.archetype->GetComponent(record.chunk, record.row, componentId);
+    }
+
+    void World::RunParallel(const std::function<void()>& work, uint32_t workerCount)
+    {
+        static ChunkWorkerPool pool;
+        pool.Run(work, std::max(workerCount, 1u));
+    }
+} // namespace Fluent
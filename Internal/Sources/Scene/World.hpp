@@ -0,0 +1,257 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include "Core/Base.hpp"
+
+namespace Fluent
+{
+    static constexpr uint32_t MAX_COMPONENT_TYPES = 64;
+    /// Size of one archetype storage block, all components of an entity live in the same chunk
+    static constexpr uint32_t ARCHETYPE_CHUNK_SIZE = 16 * 1024;
+
+    using ComponentMask = std::bitset<MAX_COMPONENT_TYPES>;
+
+    struct Entity
+    {
+        uint32_t index = ~0u;
+        uint32_t generation = 0;
+
+        bool operator==(const Entity& other) const { return index == other.index && generation == other.generation; }
+        bool operator!=(const Entity& other) const { return !(*this == other); }
+    };
+
+    struct ComponentInfo
+    {
+        uint32_t size;
+        uint32_t alignment;
+    };
+
+    /// Component ids are assigned on first use and are shared by all worlds
+    class ComponentRegistry
+    {
+    private:
+        static uint32_t Register(const ComponentInfo& info);
+    public:
+        static const ComponentInfo& GetInfo(uint32_t id);
+
+        template<typename T>
+        static uint32_t GetId()
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "Components are moved between chunks with memcpy");
+            static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "Chunk memory alignment is not enough");
+            static const uint32_t id = Register({ sizeof(T), alignof(T) });
+            return id;
+        }
+    };
+
+    struct ArchetypeChunk
+    {
+        std::unique_ptr<uint8_t[]>  data;
+        uint32_t                    count = 0;
+    };
+
+    /// Entities with identical component set. Each chunk stores entity ids
+    /// followed by one tightly packed array per component
+    class Archetype
+    {
+    private:
+        ComponentMask                               mMask;
+        std::vector<uint32_t>                       mComponents;
+        std::array<uint32_t, MAX_COMPONENT_TYPES>   mColumnOffsets{};
+        uint32_t                                    mChunkByteSize = 0;
+        uint32_t                                    mChunkCapacity = 0;
+        std::vector<ArchetypeChunk>                 mChunks;
+    public:
+        explicit Archetype(const ComponentMask& mask);
+
+        /// Chunks are kept dense, only last one may have free rows
+        uint32_t AllocateRow(uint32_t& row);
+        /// Moves last entity into freed row, returns moved entity or invalid one
+        Entity RemoveRow(uint32_t chunk, uint32_t row);
+
+        void* GetComponent(uint32_t chunk, uint32_t row, uint32_t componentId)
+        {
+            return mChunks[chunk].data.get() + mColumnOffsets[componentId] + row * ComponentRegistry::GetInfo(componentId).size;
+        }
+
+        Entity* GetEntities(ArchetypeChunk& chunk) { return reinterpret_cast<Entity*>(chunk.data.get()); }
+
+        template<typename T>
+        T* GetColumn(ArchetypeChunk& chunk) { return reinterpret_cast<T*>(chunk.data.get() + mColumnOffsets[ComponentRegistry::GetId<T>()]); }
+
+        const ComponentMask& GetMask() const { return mMask; }
+        const std::vector<uint32_t>& GetComponents() const { return mComponents; }
+        std::vector<ArchetypeChunk>& GetChunks() { return mChunks; }
+        uint32_t GetChunkCapacity() const { return mChunkCapacity; }
+    };
+
+    /// Archetype based entity storage. Structural changes (create, destroy, add and remove
+    /// component) must not happen while a query is running
+    class World
+    {
+    private:
+        struct EntityRecord
+        {
+            Archetype*  archetype = nullptr;
+            uint32_t    chunk = 0;
+            uint32_t    row = 0;
+            uint32_t    generation = 0;
+        };
+
+        std::unordered_map<ComponentMask, Scope<Archetype>> mArchetypeMap;
+        std::vector<Archetype*>                             mArchetypes;
+        std::vector<EntityRecord>                           mRecords;
+        std::vector<uint32_t>                               mFreeIndices;
+        uint32_t                                            mEntityCount = 0;
+
+        Archetype* GetArchetype(const ComponentMask& mask);
+        Entity CreateEntityWithMask(const ComponentMask& mask);
+        void MoveEntity(Entity entity, const ComponentMask& mask);
+        void* GetComponentData(Entity entity, uint32_t componentId);
+
+        template<typename... T>
+        static ComponentMask MakeMask()
+        {
+            ComponentMask mask;
+            (mask.set(ComponentRegistry::GetId<T>()), ...);
+            return mask;
+        }
+    public:
+        World() = default;
+        World(const World&) = delete;
+        World& operator=(const World&) = delete;
+
+        template<typename... T>
+        Entity CreateEntity(const T&... components)
+        {
+            auto entity = CreateEntityWithMask(MakeMask<T...>());
+            ((*GetComponent<T>(entity) = components), ...);
+            return entity;
+        }
+
+        void DestroyEntity(Entity entity);
+        bool IsAlive(Entity entity) const;
+
+        /// Entity must be alive, existing component is overwritten
+        template<typename T>
+        T& AddComponent(Entity entity, const T& component = {})
+        {
+            auto id = ComponentRegistry::GetId<T>();
+            auto& record = mRecords[entity.index];
+            if (!record.archetype->GetMask().test(id))
+            {
+                auto mask = record.archetype->GetMask();
+                MoveEntity(entity, mask.set(id));
+            }
+
+            auto* result = GetComponent<T>(entity);
+            *result = component;
+            return *result;
+        }
+
+        template<typename T>
+        void RemoveComponent(Entity entity)
+        {
+            if (!IsAlive(entity))
+                return;
+
+            auto id = ComponentRegistry::GetId<T>();
+            auto mask = mRecords[entity.index].archetype->GetMask();
+            if (mask.test(id))
+                MoveEntity(entity, mask.reset(id));
+        }
+
+        template<typename T>
+        bool HasComponent(Entity entity) const
+        {
+            return IsAlive(entity) && mRecords[entity.index].archetype->GetMask().test(ComponentRegistry::GetId<T>());
+        }
+
+        /// Pointer is valid until next structural change
+        template<typename T>
+        T* GetComponent(Entity entity)
+        {
+            return reinterpret_cast<T*>(GetComponentData(entity, ComponentRegistry::GetId<T>()));
+        }
+
+        /// function(uint32_t count, const Entity* entities, T*... components) for every matching chunk
+        template<typename... T, typename Function>
+        void ForEachChunk(Function&& function)
+        {
+            ForEachChunkOf<T...>([&function](Archetype* archetype, ArchetypeChunk& chunk)
+            {
+                function(chunk.count, archetype->GetEntities(chunk), archetype->template GetColumn<T>(chunk)...);
+            });
+        }
+
+        /// function(Entity entity, T&... components) for every matching entity
+        template<typename... T, typename Function>
+        void Each(Function&& function)
+        {
+            ForEachChunk<T...>([&function](uint32_t count, const Entity* entities, T*... components)
+            {
+                for (uint32_t i = 0; i < count; ++i)
+                    function(entities[i], components[i]...);
+            });
+        }
+
+        /// Same as ForEachChunk, but chunks are spread over persistent worker threads shared by all
+        /// worlds. Function must only touch components of chunk it was given. Calls made while
+        /// workers are busy, including nested ones, run on calling thread
+        template<typename... T, typename Function>
+        void ParallelForEachChunk(Function&& function, uint32_t workerCount = 0)
+        {
+            struct ChunkRef
+            {
+                Archetype*      archetype;
+                ArchetypeChunk* chunk;
+            };
+
+            std::vector<ChunkRef> chunks;
+            ForEachChunkOf<T...>([&chunks](Archetype* archetype, ArchetypeChunk& chunk) { chunks.push_back({ archetype, &chunk }); });
+            if (chunks.empty())
+                return;
+
+            std::atomic<size_t> next = 0;
+            RunParallel([&]()
+            {
+                for (size_t i = next++; i < chunks.size(); i = next++)
+                {
+                    auto& [archetype, chunk] = chunks[i];
+                    function(chunk->count, archetype->GetEntities(*chunk), archetype->template GetColumn<T>(*chunk)...);
+                }
+            }, std::min(workerCount ? workerCount : ~0u, static_cast<uint32_t>(chunks.size())));
+        }
+
+        uint32_t GetEntityCount() const { return mEntityCount; }
+    private:
+        /// Runs work on calling thread and up to workerCount - 1 pool threads, returns when all finished
+        static void RunParallel(const std::function<void()>& work, uint32_t workerCount);
+
+        template<typename... T, typename Function>
+        void ForEachChunkOf(Function&& function)
+        {
+            auto required = MakeMask<T...>();
+            for (auto* archetype : mArchetypes)
+            {
+                if ((archetype->GetMask() & required) != required)
+                    continue;
+
+                for (auto& chunk : archetype->GetChunks())
+                {
+                    if (chunk.count)
+                        function(archetype, chunk);
+                }
+            }
+        }
+    };
+} // namespace Fluent
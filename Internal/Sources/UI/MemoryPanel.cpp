@@ -0,0 +1,59 @@
+#include <imgui.h>
+#include "Renderer/GraphicContext.hpp"
+#include "UI/MemoryPanel.hpp"
+
+namespace Fluent
+{
+    static float ToMegabytes(uint64_t bytes)
+    {
+        return static_cast<float>(bytes) / (1024.0f * 1024.0f);
+    }
+
+    void ShowMemoryPanel(bool* open)
+    {
+        auto& allocator = GetGraphicContext().GetDeviceAllocator();
+
+        if (!ImGui::Begin("Device memory", open))
+        {
+            ImGui::End();
+            return;
+        }
+
+        auto budgets = allocator.GetHeapBudgets();
+        for (uint32_t i = 0; i < budgets.size(); ++i)
+        {
+            const auto& heap = budgets[i];
+            ImGui::Text("Heap %u %s", i, heap.deviceLocal ? "(device local)" : "");
+            ImGui::Text("Usage %.1f MB / Budget %.1f MB / Size %.1f MB",
+                        ToMegabytes(heap.usage), ToMegabytes(heap.budget), ToMegabytes(heap.size));
+            float fraction = heap.budget > 0 ? static_cast<float>(heap.usage) / static_cast<float>(heap.budget) : 0.0f;
+            ImGui::ProgressBar(fraction);
+        }
+
+        ImGui::Separator();
+
+        auto statistics = allocator.GetStatistics();
+        for (size_t i = 0; i < statistics.tags.size(); ++i)
+        {
+            const auto& tag = statistics.tags[i];
+            ImGui::Text("%-12s %6llu allocations %9.2f MB (peak %9.2f MB)",
+                        ToString(static_cast<MemoryTag>(i)),
+                        static_cast<unsigned long long>(tag.allocationCount),
+                        ToMegabytes(tag.currentBytes), ToMegabytes(tag.peakBytes));
+        }
+
+        ImGui::Text("%-12s %6llu allocations %9.2f MB (peak %9.2f MB)", "Total",
+                    static_cast<unsigned long long>(statistics.total.allocationCount),
+                    ToMegabytes(statistics.total.currentBytes), ToMegabytes(statistics.total.peakBytes));
+
+        auto defragmentation = allocator.GetDefragmentationStatistics();
+        ImGui::Text("Defragmentation moved %u allocations (%.2f MB), reclaimed %.2f MB in %u blocks",
+                    defragmentation.allocationsMoved, ToMegabytes(defragmentation.bytesMoved),
+                    ToMegabytes(defragmentation.bytesFreed), defragmentation.deviceMemoryBlocksFreed);
+
+        if (ImGui::Button("Dump statistics"))
+            allocator.DumpStatistics("MemoryStatistics.json", true);
+
+        ImGui::End();
+    }
+} // namespace Fluent
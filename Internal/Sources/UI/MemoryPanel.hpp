@@ -0,0 +1,8 @@
+#pragma once
+
+namespace Fluent
+{
+    /// ImGui window with device memory budgets and per tag allocation statistics.
+    /// Should be called between UIContext BeginFrame and EndFrame
+    void ShowMemoryPanel(bool* open = nullptr);
+} // namespace Fluent
@@ -77,8 +77,10 @@ namespace Fluent
         {
             ImGui::Render();
             auto& context = GetGraphicContext();
-            auto cmd = (VkCommandBuffer)context.GetCurrentCommandBuffer()->GetNativeHandle();
-            ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), cmd);
+            auto& commandBuffer = context.GetCurrentCommandBuffer();
+            ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), (VkCommandBuffer)commandBuffer->GetNativeHandle());
+            /// ImGui binds its own pipeline, buffers and dynamic state
+            commandBuffer->InvalidateState();
 
             ImGuiIO& io = ImGui::GetIO();
             if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
@@ -0,0 +1,185 @@
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <vector>
+#include "Core/Archive.hpp"
+#include "Check.hpp"
+
+using namespace Fluent;
+
+static std::string GetTempPath(const std::string& name)
+{
+    return (std::filesystem::temp_directory_path() / ("FluentArchiveTests_" + name)).string();
+}
+
+static std::vector<uint8_t> CreateRandomData(size_t size, uint32_t seed)
+{
+    std::mt19937 random(seed);
+    std::vector<uint8_t> data(size);
+    for (auto& value : data)
+        value = static_cast<uint8_t>(random());
+    return data;
+}
+
+/// Repeated words with varying numbers, matches of many lengths and offsets
+static std::vector<uint8_t> CreateTextData(size_t size)
+{
+    std::string text;
+    for (uint32_t i = 0; text.size() < size; ++i)
+        text += "vertex " + std::to_string(i % 977) + " position " + std::to_string(i * 7 % 131) + "\n";
+    return { text.begin(), text.begin() + size };
+}
+
+static std::vector<uint8_t> ReadEntry(const Archive& archive, const std::string& path)
+{
+    const auto* entry = archive.Find(path);
+    CHECK(entry);
+    std::vector<uint8_t> data(entry->size);
+    CHECK(archive.Read(*entry, data.data()));
+    return data;
+}
+
+static void TestRoundTrip()
+{
+    auto text = CreateTextData(3 * ARCHIVE_BLOCK_SIZE + 1234);
+    auto noise = CreateRandomData(ARCHIVE_BLOCK_SIZE + 17, 1);
+    /// Run of one byte is encoded as match overlapping its own output
+    std::vector<uint8_t> run(100000, 0x5A);
+    /// First block doesn't compress and is stored raw, second one does
+    auto mixed = CreateRandomData(ARCHIVE_BLOCK_SIZE, 2);
+    mixed.resize(2 * ARCHIVE_BLOCK_SIZE, 0);
+    std::vector<uint8_t> small = { 1, 2, 3 };
+
+    ArchiveWriter writer;
+    writer.AddFile("text.txt", text.data(), text.size(), true);
+    writer.AddFile("noise.bin", noise.data(), noise.size(), true);
+    writer.AddFile("run.bin", run.data(), run.size(), true);
+    writer.AddFile("mixed.bin", mixed.data(), mixed.size(), true);
+    writer.AddFile("plain/./../plain/small.bin", small.data(), small.size());
+    writer.AddFile("empty.bin", nullptr, 0, true);
+    CHECK(writer.GetEntryCount() == 6);
+
+    auto filename = GetTempPath("RoundTrip.pak");
+    CHECK(writer.Write(filename));
+    auto archive = Archive::Create({ filename });
+    CHECK(archive);
+    CHECK(archive->GetEntries().size() == 6);
+
+    CHECK(ReadEntry(*archive, "text.txt") == text);
+    CHECK(ReadEntry(*archive, "noise.bin") == noise);
+    CHECK(ReadEntry(*archive, "run.bin") == run);
+    CHECK(ReadEntry(*archive, "mixed.bin") == mixed);
+    CHECK(ReadEntry(*archive, "plain/small.bin") == small);
+    CHECK(ReadEntry(*archive, "empty.bin").empty());
+    CHECK(!archive->Find("missing.bin"));
+    CHECK(!archive->Find("plain/./../plain/small.bin"));
+
+    const auto* textEntry = archive->Find("text.txt");
+    CHECK(textEntry->compressed && textEntry->storedSize < textEntry->size / 2);
+    CHECK(!archive->Map(*textEntry));
+    CHECK(archive->Find("run.bin")->storedSize < run.size() / 50);
+    CHECK(archive->Find("mixed.bin")->compressed);
+
+    /// Compression is dropped when it doesn't help, such entries are mapped
+    const auto* noiseEntry = archive->Find("noise.bin");
+    CHECK(!noiseEntry->compressed && noiseEntry->storedSize == noise.size());
+    CHECK(std::memcmp(archive->Map(*noiseEntry), noise.data(), noise.size()) == 0);
+
+    for (const auto& entry : archive->GetEntries())
+        CHECK(entry.offset % ARCHIVE_ALIGNMENT == 0);
+
+    archive.reset();
+    std::filesystem::remove(filename);
+}
+
+static void TestAddDirectory()
+{
+    auto directory = GetTempPath("Directory");
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory + "/shaders/cache");
+    std::ofstream(directory + "/model.gltf") << "model";
+    std::ofstream(directory + "/shaders/cache/main.spv") << "spirv";
+
+    ArchiveWriter writer;
+    CHECK(writer.AddDirectory(directory, true));
+    CHECK(!writer.AddDirectory(directory + "/missing"));
+    CHECK(writer.GetEntryCount() == 2);
+
+    auto filename = GetTempPath("Directory.pak");
+    CHECK(writer.Write(filename));
+    auto archive = Archive::Create({ filename });
+    CHECK(archive);
+    auto spirv = ReadEntry(*archive, "shaders/cache/main.spv");
+    CHECK(std::string(spirv.begin(), spirv.end()) == "spirv");
+    CHECK(archive->Find("model.gltf"));
+
+    archive.reset();
+    std::filesystem::remove(filename);
+    std::filesystem::remove_all(directory);
+}
+
+static void TestInvalidFiles()
+{
+    CHECK(!Archive::Create({ GetTempPath("Missing.pak") }));
+
+    auto filename = GetTempPath("Invalid.pak");
+    std::ofstream(filename, std::ios::binary) << "not an archive at all, just some text";
+    CHECK(!Archive::Create({ filename }));
+
+    /// Table of contents cut off
+    auto text = CreateTextData(10000);
+    ArchiveWriter writer;
+    writer.AddFile("text.txt", text.data(), text.size(), true);
+    CHECK(writer.Write(filename));
+    std::filesystem::resize_file(filename, std::filesystem::file_size(filename) - 4);
+    CHECK(!Archive::Create({ filename }));
+    std::filesystem::remove(filename);
+}
+
+static void TestCorruptedBlocks()
+{
+    auto text = CreateTextData(2 * ARCHIVE_BLOCK_SIZE);
+    ArchiveWriter writer;
+    writer.AddFile("text.txt", text.data(), text.size(), true);
+    auto filename = GetTempPath("Corrupted.pak");
+    CHECK(writer.Write(filename));
+
+    std::vector<uint8_t> original;
+    {
+        auto archive = Archive::Create({ filename });
+        CHECK(archive);
+        const auto* entry = archive->Find("text.txt");
+        CHECK(entry->compressed);
+
+        std::ifstream file(filename, std::ios::binary);
+        original.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    /// Random damage in payload makes read fail or give wrong data, never write out of bounds
+    std::mt19937 random(3);
+    const size_t payloadBegin = ARCHIVE_ALIGNMENT;
+    for (uint32_t iteration = 0; iteration < 200; ++iteration)
+    {
+        auto corrupted = original;
+        for (uint32_t i = 0; i < 1 + iteration % 4; ++i)
+            corrupted[payloadBegin + random() % 2048] = static_cast<uint8_t>(random());
+
+        std::ofstream(filename, std::ios::binary).write(reinterpret_cast<const char*>(corrupted.data()), static_cast<std::streamsize>(corrupted.size()));
+        auto archive = Archive::Create({ filename });
+        CHECK(archive);
+        const auto* entry = archive->Find("text.txt");
+        std::vector<uint8_t> data(entry->size);
+        archive->Read(*entry, data.data());
+    }
+    std::filesystem::remove(filename);
+}
+
+int main()
+{
+    TestRoundTrip();
+    TestAddDirectory();
+    TestInvalidFiles();
+    TestCorruptedBlocks();
+    return 0;
+}
@@ -0,0 +1,169 @@
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <vector>
+#include "Core/Archive.hpp"
+#include "Core/AsyncFileReader.hpp"
+#include "Core/FileSystem.hpp"
+#include "Check.hpp"
+
+using namespace Fluent;
+
+static const std::string TEST_DIRECTORY = (std::filesystem::temp_directory_path() / "FluentAsyncFileReaderTests").string();
+
+static std::vector<char> CreateFileData(uint32_t seed, size_t size)
+{
+    std::mt19937 random(seed);
+    std::vector<char> data(size);
+    for (auto& value : data)
+        value = static_cast<char>(random());
+    return data;
+}
+
+/// Sizes cross page and read chunk boundaries, first file is empty
+static std::vector<std::string> CreateFiles(uint32_t count)
+{
+    std::filesystem::create_directories(TEST_DIRECTORY);
+    std::vector<std::string> paths;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        auto path = TEST_DIRECTORY + "/file" + std::to_string(i) + ".bin";
+        auto data = CreateFileData(i, size_t(i) * i * 37);
+        std::ofstream(path, std::ios::binary).write(data.data(), static_cast<std::streamsize>(data.size()));
+        paths.push_back(path);
+    }
+    return paths;
+}
+
+static void CheckResults(const std::vector<FileReadResult>& results, const std::vector<std::string>& paths)
+{
+    CHECK(results.size() == paths.size());
+    for (uint32_t i = 0; i < paths.size(); ++i)
+    {
+        CHECK(results[i].path == paths[i]);
+        CHECK(results[i].success);
+        CHECK(results[i].data == CreateFileData(i, size_t(i) * i * 37));
+    }
+}
+
+static void TestBatches(bool preferIoUring)
+{
+    AsyncFileReaderDescription description{};
+    description.preferIoUring = preferIoUring;
+    /// More files than queue depth, so submissions are refilled as reads finish
+    description.queueDepth = 8;
+    auto reader = AsyncFileReader::Create(description);
+    CHECK(reader);
+
+    auto paths = CreateFiles(100);
+    uint32_t callbackCount = 0;
+    auto batch = reader->Read(paths, [&](std::vector<FileReadResult>& results)
+    {
+        CheckResults(results, paths);
+        callbackCount++;
+    });
+
+    /// Batch without callback is waited on directly
+    auto missingPath = TEST_DIRECTORY + "/missing.bin";
+    auto second = reader->Read({ paths[7], missingPath, paths[0] });
+    second->Wait();
+    CHECK(second->IsReady());
+    const auto& results = second->GetResults();
+    CHECK(results[0].success && results[0].data == CreateFileData(7, 7 * 7 * 37));
+    CHECK(!results[1].success && results[1].data.empty());
+    CHECK(results[2].success && results[2].data.empty());
+
+    while (!callbackCount)
+        reader->Update();
+    CHECK(batch->IsReady());
+    batch->Wait();
+    reader->Update();
+    CHECK(callbackCount == 1);
+
+    /// Empty batch is ready at once, callback still waits for Update
+    bool emptyCalled = false;
+    auto empty = reader->Read({}, [&emptyCalled](std::vector<FileReadResult>& results)
+    {
+        CHECK(results.empty());
+        emptyCalled = true;
+    });
+    CHECK(empty->IsReady());
+    CHECK(!emptyCalled);
+    reader->Update();
+    CHECK(emptyCalled);
+
+    /// Callback may submit another batch, which is finished by later Update
+    bool chainedCalled = false;
+    reader->Read({ paths[1] }, [&](std::vector<FileReadResult>&)
+    {
+        reader->Read({ paths[2] }, [&chainedCalled](std::vector<FileReadResult>& results)
+        {
+            CHECK(results[0].data == CreateFileData(2, 2 * 2 * 37));
+            chainedCalled = true;
+        });
+    });
+    while (!chainedCalled)
+        reader->Update();
+}
+
+static void TestArchivedFiles(bool preferIoUring)
+{
+    auto text = std::string(100000, 'a') + "tail";
+    auto binary = CreateFileData(1, 5000);
+
+    ArchiveWriter writer;
+    writer.AddFile("compressed.txt", text.data(), text.size(), true);
+    writer.AddFile("plain.bin", binary.data(), binary.size());
+    auto archivePath = TEST_DIRECTORY + "/assets.pak";
+    std::filesystem::create_directories(TEST_DIRECTORY);
+    CHECK(writer.Write(archivePath));
+
+    /// FileSystem isn't initialized, so paths relative to executable are just absolute ones
+    auto mountDirectory = TEST_DIRECTORY + "/mounted";
+    CHECK(FileSystem::Mount(archivePath, mountDirectory));
+
+    AsyncFileReaderDescription description{};
+    description.preferIoUring = preferIoUring;
+    auto reader = AsyncFileReader::Create(description);
+    auto batch = reader->Read({ mountDirectory + "/compressed.txt", mountDirectory + "/plain.bin", mountDirectory + "/missing.bin" });
+    batch->Wait();
+
+    const auto& results = batch->GetResults();
+    CHECK(results[0].success && std::string(results[0].data.begin(), results[0].data.end()) == text);
+    CHECK(results[1].success && results[1].data == binary);
+    CHECK(!results[2].success);
+    FileSystem::UnmountAll();
+}
+
+static void TestShutdownWithPendingReads(bool preferIoUring)
+{
+    auto paths = CreateFiles(100);
+    Ref<FileReadBatch> batch;
+    {
+        AsyncFileReaderDescription description{};
+        description.preferIoUring = preferIoUring;
+        description.queueDepth = 2;
+        description.workerCount = 1;
+        auto reader = AsyncFileReader::Create(description);
+        batch = reader->Read(paths);
+    }
+
+    /// Reads which were not started fail, finished ones are intact
+    batch->Wait();
+    const auto& results = batch->GetResults();
+    for (uint32_t i = 0; i < paths.size(); ++i)
+        CHECK(!results[i].success || results[i].data == CreateFileData(i, size_t(i) * i * 37));
+}
+
+int main()
+{
+    for (bool preferIoUring : { true, false })
+    {
+        TestBatches(preferIoUring);
+        TestArchivedFiles(preferIoUring);
+        TestShutdownWithPendingReads(preferIoUring);
+    }
+
+    std::filesystem::remove_all(TEST_DIRECTORY);
+    return 0;
+}
@@ -0,0 +1,186 @@
+#include <cstring>
+#include <vector>
+#include "Renderer/CommandStream.hpp"
+#include "Check.hpp"
+#include "FakeResources.hpp"
+
+using namespace Fluent;
+
+/// Serialized stream starts with magic, group count and data size
+static constexpr size_t SERIALIZED_HEADER_SIZE = 3 * sizeof(uint32_t);
+
+static CommandStream RecordStream()
+{
+    auto pipeline = CreateRef<FakePipeline>(1, std::vector<PushConstantRange>{ { ShaderStage::eVertex, 0, 64 } });
+    auto vertexBuffer = CreateRef<FakeBuffer>(2);
+    auto indexBuffer = CreateRef<FakeBuffer>(3);
+    uint8_t constants[5] = { 1, 2, 3, 4, 5 };
+
+    CommandStream stream;
+    stream.BeginGroup(7);
+    stream.BindPipeline(pipeline);
+    stream.SetViewport(640, 480, 0.0f, 1.0f, 0, 0);
+    stream.SetScissor(640, 480, 0, 0);
+    stream.BeginGroup(3);
+    stream.BindVertexBuffer(vertexBuffer, 16);
+    stream.BindIndexBuffer(indexBuffer, 0, IndexType::eUint16);
+    stream.PushConstants(pipeline, 8, sizeof(constants), constants);
+    stream.DrawIndexed(36, 1, 0, 0, 0);
+    stream.Draw(3, 1, 0, 0);
+    stream.Dispatch(1, 2, 3);
+    return stream;
+}
+
+static CommandHeader ReadHeader(const std::vector<uint8_t>& data, size_t offset)
+{
+    CommandHeader header;
+    std::memcpy(&header, data.data() + offset, sizeof(header));
+    return header;
+}
+
+static void TestLayout()
+{
+    auto stream = RecordStream();
+    const auto& groups = stream.GetGroups();
+    CHECK(groups.size() == 2);
+    CHECK(groups[0].sortKey == 7 && groups[1].sortKey == 3);
+    CHECK(groups[0].begin == 0 && groups[0].end == groups[1].begin);
+    CHECK(groups[1].end == stream.GetData().size());
+
+    /// Packets are 8 byte aligned, push constant data is padded too
+    uint32_t packetCount = 0;
+    const auto& data = stream.GetData();
+    for (size_t offset = 0; offset < data.size(); ++packetCount)
+    {
+        auto header = ReadHeader(data, offset);
+        CHECK(header.size % 8 == 0);
+        if (header.type == CommandType::ePushConstants)
+        {
+            PushConstantsCommand command;
+            std::memcpy(&command, data.data() + offset + sizeof(header), sizeof(command));
+            CHECK(command.offset == 8 && command.size == 5);
+            CHECK(command.stageFlags == VK_SHADER_STAGE_VERTEX_BIT);
+            CHECK(data[offset + sizeof(header) + sizeof(command) + 4] == 5);
+        }
+        offset += header.size;
+    }
+    CHECK(packetCount == 9);
+
+    /// Empty group takes key of next one instead of staying in stream
+    stream.BeginGroup(10);
+    stream.BeginGroup(11);
+    CHECK(stream.GetGroups().size() == 3);
+    CHECK(stream.GetGroups().back().sortKey == 11);
+
+    stream.Reset();
+    CHECK(stream.IsEmpty());
+    CHECK(stream.GetGroups().empty());
+}
+
+static void TestRoundTrip()
+{
+    auto stream = RecordStream();
+    std::vector<uint8_t> serialized;
+    stream.Serialize(serialized);
+
+    CommandStream loaded;
+    CHECK(loaded.Deserialize(serialized));
+    CHECK(loaded.GetData() == stream.GetData());
+    CHECK(loaded.GetGroups().size() == stream.GetGroups().size());
+    for (size_t i = 0; i < loaded.GetGroups().size(); ++i)
+    {
+        CHECK(loaded.GetGroups()[i].sortKey == stream.GetGroups()[i].sortKey);
+        CHECK(loaded.GetGroups()[i].begin == stream.GetGroups()[i].begin);
+        CHECK(loaded.GetGroups()[i].end == stream.GetGroups()[i].end);
+    }
+
+    /// Loaded stream can be appended to
+    loaded.Draw(3, 1, 0, 0);
+    CHECK(loaded.GetGroups().back().end == loaded.GetData().size());
+
+    CommandStream empty;
+    empty.Serialize(serialized);
+    CHECK(serialized.size() == SERIALIZED_HEADER_SIZE);
+    CHECK(loaded.Deserialize(serialized));
+    CHECK(loaded.IsEmpty());
+}
+
+static void CheckRejected(const std::vector<uint8_t>& serialized)
+{
+    CommandStream stream;
+    CHECK(!stream.Deserialize(serialized));
+    CHECK(stream.IsEmpty());
+    CHECK(stream.GetGroups().empty());
+}
+
+static void TestCorruptedData()
+{
+    auto stream = RecordStream();
+    std::vector<uint8_t> valid;
+    stream.Serialize(valid);
+
+    size_t dataOffset = SERIALIZED_HEADER_SIZE + stream.GetGroups().size() * sizeof(CommandGroup);
+    size_t secondGroupOffset = dataOffset + stream.GetGroups()[1].begin;
+    auto firstHeader = ReadHeader(valid, dataOffset);
+
+    CheckRejected({});
+    CheckRejected(std::vector<uint8_t>(valid.begin(), valid.begin() + SERIALIZED_HEADER_SIZE - 1));
+    CheckRejected(std::vector<uint8_t>(valid.begin(), valid.end() - 1));
+
+    auto corrupted = valid;
+    corrupted[0] ^= 0xFF;
+    CheckRejected(corrupted);
+
+    /// Group count which doesn't match size
+    corrupted = valid;
+    corrupted[4]++;
+    CheckRejected(corrupted);
+
+    /// Unknown packet type
+    corrupted = valid;
+    CommandHeader header{ CommandType::eMaxCommand, firstHeader.size };
+    std::memcpy(corrupted.data() + dataOffset, &header, sizeof(header));
+    CheckRejected(corrupted);
+
+    /// Packet size which is unaligned, smaller than command or crosses group end
+    for (uint32_t size : { firstHeader.size + 4, 8u, firstHeader.size + stream.GetGroups()[0].end })
+    {
+        corrupted = valid;
+        header = { firstHeader.type, size };
+        std::memcpy(corrupted.data() + dataOffset, &header, sizeof(header));
+        CheckRejected(corrupted);
+    }
+
+    /// Group which ends past data
+    corrupted = valid;
+    CommandGroup group = stream.GetGroups()[1];
+    group.end += 8;
+    std::memcpy(corrupted.data() + SERIALIZED_HEADER_SIZE + sizeof(CommandGroup), &group, sizeof(group));
+    CheckRejected(corrupted);
+
+    /// Push constants claiming more data than packet holds, third packet of second group
+    corrupted = valid;
+    size_t pushOffset = secondGroupOffset;
+    for (uint32_t i = 0; i < 2; ++i)
+        pushOffset += ReadHeader(valid, pushOffset).size;
+    CHECK(ReadHeader(valid, pushOffset).type == CommandType::ePushConstants);
+    PushConstantsCommand push;
+    std::memcpy(&push, corrupted.data() + pushOffset + sizeof(CommandHeader), sizeof(push));
+    push.size = 64;
+    std::memcpy(corrupted.data() + pushOffset + sizeof(CommandHeader), &push, sizeof(push));
+    CheckRejected(corrupted);
+
+    /// Failed load drops previously loaded stream
+    CommandStream loaded;
+    CHECK(loaded.Deserialize(valid));
+    CHECK(!loaded.Deserialize(corrupted));
+    CHECK(loaded.IsEmpty());
+}
+
+int main()
+{
+    TestLayout();
+    TestRoundTrip();
+    TestCorruptedData();
+    return 0;
+}
@@ -0,0 +1,149 @@
+#include <thread>
+#include <vector>
+#include "Core/EventBus.hpp"
+#include "Check.hpp"
+
+using namespace Fluent;
+
+static void TestDispatchOrder()
+{
+    EventBus bus({});
+    std::vector<int> keys;
+    std::vector<int> widths;
+    bus.Subscribe<KeyEvent>([&keys](const KeyEvent& event) { keys.push_back(event.key); });
+    bus.Subscribe<WindowResizeEvent>([&widths](const WindowResizeEvent& event) { widths.push_back(event.width); });
+
+    CHECK(bus.Push(KeyEvent{ 1, PressState::ePress }));
+    CHECK(bus.Push(WindowResizeEvent{ 640, 480 }));
+    CHECK(bus.Push(KeyEvent{ 2, PressState::eRelease }));
+    CHECK(keys.empty());
+
+    bus.Dispatch();
+    CHECK((keys == std::vector<int>{ 1, 2 }));
+    CHECK((widths == std::vector<int>{ 640 }));
+
+    /// Queue is empty after dispatch
+    bus.Dispatch();
+    CHECK(keys.size() == 2);
+}
+
+static void TestPushFromCallback()
+{
+    EventBus bus({});
+    uint32_t count = 0;
+    bus.Subscribe<KeyEvent>([&bus, &count](const KeyEvent& event)
+    {
+        count++;
+        if (event.key == 0)
+            bus.Push(KeyEvent{ 1, PressState::ePress });
+    });
+
+    bus.Push(KeyEvent{ 0, PressState::ePress });
+    bus.Dispatch();
+    CHECK(count == 1);
+    bus.Dispatch();
+    CHECK(count == 2);
+}
+
+static void TestOverflow()
+{
+    EventBusDescription description{};
+    description.capacity = 3;
+    EventBus bus(description);
+
+    uint32_t count = 0;
+    bus.Subscribe<KeyTypedEvent>([&count](const KeyTypedEvent&) { count++; });
+
+    /// Capacity is rounded up to 4
+    for (int i = 0; i < 4; ++i)
+        CHECK(bus.Push(KeyTypedEvent{ i }));
+    CHECK(!bus.Push(KeyTypedEvent{ 4 }));
+
+    bus.Dispatch();
+    CHECK(count == 4);
+
+    /// Cells are reused after dispatch
+    CHECK(bus.Push(KeyTypedEvent{ 5 }));
+    bus.Dispatch();
+    CHECK(count == 5);
+}
+
+static void TestSubscribeDuringDispatch()
+{
+    EventBus bus({});
+    uint32_t outerCount = 0;
+    uint32_t innerCount = 0;
+    EventBus::SubscriptionId inner = 0;
+    EventBus::SubscriptionId outer = 0;
+    outer = bus.Subscribe<MouseMoveEvent>([&](const MouseMoveEvent&)
+    {
+        outerCount++;
+        if (!inner)
+            inner = bus.Subscribe<MouseMoveEvent>([&innerCount](const MouseMoveEvent&) { innerCount++; });
+        bus.Unsubscribe(outer);
+    });
+
+    /// Subscriber added by callback misses events of current dispatch, removed one gets no more
+    bus.Push(MouseMoveEvent{ 0, 0 });
+    bus.Push(MouseMoveEvent{ 1, 1 });
+    bus.Dispatch();
+    CHECK(outerCount == 1);
+    CHECK(innerCount == 0);
+
+    bus.Push(MouseMoveEvent{ 2, 2 });
+    bus.Dispatch();
+    CHECK(outerCount == 1);
+    CHECK(innerCount == 1);
+
+    bus.Unsubscribe(inner);
+    bus.Push(MouseMoveEvent{ 3, 3 });
+    bus.Dispatch();
+    CHECK(innerCount == 1);
+}
+
+static void TestConcurrentProducers()
+{
+    constexpr int threadCount = 4;
+    constexpr int eventCount = 1000;
+
+    EventBusDescription description{};
+    description.capacity = threadCount * eventCount;
+    EventBus bus(description);
+
+    std::vector<int> next(threadCount, 0);
+    bool ordered = true;
+    bus.Subscribe<MouseMoveEvent>([&](const MouseMoveEvent& event)
+    {
+        ordered &= event.y == next[event.x];
+        next[event.x] = event.y + 1;
+    });
+
+    std::vector<std::thread> producers;
+    for (int thread = 0; thread < threadCount; ++thread)
+    {
+        producers.emplace_back([&bus, thread]()
+        {
+            for (int i = 0; i < eventCount; ++i)
+                CHECK(bus.Push(MouseMoveEvent{ thread, i }));
+        });
+    }
+
+    for (auto& producer : producers)
+        producer.join();
+
+    /// Events of one producer keep their order
+    bus.Dispatch();
+    CHECK(ordered);
+    for (int count : next)
+        CHECK(count == eventCount);
+}
+
+int main()
+{
+    TestDispatchOrder();
+    TestPushFromCallback();
+    TestOverflow();
+    TestSubscribeDuringDispatch();
+    TestConcurrentProducers();
+    return 0;
+}
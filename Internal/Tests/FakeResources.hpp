@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "Renderer/Buffer.hpp"
+#include "Renderer/DescriptorSetLayout.hpp"
+#include "Renderer/Pipeline.hpp"
+#include "Renderer/Shader.hpp"
+
+namespace Fluent
+{
+    /// Resources without device, native handle is just id so recorded packets can be checked
+    class FakeShader : public Shader
+    {
+    private:
+        ShaderStage                         mStage;
+        std::string                         mFilename;
+        std::vector<VertexInput>            mInputAttributes;
+        std::vector<ShaderUniforms>         mUniforms;
+        std::vector<PushConstantRange>      mPushConstantRanges;
+        std::vector<SpecializationConstant> mSpecializationConstants;
+        std::vector<VertexInputSemantic>    mInputSemantics;
+    public:
+        FakeShader(ShaderStage stage, const std::string& filename) : mStage(stage), mFilename(filename) {}
+
+        ShaderStage GetStage() const override { return mStage; }
+        const std::vector<VertexInput>& GetInputAttributes() const override { return mInputAttributes; }
+        const std::vector<ShaderUniforms>& GetUniforms() const override { return mUniforms; }
+        const std::vector<PushConstantRange>& GetPushConstantRanges() const override { return mPushConstantRanges; }
+        const std::vector<SpecializationConstant>& GetSpecializationConstants() const override { return mSpecializationConstants; }
+        const std::vector<VertexInputSemantic>& GetInputSemantics() const override { return mInputSemantics; }
+        const std::string& GetFilename() const override { return mFilename; }
+        uint64_t GetByteCodeHash() const override { return std::hash<std::string>{}(mFilename); }
+        Handle GetNativeHandle() const override { return nullptr; }
+        void Replace(const Ref<Shader>&) override {}
+    };
+
+    class FakeDescriptorSetLayout : public DescriptorSetLayout
+    {
+    private:
+        std::vector<Ref<Shader>> mShaders;
+    public:
+        explicit FakeDescriptorSetLayout(const std::vector<Ref<Shader>>& shaders) : mShaders(shaders) {}
+
+        const std::vector<Ref<Shader>>& GetShaders() const override { return mShaders; }
+        uint32_t GetSetCount() const override { return 0; }
+        Handle GetNativeHandle(uint32_t) const override { return nullptr; }
+    };
+
+    class FakePipeline : public Pipeline
+    {
+    private:
+        uintptr_t                       mId;
+        PipelineDescription             mDescription{};
+        std::vector<PushConstantRange>  mPushConstantRanges;
+    public:
+        explicit FakePipeline(uintptr_t id, const std::vector<PushConstantRange>& ranges = {}, const Ref<DescriptorSetLayout>& layout = nullptr)
+            : mId(id), mPushConstantRanges(ranges)
+        {
+            mDescription.type = PipelineType::eGraphics;
+            mDescription.descriptorSetLayout = layout;
+        }
+
+        PipelineType GetType() const override { return PipelineType::eGraphics; }
+        const PipelineDescription& GetDescription() const override { return mDescription; }
+        const std::vector<PushConstantRange>& GetPushConstantRanges() const override { return mPushConstantRanges; }
+        Handle Rebuild(const std::vector<Ref<Shader>>&) const override { return nullptr; }
+        void Replace(Handle) override {}
+        Handle GetPipelineLayout() const override { return reinterpret_cast<Handle>(mId + 0x1000); }
+        Handle GetNativeHandle() const override { return reinterpret_cast<Handle>(mId); }
+    };
+
+    class FakeBuffer : public Buffer
+    {
+    private:
+        uintptr_t mId;
+    public:
+        explicit FakeBuffer(uintptr_t id) : mId(id) {}
+
+        void WriteData(const void*, uint32_t, uint32_t) override {}
+        void* MapMemory() override { return nullptr; }
+        void UnmapMemory() override {}
+        void FlushMemory(uint32_t, uint32_t) override {}
+        bool IsMemoryMapped() const override { return false; }
+        uint32_t GetSize() const override { return 0; }
+        Handle GetNativeHandle() const override { return reinterpret_cast<Handle>(mId); }
+    };
+} // namespace Fluent
@@ -0,0 +1,172 @@
+#include <algorithm>
+#include <array>
+#include <random>
+#include <vector>
+#include "Scene/MeshOptimizer.hpp"
+#include "Check.hpp"
+
+using namespace Fluent;
+
+using Triangle = std::array<float, 9>;
+
+/// Triangles by vertex positions with rotation normalized, winding is kept
+static std::vector<Triangle> GetTriangles(const std::vector<float>& vertices, const std::vector<uint32_t>& indices, uint32_t stride)
+{
+    std::vector<Triangle> triangles;
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        std::array<Triangle, 3> rotations;
+        for (uint32_t r = 0; r < 3; ++r)
+        {
+            for (uint32_t j = 0; j < 3; ++j)
+            {
+                const float* position = &vertices[size_t(indices[i + (r + j) % 3]) * stride];
+                std::copy(position, position + 3, rotations[r].begin() + j * 3);
+            }
+        }
+        triangles.push_back(*std::min_element(rotations.begin(), rotations.end()));
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+/// Grid in xy plane with triangles shuffled, so cache behaviour is poor
+static void CreateShuffledGrid(uint32_t size, uint32_t stride, std::vector<float>& vertices, std::vector<uint32_t>& indices)
+{
+    vertices.clear();
+    for (uint32_t y = 0; y <= size; ++y)
+    {
+        for (uint32_t x = 0; x <= size; ++x)
+        {
+            vertices.insert(vertices.end(), { static_cast<float>(x), static_cast<float>(y), 0.0f });
+            for (uint32_t k = 3; k < stride; ++k)
+                vertices.push_back(static_cast<float>(k));
+        }
+    }
+
+    std::vector<std::array<uint32_t, 3>> triangles;
+    for (uint32_t y = 0; y < size; ++y)
+    {
+        for (uint32_t x = 0; x < size; ++x)
+        {
+            uint32_t i = y * (size + 1) + x;
+            triangles.push_back({ i, i + 1, i + size + 2 });
+            triangles.push_back({ i, i + size + 2, i + size + 1 });
+        }
+    }
+
+    std::mt19937 random(1);
+    std::shuffle(triangles.begin(), triangles.end(), random);
+    indices.clear();
+    for (const auto& triangle : triangles)
+        indices.insert(indices.end(), triangle.begin(), triangle.end());
+}
+
+static void TestAnalyzeVertexCache()
+{
+    auto statistics = MeshOptimizer::AnalyzeVertexCache({ 0, 1, 2, 2, 1, 3 }, 4);
+    CHECK(statistics.triangleCount == 2);
+    CHECK(statistics.cacheMissCount == 4);
+    CHECK(statistics.GetAcmr() == 2.0f);
+    CHECK(statistics.GetAtvr() == 1.0f);
+
+    /// FIFO evicts oldest vertices even when they were hit since
+    statistics = MeshOptimizer::AnalyzeVertexCache({ 0, 1, 2, 0, 1, 2, 3, 4, 5, 0, 1, 2 }, 6, 3);
+    CHECK(statistics.cacheMissCount == 9);
+
+    VertexCacheStatistics total{};
+    total.Add(statistics);
+    total.Add(statistics);
+    CHECK(total.cacheMissCount == 18 && total.triangleCount == 8 && total.vertexCount == 12);
+    CHECK(VertexCacheStatistics{}.GetAcmr() == 0.0f);
+}
+
+static void TestDeduplicateVertices()
+{
+    std::vector<float> vertices = { 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 1, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0 };
+    std::vector<uint32_t> indices = { 0, 1, 2, 3, 4, 5, 5, 2, 3 };
+    auto expected = GetTriangles(vertices, indices, 4);
+
+    /// Vertex 3 repeats 1 and vertex 5 repeats 0, vertex 4 differs from 0 only in fourth float
+    auto count = MeshOptimizer::DeduplicateVertices(vertices, indices, 4);
+    CHECK(count == 4);
+    CHECK(vertices.size() == 16);
+    CHECK((indices == std::vector<uint32_t>{ 0, 1, 2, 1, 3, 0, 0, 2, 1 }));
+    CHECK(GetTriangles(vertices, indices, 4) == expected);
+}
+
+static void TestOptimizeVertexCache()
+{
+    std::vector<float> vertices;
+    std::vector<uint32_t> indices;
+    CreateShuffledGrid(32, 3, vertices, indices);
+    auto vertexCount = static_cast<uint32_t>(vertices.size() / 3);
+    auto expected = GetTriangles(vertices, indices, 3);
+    auto before = MeshOptimizer::AnalyzeVertexCache(indices, vertexCount);
+
+    MeshOptimizer::OptimizeVertexCache(indices, vertexCount);
+    auto after = MeshOptimizer::AnalyzeVertexCache(indices, vertexCount);
+    CHECK(GetTriangles(vertices, indices, 3) == expected);
+
+    /// Shuffled grid misses almost every vertex, optimized one is close to 0.5 lower bound
+    CHECK(before.GetAcmr() > 2.0f);
+    CHECK(after.GetAcmr() < 0.8f);
+
+    std::vector<uint32_t> empty;
+    MeshOptimizer::OptimizeVertexCache(empty, 0);
+    CHECK(empty.empty());
+}
+
+static void TestOptimizeOverdraw()
+{
+    std::vector<float> vertices;
+    std::vector<uint32_t> indices;
+    CreateShuffledGrid(32, 3, vertices, indices);
+    auto vertexCount = static_cast<uint32_t>(vertices.size() / 3);
+    auto expected = GetTriangles(vertices, indices, 3);
+
+    MeshOptimizer::OptimizeVertexCache(indices, vertexCount);
+    auto before = MeshOptimizer::AnalyzeVertexCache(indices, vertexCount);
+    MeshOptimizer::OptimizeOverdraw(indices, vertices, 3, 1.05f);
+    auto after = MeshOptimizer::AnalyzeVertexCache(indices, vertexCount);
+
+    /// Clusters are reordered as a whole, cache efficiency stays near threshold
+    CHECK(GetTriangles(vertices, indices, 3) == expected);
+    CHECK(after.GetAcmr() <= before.GetAcmr() * 1.05f + 0.05f);
+}
+
+static void TestOptimizeVertexFetch()
+{
+    std::vector<float> vertices;
+    std::vector<uint32_t> indices;
+    CreateShuffledGrid(8, 5, vertices, indices);
+    auto expected = GetTriangles(vertices, indices, 5);
+
+    /// Vertex which no triangle uses is dropped
+    vertices.insert(vertices.end(), { 100.0f, 100.0f, 100.0f, 0.0f, 0.0f });
+    auto vertexCount = static_cast<uint32_t>(vertices.size() / 5);
+
+    MeshOptimizer::OptimizeVertexFetch(vertices, indices, 5);
+    CHECK(vertices.size() / 5 == vertexCount - 1);
+    CHECK(GetTriangles(vertices, indices, 5) == expected);
+
+    /// Vertices are numbered by first use
+    uint32_t nextVertex = 0;
+    for (auto index : indices)
+    {
+        CHECK(index <= nextVertex);
+        if (index == nextVertex)
+            nextVertex++;
+    }
+    CHECK(nextVertex == vertexCount - 1);
+}
+
+int main()
+{
+    TestAnalyzeVertexCache();
+    TestDeduplicateVertices();
+    TestOptimizeVertexCache();
+    TestOptimizeOverdraw();
+    TestOptimizeVertexFetch();
+    return 0;
+}
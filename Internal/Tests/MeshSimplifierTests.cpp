@@ -0,0 +1,239 @@
+#include <cmath>
+#include <set>
+#include <vector>
+#include "Scene/MeshSimplifier.hpp"
+#include "Check.hpp"
+
+using namespace Fluent;
+
+struct TestMesh
+{
+    std::vector<float>      vertices;
+    std::vector<uint32_t>   indices;
+    uint32_t                stride = 3;
+
+    uint32_t GetVertexCount() const { return static_cast<uint32_t>(vertices.size() / stride); }
+    const float* GetPosition(uint32_t index) const { return &vertices[size_t(index) * stride]; }
+};
+
+/// Unit square in xy plane, counter clockwise. Two extra floats per vertex stand for texcoords
+static TestMesh CreateGrid(uint32_t size)
+{
+    TestMesh mesh;
+    mesh.stride = 5;
+    for (uint32_t y = 0; y <= size; ++y)
+    {
+        for (uint32_t x = 0; x <= size; ++x)
+        {
+            float u = static_cast<float>(x) / size;
+            float v = static_cast<float>(y) / size;
+            mesh.vertices.insert(mesh.vertices.end(), { u, v, 0.0f, u, v });
+        }
+    }
+
+    for (uint32_t y = 0; y < size; ++y)
+    {
+        for (uint32_t x = 0; x < size; ++x)
+        {
+            uint32_t i = y * (size + 1) + x;
+            mesh.indices.insert(mesh.indices.end(), { i, i + 1, i + size + 2, i, i + size + 2, i + size + 1 });
+        }
+    }
+    return mesh;
+}
+
+/// Closed unit sphere with single vertex poles, counter clockwise from outside
+static TestMesh CreateSphere(uint32_t rings, uint32_t segments)
+{
+    constexpr float pi = 3.14159265f;
+    TestMesh mesh;
+    mesh.vertices = { 0.0f, 0.0f, 1.0f };
+    for (uint32_t ring = 1; ring < rings; ++ring)
+    {
+        float theta = pi * ring / rings;
+        for (uint32_t segment = 0; segment < segments; ++segment)
+        {
+            float phi = 2.0f * pi * segment / segments;
+            mesh.vertices.insert(mesh.vertices.end(), { std::sin(theta) * std::cos(phi), std::sin(theta) * std::sin(phi), std::cos(theta) });
+        }
+    }
+    mesh.vertices.insert(mesh.vertices.end(), { 0.0f, 0.0f, -1.0f });
+
+    uint32_t south = mesh.GetVertexCount() - 1;
+    auto vertex = [segments](uint32_t ring, uint32_t segment) { return 1 + (ring - 1) * segments + segment % segments; };
+    for (uint32_t segment = 0; segment < segments; ++segment)
+    {
+        mesh.indices.insert(mesh.indices.end(), { 0, vertex(1, segment), vertex(1, segment + 1) });
+        mesh.indices.insert(mesh.indices.end(), { south, vertex(rings - 1, segment + 1), vertex(rings - 1, segment) });
+        for (uint32_t ring = 1; ring + 1 < rings; ++ring)
+        {
+            uint32_t a = vertex(ring, segment), b = vertex(ring, segment + 1);
+            uint32_t c = vertex(ring + 1, segment), d = vertex(ring + 1, segment + 1);
+            mesh.indices.insert(mesh.indices.end(), { a, c, d, a, d, b });
+        }
+    }
+    return mesh;
+}
+
+static SimplifyMeshDescription Describe(const TestMesh& mesh, uint32_t targetIndexCount, float maxError)
+{
+    SimplifyMeshDescription description{};
+    description.vertices = mesh.vertices.data();
+    description.vertexCount = mesh.GetVertexCount();
+    description.stride = mesh.stride;
+    description.indices = mesh.indices.data();
+    description.indexCount = static_cast<uint32_t>(mesh.indices.size());
+    description.targetIndexCount = targetIndexCount;
+    description.maxError = maxError;
+    return description;
+}
+
+/// Cross product of triangle edges, length is twice the area
+static void GetNormal(const TestMesh& mesh, const uint32_t* triangle, float normal[3])
+{
+    const float* p0 = mesh.GetPosition(triangle[0]);
+    const float* p1 = mesh.GetPosition(triangle[1]);
+    const float* p2 = mesh.GetPosition(triangle[2]);
+    float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+    float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+    normal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+    normal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+    normal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+}
+
+static void CheckValidIndices(const TestMesh& mesh, const std::vector<uint32_t>& indices)
+{
+    CHECK(indices.size() % 3 == 0);
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        CHECK(indices[i] < mesh.GetVertexCount() && indices[i + 1] < mesh.GetVertexCount() && indices[i + 2] < mesh.GetVertexCount());
+        CHECK(indices[i] != indices[i + 1] && indices[i + 1] != indices[i + 2] && indices[i] != indices[i + 2]);
+    }
+}
+
+static void TestPlanarGrid()
+{
+    auto mesh = CreateGrid(16);
+    float error = -1.0f;
+    auto result = SimplifyMesh(Describe(mesh, 0, 0.01f), &error);
+    CheckValidIndices(mesh, result);
+
+    /// Interior of plane collapses for free, locked border keeps it from shrinking further
+    CHECK(result.size() < mesh.indices.size() / 4);
+    CHECK(error >= 0.0f && error < 1e-4f);
+
+    /// Plane stays covered without flips or overlaps, so facing area is kept
+    float area = 0.0f;
+    for (size_t i = 0; i < result.size(); i += 3)
+    {
+        float normal[3];
+        GetNormal(mesh, &result[i], normal);
+        CHECK(normal[2] > 0.0f);
+        area += 0.5f * normal[2];
+    }
+    CHECK(std::abs(area - 1.0f) < 1e-4f);
+
+    /// Every border vertex is still used
+    std::set<uint32_t> used(result.begin(), result.end());
+    for (uint32_t i = 0; i <= 16; ++i)
+    {
+        CHECK(used.count(i) && used.count(16 * 17 + i));
+        CHECK(used.count(i * 17) && used.count(i * 17 + 16));
+    }
+}
+
+static void TestTargetReached()
+{
+    auto mesh = CreateGrid(8);
+
+    /// Nothing to do when target isn't below source
+    auto result = SimplifyMesh(Describe(mesh, static_cast<uint32_t>(mesh.indices.size()), 1.0f));
+    CHECK(result == mesh.indices);
+
+    /// Collapses stop once target is met
+    uint32_t target = static_cast<uint32_t>(mesh.indices.size() / 2);
+    result = SimplifyMesh(Describe(mesh, target, 1.0f));
+    CheckValidIndices(mesh, result);
+    CHECK(result.size() <= target);
+    CHECK(result.size() >= target - 3 * 4);
+}
+
+static void TestErrorBound()
+{
+    auto mesh = CreateSphere(24, 48);
+    uint32_t previousSize = static_cast<uint32_t>(mesh.indices.size()) + 1;
+    for (float maxError : { 0.001f, 0.01f, 0.05f })
+    {
+        float error = -1.0f;
+        auto result = SimplifyMesh(Describe(mesh, 0, maxError), &error);
+        CheckValidIndices(mesh, result);
+
+        /// Extent of unit sphere is 2
+        CHECK(error >= 0.0f && error <= maxError * 2.0f);
+        CHECK(result.size() < previousSize);
+        previousSize = static_cast<uint32_t>(result.size());
+
+        /// Surface stays closed and facing outwards
+        for (size_t i = 0; i < result.size(); i += 3)
+        {
+            float normal[3];
+            GetNormal(mesh, &result[i], normal);
+            const float* p0 = mesh.GetPosition(result[i]);
+            CHECK(normal[0] * p0[0] + normal[1] * p0[1] + normal[2] * p0[2] > 0.0f);
+        }
+    }
+    CHECK(previousSize < mesh.indices.size() / 2);
+}
+
+static void TestSeamLocked()
+{
+    /// Two grids meeting at x = 1 with own vertices, seam edges are used once so they are kept
+    auto left = CreateGrid(8);
+    auto right = CreateGrid(8);
+    TestMesh mesh = left;
+    auto offset = left.GetVertexCount();
+    for (uint32_t i = 0; i < right.GetVertexCount(); ++i)
+    {
+        const float* vertex = &right.vertices[size_t(i) * right.stride];
+        mesh.vertices.insert(mesh.vertices.end(), { vertex[0] + 1.0f, vertex[1], vertex[2], vertex[3], vertex[4] });
+    }
+    for (auto index : right.indices)
+        mesh.indices.push_back(index + offset);
+
+    auto result = SimplifyMesh(Describe(mesh, 0, 0.01f));
+    CheckValidIndices(mesh, result);
+    std::set<uint32_t> used(result.begin(), result.end());
+    for (uint32_t y = 0; y <= 8; ++y)
+    {
+        CHECK(used.count(y * 9 + 8));
+        CHECK(used.count(offset + y * 9));
+    }
+}
+
+static void TestInvalidIndices()
+{
+    auto mesh = CreateGrid(4);
+    auto description = Describe(mesh, 0, 1.0f);
+
+    /// Incomplete last triangle is ignored
+    description.indexCount -= 2;
+    auto result = SimplifyMesh(description);
+    CheckValidIndices(mesh, result);
+    CHECK(result.size() < mesh.indices.size() - 3);
+
+    /// Out of range index keeps mesh as is
+    mesh.indices[7] = mesh.GetVertexCount();
+    description = Describe(mesh, 0, 1.0f);
+    result = SimplifyMesh(description);
+    CHECK(result == mesh.indices);
+}
+
+int main()
+{
+    TestPlanarGrid();
+    TestTargetReached();
+    TestErrorBound();
+    TestSeamLocked();
+    TestInvalidIndices();
+    return 0;
+}
@@ -0,0 +1,226 @@
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "Renderer/CommandStream.hpp"
+#include "Renderer/RenderQueue.hpp"
+#include "Check.hpp"
+#include "FakeResources.hpp"
+
+using namespace Fluent;
+
+struct RecordedPacket
+{
+    CommandType     type;
+    const uint8_t*  command;
+};
+
+/// Every command is at most 8 byte aligned, so it follows 8 byte header directly
+static std::vector<RecordedPacket> ReadPackets(const CommandStream& stream)
+{
+    std::vector<RecordedPacket> packets;
+    const auto& data = stream.GetData();
+    for (uint32_t offset = 0; offset < data.size();)
+    {
+        CommandHeader header;
+        std::memcpy(&header, data.data() + offset, sizeof(header));
+        CHECK(header.size > sizeof(header));
+        packets.push_back({ header.type, data.data() + offset + sizeof(header) });
+        offset += header.size;
+    }
+    return packets;
+}
+
+/// Draws are told apart by first instance, which is set to submission index
+static std::vector<uint32_t> ReadDrawOrder(const CommandStream& stream)
+{
+    std::vector<uint32_t> order;
+    for (const auto& packet : ReadPackets(stream))
+    {
+        if (packet.type != CommandType::eDrawIndexed)
+            continue;
+        DrawIndexedCommand command;
+        std::memcpy(&command, packet.command, sizeof(command));
+        order.push_back(command.firstInstance);
+    }
+    return order;
+}
+
+static uint32_t CountPackets(const CommandStream& stream, CommandType type)
+{
+    auto packets = ReadPackets(stream);
+    return static_cast<uint32_t>(std::count_if(packets.begin(), packets.end(), [type](const RecordedPacket& packet) { return packet.type == type; }));
+}
+
+static void AddResources(RenderQueue& queue, uint32_t pipelineCount, uint32_t materialCount, uint32_t meshCount)
+{
+    for (uint32_t i = 0; i < pipelineCount; ++i)
+        queue.AddPipeline(CreateRef<FakePipeline>(i + 1));
+
+    /// Empty materials differ only by offset, so they aren't merged and record nothing
+    for (uint32_t i = 0; i < materialCount; ++i)
+    {
+        RenderMaterial material{};
+        material.pushConstantOffset = i;
+        queue.AddMaterial(material);
+    }
+
+    for (uint32_t i = 0; i < meshCount; ++i)
+    {
+        RenderMesh mesh{};
+        mesh.vertexBuffer = CreateRef<FakeBuffer>(2 * i + 1);
+        mesh.indexBuffer = CreateRef<FakeBuffer>(2 * i + 2);
+        mesh.indexCount = 3;
+        queue.AddMesh(mesh);
+    }
+}
+
+static void TestSortKeys()
+{
+    auto key = [](uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t mesh, float depth, bool translucent = false)
+    {
+        return RenderQueue::MakeSortKey(pass, pipeline, material, mesh, depth, translucent);
+    };
+
+    /// Opaque fields compare in order pass, pipeline, material, mesh, depth
+    CHECK(key(0, 9, 9, 9, 1.0f) < key(1, 0, 0, 0, 0.0f));
+    CHECK(key(0, 0, 9, 9, 1.0f) < key(0, 1, 0, 0, 0.0f));
+    CHECK(key(0, 0, 0, 9, 1.0f) < key(0, 0, 1, 0, 0.0f));
+    CHECK(key(0, 0, 0, 0, 1.0f) < key(0, 0, 0, 1, 0.0f));
+    CHECK(key(0, 0, 0, 0, 0.25f) < key(0, 0, 0, 0, 0.5f));
+
+    /// Translucent goes back to front regardless of state
+    CHECK(key(0, 9, 9, 9, 0.75f, true) < key(0, 0, 0, 0, 0.5f, true));
+    CHECK(key(0, 9, 9, 9, 0.0f, true) < key(1, 0, 0, 0, 1.0f, true));
+
+    /// Depth is clamped and indices are truncated
+    CHECK(key(0, 0, 0, 0, -1.0f) == key(0, 0, 0, 0, 0.0f));
+    CHECK(key(0, 0, 0, 0, 2.0f) == key(0, 0, 0, 0, 1.0f));
+    CHECK(key(0, 1u << RenderQueue::PIPELINE_BITS, 0, 0, 0.0f) == key(0, 0, 0, 0, 0.0f));
+}
+
+static void TestStableOrder()
+{
+    RenderQueue queue;
+    AddResources(queue, 1, 1, 1);
+
+    /// Few distinct keys spread over all bytes, so equal keys are common and every pass reorders
+    std::mt19937 random(1);
+    std::vector<uint64_t> distinctKeys;
+    for (uint32_t i = 0; i < 16; ++i)
+        distinctKeys.push_back((static_cast<uint64_t>(random()) << 32) | random());
+
+    std::vector<uint64_t> keys;
+    for (uint32_t i = 0; i < 2000; ++i)
+    {
+        DrawItem item{};
+        item.sortKey = distinctKeys[random() % distinctKeys.size()];
+        item.firstInstance = i;
+        queue.Submit(item);
+        keys.push_back(item.sortKey);
+    }
+    CHECK(queue.GetDrawCount() == 2000);
+
+    std::vector<uint32_t> expected(keys.size());
+    for (uint32_t i = 0; i < expected.size(); ++i)
+        expected[i] = i;
+    std::stable_sort(expected.begin(), expected.end(), [&keys](uint32_t a, uint32_t b) { return keys[a] < keys[b]; });
+
+    CommandStream stream;
+    queue.Execute(stream);
+    CHECK(ReadDrawOrder(stream) == expected);
+    CHECK(queue.GetStats().drawCount == 2000);
+
+    queue.Clear();
+    CHECK(queue.GetDrawCount() == 0);
+    CHECK(queue.GetStats().drawCount == 0);
+}
+
+static void TestPassFilter()
+{
+    RenderQueue queue;
+    AddResources(queue, 1, 1, 1);
+
+    constexpr uint32_t lastPass = (1u << RenderQueue::PASS_BITS) - 1;
+    uint32_t passes[] = { 2, lastPass, 0, 1, 2, 1 };
+    for (uint32_t i = 0; i < 6; ++i)
+    {
+        DrawItem item{};
+        item.sortKey = RenderQueue::MakeSortKey(passes[i], 0, 0, 0, 0.5f);
+        item.firstInstance = i;
+        queue.Submit(item);
+    }
+
+    CommandStream stream;
+    queue.Execute(stream, 1);
+    CHECK((ReadDrawOrder(stream) == std::vector<uint32_t>{ 3, 5 }));
+
+    stream.Reset();
+    queue.Execute(stream, lastPass);
+    CHECK((ReadDrawOrder(stream) == std::vector<uint32_t>{ 1 }));
+
+    stream.Reset();
+    queue.Execute(stream, 7);
+    CHECK(stream.IsEmpty());
+
+    stream.Reset();
+    queue.Execute(stream);
+    CHECK((ReadDrawOrder(stream) == std::vector<uint32_t>{ 2, 3, 5, 0, 4, 1 }));
+}
+
+static void TestRedundantBinds()
+{
+    RenderQueue queue;
+    AddResources(queue, 2, 2, 3);
+
+    /// Submitted interleaved, sorted draws share state in runs
+    uint32_t index = 0;
+    for (uint32_t mesh = 0; mesh < 3; ++mesh)
+    {
+        for (uint32_t pipeline = 0; pipeline < 2; ++pipeline)
+        {
+            for (uint32_t copy = 0; copy < 2; ++copy)
+            {
+                DrawItem item{};
+                item.pipeline = pipeline;
+                item.material = pipeline;
+                item.mesh = mesh;
+                item.firstInstance = index++;
+                item.sortKey = RenderQueue::MakeSortKey(0, item.pipeline, item.material, item.mesh, 0.1f * copy);
+                queue.Submit(item);
+            }
+        }
+    }
+
+    CommandStream stream;
+    queue.Execute(stream);
+
+    const auto& stats = queue.GetStats();
+    CHECK(stats.drawCount == 12);
+    CHECK(stats.pipelineBindCount == 2);
+    CHECK(stats.materialBindCount == 2);
+    CHECK(stats.meshBindCount == 6);
+    CHECK(CountPackets(stream, CommandType::eBindPipeline) == 2);
+    CHECK(CountPackets(stream, CommandType::eBindVertexBuffer) == 6);
+    CHECK(CountPackets(stream, CommandType::eBindIndexBuffer) == 6);
+    CHECK(CountPackets(stream, CommandType::eDrawIndexed) == 12);
+
+    /// Pipeline 0 draws of every mesh come first
+    CHECK((ReadDrawOrder(stream) == std::vector<uint32_t>{ 0, 1, 4, 5, 8, 9, 2, 3, 6, 7, 10, 11 }));
+
+    /// First packet binds pipeline with id 1
+    auto packets = ReadPackets(stream);
+    CHECK(packets[0].type == CommandType::eBindPipeline);
+    BindPipelineCommand bind;
+    std::memcpy(&bind, packets[0].command, sizeof(bind));
+    CHECK(bind.pipeline == reinterpret_cast<Handle>(1));
+}
+
+int main()
+{
+    TestSortKeys();
+    TestStableOrder();
+    TestPassFilter();
+    TestRedundantBinds();
+    return 0;
+}
@@ -0,0 +1,65 @@
+#include <algorithm>
+#include <filesystem>
+#include <vector>
+#include "Renderer/ShaderHotReload.hpp"
+#include "Check.hpp"
+#include "FakeResources.hpp"
+
+using namespace Fluent;
+
+static Ref<Pipeline> CreatePipeline(uintptr_t id, const std::string& vertexShader, const std::string& fragmentShader)
+{
+    std::vector<Ref<Shader>> shaders = {
+        CreateRef<FakeShader>(ShaderStage::eVertex, vertexShader),
+        CreateRef<FakeShader>(ShaderStage::eFragment, fragmentShader)
+    };
+    return CreateRef<FakePipeline>(id, std::vector<PushConstantRange>{}, CreateRef<FakeDescriptorSetLayout>(shaders));
+}
+
+static bool Contains(const std::vector<Ref<Pipeline>>& pipelines, const Ref<Pipeline>& pipeline)
+{
+    return std::find(pipelines.begin(), pipelines.end(), pipeline) != pipelines.end();
+}
+
+/// Application creates hot reload before layers build pipelines and watches shaders directory
+/// only in Run, pipelines created in between must be rebuilt on change
+static void TestPipelinesCreatedBeforeWatch()
+{
+    auto early = CreatePipeline(1, "main.vert", "main.frag");
+    ShaderHotReload::RegisterPipeline(early);
+
+    auto hotReload = ShaderHotReload::Create({});
+    hotReload->Update();
+
+    auto first = CreatePipeline(2, "main.vert", "main.frag");
+    auto second = CreatePipeline(3, "main.vert", "other.frag");
+    ShaderHotReload::RegisterPipeline(first);
+    ShaderHotReload::RegisterPipeline(second);
+
+    hotReload->Watch(std::filesystem::temp_directory_path().string());
+    hotReload->Update();
+
+    auto dependents = ShaderHotReload::GetDependentPipelines("main.vert");
+    CHECK(dependents.size() == 2);
+    CHECK(Contains(dependents, first) && Contains(dependents, second));
+    /// Registered while no hot reload existed
+    CHECK(!Contains(dependents, early));
+
+    dependents = ShaderHotReload::GetDependentPipelines("main.frag");
+    CHECK(dependents.size() == 1 && dependents[0] == first);
+    CHECK(ShaderHotReload::GetDependentPipelines("missing.frag").empty());
+
+    /// Registry holds weak references only
+    dependents.clear();
+    first.reset();
+    CHECK(ShaderHotReload::GetDependentPipelines("main.frag").empty());
+
+    hotReload.reset();
+    CHECK(ShaderHotReload::GetDependentPipelines("main.vert").empty());
+}
+
+int main()
+{
+    TestPipelinesCreatedBeforeWatch();
+    return 0;
+}
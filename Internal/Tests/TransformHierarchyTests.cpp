@@ -0,0 +1,144 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "Scene/TransformHierarchy.hpp"
+#include "Check.hpp"
+
+using namespace Fluent;
+
+/// Plain column major product, reference for vectorized one
+static Matrix4 Multiply(const Matrix4& a, const Matrix4& b)
+{
+    Matrix4 result(1.0f);
+    for (int column = 0; column < 4; ++column)
+    {
+        for (int row = 0; row < 4; ++row)
+        {
+            float sum = 0.0f;
+            for (int k = 0; k < 4; ++k)
+                sum += a[k][row] * b[column][k];
+            result[column][row] = sum;
+        }
+    }
+    return result;
+}
+
+static bool IsNear(const Matrix4& a, const Matrix4& b)
+{
+    for (int column = 0; column < 4; ++column)
+    {
+        for (int row = 0; row < 4; ++row)
+        {
+            float tolerance = 1e-4f * std::max(1.0f, std::abs(b[column][row]));
+            if (std::abs(a[column][row] - b[column][row]) > tolerance)
+                return false;
+        }
+    }
+    return true;
+}
+
+static Matrix4 RandomMatrix(std::mt19937& random)
+{
+    std::uniform_real_distribution<float> distribution(-2.0f, 2.0f);
+    Matrix4 result(1.0f);
+    for (int column = 0; column < 4; ++column)
+    {
+        for (int row = 0; row < 3; ++row)
+            result[column][row] = distribution(random);
+    }
+    return result;
+}
+
+static void CheckAgainstReference(const TransformHierarchy& hierarchy)
+{
+    std::vector<Matrix4> expected(hierarchy.GetNodeCount());
+    for (uint32_t i = 0; i < hierarchy.GetNodeCount(); ++i)
+    {
+        auto parent = hierarchy.GetParent(i);
+        expected[i] = parent == TransformHierarchy::INVALID_NODE ? hierarchy.GetLocalTransform(i)
+                                                                 : Multiply(expected[parent], hierarchy.GetLocalTransform(i));
+        CHECK(IsNear(hierarchy.GetWorldTransform(i), expected[i]));
+    }
+}
+
+static void TestChain()
+{
+    std::mt19937 random(1);
+    TransformHierarchy hierarchy;
+    auto root = hierarchy.AddNode(RandomMatrix(random));
+    auto child = hierarchy.AddNode(RandomMatrix(random), root);
+    auto grandChild = hierarchy.AddNode(RandomMatrix(random), child);
+    hierarchy.Update();
+
+    auto expected = Multiply(Multiply(hierarchy.GetLocalTransform(root), hierarchy.GetLocalTransform(child)),
+                             hierarchy.GetLocalTransform(grandChild));
+    CHECK(IsNear(hierarchy.GetWorldTransform(grandChild), expected));
+    CheckAgainstReference(hierarchy);
+}
+
+/// Debug builds assert on missing parent, only release builds fall back to root
+#ifdef NDEBUG
+static void TestInvalidParent()
+{
+    TransformHierarchy hierarchy;
+    auto node = hierarchy.AddNode(Matrix4(1.0f), 5);
+    CHECK(hierarchy.GetParent(node) == TransformHierarchy::INVALID_NODE);
+}
+#endif
+
+static void TestPartialUpdate()
+{
+    std::mt19937 random(2);
+    TransformHierarchy hierarchy;
+    auto root = hierarchy.AddNode(RandomMatrix(random));
+    auto left = hierarchy.AddNode(RandomMatrix(random), root);
+    auto right = hierarchy.AddNode(RandomMatrix(random), root);
+    auto leftChild = hierarchy.AddNode(RandomMatrix(random), left);
+    hierarchy.Update();
+
+    auto rightWorld = hierarchy.GetWorldTransform(right);
+    hierarchy.SetLocalTransform(left, RandomMatrix(random));
+    hierarchy.Update();
+
+    /// Sibling keeps its transform, descendant follows changed node
+    CHECK(IsNear(hierarchy.GetWorldTransform(right), rightWorld));
+    CHECK(IsNear(hierarchy.GetWorldTransform(leftChild), Multiply(hierarchy.GetWorldTransform(left), hierarchy.GetLocalTransform(leftChild))));
+    CheckAgainstReference(hierarchy);
+}
+
+static void TestRandomTree()
+{
+    std::mt19937 random(3);
+    TransformHierarchy hierarchy;
+    hierarchy.Reserve(1000);
+    for (uint32_t i = 0; i < 1000; ++i)
+    {
+        auto parent = i == 0 || random() % 8 == 0 ? TransformHierarchy::INVALID_NODE : random() % i;
+        hierarchy.AddNode(RandomMatrix(random), parent);
+    }
+    hierarchy.Update();
+    CheckAgainstReference(hierarchy);
+
+    for (uint32_t iteration = 0; iteration < 10; ++iteration)
+    {
+        for (uint32_t i = 0; i < 20; ++i)
+            hierarchy.SetLocalTransform(random() % hierarchy.GetNodeCount(), RandomMatrix(random));
+        hierarchy.Update();
+        CheckAgainstReference(hierarchy);
+    }
+
+    hierarchy.Clear();
+    CHECK(hierarchy.GetNodeCount() == 0);
+}
+
+int main()
+{
+    TestChain();
+#ifdef NDEBUG
+    TestInvalidParent();
+#endif
+    TestPartialUpdate();
+    TestRandomTree();
+    return 0;
+}
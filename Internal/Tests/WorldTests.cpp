@@ -0,0 +1,175 @@
+#include <atomic>
+#include <vector>
+#include "Scene/World.hpp"
+#include "Check.hpp"
+
+using namespace Fluent;
+
+struct Position
+{
+    float x, y, z;
+};
+
+struct Velocity
+{
+    float x, y, z;
+};
+
+struct Counter
+{
+    uint32_t value;
+};
+
+static void TestLifetime()
+{
+    World world;
+    auto first = world.CreateEntity(Position{ 1.0f, 2.0f, 3.0f });
+    auto second = world.CreateEntity(Position{ 4.0f, 5.0f, 6.0f });
+    CHECK(world.GetEntityCount() == 2);
+    CHECK(world.IsAlive(first) && world.IsAlive(second));
+
+    world.DestroyEntity(first);
+    CHECK(!world.IsAlive(first));
+    CHECK(world.GetEntityCount() == 1);
+    /// Removed row is filled by last entity, which must keep its data
+    CHECK(world.GetComponent<Position>(second)->x == 4.0f);
+
+    /// Index is reused with new generation, stale handle stays dead
+    auto third = world.CreateEntity(Position{ 7.0f, 8.0f, 9.0f });
+    CHECK(third.index == first.index);
+    CHECK(third.generation != first.generation);
+    CHECK(!world.IsAlive(first));
+    CHECK(!world.HasComponent<Position>(first));
+
+    world.DestroyEntity(first);
+    CHECK(world.GetEntityCount() == 2);
+}
+
+static void TestComponentMoves()
+{
+    World world;
+    auto entity = world.CreateEntity(Position{ 1.0f, 2.0f, 3.0f });
+    CHECK(!world.HasComponent<Velocity>(entity));
+
+    world.AddComponent(entity, Velocity{ 0.5f, 0.0f, 0.0f });
+    CHECK(world.HasComponent<Velocity>(entity));
+    CHECK(world.GetComponent<Position>(entity)->y == 2.0f);
+    CHECK(world.GetComponent<Velocity>(entity)->x == 0.5f);
+
+    /// Existing component is overwritten in place
+    world.AddComponent(entity, Velocity{ 1.5f, 0.0f, 0.0f });
+    CHECK(world.GetComponent<Velocity>(entity)->x == 1.5f);
+
+    world.RemoveComponent<Velocity>(entity);
+    CHECK(!world.HasComponent<Velocity>(entity));
+    CHECK(world.GetComponent<Position>(entity)->z == 3.0f);
+}
+
+static void TestManyChunks()
+{
+    World world;
+    std::vector<Entity> entities;
+    for (uint32_t i = 0; i < 10000; ++i)
+        entities.push_back(world.CreateEntity(Position{ static_cast<float>(i), 0.0f, 0.0f }, Counter{ i }));
+
+    /// Every other entity is removed, rows are compacted
+    for (uint32_t i = 0; i < entities.size(); i += 2)
+        world.DestroyEntity(entities[i]);
+    CHECK(world.GetEntityCount() == 5000);
+
+    for (uint32_t i = 1; i < entities.size(); i += 2)
+    {
+        CHECK(world.GetComponent<Counter>(entities[i])->value == i);
+        CHECK(world.GetComponent<Position>(entities[i])->x == static_cast<float>(i));
+    }
+
+    uint32_t visited = 0;
+    uint32_t chunks = 0;
+    world.ForEachChunk<Counter>([&](uint32_t count, const Entity* chunkEntities, Counter* counters)
+    {
+        chunks++;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            CHECK(counters[i].value == chunkEntities[i].index);
+            visited++;
+        }
+    });
+    CHECK(visited == 5000);
+    CHECK(chunks > 1);
+}
+
+static void TestQueryMasks()
+{
+    World world;
+    world.CreateEntity(Position{});
+    world.CreateEntity(Position{}, Velocity{ 1.0f, 1.0f, 1.0f });
+    world.CreateEntity(Velocity{ 2.0f, 2.0f, 2.0f });
+
+    uint32_t positions = 0;
+    world.Each<Position>([&positions](Entity, Position&) { positions++; });
+    CHECK(positions == 2);
+
+    float velocitySum = 0.0f;
+    world.Each<Velocity>([&velocitySum](Entity, Velocity& velocity) { velocitySum += velocity.x; });
+    CHECK(velocitySum == 3.0f);
+
+    uint32_t both = 0;
+    world.Each<Position, Velocity>([&both](Entity, Position& position, Velocity& velocity)
+    {
+        position.x += velocity.x;
+        both++;
+    });
+    CHECK(both == 1);
+}
+
+static void TestParallelChunks()
+{
+    World world;
+    for (uint32_t i = 0; i < 20000; ++i)
+        world.CreateEntity(Counter{ 0 }, Position{});
+
+    /// Every entity is visited exactly once, nested call runs inline
+    std::atomic<uint32_t> nested = 0;
+    world.ParallelForEachChunk<Counter>([&nested](uint32_t count, const Entity*, Counter* counters)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+            counters[i].value++;
+
+        World inner;
+        inner.CreateEntity(Counter{ 0 });
+        inner.ParallelForEachChunk<Counter>([&nested](uint32_t innerCount, const Entity*, Counter*) { nested += innerCount; });
+    });
+
+    uint32_t total = 0;
+    world.Each<Counter>([&total](Entity, Counter& counter)
+    {
+        CHECK(counter.value == 1);
+        total++;
+    });
+    CHECK(total == 20000);
+
+    uint32_t chunkCount = 0;
+    world.ForEachChunk<Counter>([&chunkCount](uint32_t, const Entity*, Counter*) { chunkCount++; });
+    CHECK(nested == chunkCount);
+
+    for (uint32_t workerCount = 1; workerCount < 4; ++workerCount)
+    {
+        world.ParallelForEachChunk<Counter>([](uint32_t count, const Entity*, Counter* counters)
+        {
+            for (uint32_t i = 0; i < count; ++i)
+                counters[i].value++;
+        }, workerCount);
+    }
+
+    world.Each<Counter>([](Entity, Counter& counter) { CHECK(counter.value == 4); });
+}
+
+int main()
+{
+    TestLifetime();
+    TestComponentMoves();
+    TestManyChunks();
+    TestQueryMasks();
+    TestParallelChunks();
+    return 0;
+}